@@ -0,0 +1,371 @@
+// Microbenchmark: AudioRingBuffer SPSC throughput and per-call latency.
+// Sweeps chunk size, channel count, capacity, storage backend and thread pinning, and reports
+// Mframes/s plus ns/frame percentiles of successful write_frames/read_frames calls.
+// Capacities are multiples of the chunk (powers of two, so the mask path) plus latency-derived
+// ones from frames_for_latency (44.1/48/96 kHz by default), which a latency-sized ring gets in
+// Exact mode and which take the modulo path. Use it to check whether a layout or indexing change moves the numbers.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "buffer/audio_ring_buffer.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// None leaves placement to the scheduler; Same puts both threads on one core (no coherence
+// traffic, maximal preemption); Split puts them on different cores.
+enum class Pinning { None, Same, Split };
+
+const char* PinningName(Pinning pinning) {
+  switch (pinning) {
+    case Pinning::None:
+      return "none";
+    case Pinning::Same:
+      return "same";
+    case Pinning::Split:
+      return "split";
+  }
+  return "?";
+}
+
+bool PinCurrentThread(unsigned cpu) {
+#if defined(_WIN32)
+  if (cpu >= sizeof(DWORD_PTR) * 8) {
+    return false;
+  }
+  return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << cpu) != 0;
+#elif defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+using StorageBackend = AudioRingBuffer::StorageBackend;
+
+const char* BackendName(StorageBackend backend) {
+  return backend == StorageBackend::Mirrored ? "mirror" : "heap";
+}
+
+struct Options {
+  std::vector<uint32_t> chunks{64, 128, 256, 512, 1024, 2048, 4096, 8192};
+  std::vector<uint32_t> channels{1, 2, 4, 6, 8};
+  std::vector<uint32_t> capacity_factors{2, 4, 16};
+  // Latency capacities: frames_for_latency(rate, latency) for each pair, skipped when smaller
+  // than the chunk. The default is the engine's 2 s ring at common device rates.
+  std::vector<uint32_t> rates{44100, 48000, 96000};
+  std::vector<uint32_t> latencies_ms{2000};
+  std::vector<StorageBackend> backends{StorageBackend::Heap, StorageBackend::Mirrored};
+  std::vector<Pinning> pinnings{Pinning::None, Pinning::Same, Pinning::Split};
+  uint64_t total_frames = 4'000'000;
+};
+
+struct Percentiles {
+  double p50 = 0.0;
+  double p99 = 0.0;
+  double p999 = 0.0;
+  double max = 0.0;
+};
+
+// ns/frame percentiles; sorts samples in place.
+Percentiles Summarize(std::vector<double>* samples) {
+  Percentiles result;
+  if (samples->empty()) {
+    return result;
+  }
+  std::sort(samples->begin(), samples->end());
+  const auto at = [&](double quantile) {
+    const size_t index = static_cast<size_t>(quantile * static_cast<double>(samples->size() - 1));
+    return (*samples)[index];
+  };
+  result.p50 = at(0.50);
+  result.p99 = at(0.99);
+  result.p999 = at(0.999);
+  result.max = samples->back();
+  return result;
+}
+
+struct RunResult {
+  double mframes_per_second = 0.0;
+  Percentiles write_ns_per_frame;
+  Percentiles read_ns_per_frame;
+  bool pinned = true;
+  // What the ring actually built: Mirrored rounds capacity up to whole pages (which can
+  // change the indexing path) and falls back to Heap when mapping is unavailable.
+  uint32_t capacity_frames = 0;
+  bool uses_index_mask = false;
+  StorageBackend backend = StorageBackend::Heap;
+};
+
+RunResult RunOnce(uint32_t chunk_frames,
+                  uint32_t channels,
+                  uint32_t capacity_frames,
+                  StorageBackend backend,
+                  Pinning pinning,
+                  uint64_t total_frames) {
+  AudioRingBuffer ring(capacity_frames, channels, AudioRingBuffer::CapacityMode::Exact, backend);
+  const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+  const bool yield_when_idle = cpus < 2 || pinning == Pinning::Same;
+  const size_t max_calls = static_cast<size_t>(total_frames / chunk_frames + 1);
+  std::atomic<bool> go{false};
+  std::atomic<bool> producer_pinned{true};
+  std::vector<double> write_samples;
+  std::vector<double> read_samples;
+  write_samples.reserve(max_calls);
+  read_samples.reserve(max_calls);
+
+  std::thread producer([&]() {
+    if (pinning != Pinning::None) {
+      producer_pinned.store(PinCurrentThread(pinning == Pinning::Split ? 1 % cpus : 0));
+    }
+    std::vector<float> chunk(static_cast<size_t>(chunk_frames) * channels, 0.25f);
+    while (!go.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    uint64_t sent = 0;
+    while (sent < total_frames) {
+      const uint32_t frames =
+          static_cast<uint32_t>(std::min<uint64_t>(total_frames - sent, chunk_frames));
+      const auto start = Clock::now();
+      const uint32_t written = ring.write_frames(chunk.data(), frames);
+      const auto elapsed = Clock::now() - start;
+      if (written == 0) {
+        if (yield_when_idle) {
+          std::this_thread::yield();
+        }
+        continue;
+      }
+      write_samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count() /
+                              written);
+      sent += written;
+    }
+  });
+
+  // The consumer gets its own thread too, so the main thread never keeps an affinity mask.
+  std::atomic<bool> consumer_pinned{true};
+  Clock::duration run_elapsed{};
+  std::thread consumer([&]() {
+    if (pinning != Pinning::None) {
+      consumer_pinned.store(PinCurrentThread(0));
+    }
+    std::vector<float> chunk(static_cast<size_t>(chunk_frames) * channels);
+    const auto run_start = Clock::now();
+    go.store(true, std::memory_order_release);
+    uint64_t received = 0;
+    while (received < total_frames) {
+      const auto start = Clock::now();
+      const uint32_t read = ring.read_frames(chunk.data(), chunk_frames);
+      const auto elapsed = Clock::now() - start;
+      if (read == 0) {
+        if (yield_when_idle) {
+          std::this_thread::yield();
+        }
+        continue;
+      }
+      read_samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / read);
+      received += read;
+    }
+    run_elapsed = Clock::now() - run_start;
+  });
+  consumer.join();
+  producer.join();
+
+  RunResult result;
+  result.mframes_per_second = static_cast<double>(total_frames) /
+                              std::chrono::duration<double>(run_elapsed).count() / 1e6;
+  result.write_ns_per_frame = Summarize(&write_samples);
+  result.read_ns_per_frame = Summarize(&read_samples);
+  result.pinned = consumer_pinned.load() && producer_pinned.load();
+  result.capacity_frames = ring.capacity_frames();
+  result.uses_index_mask = ring.uses_index_mask();
+  result.backend = ring.storage_backend();
+  return result;
+}
+
+// Capacities to run for one chunk size: chunk multiples first, then latency-derived ones,
+// without duplicates.
+std::vector<uint32_t> CapacitiesFor(uint32_t chunk, const Options& options) {
+  std::vector<uint32_t> capacities;
+  const auto add = [&](uint64_t capacity) {
+    if (capacity >= chunk && capacity <= UINT32_MAX &&
+        std::find(capacities.begin(), capacities.end(), capacity) == capacities.end()) {
+      capacities.push_back(static_cast<uint32_t>(capacity));
+    }
+  };
+  for (const uint32_t factor : options.capacity_factors) {
+    add(static_cast<uint64_t>(chunk) * factor);
+  }
+  for (const uint32_t latency_ms : options.latencies_ms) {
+    for (const uint32_t rate : options.rates) {
+      add(AudioRingBuffer::frames_for_latency(rate, std::chrono::milliseconds(latency_ms)));
+    }
+  }
+  return capacities;
+}
+
+bool ParseList(const char* text, std::vector<uint32_t>* values) {
+  values->clear();
+  std::string_view rest = text;
+  while (!rest.empty()) {
+    const size_t comma = rest.find(',');
+    const std::string item(rest.substr(0, comma));
+    const unsigned long value = std::strtoul(item.c_str(), nullptr, 10);
+    if (value == 0) {
+      return false;
+    }
+    values->push_back(static_cast<uint32_t>(value));
+    rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+  }
+  return !values->empty();
+}
+
+bool ParsePinning(std::string_view text, std::vector<Pinning>* pinnings) {
+  if (text == "none") {
+    *pinnings = {Pinning::None};
+  } else if (text == "same") {
+    *pinnings = {Pinning::Same};
+  } else if (text == "split") {
+    *pinnings = {Pinning::Split};
+  } else if (text == "all") {
+    *pinnings = {Pinning::None, Pinning::Same, Pinning::Split};
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ParseBackend(std::string_view text, std::vector<StorageBackend>* backends) {
+  if (text == "heap") {
+    *backends = {StorageBackend::Heap};
+  } else if (text == "mirrored") {
+    *backends = {StorageBackend::Mirrored};
+  } else if (text == "all") {
+    *backends = {StorageBackend::Heap, StorageBackend::Mirrored};
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ParseArgs(int argc, char* argv[], Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    if (arg == "--chunks") {
+      if (!ParseList(argv[++i], &options->chunks)) {
+        return false;
+      }
+    } else if (arg == "--channels") {
+      if (!ParseList(argv[++i], &options->channels)) {
+        return false;
+      }
+    } else if (arg == "--capacity-factors") {
+      if (!ParseList(argv[++i], &options->capacity_factors)) {
+        return false;
+      }
+    } else if (arg == "--rates") {
+      if (!ParseList(argv[++i], &options->rates)) {
+        return false;
+      }
+    } else if (arg == "--latencies-ms") {
+      if (!ParseList(argv[++i], &options->latencies_ms)) {
+        return false;
+      }
+    } else if (arg == "--backend") {
+      if (!ParseBackend(argv[++i], &options->backends)) {
+        return false;
+      }
+    } else if (arg == "--pin") {
+      if (!ParsePinning(argv[++i], &options->pinnings)) {
+        return false;
+      }
+    } else if (arg == "--frames") {
+      options->total_frames = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+  return options->total_frames > 0;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--chunks 64,256,...] [--channels 1,2,...] [--capacity-factors 2,4,...]"
+                 " [--rates 44100,48000,...] [--latencies-ms 20,2000,...]"
+                 " [--backend heap|mirrored|all] [--pin none|same|split|all] [--frames TOTAL]\n";
+    return 1;
+  }
+  if (std::thread::hardware_concurrency() < 2) {
+    std::cerr << "warning: fewer than two hardware threads; split pinning shares one core.\n";
+  }
+
+  std::cout << "frames/run=" << options.total_frames
+            << "  latency columns are ns/frame per successful call (p50/p99/p99.9/max)\n";
+  std::cout << std::setw(6) << "chunk" << std::setw(4) << "ch" << std::setw(8) << "cap"
+            << std::setw(5) << "idx" << std::setw(8) << "backend" << std::setw(7) << "pin"
+            << std::setw(10) << "Mfr/s" << "  " << std::left << std::setw(30) << "write"
+            << std::setw(30) << "read" << std::right << "\n";
+  for (const StorageBackend backend : options.backends) {
+    for (const Pinning pinning : options.pinnings) {
+      for (const uint32_t channels : options.channels) {
+        for (const uint32_t chunk : options.chunks) {
+          for (const uint32_t capacity : CapacitiesFor(chunk, options)) {
+            RunResult result =
+                RunOnce(chunk, channels, capacity, backend, pinning, options.total_frames);
+            const auto format = [](const Percentiles& p) {
+              std::ostringstream out;
+              out << std::fixed << std::setprecision(2) << p.p50 << "/" << p.p99 << "/"
+                  << p.p999 << "/" << p.max;
+              return out.str();
+            };
+            std::cout << std::setw(6) << chunk << std::setw(4) << channels << std::setw(8)
+                      << result.capacity_frames << std::setw(5)
+                      << (result.uses_index_mask ? "mask" : "mod") << std::setw(7)
+                      << BackendName(result.backend) << (result.backend == backend ? " " : "!")
+                      << std::setw(6) << PinningName(pinning) << (result.pinned ? " " : "*")
+                      << std::fixed << std::setprecision(1) << std::setw(9)
+                      << result.mframes_per_second << "  " << std::left << std::setw(30)
+                      << format(result.write_ns_per_frame) << std::setw(30)
+                      << format(result.read_ns_per_frame) << std::right << "\n";
+          }
+        }
+      }
+    }
+  }
+  std::cout << "(* = affinity request refused; thread ran unpinned."
+               " ! = mirrored mapping unavailable; ran on the heap)\n";
+  return 0;
+}
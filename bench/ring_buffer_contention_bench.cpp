@@ -0,0 +1,281 @@
+// Contention benchmark: SPSC throughput of the packed index layout versus the split one.
+// Both reference rings are minimal (copy in, copy out, indices and counters only; no
+// markers, flush, waits or taps), so the gain column isolates the layout:
+// - packed keeps both indices and all counters adjacent and reloads the peer index on every
+//   call, which is what AudioRingBuffer did before the cache-line split;
+// - split puts each side's index, cached peer index and counter on its own cache line and
+//   reloads the peer only when the cached view falls short.
+// The full AudioRingBuffer column shows what its markers, flush checks and waiter checks cost
+// on top of the split layout; full/packed is the number to watch at small chunks.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "buffer/audio_ring_buffer.h"
+
+namespace {
+
+// Wrapping copy shared by the reference rings (modulo indexing, as before the split).
+void CopyFrames(uint32_t capacity_frames,
+                uint32_t channels,
+                float* dst,
+                uint64_t pos,
+                const float* src,
+                uint32_t frames,
+                bool to_ring) {
+  const uint32_t index = static_cast<uint32_t>(pos % capacity_frames);
+  const uint32_t first = std::min(frames, capacity_frames - index);
+  const size_t ring_offset = static_cast<size_t>(index) * channels;
+  const size_t first_samples = static_cast<size_t>(first) * channels;
+  const size_t second_samples = static_cast<size_t>(frames - first) * channels;
+  if (to_ring) {
+    std::memcpy(dst + ring_offset, src, first_samples * sizeof(float));
+    std::memcpy(dst, src + first_samples, second_samples * sizeof(float));
+  } else {
+    std::memcpy(dst, src + ring_offset, first_samples * sizeof(float));
+    std::memcpy(dst + first_samples, src, second_samples * sizeof(float));
+  }
+}
+
+// Reference copy of the pre-split layout; same algorithm, no cached peer indices.
+class PackedLayoutRing {
+public:
+  PackedLayoutRing(uint32_t capacity_frames, uint32_t channels)
+      : capacity_frames_(capacity_frames),
+        channels_(channels),
+        storage_(static_cast<size_t>(capacity_frames) * channels) {}
+
+  uint32_t write_frames(const float* src, uint32_t frames_requested) {
+    const uint64_t read_pos = read_pos_frames_.load(std::memory_order_acquire);
+    const uint64_t write_pos = write_pos_frames_.load(std::memory_order_relaxed);
+    const uint32_t available =
+        capacity_frames_ - static_cast<uint32_t>(write_pos - read_pos);
+    const uint32_t frames = std::min(frames_requested, available);
+    if (frames < frames_requested) {
+      overrun_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (frames == 0) {
+      return 0;
+    }
+    CopyFrames(capacity_frames_, channels_, storage_.data(), write_pos, src, frames, true);
+    write_pos_frames_.store(write_pos + frames, std::memory_order_release);
+    return frames;
+  }
+
+  uint32_t read_frames(float* dst, uint32_t frames_requested) {
+    const uint64_t write_pos = write_pos_frames_.load(std::memory_order_acquire);
+    const uint64_t read_pos = read_pos_frames_.load(std::memory_order_relaxed);
+    const uint32_t available = static_cast<uint32_t>(write_pos - read_pos);
+    const uint32_t frames = std::min(frames_requested, available);
+    if (frames < frames_requested) {
+      underrun_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (frames == 0) {
+      return 0;
+    }
+    CopyFrames(capacity_frames_, channels_, dst, read_pos, storage_.data(), frames, false);
+    read_pos_frames_.store(read_pos + frames, std::memory_order_release);
+    return frames;
+  }
+
+private:
+  uint32_t capacity_frames_{0};
+  uint32_t channels_{0};
+  std::vector<float> storage_;
+
+  std::atomic<uint64_t> write_pos_frames_{0};
+  std::atomic<uint64_t> read_pos_frames_{0};
+  std::atomic<uint64_t> underrun_count_{0};
+  std::atomic<uint64_t> overrun_count_{0};
+  std::atomic<uint64_t> invariant_violation_count_{0};
+};
+
+// Minimal copy of the split layout: PackedLayoutRing with cache-line separated sides and
+// cached peer indices.
+class SplitLayoutRing {
+public:
+  SplitLayoutRing(uint32_t capacity_frames, uint32_t channels)
+      : capacity_frames_(capacity_frames),
+        channels_(channels),
+        storage_(static_cast<size_t>(capacity_frames) * channels) {}
+
+  uint32_t write_frames(const float* src, uint32_t frames_requested) {
+    const uint64_t write_pos = write_pos_frames_.load(std::memory_order_relaxed);
+    uint32_t available =
+        capacity_frames_ - static_cast<uint32_t>(write_pos - cached_read_pos_frames_);
+    if (available < frames_requested) {
+      cached_read_pos_frames_ = read_pos_frames_.load(std::memory_order_acquire);
+      available = capacity_frames_ - static_cast<uint32_t>(write_pos - cached_read_pos_frames_);
+    }
+    const uint32_t frames = std::min(frames_requested, available);
+    if (frames < frames_requested) {
+      overrun_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (frames == 0) {
+      return 0;
+    }
+    CopyFrames(capacity_frames_, channels_, storage_.data(), write_pos, src, frames, true);
+    write_pos_frames_.store(write_pos + frames, std::memory_order_release);
+    return frames;
+  }
+
+  uint32_t read_frames(float* dst, uint32_t frames_requested) {
+    const uint64_t read_pos = read_pos_frames_.load(std::memory_order_relaxed);
+    uint32_t available = static_cast<uint32_t>(cached_write_pos_frames_ - read_pos);
+    if (available < frames_requested) {
+      cached_write_pos_frames_ = write_pos_frames_.load(std::memory_order_acquire);
+      available = static_cast<uint32_t>(cached_write_pos_frames_ - read_pos);
+    }
+    const uint32_t frames = std::min(frames_requested, available);
+    if (frames < frames_requested) {
+      underrun_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (frames == 0) {
+      return 0;
+    }
+    CopyFrames(capacity_frames_, channels_, dst, read_pos, storage_.data(), frames, false);
+    read_pos_frames_.store(read_pos + frames, std::memory_order_release);
+    return frames;
+  }
+
+private:
+  static constexpr size_t kCacheLineBytes = 64;
+
+  uint32_t capacity_frames_{0};
+  uint32_t channels_{0};
+  std::vector<float> storage_;
+
+  alignas(kCacheLineBytes) std::atomic<uint64_t> write_pos_frames_{0};
+  uint64_t cached_read_pos_frames_{0};
+  std::atomic<uint64_t> overrun_count_{0};
+
+  alignas(kCacheLineBytes) std::atomic<uint64_t> read_pos_frames_{0};
+  uint64_t cached_write_pos_frames_{0};
+  std::atomic<uint64_t> underrun_count_{0};
+};
+
+struct Options {
+  uint32_t channels = 2;
+  uint32_t capacity_frames = 4096;
+  uint64_t total_frames = 50'000'000;
+  int repeats = 3;
+};
+
+// Producer and consumer spin to maximize index traffic between the cores; they only yield
+// on single-core hosts, where spinning would just burn the peer's time slice.
+template <typename Ring>
+double RunOnce(const Options& options, uint32_t chunk_frames) {
+  Ring ring(options.capacity_frames, options.channels);
+  std::atomic<bool> go{false};
+  const bool yield_when_idle = std::thread::hardware_concurrency() < 2;
+
+  std::thread producer([&]() {
+    std::vector<float> chunk(static_cast<size_t>(chunk_frames) * options.channels, 0.25f);
+    while (!go.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    uint64_t sent = 0;
+    while (sent < options.total_frames) {
+      const uint64_t remaining = options.total_frames - sent;
+      const uint32_t frames =
+          static_cast<uint32_t>(std::min<uint64_t>(remaining, chunk_frames));
+      const uint32_t written = ring.write_frames(chunk.data(), frames);
+      sent += written;
+      if (written == 0 && yield_when_idle) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::vector<float> chunk(static_cast<size_t>(chunk_frames) * options.channels);
+  const auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  uint64_t received = 0;
+  while (received < options.total_frames) {
+    const uint32_t read = ring.read_frames(chunk.data(), chunk_frames);
+    received += read;
+    if (read == 0 && yield_when_idle) {
+      std::this_thread::yield();
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  producer.join();
+
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  return static_cast<double>(options.total_frames) / seconds / 1e6;
+}
+
+template <typename Ring>
+double BestOf(const Options& options, uint32_t chunk_frames) {
+  double best = 0.0;
+  for (int i = 0; i < options.repeats; ++i) {
+    best = std::max(best, RunOnce<Ring>(options, chunk_frames));
+  }
+  return best;
+}
+
+bool ParseArgs(int argc, char* argv[], Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--channels" && i + 1 < argc) {
+      options->channels = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+      continue;
+    }
+    if (arg == "--capacity" && i + 1 < argc) {
+      options->capacity_frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+      continue;
+    }
+    if (arg == "--frames" && i + 1 < argc) {
+      options->total_frames = std::strtoull(argv[++i], nullptr, 10);
+      continue;
+    }
+    if (arg == "--repeat" && i + 1 < argc) {
+      options->repeats = std::max(1, static_cast<int>(std::strtol(argv[++i], nullptr, 10)));
+      continue;
+    }
+    return false;
+  }
+  return options->channels > 0 && options->capacity_frames > 0 && options->total_frames > 0;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--channels N] [--capacity FRAMES] [--frames TOTAL] [--repeat N]\n";
+    return 1;
+  }
+  if (std::thread::hardware_concurrency() < 2) {
+    std::cerr << "warning: fewer than two hardware threads; contention is not exercised.\n";
+  }
+
+  std::cout << "channels=" << options.channels << " capacity=" << options.capacity_frames
+            << " frames=" << options.total_frames << " (best of " << options.repeats
+            << ", Mframes/s)\n";
+  std::cout << std::setw(8) << "chunk" << std::setw(12) << "packed" << std::setw(12)
+            << "split" << std::setw(10) << "gain" << std::setw(12) << "full" << std::setw(12)
+            << "full/packed" << "\n";
+  for (uint32_t chunk_frames : {1u, 4u, 16u, 64u, 256u, 1024u}) {
+    if (chunk_frames > options.capacity_frames) {
+      continue;
+    }
+    const double packed = BestOf<PackedLayoutRing>(options, chunk_frames);
+    const double split = BestOf<SplitLayoutRing>(options, chunk_frames);
+    const double full = BestOf<AudioRingBuffer>(options, chunk_frames);
+    std::cout << std::setw(8) << chunk_frames << std::fixed << std::setprecision(1)
+              << std::setw(12) << packed << std::setw(12) << split << std::setw(9)
+              << std::setprecision(2) << split / packed << "x" << std::setprecision(1)
+              << std::setw(12) << full << std::setprecision(2) << std::setw(11)
+              << full / packed << "x" << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,286 @@
+#include "audio/alsa_output.h"
+
+#include "buffer/audio_ring_buffer.h"
+
+#include <alsa/asoundlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+
+namespace tomplayer {
+namespace alsa {
+namespace {
+
+struct FormatChoice {
+  snd_pcm_format_t alsa;
+  SampleFormat format;
+};
+
+// Preference order: float32 is the ring's own format (a plain copy); integer formats go
+// through the shared conversion kernels, widest first.
+constexpr FormatChoice kFormatPreference[] = {
+    {SND_PCM_FORMAT_FLOAT_LE, SampleFormat::Float32},
+    {SND_PCM_FORMAT_S32_LE, SampleFormat::Pcm32},
+    {SND_PCM_FORMAT_S24_3LE, SampleFormat::Pcm24},
+    {SND_PCM_FORMAT_S16_LE, SampleFormat::Pcm16},
+};
+}  // namespace
+
+AlsaOutput::AlsaOutput() : AlsaOutput(Config{}) {}
+
+AlsaOutput::AlsaOutput(const Config& config) : config_(config) {}
+
+AlsaOutput::~AlsaOutput() {
+  shutdown();
+}
+
+bool AlsaOutput::init_default_device() {
+  if (pcm_) {
+    return false;
+  }
+  if (config_.channels == 0 || config_.periods == 0) {
+    return false;
+  }
+  // Non-blocking: the render thread only touches the PCM after poll() says it may.
+  if (snd_pcm_open(&pcm_, config_.device.c_str(), SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK) <
+      0) {
+    pcm_ = nullptr;
+    return false;
+  }
+
+  snd_pcm_hw_params_t* hw = nullptr;
+  snd_pcm_hw_params_alloca(&hw);
+  if (snd_pcm_hw_params_any(pcm_, hw) < 0 ||
+      snd_pcm_hw_params_set_access(pcm_, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0) {
+    shutdown();
+    return false;
+  }
+  const FormatChoice* choice = nullptr;
+  for (const FormatChoice& candidate : kFormatPreference) {
+    if (snd_pcm_hw_params_test_format(pcm_, hw, candidate.alsa) == 0) {
+      choice = &candidate;
+      break;
+    }
+  }
+  if (!choice || snd_pcm_hw_params_set_format(pcm_, hw, choice->alsa) < 0 ||
+      snd_pcm_hw_params_set_channels(pcm_, hw, config_.channels) < 0) {
+    shutdown();
+    return false;
+  }
+  unsigned int rate = config_.sample_rate;
+  if (snd_pcm_hw_params_set_rate_near(pcm_, hw, &rate, nullptr) < 0) {
+    shutdown();
+    return false;
+  }
+
+  // Period from the latency target at the negotiated rate; the buffer holds config.periods.
+  const uint32_t latency_frames = AudioRingBufferTypes::frames_for_latency(rate, config_.latency);
+  snd_pcm_uframes_t period = std::max<uint32_t>(latency_frames / config_.periods, 1);
+  snd_pcm_uframes_t buffer = period * config_.periods;
+  if (snd_pcm_hw_params_set_period_size_near(pcm_, hw, &period, nullptr) < 0 ||
+      snd_pcm_hw_params_set_buffer_size_near(pcm_, hw, &buffer) < 0 ||
+      snd_pcm_hw_params(pcm_, hw) < 0 ||
+      snd_pcm_hw_params_get_period_size(hw, &period, nullptr) < 0 ||
+      snd_pcm_hw_params_get_buffer_size(hw, &buffer) < 0) {
+    shutdown();
+    return false;
+  }
+
+  // Wake once a period is writable; start by itself once the first cycle fills the buffer.
+  snd_pcm_sw_params_t* sw = nullptr;
+  snd_pcm_sw_params_alloca(&sw);
+  if (snd_pcm_sw_params_current(pcm_, sw) < 0 ||
+      snd_pcm_sw_params_set_avail_min(pcm_, sw, period) < 0 ||
+      snd_pcm_sw_params_set_start_threshold(pcm_, sw, buffer) < 0 ||
+      snd_pcm_sw_params(pcm_, sw) < 0) {
+    shutdown();
+    return false;
+  }
+
+  const int descriptor_count = snd_pcm_poll_descriptors_count(pcm_);
+  stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (descriptor_count <= 0 || stop_fd_ < 0) {
+    shutdown();
+    return false;
+  }
+  poll_fds_.assign(static_cast<size_t>(descriptor_count) + 1, pollfd{});
+  if (snd_pcm_poll_descriptors(pcm_, poll_fds_.data(), descriptor_count) != descriptor_count) {
+    shutdown();
+    return false;
+  }
+  poll_fds_.back() = pollfd{stop_fd_, POLLIN, 0};
+
+  sample_rate_ = rate;
+  channels_ = config_.channels;
+  period_frames_ = static_cast<uint32_t>(period);
+  buffer_frames_ = static_cast<uint32_t>(buffer);
+  sample_format_ = choice->format;
+  core_.configure(sample_format_, channels_, buffer_frames_, sample_rate_);
+
+  mmap_context_.pcm = pcm_;
+  mmap_context_.buffer_frames = buffer_frames_;
+  device_api_.context = &mmap_context_;
+  device_api_.GetPadding = [](void* context, uint32_t* padding) {
+    auto* ctx = static_cast<MmapContext*>(context);
+    const snd_pcm_sframes_t avail = snd_pcm_avail_update(ctx->pcm);
+    if (avail < 0) {
+      ctx->error = static_cast<int>(avail);
+      return false;
+    }
+    // avail can exceed the buffer after an xrun; the commit then fails and recovers.
+    const auto writable = static_cast<uint32_t>(
+        std::min<snd_pcm_sframes_t>(avail, static_cast<snd_pcm_sframes_t>(ctx->buffer_frames)));
+    *padding = ctx->buffer_frames - writable;
+    return true;
+  };
+  device_api_.GetBuffer = [](void* context, uint32_t frames, uint8_t** data, uint32_t* granted) {
+    auto* ctx = static_cast<MmapContext*>(context);
+    const snd_pcm_channel_area_t* areas = nullptr;
+    snd_pcm_uframes_t offset = 0;
+    snd_pcm_uframes_t contiguous = frames;
+    const int error = snd_pcm_mmap_begin(ctx->pcm, &areas, &offset, &contiguous);
+    if (error < 0) {
+      ctx->error = error;
+      return false;
+    }
+    // Interleaved access: channel 0's area addresses whole frames.
+    *data = static_cast<uint8_t*>(areas[0].addr) + areas[0].first / 8 +
+            offset * (areas[0].step / 8);
+    *granted = static_cast<uint32_t>(contiguous);
+    ctx->offset = offset;
+    return true;
+  };
+  device_api_.ReleaseBuffer = [](void* context, uint32_t frames, bool) {
+    auto* ctx = static_cast<MmapContext*>(context);
+    const snd_pcm_sframes_t committed = snd_pcm_mmap_commit(ctx->pcm, ctx->offset, frames);
+    if (committed < 0 || static_cast<uint32_t>(committed) != frames) {
+      ctx->error = committed < 0 ? static_cast<int>(committed) : -EPIPE;
+      return false;
+    }
+    return true;
+  };
+  return true;
+}
+
+void AlsaOutput::set_ring_buffer(AudioRingBuffer* ring_buffer) {
+  assert(!running_.load(std::memory_order_relaxed));
+  core_.set_ring_buffer(ring_buffer);
+}
+
+AudioRingBuffer* AlsaOutput::exchange_ring_buffer(AudioRingBuffer* ring_buffer) {
+  return core_.exchange_ring_buffer(ring_buffer);
+}
+
+bool AlsaOutput::start() {
+  if (!pcm_) {
+    return false;
+  }
+  AudioRingBuffer* ring_buffer = core_.ring_buffer();
+  if (!ring_buffer || ring_buffer->channels() != channels_) {
+    return false;
+  }
+  if (snd_pcm_prepare(pcm_) < 0) {
+    return false;
+  }
+  if (running_.exchange(true)) {
+    return false;
+  }
+  // Clear a stale stop request from the previous run.
+  uint64_t drained = 0;
+  [[maybe_unused]] const ssize_t ignored = read(stop_fd_, &drained, sizeof(drained));
+  core_.prepare(config_.dither);
+  timing_.restart();
+  render_thread_ = std::thread(&AlsaOutput::RenderLoop, this);
+  return true;
+}
+
+void AlsaOutput::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  const uint64_t wake = 1;
+  [[maybe_unused]] const ssize_t ignored = write(stop_fd_, &wake, sizeof(wake));
+  if (render_thread_.joinable()) {
+    render_thread_.join();
+  }
+  snd_pcm_drop(pcm_);
+  core_.halt();
+}
+
+void AlsaOutput::shutdown() {
+  stop();
+  if (pcm_) {
+    snd_pcm_close(pcm_);
+    pcm_ = nullptr;
+  }
+  if (stop_fd_ >= 0) {
+    close(stop_fd_);
+    stop_fd_ = -1;
+  }
+  poll_fds_.clear();
+  mmap_context_ = {};
+  device_api_ = {};
+  core_.configure(SampleFormat::Unsupported, 0, 0, 0);
+  sample_rate_ = 0;
+  channels_ = 0;
+  period_frames_ = 0;
+  buffer_frames_ = 0;
+  sample_format_ = SampleFormat::Unsupported;
+}
+
+void AlsaOutput::RenderLoop() {
+  thread_policy_.apply();
+  const int descriptor_count = static_cast<int>(poll_fds_.size()) - 1;
+  while (running_.load(std::memory_order_acquire)) {
+    if (poll(poll_fds_.data(), poll_fds_.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (poll_fds_.back().revents & POLLIN) {
+      break;
+    }
+
+    const auto wake = audio::RenderTiming::Clock::now();
+    timing_.begin_callback(wake);
+    unsigned short revents = 0;
+    if (snd_pcm_poll_descriptors_revents(pcm_, poll_fds_.data(), descriptor_count, &revents) <
+        0) {
+      break;
+    }
+    bool ok = true;
+    if (revents & POLLERR) {
+      // Starved device (xrun) or suspend: recover, then refill on the next wake.
+      ok = Recover(snd_pcm_state(pcm_) == SND_PCM_STATE_SUSPENDED ? -ESTRPIPE : -EPIPE);
+    } else if (revents & POLLOUT) {
+      ok = RenderAudio();
+    }
+    // Quiescent point: this cycle no longer holds a ring pointer (see render_grace_token).
+    core_.complete_cycle();
+    timing_.end_callback(wake, audio::RenderTiming::Clock::now());
+    if (!ok) {
+      break;
+    }
+  }
+}
+
+bool AlsaOutput::RenderAudio() {
+  const audio::RenderCycle cycle = core_.render(device_api_);
+  if (cycle.device_error) {
+    return Recover(mmap_context_.error);
+  }
+  return true;
+}
+
+bool AlsaOutput::Recover(int error) {
+  xrun_count_.fetch_add(1, std::memory_order_relaxed);
+  // silent = 1: xruns are reported through xrun_count(), not stderr.
+  return snd_pcm_recover(pcm_, error, 1) >= 0;
+}
+
+}  // namespace alsa
+}  // namespace tomplayer
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+
+#include "audio/audio_output.h"
+#include "audio/render_core.h"
+#include "audio/sample_convert.h"
+#include "buffer/audio_ring_buffer_fwd.h"
+
+// alsa/asoundlib.h stays out of this header; the engine only sees AudioOutput.
+typedef struct _snd_pcm snd_pcm_t;
+
+namespace tomplayer {
+namespace alsa {
+
+using audio::SampleFormat;
+
+// Summary: ALSA playback AudioOutput in mmap mode: the render thread waits in poll() and
+//   converts ring frames straight into the hardware buffer between snd_pcm_mmap_begin and
+//   snd_pcm_mmap_commit, so there is no intermediate copy.
+// Preconditions: same control-thread rules as AudioOutput.
+// Postconditions: counters match WasapiOutput semantics. rendered_frames_total counts every
+//   committed frame, silence included. Underruns count short ring reads; xruns (device
+//   starvation) are recovered and counted separately.
+// Errors: init_default_device fails if the device cannot be opened or does not support
+//   mmap interleaved access in a float32 or 16/24/32-bit PCM format.
+class AlsaOutput final : public audio::AudioOutput {
+public:
+  // Summary: Device request.
+  // Preconditions: none.
+  // Postconditions: copied at construction.
+  // Errors: none.
+  struct Config {
+    // Any ALSA PCM name. "null" and "file:FILE=out.raw,FORMAT=raw" are handy without hardware.
+    std::string device = "default";
+    uint32_t sample_rate = 48000;
+    uint16_t channels = 2;
+    // Device buffer latency; each period is latency / periods (rounded by the device).
+    std::chrono::microseconds latency{20000};
+    uint32_t periods = 2;
+    // Applied when the device takes an integer format (float32 is preferred).
+    audio::DitherMode dither = audio::DitherMode::Tpdf;
+  };
+
+  AlsaOutput();
+  explicit AlsaOutput(const Config& config);
+  ~AlsaOutput() override;
+
+  AlsaOutput(const AlsaOutput&) = delete;
+  AlsaOutput& operator=(const AlsaOutput&) = delete;
+
+  // Opens config.device and negotiates format, rate and period/buffer sizes.
+  bool init_default_device() override;
+  void set_ring_buffer(AudioRingBuffer* ring_buffer) override;
+  AudioRingBuffer* exchange_ring_buffer(AudioRingBuffer* ring_buffer) override;
+  uint64_t render_grace_token() const override { return core_.render_grace_token(); }
+  bool render_grace_period_elapsed(uint64_t token) const override {
+    return !running_.load(std::memory_order_acquire) || core_.cycle_completed_since(token);
+  }
+  // The stream starts itself once the first render cycle has filled the buffer.
+  bool start() override;
+  // Drops pending frames, like WasapiOutput's Stop + Reset.
+  void stop() override;
+  void shutdown() override;
+  bool is_running() const override { return running_.load(std::memory_order_acquire); }
+  uint32_t sample_rate() const override { return sample_rate_; }
+  uint16_t channels() const override { return channels_; }
+  SampleFormat sample_format() const override { return sample_format_; }
+  uint32_t buffer_frames() const override { return buffer_frames_; }
+  uint64_t underrun_wake_count() const override { return core_.underrun_wake_count(); }
+  uint64_t underrun_frame_count() const override { return core_.underrun_frame_count(); }
+  uint64_t rendered_frames_total() const override { return core_.rendered_frames_total(); }
+  void reset_rendered_frames() override { core_.reset_rendered_frames(); }
+  audio::RenderTiming& render_timing() override { return timing_; }
+  platform::ThreadPolicySlot& render_thread_policy() override { return thread_policy_; }
+  const audio::PresentationClock& presentation_clock() const override {
+    return core_.presentation_clock();
+  }
+  // Always the whole buffer: the stream starts once the buffer is full and avail_min wakes
+  // the render thread one period before it drains, so a partial fill would never start or
+  // would spin in poll.
+  uint32_t set_fill_frames(uint32_t) override { return buffer_frames_; }
+
+  // Summary: Negotiated period size in frames (the poll wake granularity).
+  // Preconditions: init_default_device succeeded.
+  // Postconditions: none.
+  // Errors: returns 0 if uninitialized.
+  uint32_t period_frames() const { return period_frames_; }
+
+  // Summary: Device xruns recovered since construction.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint64_t xrun_count() const { return xrun_count_.load(std::memory_order_relaxed); }
+
+private:
+  // Summary: Render thread body; polls the PCM and the stop eventfd.
+  // Preconditions: start() succeeded.
+  // Postconditions: exits when stop() signals or the device fails unrecoverably.
+  // Errors: none.
+  void RenderLoop();
+
+  // Summary: Single render cycle through the render core: avail_update gives the padding,
+  //   then mmap_begin/mmap_commit once per contiguous area of the (possibly wrapping)
+  //   writable space.
+  // Preconditions: render thread only.
+  // Postconditions: committed frames are counted; xruns are recovered.
+  // Errors: returns false if the device cannot be recovered.
+  bool RenderAudio();
+
+  // Summary: State behind the render core's DeviceBufferApi for the mmap cycle.
+  // Preconditions: render thread only.
+  // Postconditions: error holds the negative ALSA error of the hook that failed.
+  // Errors: none.
+  struct MmapContext {
+    snd_pcm_t* pcm{nullptr};
+    uint32_t buffer_frames{0};
+    // mmap_begin's offset, committed by the matching ReleaseBuffer.
+    unsigned long offset{0};
+    int error{0};
+  };
+
+  // Summary: snd_pcm_recover wrapper that counts xruns.
+  // Preconditions: render thread only.
+  // Postconditions: the PCM is prepared again on success.
+  // Errors: returns false if recovery failed.
+  bool Recover(int error);
+
+  const Config config_;
+  snd_pcm_t* pcm_{nullptr};
+  int stop_fd_{-1};
+  // PCM descriptors followed by stop_fd_; sized in init so the render loop never allocates.
+  std::vector<pollfd> poll_fds_;
+
+  std::thread render_thread_;
+  std::atomic<bool> running_{false};
+
+  uint32_t sample_rate_{0};
+  uint16_t channels_{0};
+  uint32_t period_frames_{0};
+  uint32_t buffer_frames_{0};
+  SampleFormat sample_format_{SampleFormat::Unsupported};
+
+  MmapContext mmap_context_;
+  audio::DeviceBufferApi device_api_{};
+  audio::RenderCore core_;
+  std::atomic<uint64_t> xrun_count_{0};
+  audio::RenderTiming timing_;
+  platform::ThreadPolicySlot thread_policy_;
+};
+
+}  // namespace alsa
+}  // namespace tomplayer
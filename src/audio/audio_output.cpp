@@ -0,0 +1,23 @@
+#include "audio/audio_output.h"
+
+#if defined(_WIN32)
+#include "audio/wasapi_output.h"
+#elif defined(TOMPLAYER_HAS_ALSA)
+#include "audio/alsa_output.h"
+#endif
+
+namespace tomplayer {
+namespace audio {
+
+std::unique_ptr<AudioOutput> CreateDefaultAudioOutput() {
+#if defined(_WIN32)
+  return std::make_unique<wasapi::WasapiOutput>();
+#elif defined(TOMPLAYER_HAS_ALSA)
+  return std::make_unique<alsa::AlsaOutput>();
+#else
+  return nullptr;
+#endif
+}
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "audio/presentation_clock.h"
+#include "audio/render_timing.h"
+#include "buffer/audio_ring_buffer_fwd.h"
+#include "platform/thread_priority.h"
+
+namespace tomplayer {
+namespace audio {
+
+// Device sample format the backend renders to (the ring always carries float32; see
+// audio/sample_convert.h for the conversion into integer formats).
+enum class SampleFormat {
+  Float32,
+  Pcm16,
+  // Packed 3-byte little-endian samples.
+  Pcm24,
+  // Full 32-bit container; also covers 24-in-32 (MSB-aligned) device formats.
+  Pcm32,
+  Unsupported
+};
+
+// Summary: Platform-neutral audio device sink that pulls frames from an AudioRingBuffer on
+//   its own render thread. The engine programs against this; WasapiOutput is one backend.
+// Preconditions: init_default_device, start, stop and shutdown are called from one control
+//   thread. Format accessors (sample_rate, channels, sample_format, buffer_frames) are
+//   written by init_default_device and read on that thread only; counters may be read from
+//   any thread.
+// Postconditions: start/stop control the render thread lifecycle deterministically.
+// Errors: methods return false on initialization or start failures.
+class AudioOutput {
+public:
+  virtual ~AudioOutput() = default;
+
+  // Summary: Open the default device and fix the mix format.
+  // Preconditions: not initialized (or shut down since).
+  // Postconditions: sample_rate/channels/sample_format describe the device on success.
+  // Errors: returns false if no device could be opened; any backend setup (e.g. COM) is
+  //   undone by shutdown().
+  virtual bool init_default_device() = 0;
+
+  // Summary: Set the ring buffer the render thread reads from.
+  // Preconditions: called before start(); buffer outlives stop()/shutdown().
+  // Postconditions: the next start() renders from ring_buffer.
+  // Errors: none.
+  virtual void set_ring_buffer(AudioRingBuffer* ring_buffer) = 0;
+
+  // Summary: Publish a replacement ring buffer to the render thread (RCU-style swap).
+  // Preconditions: ring_buffer is non-null and outlives its use; safe while running.
+  // Postconditions: the next render cycle reads from ring_buffer. The returned previous
+  //   buffer may still be read by the in-flight cycle; reclaim it only once
+  //   render_grace_period_elapsed(token) is true for a token taken after this call.
+  // Errors: a buffer whose channel count differs from the device renders silence.
+  virtual AudioRingBuffer* exchange_ring_buffer(AudioRingBuffer* ring_buffer) = 0;
+
+  // Summary: Token for render_grace_period_elapsed, sampled after exchange_ring_buffer.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  virtual uint64_t render_grace_token() const = 0;
+
+  // Summary: True once no render cycle can still hold a ring pointer loaded before token.
+  // Preconditions: called on the control thread.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  virtual bool render_grace_period_elapsed(uint64_t token) const = 0;
+
+  // Summary: Start the render thread.
+  // Preconditions: init_default_device succeeded; a ring buffer with matching channels is set.
+  // Postconditions: is_running() is true on success.
+  // Errors: returns false if the device could not be started.
+  virtual bool start() = 0;
+
+  // Summary: Stop rendering and join the render thread.
+  // Preconditions: none (safe if not running).
+  // Postconditions: no render callbacks execute after return.
+  // Errors: none.
+  virtual void stop() = 0;
+
+  // Summary: Stop and release every device resource.
+  // Preconditions: none.
+  // Postconditions: object returns to the uninitialized state.
+  // Errors: none.
+  virtual void shutdown() = 0;
+
+  // Summary: Whether the render thread is running (between start() and stop()).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  virtual bool is_running() const = 0;
+
+  // Summary: Device sample rate in Hz.
+  // Preconditions: init_default_device succeeded; control thread.
+  // Postconditions: none.
+  // Errors: returns 0 if uninitialized.
+  virtual uint32_t sample_rate() const = 0;
+
+  // Summary: Device channel count.
+  // Preconditions: init_default_device succeeded; control thread.
+  // Postconditions: none.
+  // Errors: returns 0 if uninitialized.
+  virtual uint16_t channels() const = 0;
+
+  // Summary: Device sample format.
+  // Preconditions: init_default_device succeeded; control thread.
+  // Postconditions: none.
+  // Errors: Unsupported if the format is not handled.
+  virtual SampleFormat sample_format() const = 0;
+
+  // Summary: Device buffer size in frames (one render period's worth or more).
+  // Preconditions: init_default_device succeeded; control thread.
+  // Postconditions: none.
+  // Errors: returns 0 if uninitialized.
+  virtual uint32_t buffer_frames() const = 0;
+
+  // Summary: Number of render wakes that saw a short read.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  virtual uint64_t underrun_wake_count() const = 0;
+
+  // Summary: Number of frames zero-filled due to underrun.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  virtual uint64_t underrun_frame_count() const = 0;
+
+  // Summary: Number of frames handed to the device since the last reset.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  virtual uint64_t rendered_frames_total() const = 0;
+
+  // Summary: Reset the rendered frame counter (control thread only).
+  // Preconditions: render thread stopped or quiescent.
+  // Postconditions: rendered_frames_total returns 0.
+  // Errors: none.
+  virtual void reset_rendered_frames() = 0;
+
+  // Summary: Render thread timing owned by the output: wake-to-wake intervals, callback
+  //   execution time and deadline overruns.
+  // Preconditions: none; the returned object is safe to read and configure from any thread.
+  // Postconditions: lives as long as the output.
+  // Errors: none.
+  virtual RenderTiming& render_timing() = 0;
+
+  // Summary: Scheduling policy the render thread applies when start() launches it, and the
+  //   report of what the OS granted.
+  // Preconditions: set the policy before start(); it takes effect on the next start.
+  // Postconditions: lives as long as the output; report() reflects the latest start.
+  // Errors: none; refusals show up in the report.
+  virtual tomplayer::platform::ThreadPolicySlot& render_thread_policy() = 0;
+
+  // Summary: Ring audio handed to the device and not yet audible (device buffer plus any
+  //   pipeline latency the backend reports), interpolated between render cycles.
+  // Preconditions: none; read it with the clock's seqlock protocol from any thread.
+  // Postconditions: lives as long as the output; empty after start(), held after stop().
+  // Errors: none; outputs with no device queue report 0.
+  virtual const PresentationClock& presentation_clock() const = 0;
+
+  // Summary: Keep at most frames queued in the device instead of the whole buffer, for
+  //   adaptive latency.
+  // Preconditions: none; safe while running.
+  // Postconditions: later render cycles top the device up to the returned depth: frames
+  //   clamped to what the backend can run with (at least one device period, at most
+  //   buffer_frames()). Cleared by init_default_device.
+  // Errors: none; returns 0 for outputs without a device queue.
+  virtual uint32_t set_fill_frames(uint32_t frames) = 0;
+};
+
+// Summary: Create the platform's default output backend (WASAPI on Windows, ALSA on Linux
+//   builds with alsa-lib).
+// Preconditions: none.
+// Postconditions: the returned output is uninitialized.
+// Errors: returns nullptr when this build has no backend for the platform.
+std::unique_ptr<AudioOutput> CreateDefaultAudioOutput();
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,316 @@
+#include "audio/file_output.h"
+
+#include "buffer/audio_ring_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+
+namespace tomplayer {
+namespace audio {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+static_assert(std::endian::native == std::endian::little,
+              "FileOutput writes float32 ring samples to disk as-is (little-endian)");
+
+constexpr uint16_t kWaveFormatPcm = 1;
+constexpr uint16_t kWaveFormatIeeeFloat = 3;
+constexpr uint16_t kWaveFormatExtensible = 0xFFFE;
+// KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT: the format tag as Data1, then this fixed tail.
+constexpr std::array<uint8_t, 12> kSubtypeGuidTail = {0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+                                                      0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+// Plain WAVEFORMAT for mono/stereo float and 16-bit PCM; WAVEFORMATEXTENSIBLE (40-byte fmt)
+// above two channels or 16 bits, as the format spec asks.
+constexpr size_t kWavHeaderBytes = 44;
+constexpr size_t kWavExtensibleHeaderBytes = 68;
+// Sink thread sleeps at most this long waiting for the producer, bounding stop() latency.
+constexpr auto kDataWaitTimeout = std::chrono::milliseconds(10);
+
+class HeaderWriter {
+public:
+  explicit HeaderWriter(uint8_t* out) : out_(out) {}
+  void Tag(const char (&tag)[5]) { Bytes(reinterpret_cast<const uint8_t*>(tag), 4); }
+  void U16(uint16_t value) {
+    const uint8_t bytes[2] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)};
+    Bytes(bytes, 2);
+  }
+  void U32(uint32_t value) {
+    U16(static_cast<uint16_t>(value));
+    U16(static_cast<uint16_t>(value >> 16));
+  }
+  void Bytes(const uint8_t* bytes, size_t count) {
+    std::memcpy(out_ + offset_, bytes, count);
+    offset_ += count;
+  }
+  size_t size() const { return offset_; }
+
+private:
+  uint8_t* out_;
+  size_t offset_ = 0;
+};
+
+// RIFF sizes are 32-bit; longer renders keep writing samples but clamp the header fields.
+// An odd-sized data chunk is followed by a pad byte, which RIFF counts but the data size
+// does not (Pcm24 with an odd channels x frames product).
+size_t BuildWavHeader(SampleFormat format,
+                      uint16_t channels,
+                      uint32_t sample_rate,
+                      uint64_t data_bytes,
+                      std::array<uint8_t, kWavExtensibleHeaderBytes>* header) {
+  const uint16_t bits = static_cast<uint16_t>(BytesPerSample(format) * 8);
+  const uint16_t format_tag =
+      format == SampleFormat::Float32 ? kWaveFormatIeeeFloat : kWaveFormatPcm;
+  const bool extensible = channels > 2 || (format_tag == kWaveFormatPcm && bits > 16);
+  const size_t header_bytes = extensible ? kWavExtensibleHeaderBytes : kWavHeaderBytes;
+  const uint64_t riff_bytes = data_bytes + (data_bytes & 1) + header_bytes - 8;
+  const uint16_t block_align = static_cast<uint16_t>(channels * BytesPerSample(format));
+
+  HeaderWriter writer(header->data());
+  writer.Tag("RIFF");
+  writer.U32(static_cast<uint32_t>(std::min<uint64_t>(riff_bytes, UINT32_MAX)));
+  writer.Tag("WAVE");
+  writer.Tag("fmt ");
+  writer.U32(extensible ? 40 : 16);
+  writer.U16(extensible ? kWaveFormatExtensible : format_tag);
+  writer.U16(channels);
+  writer.U32(sample_rate);
+  writer.U32(sample_rate * block_align);
+  writer.U16(block_align);
+  writer.U16(bits);
+  if (extensible) {
+    writer.U16(22);
+    writer.U16(bits);
+    // Channel mask 0: no speaker assignment (channel order is the ring's).
+    writer.U32(0);
+    writer.U32(format_tag);
+    writer.Bytes(kSubtypeGuidTail.data(), kSubtypeGuidTail.size());
+  }
+  writer.Tag("data");
+  writer.U32(static_cast<uint32_t>(std::min<uint64_t>(data_bytes, UINT32_MAX)));
+  assert(writer.size() == header_bytes);
+  return header_bytes;
+}
+}  // namespace
+
+FileOutput::FileOutput(const Config& config) : config_(config) {}
+
+FileOutput::~FileOutput() {
+  shutdown();
+}
+
+bool FileOutput::init_default_device() {
+  const uint32_t bytes_per_sample = BytesPerSample(config_.sample_format);
+  if (file_ || config_.path.empty() || config_.sample_rate == 0 || config_.channels == 0 ||
+      config_.block_frames == 0 || bytes_per_sample == 0) {
+    return false;
+  }
+  file_ = std::fopen(config_.path.c_str(), "wb");
+  if (!file_) {
+    return false;
+  }
+  // Large stdio buffer: ring spans go to disk in few syscalls without a staging copy.
+  std::setvbuf(file_, nullptr, _IOFBF, size_t{1} << 20);
+
+  sample_rate_ = config_.sample_rate;
+  channels_ = config_.channels;
+  block_frames_ = config_.block_frames;
+  if (config_.sample_format != SampleFormat::Float32) {
+    scratch_.assign(static_cast<size_t>(block_frames_) * channels_ * bytes_per_sample, 0);
+  }
+  frames_written_.store(0, std::memory_order_relaxed);
+  frames_drained_total_.store(0, std::memory_order_relaxed);
+  write_error_.store(false, std::memory_order_relaxed);
+  tail_pad_ = false;
+  patched_frames_ = 0;
+  run_time_ = {};
+
+  if (config_.container == Container::Wav) {
+    std::array<uint8_t, kWavExtensibleHeaderBytes> header{};
+    const size_t header_bytes =
+        BuildWavHeader(config_.sample_format, channels_, sample_rate_, 0, &header);
+    if (std::fwrite(header.data(), 1, header_bytes, file_) != header_bytes) {
+      shutdown();
+      return false;
+    }
+  }
+  return true;
+}
+
+void FileOutput::set_ring_buffer(AudioRingBuffer* ring_buffer) {
+  assert(!running_.load(std::memory_order_relaxed));
+  ring_slot_.set(ring_buffer);
+}
+
+AudioRingBuffer* FileOutput::exchange_ring_buffer(AudioRingBuffer* ring_buffer) {
+  return ring_slot_.exchange(ring_buffer);
+}
+
+bool FileOutput::start() {
+  if (!file_) {
+    return false;
+  }
+  AudioRingBuffer* ring_buffer = ring_slot_.current();
+  if (!ring_buffer || ring_buffer->channels() != channels_) {
+    return false;
+  }
+  if (running_.exchange(true)) {
+    return false;
+  }
+  run_started_ = Clock::now();
+  dither_.reset(config_.dither);
+  timing_.restart();
+  render_thread_ = std::thread(&FileOutput::RenderLoop, this);
+  return true;
+}
+
+void FileOutput::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  if (render_thread_.joinable()) {
+    render_thread_.join();
+  }
+  run_time_ += Clock::now() - run_started_;
+  PatchHeader();
+}
+
+void FileOutput::shutdown() {
+  stop();
+  if (file_) {
+    PatchHeader();
+    if (std::fclose(file_) != 0) {
+      write_error_.store(true, std::memory_order_release);
+    }
+    file_ = nullptr;
+  }
+  sample_rate_ = 0;
+  channels_ = 0;
+  block_frames_ = 0;
+  scratch_.clear();
+  scratch_.shrink_to_fit();
+}
+
+double FileOutput::speed_factor() const {
+  Clock::duration elapsed = run_time_;
+  if (running_.load(std::memory_order_acquire)) {
+    elapsed += Clock::now() - run_started_;
+  }
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  const uint64_t frames = frames_drained_total_.load(std::memory_order_relaxed);
+  if (seconds <= 0.0 || frames == 0 || config_.sample_rate == 0) {
+    return 0.0;
+  }
+  return static_cast<double>(frames) / config_.sample_rate / seconds;
+}
+
+void FileOutput::RenderLoop() {
+  thread_policy_.apply();
+  const size_t frame_bytes =
+      static_cast<size_t>(channels_) * BytesPerSample(config_.sample_format);
+  while (running_.load(std::memory_order_acquire)) {
+    // Load once per cycle: the engine may swap in a resized ring.
+    AudioRingBuffer* ring_buffer = ring_slot_.load_for_cycle();
+    if (!ring_buffer || ring_buffer->channels() != channels_) {
+      ring_slot_.complete_cycle();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+
+    const AudioRingBuffer::ReadRegion region = ring_buffer->acquire_read(block_frames_);
+    if (region.frames == 0) {
+      // No device clock: wait for the producer instead of inventing silence.
+      ring_buffer->wait_readable(1, kDataWaitTimeout);
+      ring_slot_.complete_cycle();
+      continue;
+    }
+    // Timed from the moment data is available: intervals show the drain cadence and
+    // callbacks the conversion plus file write.
+    const auto wake = Clock::now();
+    timing_.begin_callback(wake);
+
+    const uint64_t written = frames_written_.load(std::memory_order_relaxed);
+    uint64_t frames_to_file = region.frames;
+    if (config_.frame_limit != 0) {
+      frames_to_file = written >= config_.frame_limit
+                           ? 0
+                           : std::min<uint64_t>(frames_to_file, config_.frame_limit - written);
+    }
+    if (write_error_.load(std::memory_order_relaxed)) {
+      frames_to_file = 0;
+    }
+    if (frames_to_file > 0) {
+      const size_t first_frames = std::min<size_t>(frames_to_file, region.first.size() / channels_);
+      const size_t second_frames = static_cast<size_t>(frames_to_file) - first_frames;
+      bool ok = true;
+      if (scratch_.empty()) {
+        // Float32: straight from ring storage to the stdio buffer, no conversion.
+        ok = std::fwrite(region.first.data(), frame_bytes, first_frames, file_) == first_frames;
+        if (ok && second_frames > 0) {
+          ok = std::fwrite(region.second.data(), frame_bytes, second_frames, file_) ==
+               second_frames;
+        }
+      } else {
+        // Integer formats: one conversion pass from both ring spans into the block buffer.
+        ConvertFloatToDevice(region.first.data(), static_cast<uint32_t>(first_frames), channels_,
+                             config_.sample_format, &dither_, scratch_.data());
+        if (second_frames > 0) {
+          ConvertFloatToDevice(region.second.data(), static_cast<uint32_t>(second_frames),
+                               channels_, config_.sample_format, &dither_,
+                               scratch_.data() + first_frames * frame_bytes);
+        }
+        const size_t total_frames = first_frames + second_frames;
+        ok = std::fwrite(scratch_.data(), frame_bytes, total_frames, file_) == total_frames;
+      }
+      if (ok) {
+        frames_written_.store(written + frames_to_file, std::memory_order_release);
+      } else {
+        write_error_.store(true, std::memory_order_release);
+      }
+    }
+
+    ring_buffer->commit_read(region.frames);
+    frames_drained_total_.fetch_add(region.frames, std::memory_order_relaxed);
+    rendered_frames_total_.fetch_add(region.frames, std::memory_order_relaxed);
+    ring_slot_.complete_cycle();
+    timing_.end_callback(wake, Clock::now());
+  }
+}
+
+void FileOutput::PatchHeader() {
+  if (!file_) {
+    return;
+  }
+  if (config_.container == Container::Wav) {
+    const uint64_t frames = frames_written_.load(std::memory_order_acquire);
+    const uint64_t data_bytes =
+        frames * static_cast<uint64_t>(channels_) * BytesPerSample(config_.sample_format);
+    std::array<uint8_t, kWavExtensibleHeaderBytes> header{};
+    const size_t header_bytes =
+        BuildWavHeader(config_.sample_format, channels_, sample_rate_, data_bytes, &header);
+    // A pad byte left by the previous patch is still the last byte of the file unless
+    // frames were written over it since.
+    const bool stale_pad = tail_pad_ && frames == patched_frames_;
+    bool ok = std::fflush(file_) == 0 && std::fseek(file_, 0, SEEK_SET) == 0 &&
+              std::fwrite(header.data(), 1, header_bytes, file_) == header_bytes &&
+              std::fseek(file_, stale_pad ? -1 : 0, SEEK_END) == 0;
+    // Write the pad, then step back over it so frames written after a restart replace it
+    // instead of landing behind it.
+    tail_pad_ = (data_bytes & 1) != 0;
+    patched_frames_ = frames;
+    if (ok && tail_pad_) {
+      ok = std::fputc(0, file_) != EOF && std::fseek(file_, -1, SEEK_CUR) == 0;
+    }
+    if (!ok) {
+      write_error_.store(true, std::memory_order_release);
+    }
+  }
+  if (std::fflush(file_) != 0) {
+    write_error_.store(true, std::memory_order_release);
+  }
+}
+
+}  // namespace audio
+}  // namespace tomplayer
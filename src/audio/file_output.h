@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/audio_output.h"
+#include "audio/render_ring_slot.h"
+#include "audio/sample_convert.h"
+
+namespace tomplayer {
+namespace audio {
+
+// Summary: Offline AudioOutput that drains the ring as fast as the producer fills it and
+//   writes the frames to a WAV or raw PCM file; no device clock paces it.
+// Preconditions: same control-thread rules as AudioOutput; the ring handed to it is consumed
+//   only by this sink.
+// Postconditions: frames reach the file in ring order, bit-exact for Float32. Unlike a
+//   device, the sink waits for data instead of rendering silence, so underrun counters stay
+//   at 0.
+// Errors: init_default_device fails if the file cannot be created or the sample format is
+//   Unsupported; a failed write stops further writes and is reported by has_write_error().
+class FileOutput final : public AudioOutput {
+public:
+  // Summary: Container written to path.
+  // Wav is RIFF/WAVE (IEEE float or PCM per sample_format); Raw is headerless
+  // little-endian samples.
+  enum class Container { Wav, Raw };
+
+  // Summary: Sink parameters.
+  // Preconditions: none.
+  // Postconditions: copied at construction.
+  // Errors: none.
+  struct Config {
+    std::string path;
+    Container container = Container::Wav;
+    uint32_t sample_rate = 48000;
+    uint16_t channels = 2;
+    // Float32 writes ring samples as-is; integer formats go through the shared kernels.
+    SampleFormat sample_format = SampleFormat::Float32;
+    DitherMode dither = DitherMode::Tpdf;
+    // Largest span moved from the ring to the file per cycle.
+    uint32_t block_frames = 4096;
+    // Stop writing after this many frames (0 = unlimited); the ring keeps draining so the
+    // engine never stalls, and finished() turns true.
+    uint64_t frame_limit = 0;
+  };
+
+  explicit FileOutput(const Config& config);
+  ~FileOutput() override;
+
+  FileOutput(const FileOutput&) = delete;
+  FileOutput& operator=(const FileOutput&) = delete;
+
+  // Creates (truncates) the file and writes a provisional header.
+  bool init_default_device() override;
+  void set_ring_buffer(AudioRingBuffer* ring_buffer) override;
+  AudioRingBuffer* exchange_ring_buffer(AudioRingBuffer* ring_buffer) override;
+  uint64_t render_grace_token() const override { return ring_slot_.grace_token(); }
+  bool render_grace_period_elapsed(uint64_t token) const override {
+    return !running_.load(std::memory_order_acquire) || ring_slot_.cycle_completed_since(token);
+  }
+  bool start() override;
+  // Also patches the header, so the file is valid whenever the sink is stopped.
+  void stop() override;
+  // Finalizes and closes the file.
+  void shutdown() override;
+  bool is_running() const override { return running_.load(std::memory_order_acquire); }
+  uint32_t sample_rate() const override { return sample_rate_; }
+  uint16_t channels() const override { return channels_; }
+  SampleFormat sample_format() const override {
+    return file_ ? config_.sample_format : SampleFormat::Unsupported;
+  }
+  uint32_t buffer_frames() const override { return block_frames_; }
+  uint64_t underrun_wake_count() const override { return 0; }
+  uint64_t underrun_frame_count() const override { return 0; }
+  uint64_t rendered_frames_total() const override {
+    return rendered_frames_total_.load(std::memory_order_relaxed);
+  }
+  void reset_rendered_frames() override {
+    rendered_frames_total_.store(0, std::memory_order_relaxed);
+  }
+  RenderTiming& render_timing() override { return timing_; }
+  platform::ThreadPolicySlot& render_thread_policy() override { return thread_policy_; }
+  // Frames are written as they are read; nothing is ever pending.
+  const PresentationClock& presentation_clock() const override { return presentation_; }
+  uint32_t set_fill_frames(uint32_t) override { return 0; }
+
+  // Summary: Frames written to the file since init_default_device.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint64_t frames_written() const { return frames_written_.load(std::memory_order_acquire); }
+
+  // Summary: True once frame_limit frames have been written.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: always false when frame_limit is 0.
+  bool finished() const {
+    return config_.frame_limit != 0 && frames_written() >= config_.frame_limit;
+  }
+
+  // Summary: Times-realtime factor: audio seconds drained per wall-clock second while running.
+  // Preconditions: control thread.
+  // Postconditions: does not modify state.
+  // Errors: returns 0 before anything has been rendered.
+  double speed_factor() const;
+
+  // Summary: Whether a file write failed (disk full, I/O error).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  bool has_write_error() const { return write_error_.load(std::memory_order_acquire); }
+
+private:
+  // Summary: Sink thread body: wait for frames, write ring spans (converted when the
+  //   format is not Float32) into the file.
+  // Preconditions: start() succeeded.
+  // Postconditions: exits when stop() clears running_.
+  // Errors: none; write failures set write_error_.
+  void RenderLoop();
+
+  // Summary: Rewrite the header for the frames written so far, then return to the end.
+  // Preconditions: render thread not running; file open.
+  // Postconditions: the file is a complete WAV (no-op for Raw).
+  // Errors: sets write_error_ on failure.
+  void PatchHeader();
+
+  const Config config_;
+  uint32_t sample_rate_{0};
+  uint16_t channels_{0};
+  uint32_t block_frames_{0};
+  std::FILE* file_{nullptr};
+  // Conversion target for integer formats (one block); empty for Float32.
+  std::vector<uint8_t> scratch_;
+  DitherState dither_;
+
+  std::thread render_thread_;
+  std::atomic<bool> running_{false};
+  std::chrono::steady_clock::time_point run_started_{};
+  // Wall time spent running, excluding the current run (speed_factor adds it).
+  std::chrono::steady_clock::duration run_time_{};
+
+  // Read once per sink cycle; swapped by exchange_ring_buffer (see render_grace_token).
+  RenderRingSlot ring_slot_;
+  std::atomic<uint64_t> rendered_frames_total_{0};
+  // Frames consumed from the ring while running, written or past frame_limit.
+  std::atomic<uint64_t> frames_drained_total_{0};
+  std::atomic<uint64_t> frames_written_{0};
+  std::atomic<bool> write_error_{false};
+  // Control thread (PatchHeader): the file ends with a RIFF pad byte past the data, as of
+  // patched_frames_ frames written.
+  bool tail_pad_{false};
+  uint64_t patched_frames_{0};
+  RenderTiming timing_;
+  platform::ThreadPolicySlot thread_policy_;
+  PresentationClock presentation_;
+};
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,173 @@
+#include "audio/null_output.h"
+
+#include "buffer/audio_ring_buffer.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace tomplayer {
+namespace audio {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Frames a device at sample_rate_hz has played after elapsed (no overflow for years).
+uint64_t FramesElapsed(Clock::duration elapsed, uint32_t sample_rate_hz) {
+  const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(elapsed);
+  const auto remainder = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed - seconds);
+  return static_cast<uint64_t>(seconds.count()) * sample_rate_hz +
+         static_cast<uint64_t>(remainder.count()) * sample_rate_hz / 1'000'000'000ull;
+}
+}  // namespace
+
+NullOutput::NullOutput() : NullOutput(Config{}) {}
+
+NullOutput::NullOutput(const Config& config) : config_(config) {}
+
+NullOutput::~NullOutput() {
+  shutdown();
+}
+
+bool NullOutput::init_default_device() {
+  if (initialized_) {
+    return false;
+  }
+  const uint32_t period_frames =
+      AudioRingBufferTypes::frames_for_latency(config_.sample_rate, config_.period);
+  const uint32_t bytes_per_sample = BytesPerSample(config_.sample_format);
+  if (period_frames == 0 || config_.channels == 0 || bytes_per_sample == 0) {
+    return false;
+  }
+
+  sample_rate_ = config_.sample_rate;
+  channels_ = config_.channels;
+  period_frames_ = period_frames;
+  buffer_frames_ = config_.buffer_frames == 0 ? period_frames * 2
+                                              : std::max(config_.buffer_frames, period_frames);
+  // Allocated here so the render loop never allocates.
+  device_.memory.assign(static_cast<size_t>(buffer_frames_) * channels_ * bytes_per_sample, 0);
+  core_.configure(config_.sample_format, channels_, buffer_frames_, sample_rate_);
+  core_.set_fill_limit(0);
+
+  device_api_.context = &device_;
+  device_api_.GetPadding = [](void* context, uint32_t* padding) {
+    auto* device = static_cast<SimulatedDevice*>(context);
+    // The device has played what it was given, up to its clock; a late wake leaves it starved.
+    const uint64_t played = std::min(device->written_frames, device->clock_frames);
+    *padding = static_cast<uint32_t>(device->written_frames - played);
+    return true;
+  };
+  device_api_.GetBuffer = [](void* context, uint32_t frames, uint8_t** data, uint32_t* granted) {
+    *data = static_cast<SimulatedDevice*>(context)->memory.data();
+    *granted = frames;
+    return true;
+  };
+  device_api_.ReleaseBuffer = [](void* context, uint32_t frames, bool) {
+    static_cast<SimulatedDevice*>(context)->written_frames += frames;
+    return true;
+  };
+  initialized_ = true;
+  return true;
+}
+
+uint32_t NullOutput::set_fill_frames(uint32_t frames) {
+  if (!initialized_) {
+    return 0;
+  }
+  const uint32_t fill = std::clamp(frames, period_frames_, buffer_frames_);
+  core_.set_fill_limit(fill);
+  return fill;
+}
+
+void NullOutput::set_ring_buffer(AudioRingBuffer* ring_buffer) {
+  assert(!running_.load(std::memory_order_relaxed));
+  core_.set_ring_buffer(ring_buffer);
+}
+
+AudioRingBuffer* NullOutput::exchange_ring_buffer(AudioRingBuffer* ring_buffer) {
+  return core_.exchange_ring_buffer(ring_buffer);
+}
+
+bool NullOutput::start() {
+  if (!initialized_) {
+    return false;
+  }
+  AudioRingBuffer* ring_buffer = core_.ring_buffer();
+  if (!ring_buffer || ring_buffer->channels() != channels_) {
+    return false;
+  }
+  if (running_.exchange(true)) {
+    return false;
+  }
+  // A started device begins with an empty buffer, as after IAudioClient::Reset.
+  device_.clock_frames = 0;
+  device_.written_frames = 0;
+  core_.prepare(config_.dither);
+  timing_.restart();
+  render_thread_ = std::thread(&NullOutput::RenderLoop, this);
+  return true;
+}
+
+void NullOutput::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  {
+    // Taking the lock orders the flag change before the render thread's predicate check.
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+  }
+  stop_cv_.notify_all();
+  if (render_thread_.joinable()) {
+    render_thread_.join();
+  }
+  core_.halt();
+}
+
+void NullOutput::shutdown() {
+  stop();
+  initialized_ = false;
+  sample_rate_ = 0;
+  channels_ = 0;
+  period_frames_ = 0;
+  buffer_frames_ = 0;
+  device_.memory.clear();
+  device_.memory.shrink_to_fit();
+  device_api_ = {};
+  core_.configure(SampleFormat::Unsupported, 0, 0, 0);
+}
+
+void NullOutput::RenderLoop() {
+  thread_policy_.apply();
+  const auto start = Clock::now();
+  auto next_wake = start;
+  uint64_t cycle = 0;
+  while (running_.load(std::memory_order_acquire)) {
+    const auto wake = Clock::now();
+    timing_.begin_callback(wake);
+    device_.clock_frames =
+        config_.free_running ? cycle * period_frames_ : FramesElapsed(wake - start, sample_rate_);
+    core_.render(device_api_);
+    // Quiescent point: this cycle no longer holds a ring pointer (see render_grace_token).
+    core_.complete_cycle();
+    timing_.end_callback(wake, Clock::now());
+    ++cycle;
+
+    if (config_.free_running) {
+      // Let the producer run when both share a core.
+      std::this_thread::yield();
+      continue;
+    }
+    next_wake += config_.period;
+    const auto now = Clock::now();
+    if (next_wake + config_.period < now) {
+      // Overslept by more than a period: wake on schedule from here rather than in a burst.
+      next_wake = now;
+    }
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    stop_cv_.wait_until(lock, next_wake, [this] {
+      return !running_.load(std::memory_order_acquire);
+    });
+  }
+}
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "audio/audio_output.h"
+#include "audio/render_core.h"
+#include "audio/sample_convert.h"
+
+namespace tomplayer {
+namespace audio {
+
+// Summary: Headless AudioOutput that pulls from the ring on a timer thread, simulating a
+//   device that drains a buffer_frames buffer at sample_rate and is refilled once per period.
+// Preconditions: same control-thread rules as AudioOutput.
+// Postconditions: rendered frames are discarded; counters match WasapiOutput semantics
+//   (every frame handed to the "device" counts toward rendered_frames_total, silence included).
+// Errors: init_default_device fails for a zero rate, channel count or period, or an
+//   Unsupported sample format.
+class NullOutput final : public AudioOutput {
+public:
+  // Summary: Simulated device parameters.
+  // Preconditions: none.
+  // Postconditions: copied at construction.
+  // Errors: none.
+  struct Config {
+    uint32_t sample_rate = 48000;
+    uint16_t channels = 2;
+    // Wake interval of the simulated device (e.g. 10 ms at 48 kHz, 3 ms at 192 kHz).
+    std::chrono::microseconds period{10000};
+    // Device buffer in frames; 0 means two periods. Never smaller than one period.
+    uint32_t buffer_frames = 0;
+    // Advance the simulated clock one period per cycle without sleeping, so the output
+    // drains as fast as the producer can fill (throughput runs).
+    bool free_running = false;
+    // Device buffer format; integer formats exercise the shared conversion kernels.
+    SampleFormat sample_format = SampleFormat::Float32;
+    DitherMode dither = DitherMode::Tpdf;
+  };
+
+  NullOutput();
+  explicit NullOutput(const Config& config);
+  ~NullOutput() override;
+
+  NullOutput(const NullOutput&) = delete;
+  NullOutput& operator=(const NullOutput&) = delete;
+
+  bool init_default_device() override;
+  void set_ring_buffer(AudioRingBuffer* ring_buffer) override;
+  AudioRingBuffer* exchange_ring_buffer(AudioRingBuffer* ring_buffer) override;
+  uint64_t render_grace_token() const override { return core_.render_grace_token(); }
+  bool render_grace_period_elapsed(uint64_t token) const override {
+    return !running_.load(std::memory_order_acquire) || core_.cycle_completed_since(token);
+  }
+  bool start() override;
+  void stop() override;
+  void shutdown() override;
+  bool is_running() const override { return running_.load(std::memory_order_acquire); }
+  uint32_t sample_rate() const override { return sample_rate_; }
+  uint16_t channels() const override { return channels_; }
+  SampleFormat sample_format() const override {
+    return initialized_ ? config_.sample_format : SampleFormat::Unsupported;
+  }
+  uint32_t buffer_frames() const override { return buffer_frames_; }
+  uint64_t underrun_wake_count() const override { return core_.underrun_wake_count(); }
+  uint64_t underrun_frame_count() const override { return core_.underrun_frame_count(); }
+  uint64_t rendered_frames_total() const override { return core_.rendered_frames_total(); }
+  void reset_rendered_frames() override { core_.reset_rendered_frames(); }
+  RenderTiming& render_timing() override { return timing_; }
+  platform::ThreadPolicySlot& render_thread_policy() override { return thread_policy_; }
+  const PresentationClock& presentation_clock() const override {
+    return core_.presentation_clock();
+  }
+  // Clamped to [period_frames, buffer_frames]: the device drains a period between wakes.
+  uint32_t set_fill_frames(uint32_t frames) override;
+
+  // Summary: Frames the simulated device refills per period.
+  // Preconditions: init_default_device succeeded.
+  // Postconditions: none.
+  // Errors: returns 0 if uninitialized.
+  uint32_t period_frames() const { return period_frames_; }
+
+  // Summary: Number of render cycles run since construction.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint64_t render_cycle_count() const { return core_.cycles_completed(); }
+
+private:
+  // Summary: Timer thread body; wakes once per period (or immediately when free-running).
+  // Preconditions: start() succeeded.
+  // Postconditions: exits when stop() clears running_.
+  // Errors: none.
+  void RenderLoop();
+
+  // Summary: Simulated device behind the render core's DeviceBufferApi: it has played
+  //   clock_frames of the written_frames it was given; memory stands in for its buffer.
+  // Preconditions: render thread only (reset by start()).
+  // Postconditions: padding is written - played; released frames advance written_frames.
+  // Errors: none.
+  struct SimulatedDevice {
+    uint64_t clock_frames = 0;
+    uint64_t written_frames = 0;
+    std::vector<uint8_t> memory;
+  };
+
+  const Config config_;
+  bool initialized_{false};
+  uint32_t sample_rate_{0};
+  uint16_t channels_{0};
+  uint32_t period_frames_{0};
+  uint32_t buffer_frames_{0};
+
+  SimulatedDevice device_;
+  DeviceBufferApi device_api_{};
+  RenderCore core_;
+
+  std::thread render_thread_;
+  std::atomic<bool> running_{false};
+  std::mutex stop_mutex_;
+  std::condition_variable stop_cv_;
+
+  RenderTiming timing_;
+  platform::ThreadPolicySlot thread_policy_;
+};
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,70 @@
+#include "audio/presentation_clock.h"
+
+namespace tomplayer {
+namespace audio {
+
+void PresentationClock::configure(uint32_t sample_rate, uint32_t fixed_latency_frames) {
+  sample_rate_.store(sample_rate, std::memory_order_relaxed);
+  fixed_latency_frames_.store(fixed_latency_frames, std::memory_order_relaxed);
+}
+
+void PresentationClock::begin_update() {
+  sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  // Orders the odd sequence before the ring commit and snapshot stores that follow.
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void PresentationClock::end_update(Clock::time_point at, uint32_t queued_frames) {
+  Publish(at, uint64_t{queued_frames} + fixed_latency_frames_.load(std::memory_order_relaxed),
+          true);
+}
+
+void PresentationClock::restart(Clock::time_point at) {
+  begin_update();
+  Publish(at, 0, true);
+}
+
+void PresentationClock::freeze(Clock::time_point at) {
+  const uint64_t pending = pending_frames(at);
+  begin_update();
+  Publish(at, pending, false);
+}
+
+void PresentationClock::Publish(Clock::time_point at, uint64_t queued_frames, bool draining) {
+  anchor_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(at.time_since_epoch())
+                       .count(),
+                   std::memory_order_relaxed);
+  queued_frames_.store(queued_frames, std::memory_order_relaxed);
+  draining_.store(draining, std::memory_order_relaxed);
+  sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool PresentationClock::read_retry(uint32_t sequence) const {
+  // Pairs with begin_update's fence: a reader that saw any store of a write section sees
+  // its odd sequence here.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return (sequence & 1) != 0 || sequence_.load(std::memory_order_relaxed) != sequence;
+}
+
+uint64_t PresentationClock::pending_frames(Clock::time_point now) const {
+  const uint64_t queued = queued_frames_.load(std::memory_order_relaxed);
+  const uint32_t sample_rate = sample_rate_.load(std::memory_order_relaxed);
+  if (!draining_.load(std::memory_order_relaxed) || queued == 0 || sample_rate == 0) {
+    return queued;
+  }
+  const int64_t elapsed_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count() -
+      anchor_ns_.load(std::memory_order_relaxed);
+  if (elapsed_ns <= 0) {
+    return queued;
+  }
+  // Compare in nanoseconds first so the product below cannot overflow.
+  const uint64_t elapsed = static_cast<uint64_t>(elapsed_ns);
+  if (elapsed >= queued * 1'000'000'000ull / sample_rate) {
+    return 0;
+  }
+  return queued - elapsed * sample_rate / 1'000'000'000ull;
+}
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace tomplayer {
+namespace audio {
+
+// Summary: How much ring audio an output has handed to its device but not yet played,
+//   anchored at the last render cycle and interpolated on steady_clock in between, so a
+//   reader can turn "frames consumed from the ring" into "frame audible now".
+// Preconditions: one writer at a time: the render thread while running, the control
+//   thread in restart/freeze while it is stopped. Readers on any thread.
+// Postconditions: writes never block; reads are lock-free and retry only while a render
+//   cycle is in flight (seqlock, see read_begin).
+// Errors: none.
+class PresentationClock {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Summary: Device rate used to drain the queue over time, and the fixed pipeline latency
+  //   past the device buffer (e.g. IAudioClient::GetStreamLatency).
+  // Preconditions: control thread, render thread stopped.
+  // Postconditions: applies from the next published snapshot.
+  // Errors: none.
+  void configure(uint32_t sample_rate, uint32_t fixed_latency_frames);
+
+  // Summary: Open a write section; the render core calls it before touching the ring, so
+  //   readers never pair a new ring position with an old snapshot.
+  // Preconditions: writer; not already inside a write section.
+  // Postconditions: readers that overlap retry.
+  // Errors: none.
+  void begin_update();
+
+  // Summary: Close the write section: queued_frames of ring audio were waiting in the
+  //   device at time at and drain at the sample rate from then on.
+  // Preconditions: follows begin_update.
+  // Postconditions: pending_frames is anchored at (at, queued_frames + fixed latency).
+  // Errors: none.
+  void end_update(Clock::time_point at, uint32_t queued_frames);
+
+  // Summary: The device starts empty (start()).
+  // Preconditions: render thread stopped.
+  // Postconditions: pending_frames is 0 until the first cycle publishes.
+  // Errors: none.
+  void restart(Clock::time_point at);
+
+  // Summary: The device stopped and dropped its queue (stop()): hold what was still
+  //   pending at that moment instead of letting it drain.
+  // Preconditions: render thread stopped.
+  // Postconditions: pending_frames stays constant until restart.
+  // Errors: none.
+  void freeze(Clock::time_point at);
+
+  // Summary: Seqlock read protocol. Read what must be consistent with the snapshot (e.g.
+  //   the ring's current marker) and pending_frames between read_begin and read_retry,
+  //   and repeat while read_retry returns true.
+  // Preconditions: none (any thread).
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint32_t read_begin() const { return sequence_.load(std::memory_order_acquire); }
+  bool read_retry(uint32_t sequence) const;
+
+  // Summary: Frames handed to the device that are not yet audible at now.
+  // Preconditions: inside a read_begin/read_retry section for a consistent answer.
+  // Postconditions: does not modify state.
+  // Errors: none; 0 before the first snapshot or at a zero sample rate.
+  uint64_t pending_frames(Clock::time_point now) const;
+
+private:
+  void Publish(Clock::time_point at, uint64_t queued_frames, bool draining);
+
+  std::atomic<uint32_t> sample_rate_{0};
+  std::atomic<uint32_t> fixed_latency_frames_{0};
+
+  // Odd while a write section is open.
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<int64_t> anchor_ns_{0};
+  std::atomic<uint64_t> queued_frames_{0};
+  std::atomic<bool> draining_{false};
+};
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,112 @@
+#include "audio/render_core.h"
+
+#include "audio/ring_render.h"
+#include "buffer/audio_ring_buffer.h"
+
+#include <algorithm>
+
+namespace tomplayer {
+namespace audio {
+
+void RenderCore::configure(SampleFormat format,
+                           uint16_t channels,
+                           uint32_t buffer_frames,
+                           uint32_t sample_rate,
+                           uint32_t fixed_latency_frames) {
+  format_ = format;
+  channels_ = channels;
+  buffer_frames_ = buffer_frames;
+  presentation_.configure(sample_rate, fixed_latency_frames);
+}
+
+void RenderCore::prepare(DitherMode dither) {
+  dither_.reset(dither);
+  queued_silence_frames_ = 0;
+  presentation_.restart(PresentationClock::Clock::now());
+}
+
+void RenderCore::halt() {
+  presentation_.freeze(PresentationClock::Clock::now());
+}
+
+RenderCycle RenderCore::render(const DeviceBufferApi& device) {
+  RenderCycle cycle;
+  uint32_t padding = 0;
+  // The queue drains from the moment padding is sampled, not from when this cycle ends.
+  const auto padding_time = PresentationClock::Clock::now();
+  if (!device.GetPadding(device.context, &padding)) {
+    cycle.device_error = true;
+    return cycle;
+  }
+  // Before the first ring commit, so a reader never pairs the new read position with the
+  // previous queue depth.
+  presentation_.begin_update();
+  const uint32_t fill_limit = fill_limit_.load(std::memory_order_relaxed);
+  const uint32_t fill = fill_limit > 0 ? std::min(fill_limit, buffer_frames_) : buffer_frames_;
+  uint32_t remaining = padding < fill ? fill - padding : 0;
+
+  // Load once: the engine may swap in a resized ring while this cycle runs.
+  AudioRingBuffer* ring_buffer = ring_slot_.load_for_cycle();
+  const bool ring_usable = ring_buffer && ring_buffer->channels() == channels_;
+  bool short_read = false;
+
+  while (remaining > 0) {
+    uint8_t* data = nullptr;
+    uint32_t granted = 0;
+    if (!device.GetBuffer(device.context, remaining, &data, &granted) ||
+        (granted > 0 && !data)) {
+      cycle.device_error = true;
+      break;
+    }
+    if (granted == 0) {
+      break;
+    }
+    granted = std::min(granted, remaining);
+
+    // Unknown layouts play silence rather than garbage noise, and are not a clock.
+    if (format_ == SampleFormat::Unsupported) {
+      cycle.device_error = !device.ReleaseBuffer(device.context, granted, true);
+      break;
+    }
+
+    // One pass from ring storage into the device buffer, converting for integer formats;
+    // any shortfall is zero-filled.
+    uint32_t frames_read = 0;
+    if (ring_usable) {
+      frames_read = ConsumeRingBuffer(ring_buffer, format_, &dither_, data, granted, channels_,
+                                      nullptr, &underrun_frame_count_);
+      short_read = short_read || frames_read < granted;
+    } else {
+      ConsumeRingBuffer(nullptr, format_, nullptr, data, granted, channels_, nullptr, nullptr);
+    }
+
+    if (!device.ReleaseBuffer(device.context, granted, frames_read == 0)) {
+      cycle.device_error = true;
+      break;
+    }
+    // Count all frames handed to the device, including silence, to track the playback clock.
+    rendered_frames_total_.fetch_add(granted, std::memory_order_relaxed);
+    cycle.frames_written += granted;
+    cycle.frames_read += frames_read;
+    remaining -= granted;
+  }
+
+  if (short_read) {
+    underrun_wake_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Ring audio is contiguous at the head of what was written and zeros follow it, so the
+  // silent tail is either what this cycle padded or the previous tail, less what played.
+  // Once audio is queued behind it the gap counts as pending until it plays: the reported
+  // position lags by at most one device buffer right after an underrun.
+  padding = std::min(padding, buffer_frames_);
+  queued_silence_frames_ = cycle.frames_read > 0
+                               ? cycle.frames_written - cycle.frames_read
+                               : std::min(queued_silence_frames_, padding) + cycle.frames_written;
+  const uint32_t queued = padding + cycle.frames_written;
+  presentation_.end_update(padding_time, queued - std::min(queued_silence_frames_, queued));
+  return cycle;
+}
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "audio/audio_output.h"
+#include "audio/presentation_clock.h"
+#include "audio/render_ring_slot.h"
+#include "audio/sample_convert.h"
+#include "buffer/audio_ring_buffer_fwd.h"
+
+namespace tomplayer {
+namespace audio {
+
+// Summary: Device buffer hooks one render cycle calls, in platform-neutral types. Backends
+//   wire their device API into these slots (IAudioClient/IAudioRenderClient, ALSA mmap, a
+//   simulated clock); tests plug in fakes.
+// Preconditions: every slot is set; context outlives the calls.
+// Postconditions: called only from the render thread, in the order GetPadding, then
+//   GetBuffer/ReleaseBuffer pairs.
+// Errors: a slot returns false on device failure; the backend keeps the details (HRESULT,
+//   errno) in its context.
+struct DeviceBufferApi {
+  void* context{nullptr};
+  // Frames queued in the device buffer and not yet played.
+  bool (*GetPadding)(void* context, uint32_t* padding) = nullptr;
+  // Map a writable area for up to frames frames. *granted may be smaller when the device
+  // buffer wraps (ALSA mmap); 0 ends the cycle.
+  bool (*GetBuffer)(void* context, uint32_t frames, uint8_t** data, uint32_t* granted) = nullptr;
+  // Hand granted frames to the device; silent marks a block with no ring audio in it.
+  bool (*ReleaseBuffer)(void* context, uint32_t frames, bool silent) = nullptr;
+};
+
+// Summary: What one RenderCore::render call did.
+struct RenderCycle {
+  // Frames handed to the device, silence included.
+  uint32_t frames_written = 0;
+  // Frames of ring audio among them.
+  uint32_t frames_read = 0;
+  // A device hook failed; the backend decides whether to recover or stop.
+  bool device_error = false;
+};
+
+// Summary: The render path every device backend shares: padding -> GetBuffer -> convert
+//   from the ring -> ReleaseBuffer, with silence flags, underrun accounting, the rendered
+//   frame clock, the presentation clock and the RCU ring slot (RenderRingSlot). Backends
+//   keep only their device plumbing.
+// Preconditions: configure/set_ring_buffer/prepare run on the control thread while the
+//   render thread is stopped; render and complete_cycle on the render thread only;
+//   counters and exchange_ring_buffer from any thread.
+// Postconditions: render never allocates, locks or blocks.
+// Errors: none; device failures are reported through RenderCycle::device_error.
+class RenderCore {
+public:
+  // Summary: Fix the device side (called from init_default_device). fixed_latency_frames
+  //   is what the device adds past its buffer (WASAPI stream latency; 0 when unknown).
+  // Preconditions: render thread stopped.
+  // Postconditions: render fills buffer_frames - padding frames of format per cycle; the
+  //   presentation clock drains at sample_rate.
+  // Errors: none; an Unsupported format renders silence without advancing the clock.
+  void configure(SampleFormat format,
+                 uint16_t channels,
+                 uint32_t buffer_frames,
+                 uint32_t sample_rate,
+                 uint32_t fixed_latency_frames = 0);
+
+  // Summary: Reset render-thread state before the stream starts (dither history, an empty
+  //   device queue on the presentation clock).
+  // Preconditions: render thread stopped.
+  // Postconditions: the next cycle starts a fresh requantization state for dither.
+  // Errors: none.
+  void prepare(DitherMode dither);
+
+  // Summary: The device stopped and dropped what it had queued; hold the presentation
+  //   delay where it was so a paused position does not creep forward.
+  // Preconditions: render thread stopped (after the backend joined it).
+  // Postconditions: presentation_clock().pending_frames is constant until prepare().
+  // Errors: none.
+  void halt();
+
+  // Summary: Keep at most frames queued in the device instead of the whole buffer, trading
+  //   glitch headroom for latency (adaptive latency).
+  // Preconditions: none; may change while running. The backend clamps frames to what its
+  //   device can run with.
+  // Postconditions: cycles after the call fill up to frames; 0 restores the whole buffer.
+  // Errors: none.
+  void set_fill_limit(uint32_t frames) { fill_limit_.store(frames, std::memory_order_relaxed); }
+  uint32_t fill_limit() const { return fill_limit_.load(std::memory_order_relaxed); }
+
+  // Summary: One render cycle against device.
+  // Preconditions: render thread only; configure() ran.
+  // Postconditions: the device is topped up to the fill limit (whole buffer by default);
+  //   every granted block is filled (ring audio, zeros for the rest) and
+  //   released; blocks without ring audio are flagged silent. rendered_frames_total counts
+  //   every released frame; a short read counts one underrun wake per cycle, however many
+  //   blocks it spans. A ring whose channel count differs renders silence, uncounted as
+  //   underrun. The presentation clock is republished with the ring audio still queued in
+  //   the device (padding plus what was written, less trailing silence).
+  // Errors: device_error is set when a hook fails; frames released before it stay counted.
+  RenderCycle render(const DeviceBufferApi& device);
+
+  // Summary: Mark the render thread quiescent: it holds no ring pointer until its next
+  //   render call (see render_grace_token).
+  // Preconditions: render thread, between cycles.
+  // Postconditions: grace tokens taken before this call have elapsed.
+  // Errors: none.
+  void complete_cycle() { ring_slot_.complete_cycle(); }
+
+  // Same contracts as the AudioOutput methods of the same names (see RenderRingSlot); the
+  // backend adds its running check to render_grace_period_elapsed.
+  void set_ring_buffer(AudioRingBuffer* ring_buffer) { ring_slot_.set(ring_buffer); }
+  AudioRingBuffer* exchange_ring_buffer(AudioRingBuffer* ring_buffer) {
+    return ring_slot_.exchange(ring_buffer);
+  }
+  AudioRingBuffer* ring_buffer() const { return ring_slot_.current(); }
+  uint64_t render_grace_token() const { return ring_slot_.grace_token(); }
+  bool cycle_completed_since(uint64_t token) const {
+    return ring_slot_.cycle_completed_since(token);
+  }
+  uint64_t cycles_completed() const { return ring_slot_.cycles_completed(); }
+
+  uint64_t underrun_wake_count() const {
+    return underrun_wake_count_.load(std::memory_order_relaxed);
+  }
+  uint64_t underrun_frame_count() const {
+    return underrun_frame_count_.load(std::memory_order_relaxed);
+  }
+  uint64_t rendered_frames_total() const {
+    return rendered_frames_total_.load(std::memory_order_relaxed);
+  }
+  void reset_rendered_frames() { rendered_frames_total_.store(0, std::memory_order_relaxed); }
+
+  const PresentationClock& presentation_clock() const { return presentation_; }
+
+private:
+  SampleFormat format_{SampleFormat::Unsupported};
+  uint16_t channels_{0};
+  uint32_t buffer_frames_{0};
+  // Render-thread requantization state for integer device formats.
+  DitherState dither_;
+  // Render thread: frames of silence at the tail of the device queue after the last cycle,
+  // so ring audio queued behind an underrun is not mistaken for pending.
+  uint32_t queued_silence_frames_{0};
+  PresentationClock presentation_;
+
+  // Read once per render cycle; swapped by exchange_ring_buffer (see render_grace_token).
+  RenderRingSlot ring_slot_;
+  std::atomic<uint32_t> fill_limit_{0};
+  std::atomic<uint64_t> underrun_wake_count_{0};
+  std::atomic<uint64_t> underrun_frame_count_{0};
+  std::atomic<uint64_t> rendered_frames_total_{0};
+};
+
+}  // namespace audio
+}  // namespace tomplayer
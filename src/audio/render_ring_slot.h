@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+#include "buffer/audio_ring_buffer_fwd.h"
+
+namespace tomplayer {
+namespace audio {
+
+// Summary: The render side of the engine's RCU ring swap, shared by every sink (RenderCore
+//   for the device backends, FileOutput for the offline one): the ring pointer the render
+//   thread reads and the count of render cycles it finished, which is the grace period
+//   the engine waits out before freeing a swapped-out ring.
+// Preconditions: set runs while the render thread is stopped; load_for_cycle and
+//   complete_cycle on the render thread only; exchange and the grace queries from any
+//   thread.
+// Postconditions: a ring returned by exchange is still in use only by a cycle that loaded
+//   it before the swap; once cycle_completed_since(grace_token()) holds (token sampled
+//   after exchange), no render cycle references it.
+// Errors: none.
+class RenderRingSlot {
+public:
+  // Summary: Pre-start setter; no reclamation implied.
+  void set(AudioRingBuffer* ring_buffer) {
+    ring_buffer_.store(ring_buffer, std::memory_order_release);
+  }
+
+  // Summary: Live swap; the caller reclaims the returned ring after the grace period.
+  // Preconditions: ring_buffer != nullptr.
+  AudioRingBuffer* exchange(AudioRingBuffer* ring_buffer) {
+    assert(ring_buffer != nullptr);
+    // seq_cst pairs with load_for_cycle so a token sampled after the swap is ordered after
+    // any cycle that could have observed the previous pointer.
+    return ring_buffer_.exchange(ring_buffer, std::memory_order_seq_cst);
+  }
+
+  // Summary: Current ring for control-thread checks (start, diagnostics).
+  AudioRingBuffer* current() const { return ring_buffer_.load(std::memory_order_acquire); }
+
+  // Summary: The ring one render cycle uses; load once per cycle and drop it at
+  //   complete_cycle.
+  AudioRingBuffer* load_for_cycle() const {
+    return ring_buffer_.load(std::memory_order_seq_cst);
+  }
+
+  // Summary: Quiescent point: the render thread holds no ring pointer until its next
+  //   load_for_cycle.
+  void complete_cycle() { cycles_completed_.fetch_add(1, std::memory_order_release); }
+
+  uint64_t grace_token() const { return cycles_completed_.load(std::memory_order_seq_cst); }
+  bool cycle_completed_since(uint64_t token) const {
+    return cycles_completed_.load(std::memory_order_acquire) > token;
+  }
+  uint64_t cycles_completed() const { return cycles_completed_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<AudioRingBuffer*> ring_buffer_{nullptr};
+  std::atomic<uint64_t> cycles_completed_{0};
+};
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,147 @@
+#include "audio/render_timing.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace tomplayer {
+namespace audio {
+
+uint32_t TimingHistogram::BucketIndex(uint64_t value) {
+  if (value < kExactBuckets) {
+    return static_cast<uint32_t>(value);
+  }
+  const uint32_t exponent = static_cast<uint32_t>(std::bit_width(value)) - 1;
+  if (exponent >= kMaxExponent) {
+    return kBucketCount - 1;
+  }
+  // The three bits below the leading one pick the sub-bucket.
+  const uint32_t sub = static_cast<uint32_t>(value >> (exponent - 3)) & (kSubBuckets - 1);
+  return kExactBuckets + (exponent - 4) * kSubBuckets + sub;
+}
+
+uint64_t TimingHistogram::BucketUpperEdge(uint32_t index) {
+  if (index < kExactBuckets) {
+    return index;
+  }
+  const uint32_t offset = index - kExactBuckets;
+  const uint32_t shift = offset / kSubBuckets + 1;
+  const uint64_t lower = static_cast<uint64_t>(kSubBuckets + offset % kSubBuckets) << shift;
+  return lower + (uint64_t{1} << shift) - 1;
+}
+
+void TimingHistogram::record(std::chrono::nanoseconds value) {
+  const uint64_t ns = value.count() > 0 ? static_cast<uint64_t>(value.count()) : 0;
+  buckets_[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+  // Single writer: a plain load/store keeps the maximum without a CAS loop.
+  if (ns > max_.load(std::memory_order_relaxed)) {
+    max_.store(ns, std::memory_order_relaxed);
+  }
+}
+
+TimingSummary TimingHistogram::summarize() const {
+  std::array<uint64_t, kBucketCount> counts;
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < kBucketCount; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  TimingSummary summary;
+  summary.count = total;
+  if (total == 0) {
+    return summary;
+  }
+  const uint64_t max = max_.load(std::memory_order_relaxed);
+  summary.max = std::chrono::nanoseconds(max);
+
+  // Rank of quantile q (per mille, so 99.9% stays integral) is ceil(q * total).
+  const auto percentile = [&](uint64_t per_mille) {
+    const uint64_t rank = std::max<uint64_t>((total * per_mille + 999) / 1000, 1);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < kBucketCount; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        // The last bucket is open-ended; only the maximum bounds it.
+        const uint64_t edge = i + 1 == kBucketCount ? max : BucketUpperEdge(i);
+        return std::chrono::nanoseconds(std::min(edge, max));
+      }
+    }
+    return std::chrono::nanoseconds(max);
+  };
+  summary.p50 = percentile(500);
+  summary.p99 = percentile(990);
+  summary.p999 = percentile(999);
+  return summary;
+}
+
+void TimingHistogram::reset() {
+  for (std::atomic<uint64_t>& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  max_.store(0, std::memory_order_relaxed);
+}
+
+void RenderTiming::begin_callback(Clock::time_point wake) {
+  if (last_wake_ != Clock::time_point::min()) {
+    const std::chrono::nanoseconds interval = wake - last_wake_;
+    wake_interval_.record(interval);
+    const int64_t wake_limit_ns = wake_limit_ns_.load(std::memory_order_relaxed);
+    if (wake_limit_ns > 0 && interval.count() > wake_limit_ns) {
+      late_wakes_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  last_wake_ = wake;
+}
+
+void RenderTiming::end_callback(Clock::time_point wake, Clock::time_point done) {
+  const std::chrono::nanoseconds elapsed = done - wake;
+  callback_.record(elapsed);
+  const int64_t deadline_ns = deadline_ns_.load(std::memory_order_relaxed);
+  if (deadline_ns > 0 && elapsed.count() > deadline_ns) {
+    deadline_overruns_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void RenderTiming::restart() {
+  last_wake_ = Clock::time_point::min();
+}
+
+void RenderTiming::set_deadline(std::chrono::microseconds deadline) {
+  deadline_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline).count(),
+                     std::memory_order_relaxed);
+}
+
+std::chrono::microseconds RenderTiming::deadline() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::nanoseconds(deadline_ns_.load(std::memory_order_relaxed)));
+}
+
+void RenderTiming::set_wake_limit(std::chrono::microseconds limit) {
+  wake_limit_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(limit).count(),
+                       std::memory_order_relaxed);
+}
+
+std::chrono::microseconds RenderTiming::wake_limit() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::nanoseconds(wake_limit_ns_.load(std::memory_order_relaxed)));
+}
+
+RenderTimingReport RenderTiming::report() const {
+  RenderTimingReport report;
+  report.wake_interval = wake_interval_.summarize();
+  report.callback = callback_.summarize();
+  report.deadline_overruns = deadline_overruns_.load(std::memory_order_relaxed);
+  report.deadline = deadline();
+  report.late_wakes = late_wakes_.load(std::memory_order_relaxed);
+  report.wake_limit = wake_limit();
+  return report;
+}
+
+void RenderTiming::reset() {
+  wake_interval_.reset();
+  callback_.reset();
+  deadline_overruns_.store(0, std::memory_order_relaxed);
+  late_wakes_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace tomplayer {
+namespace audio {
+
+// Summary: Percentiles of one timing histogram. Values are bucket upper edges (within
+//   12.5% of the true value, exact below 16 ns) capped at the observed maximum.
+struct TimingSummary {
+  uint64_t count = 0;
+  std::chrono::nanoseconds p50{0};
+  std::chrono::nanoseconds p99{0};
+  std::chrono::nanoseconds p999{0};
+  std::chrono::nanoseconds max{0};
+};
+
+// Summary: Log-linear latency histogram with one writer and any number of readers.
+// Preconditions: record() is called from a single thread (the render thread).
+// Postconditions: record() is wait-free (relaxed atomic adds, no allocation), so it is safe
+//   inside a device callback. summarize() may run concurrently; it sees each bucket
+//   atomically but not the whole histogram as one snapshot.
+// Errors: none; values above ~18 minutes land in the last bucket.
+class TimingHistogram {
+public:
+  void record(std::chrono::nanoseconds value);
+  TimingSummary summarize() const;
+  // Not synchronized with record(): samples recorded meanwhile may survive the reset.
+  void reset();
+
+private:
+  // 16 exact buckets for 0..15 ns, then 8 sub-buckets per power of two up to 2^40 ns.
+  static constexpr uint32_t kSubBuckets = 8;
+  static constexpr uint32_t kExactBuckets = 16;
+  static constexpr uint32_t kMaxExponent = 40;
+  static constexpr uint32_t kBucketCount = kExactBuckets + (kMaxExponent - 4) * kSubBuckets;
+
+  static uint32_t BucketIndex(uint64_t value);
+  static uint64_t BucketUpperEdge(uint32_t index);
+
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+  std::atomic<uint64_t> max_{0};
+};
+
+// Summary: What RenderTiming has measured; copied into PlayerEngine::Status.
+struct RenderTimingReport {
+  // Time between consecutive render wakes (device events, poll returns, timer ticks).
+  TimingSummary wake_interval;
+  // Time from wake to the end of the render cycle (RenderAudio and its bookkeeping).
+  TimingSummary callback;
+  // Callbacks that took longer than deadline (0 = not counted).
+  uint64_t deadline_overruns = 0;
+  std::chrono::microseconds deadline{0};
+  // Wake intervals longer than wake_limit (0 = not counted): the device queue may have run
+  // dry before the render thread got back to it.
+  uint64_t late_wakes = 0;
+  std::chrono::microseconds wake_limit{0};
+};
+
+// Summary: Per-output render thread instrumentation: wake-to-wake jitter and callback
+//   execution time, plus counts of callbacks that overran a deadline and of wakes that came
+//   later than the device queue lasts.
+// Preconditions: begin_callback/end_callback are called by the render thread only;
+//   everything else from any thread.
+// Postconditions: recording is lock-free and allocation-free.
+// Errors: none.
+class RenderTiming {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Summary: Note a render wake; records the interval since the previous one.
+  // Preconditions: render thread.
+  // Postconditions: the first wake after restart() records no interval.
+  // Errors: none.
+  void begin_callback(Clock::time_point wake);
+
+  // Summary: Record the cycle that started at wake and finished at done.
+  // Preconditions: render thread; follows begin_callback(wake).
+  // Postconditions: deadline_overruns advances when done - wake exceeds the deadline.
+  // Errors: none.
+  void end_callback(Clock::time_point wake, Clock::time_point done);
+
+  // Summary: Forget the previous wake so a stop/start gap is not recorded as jitter.
+  // Preconditions: render thread not running (called from start()).
+  // Postconditions: histograms are kept.
+  // Errors: none.
+  void restart();
+
+  // Summary: Callback duration above which a cycle counts as a deadline overrun.
+  // Preconditions: none; may change while running.
+  // Postconditions: applies to callbacks ending after the call. 0 disables counting.
+  // Errors: none.
+  void set_deadline(std::chrono::microseconds deadline);
+  std::chrono::microseconds deadline() const;
+
+  // Summary: Wake interval above which a wake counts as late (how long the audio queued in
+  //   the device lasts).
+  // Preconditions: none; may change while running.
+  // Postconditions: applies to wakes after the call. 0 disables counting.
+  // Errors: none.
+  void set_wake_limit(std::chrono::microseconds limit);
+  std::chrono::microseconds wake_limit() const;
+
+  RenderTimingReport report() const;
+  void reset();
+
+private:
+  TimingHistogram wake_interval_;
+  TimingHistogram callback_;
+  std::atomic<int64_t> deadline_ns_{0};
+  std::atomic<uint64_t> deadline_overruns_{0};
+  std::atomic<int64_t> wake_limit_ns_{0};
+  std::atomic<uint64_t> late_wakes_{0};
+  // Render-thread only; min() means "no previous wake".
+  Clock::time_point last_wake_{Clock::time_point::min()};
+};
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,81 @@
+#include "audio/ring_render.h"
+
+#include "buffer/audio_ring_buffer.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace tomplayer {
+namespace audio {
+
+uint32_t ConsumeRingBuffer(AudioRingBuffer* ring_buffer,
+                           SampleFormat format,
+                           DitherState* dither,
+                           void* dst,
+                           uint32_t frames_requested,
+                           uint32_t channels,
+                           std::atomic<uint64_t>* underrun_wakes,
+                           std::atomic<uint64_t>* underrun_frames) {
+  const size_t frame_bytes = static_cast<size_t>(channels) * BytesPerSample(format);
+  if (frames_requested == 0 || frame_bytes == 0) {
+    return 0;
+  }
+  assert(dst != nullptr);
+  uint8_t* out = static_cast<uint8_t*>(dst);
+
+  uint32_t frames_read = 0;
+  if (ring_buffer) {
+    // Convert straight out of ring storage into the device buffer (no staging copy).
+    const AudioRingBuffer::ReadRegion region = ring_buffer->acquire_read(frames_requested);
+    if (region.frames > 0) {
+      const uint32_t first_frames = static_cast<uint32_t>(region.first.size() / channels);
+      ConvertFloatToDevice(region.first.data(), first_frames, channels, format, dither, out);
+      if (!region.second.empty()) {
+        ConvertFloatToDevice(region.second.data(),
+                             region.frames - first_frames,
+                             channels,
+                             format,
+                             dither,
+                             out + first_frames * frame_bytes);
+      }
+      ring_buffer->commit_read(region.frames);
+      frames_read = region.frames;
+    }
+  }
+
+  if (frames_read < frames_requested) {
+    // All-zero bytes are silence in every supported format.
+    std::memset(out + frames_read * frame_bytes,
+                0,
+                (frames_requested - frames_read) * frame_bytes);
+
+    if (underrun_wakes) {
+      underrun_wakes->fetch_add(1, std::memory_order_relaxed);
+    }
+    if (underrun_frames) {
+      underrun_frames->fetch_add(frames_requested - frames_read,
+                                 std::memory_order_relaxed);
+    }
+  }
+
+  return frames_read;
+}
+
+uint32_t ConsumeRingBufferFloat(AudioRingBuffer* ring_buffer,
+                                float* dst_interleaved,
+                                uint32_t frames_requested,
+                                uint32_t channels,
+                                std::atomic<uint64_t>* underrun_wakes,
+                                std::atomic<uint64_t>* underrun_frames) {
+  return ConsumeRingBuffer(ring_buffer,
+                           SampleFormat::Float32,
+                           nullptr,
+                           dst_interleaved,
+                           frames_requested,
+                           channels,
+                           underrun_wakes,
+                           underrun_frames);
+}
+
+}  // namespace audio
+}  // namespace tomplayer
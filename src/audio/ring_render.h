@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "audio/audio_output.h"
+#include "audio/sample_convert.h"
+#include "buffer/audio_ring_buffer_fwd.h"
+
+namespace tomplayer {
+namespace audio {
+
+// Summary: Convert up to frames_requested frames from the ring straight into a device
+//   buffer of format, zero-filling any underrun tail (render thread; shared by every
+//   output backend).
+// Preconditions: dst holds frames_requested * channels * BytesPerSample(format) bytes; the
+//   ring (if non-null) has channels channels and this thread is its consumer. dither may be
+//   null (plain rounding) and is ignored for Float32.
+// Postconditions: the ring's read position advances by the frames returned; ring spans are
+//   converted in place into dst (no staging copy) and the remainder of dst is silence.
+//   Counters, when provided, record one underrun wake and the zero-filled frames for any
+//   short read.
+// Errors: returns frames read from the ring (0 for a null ring or Unsupported format).
+uint32_t ConsumeRingBuffer(AudioRingBuffer* ring_buffer,
+                           SampleFormat format,
+                           DitherState* dither,
+                           void* dst,
+                           uint32_t frames_requested,
+                           uint32_t channels,
+                           std::atomic<uint64_t>* underrun_wakes,
+                           std::atomic<uint64_t>* underrun_frames);
+
+// Summary: ConsumeRingBuffer for a float32 device buffer.
+// Preconditions: dst_interleaved holds frames_requested * channels floats; otherwise as
+//   ConsumeRingBuffer.
+// Postconditions: as ConsumeRingBuffer.
+// Errors: returns frames read from the ring (0 for a null ring).
+uint32_t ConsumeRingBufferFloat(AudioRingBuffer* ring_buffer,
+                                float* dst_interleaved,
+                                uint32_t frames_requested,
+                                uint32_t channels,
+                                std::atomic<uint64_t>* underrun_wakes,
+                                std::atomic<uint64_t>* underrun_frames);
+
+}  // namespace audio
+}  // namespace tomplayer
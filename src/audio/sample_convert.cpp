@@ -0,0 +1,459 @@
+#include "audio/sample_convert.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TOMPLAYER_CONVERT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+// AArch64 only: vcvtnq_s32_f32 (round to nearest) is not in 32-bit NEON.
+#define TOMPLAYER_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace tomplayer {
+namespace audio {
+namespace {
+
+static_assert(std::endian::native == std::endian::little,
+              "device buffers are little-endian; integer samples are stored with memcpy");
+
+// Noise-shaping error feedback (Wannamaker's 3-tap psychoacoustic filter). The noise
+// transfer function is 1 - sum(taps[k] z^-(k+1)), which is 0.25 (-12 dB) at DC.
+constexpr float kShapingTaps[3] = {1.623f, -0.982f, 0.109f};
+// Normal |error| is under 1.5 LSB (1 LSB dither + 0.5 rounding); clipping must not feed
+// its much larger error back into the next samples.
+constexpr float kMaxShapingError = 1.5f;
+
+template <SampleFormat Format>
+struct Traits;
+
+template <>
+struct Traits<SampleFormat::Pcm16> {
+  static constexpr uint32_t kBytes = 2;
+  static constexpr float kScale = 32768.0f;
+  static constexpr float kMin = -32768.0f;
+  static constexpr float kMax = 32767.0f;
+  static constexpr bool kDithered = true;
+  static void Store(int32_t value, uint8_t* out) {
+    const int16_t sample = static_cast<int16_t>(value);
+    std::memcpy(out, &sample, sizeof(sample));
+  }
+  static int32_t Load(const uint8_t* in) {
+    int16_t sample;
+    std::memcpy(&sample, in, sizeof(sample));
+    return sample;
+  }
+};
+
+template <>
+struct Traits<SampleFormat::Pcm24> {
+  static constexpr uint32_t kBytes = 3;
+  static constexpr float kScale = 8388608.0f;
+  static constexpr float kMin = -8388608.0f;
+  static constexpr float kMax = 8388607.0f;
+  static constexpr bool kDithered = true;
+  static void Store(int32_t value, uint8_t* out) {
+    const uint32_t bits = static_cast<uint32_t>(value);
+    out[0] = static_cast<uint8_t>(bits);
+    out[1] = static_cast<uint8_t>(bits >> 8);
+    out[2] = static_cast<uint8_t>(bits >> 16);
+  }
+  static int32_t Load(const uint8_t* in) {
+    // Into the top three bytes, then an arithmetic shift sign-extends.
+    const uint32_t bits = (uint32_t{in[0]} << 8) | (uint32_t{in[1]} << 16) |
+                          (uint32_t{in[2]} << 24);
+    return static_cast<int32_t>(bits) >> 8;
+  }
+};
+
+template <>
+struct Traits<SampleFormat::Pcm32> {
+  static constexpr uint32_t kBytes = 4;
+  static constexpr float kScale = 2147483648.0f;
+  static constexpr float kMin = -2147483648.0f;
+  // Largest float below 2^31; +1.0 saturates here instead of overflowing the conversion.
+  static constexpr float kMax = 2147483520.0f;
+  static constexpr bool kDithered = false;
+  static void Store(int32_t value, uint8_t* out) { std::memcpy(out, &value, sizeof(value)); }
+  static int32_t Load(const uint8_t* in) {
+    int32_t value;
+    std::memcpy(&value, in, sizeof(value));
+    return value;
+  }
+};
+
+uint32_t Xorshift(uint32_t x) {
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+// Top 23 bits as a float in [0, 1).
+float UnitFromBits(uint32_t x) {
+  return std::bit_cast<float>((x >> 9) | 0x3F800000u) - 1.0f;
+}
+
+// Four TPDF values in (-1, 1) LSB: the difference of two uniform draws per lane.
+void NextDither4(DitherState* dither, float* out) {
+  for (size_t lane = 0; lane < 4; ++lane) {
+    const uint32_t a = Xorshift(dither->rng[lane]);
+    const uint32_t b = Xorshift(a);
+    dither->rng[lane] = b;
+    out[lane] = UnitFromBits(a) - UnitFromBits(b);
+  }
+}
+
+// Clamp then round to nearest even, matching _mm_max/_mm_min + _mm_cvtps_epi32.
+template <SampleFormat Format>
+int32_t Quantize(float scaled) {
+  using T = Traits<Format>;
+  scaled = scaled > T::kMin ? scaled : T::kMin;
+  scaled = scaled < T::kMax ? scaled : T::kMax;
+  return static_cast<int32_t>(std::lrint(scaled));
+}
+
+// Each SIMD helper converts whole 4-sample blocks and returns the first sample left for
+// the scalar tail. A non-null dither draws one 4-lane TPDF vector per block.
+#if defined(TOMPLAYER_CONVERT_SSE2)
+
+__m128i Xorshift4(__m128i x) {
+  x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+  x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+  return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+}
+
+__m128 UnitFromBits4(__m128i x) {
+  const __m128i one_bits = _mm_set1_epi32(0x3F800000);
+  return _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), one_bits)),
+                    _mm_set1_ps(1.0f));
+}
+
+template <SampleFormat Format>
+void Store4(__m128i values, uint8_t* out) {
+  if constexpr (Format == SampleFormat::Pcm16) {
+    // Already clamped, so the saturating pack only narrows.
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(values, values));
+  } else if constexpr (Format == SampleFormat::Pcm32) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), values);
+  } else {
+    alignas(16) int32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), values);
+    for (size_t lane = 0; lane < 4; ++lane) {
+      Traits<Format>::Store(lanes[lane], out + lane * Traits<Format>::kBytes);
+    }
+  }
+}
+
+template <SampleFormat Format>
+size_t ConvertBlocks(const float* src, size_t samples, DitherState* dither, uint8_t* dst) {
+  using T = Traits<Format>;
+  const __m128 scale = _mm_set1_ps(T::kScale);
+  const __m128 min = _mm_set1_ps(T::kMin);
+  const __m128 max = _mm_set1_ps(T::kMax);
+  __m128i rng = dither ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->rng.data()))
+                       : _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 4 <= samples; i += 4) {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+    if (dither) {
+      const __m128i a = Xorshift4(rng);
+      rng = Xorshift4(a);
+      v = _mm_add_ps(v, _mm_sub_ps(UnitFromBits4(a), UnitFromBits4(rng)));
+    }
+    v = _mm_min_ps(_mm_max_ps(v, min), max);
+    Store4<Format>(_mm_cvtps_epi32(v), dst + i * T::kBytes);
+  }
+  if (dither) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->rng.data()), rng);
+  }
+  return i;
+}
+
+template <SampleFormat Format>
+__m128i Load4(const uint8_t* in) {
+  if constexpr (Format == SampleFormat::Pcm16) {
+    // Each 16-bit sample into the high half of its lane, then shift down sign-extending.
+    const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+    return _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+  } else if constexpr (Format == SampleFormat::Pcm32) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  } else {
+    // Packed 24-bit has no SSE2 shuffle; gather the lanes, convert them together.
+    using T = Traits<Format>;
+    return _mm_setr_epi32(T::Load(in), T::Load(in + T::kBytes), T::Load(in + 2 * T::kBytes),
+                          T::Load(in + 3 * T::kBytes));
+  }
+}
+
+template <SampleFormat Format>
+size_t ToFloatBlocks(const uint8_t* src, size_t samples, float* dst) {
+  using T = Traits<Format>;
+  const __m128 scale = _mm_set1_ps(1.0f / T::kScale);
+  size_t i = 0;
+  for (; i + 4 <= samples; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(Load4<Format>(src + i * T::kBytes)), scale));
+  }
+  return i;
+}
+
+#elif defined(TOMPLAYER_CONVERT_NEON)
+
+uint32x4_t Xorshift4(uint32x4_t x) {
+  x = veorq_u32(x, vshlq_n_u32(x, 13));
+  x = veorq_u32(x, vshrq_n_u32(x, 17));
+  return veorq_u32(x, vshlq_n_u32(x, 5));
+}
+
+float32x4_t UnitFromBits4(uint32x4_t x) {
+  const uint32x4_t one_bits = vdupq_n_u32(0x3F800000u);
+  return vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(vshrq_n_u32(x, 9), one_bits)),
+                   vdupq_n_f32(1.0f));
+}
+
+template <SampleFormat Format>
+void Store4(int32x4_t values, uint8_t* out) {
+  if constexpr (Format == SampleFormat::Pcm16) {
+    vst1_s16(reinterpret_cast<int16_t*>(out), vqmovn_s32(values));
+  } else if constexpr (Format == SampleFormat::Pcm32) {
+    vst1q_s32(reinterpret_cast<int32_t*>(out), values);
+  } else {
+    int32_t lanes[4];
+    vst1q_s32(lanes, values);
+    for (size_t lane = 0; lane < 4; ++lane) {
+      Traits<Format>::Store(lanes[lane], out + lane * Traits<Format>::kBytes);
+    }
+  }
+}
+
+template <SampleFormat Format>
+size_t ConvertBlocks(const float* src, size_t samples, DitherState* dither, uint8_t* dst) {
+  using T = Traits<Format>;
+  const float32x4_t scale = vdupq_n_f32(T::kScale);
+  const float32x4_t min = vdupq_n_f32(T::kMin);
+  const float32x4_t max = vdupq_n_f32(T::kMax);
+  uint32x4_t rng = dither ? vld1q_u32(dither->rng.data()) : vdupq_n_u32(0);
+  size_t i = 0;
+  for (; i + 4 <= samples; i += 4) {
+    float32x4_t v = vmulq_f32(vld1q_f32(src + i), scale);
+    if (dither) {
+      const uint32x4_t a = Xorshift4(rng);
+      rng = Xorshift4(a);
+      v = vaddq_f32(v, vsubq_f32(UnitFromBits4(a), UnitFromBits4(rng)));
+    }
+    v = vminq_f32(vmaxq_f32(v, min), max);
+    Store4<Format>(vcvtnq_s32_f32(v), dst + i * T::kBytes);
+  }
+  if (dither) {
+    vst1q_u32(dither->rng.data(), rng);
+  }
+  return i;
+}
+
+template <SampleFormat Format>
+int32x4_t Load4(const uint8_t* in) {
+  if constexpr (Format == SampleFormat::Pcm16) {
+    return vmovl_s16(vld1_s16(reinterpret_cast<const int16_t*>(in)));
+  } else if constexpr (Format == SampleFormat::Pcm32) {
+    return vld1q_s32(reinterpret_cast<const int32_t*>(in));
+  } else {
+    using T = Traits<Format>;
+    const int32_t lanes[4] = {T::Load(in), T::Load(in + T::kBytes), T::Load(in + 2 * T::kBytes),
+                              T::Load(in + 3 * T::kBytes)};
+    return vld1q_s32(lanes);
+  }
+}
+
+template <SampleFormat Format>
+size_t ToFloatBlocks(const uint8_t* src, size_t samples, float* dst) {
+  using T = Traits<Format>;
+  size_t i = 0;
+  for (; i + 4 <= samples; i += 4) {
+    vst1q_f32(dst + i,
+              vmulq_n_f32(vcvtq_f32_s32(Load4<Format>(src + i * T::kBytes)), 1.0f / T::kScale));
+  }
+  return i;
+}
+
+#else
+
+template <SampleFormat Format>
+size_t ConvertBlocks(const float*, size_t, DitherState*, uint8_t*) {
+  return 0;
+}
+
+template <SampleFormat Format>
+size_t ToFloatBlocks(const uint8_t*, size_t, float*) {
+  return 0;
+}
+
+#endif
+
+// Scalar path in the same 4-sample dither blocks as the SIMD helpers; a partial block at
+// the end still draws a full block and drops the unused values.
+template <SampleFormat Format>
+void ConvertScalar(const float* src,
+                   size_t first,
+                   size_t samples,
+                   DitherState* dither,
+                   uint8_t* dst) {
+  using T = Traits<Format>;
+  for (size_t i = first; i < samples; i += 4) {
+    float noise[4] = {};
+    if (dither) {
+      NextDither4(dither, noise);
+    }
+    const size_t count = std::min<size_t>(4, samples - i);
+    for (size_t k = 0; k < count; ++k) {
+      T::Store(Quantize<Format>(src[i + k] * T::kScale + noise[k]), dst + (i + k) * T::kBytes);
+    }
+  }
+}
+
+template <SampleFormat Format>
+void ConvertShaped(const float* src,
+                   size_t samples,
+                   uint32_t channels,
+                   DitherState* dither,
+                   uint8_t* dst) {
+  using T = Traits<Format>;
+  uint32_t ch = 0;
+  for (size_t i = 0; i < samples; i += 4) {
+    float noise[4];
+    NextDither4(dither, noise);
+    const size_t count = std::min<size_t>(4, samples - i);
+    for (size_t k = 0; k < count; ++k) {
+      std::array<float, 3>& error = dither->error[ch];
+      const float target = src[i + k] * T::kScale -
+                           (kShapingTaps[0] * error[0] + kShapingTaps[1] * error[1] +
+                            kShapingTaps[2] * error[2]);
+      const int32_t value = Quantize<Format>(target + noise[k]);
+      T::Store(value, dst + (i + k) * T::kBytes);
+      error[2] = error[1];
+      error[1] = error[0];
+      error[0] = std::clamp(static_cast<float>(value) - target, -kMaxShapingError,
+                            kMaxShapingError);
+      if (++ch == channels) {
+        ch = 0;
+      }
+    }
+  }
+}
+
+template <SampleFormat Format>
+void ConvertInteger(const float* src,
+                    size_t samples,
+                    uint32_t channels,
+                    DitherState* dither,
+                    uint8_t* dst) {
+  const DitherMode mode =
+      dither && Traits<Format>::kDithered ? dither->mode : DitherMode::None;
+  if (mode == DitherMode::TpdfShaped && channels <= DitherState::kMaxShapedChannels) {
+    ConvertShaped<Format>(src, samples, channels, dither, dst);
+    return;
+  }
+  DitherState* active = mode == DitherMode::None ? nullptr : dither;
+  const size_t done = ConvertBlocks<Format>(src, samples, active, dst);
+  ConvertScalar<Format>(src, done, samples, active, dst);
+}
+
+template <SampleFormat Format>
+void IntegerToFloat(const uint8_t* src, size_t samples, float* dst) {
+  using T = Traits<Format>;
+  for (size_t i = ToFloatBlocks<Format>(src, samples, dst); i < samples; ++i) {
+    dst[i] = static_cast<float>(T::Load(src + i * T::kBytes)) * (1.0f / T::kScale);
+  }
+}
+}  // namespace
+
+uint32_t BytesPerSample(SampleFormat format) {
+  switch (format) {
+    case SampleFormat::Float32:
+      return sizeof(float);
+    case SampleFormat::Pcm16:
+      return Traits<SampleFormat::Pcm16>::kBytes;
+    case SampleFormat::Pcm24:
+      return Traits<SampleFormat::Pcm24>::kBytes;
+    case SampleFormat::Pcm32:
+      return Traits<SampleFormat::Pcm32>::kBytes;
+    default:
+      return 0;
+  }
+}
+
+void DitherState::reset(DitherMode dither_mode, uint32_t seed) {
+  mode = dither_mode;
+  // xorshift32 must never hold 0; spread the seed over the lanes with a Weyl step.
+  for (size_t lane = 0; lane < rng.size(); ++lane) {
+    const uint32_t value = seed + static_cast<uint32_t>(lane) * 0x9E3779B9u;
+    rng[lane] = value != 0 ? value : 1;
+  }
+  for (std::array<float, 3>& history : error) {
+    history.fill(0.0f);
+  }
+}
+
+void ConvertFloatToDevice(const float* src,
+                          uint32_t frames,
+                          uint32_t channels,
+                          SampleFormat format,
+                          DitherState* dither,
+                          void* dst) {
+  const size_t samples = static_cast<size_t>(frames) * channels;
+  if (samples == 0) {
+    return;
+  }
+  uint8_t* out = static_cast<uint8_t*>(dst);
+  switch (format) {
+    case SampleFormat::Float32:
+      std::memcpy(out, src, samples * sizeof(float));
+      break;
+    case SampleFormat::Pcm16:
+      ConvertInteger<SampleFormat::Pcm16>(src, samples, channels, dither, out);
+      break;
+    case SampleFormat::Pcm24:
+      ConvertInteger<SampleFormat::Pcm24>(src, samples, channels, dither, out);
+      break;
+    case SampleFormat::Pcm32:
+      ConvertInteger<SampleFormat::Pcm32>(src, samples, channels, dither, out);
+      break;
+    default:
+      break;
+  }
+}
+
+void ConvertToFloat(const void* src,
+                    uint32_t frames,
+                    uint32_t channels,
+                    SampleFormat format,
+                    float* dst) {
+  const size_t samples = static_cast<size_t>(frames) * channels;
+  if (samples == 0) {
+    return;
+  }
+  const uint8_t* in = static_cast<const uint8_t*>(src);
+  switch (format) {
+    case SampleFormat::Float32:
+      std::memcpy(dst, in, samples * sizeof(float));
+      break;
+    case SampleFormat::Pcm16:
+      IntegerToFloat<SampleFormat::Pcm16>(in, samples, dst);
+      break;
+    case SampleFormat::Pcm24:
+      IntegerToFloat<SampleFormat::Pcm24>(in, samples, dst);
+      break;
+    case SampleFormat::Pcm32:
+      IntegerToFloat<SampleFormat::Pcm32>(in, samples, dst);
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace audio
+}  // namespace tomplayer
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "audio/audio_output.h"
+
+namespace tomplayer {
+namespace audio {
+
+// Summary: Bytes one sample of format occupies in a device buffer (Pcm24 is packed).
+// Preconditions: none.
+// Postconditions: none.
+// Errors: returns 0 for SampleFormat::Unsupported.
+uint32_t BytesPerSample(SampleFormat format);
+
+// How float samples are requantized to an integer device format.
+enum class DitherMode {
+  // Round to nearest; quiet material keeps its truncation distortion.
+  None,
+  // Triangular (TPDF) dither of +-1 LSB: the error becomes signal-independent white noise.
+  Tpdf,
+  // TPDF plus 3-tap error feedback that tilts the noise floor toward high frequencies
+  // (about 12 dB lower near DC). The feedback is a per-channel recurrence, so it runs scalar.
+  TpdfShaped,
+};
+
+// Summary: Dither generator and noise-shaping history for one output stream.
+// Preconditions: used by one thread at a time (the render thread).
+// Postconditions: reset() restarts the generator deterministically from seed and clears
+//   the shaping history.
+// Errors: none. Channels beyond kMaxShapedChannels fall back to unshaped TPDF.
+struct DitherState {
+  static constexpr uint32_t kMaxShapedChannels = 32;
+
+  explicit DitherState(DitherMode dither_mode = DitherMode::Tpdf) { reset(dither_mode); }
+  void reset(DitherMode dither_mode, uint32_t seed = 0x9E3779B9u);
+
+  DitherMode mode = DitherMode::Tpdf;
+  // Four xorshift32 lanes stepped together, so SIMD and scalar paths draw the same values.
+  std::array<uint32_t, 4> rng{};
+  // Last three requantization errors per channel in LSB, newest first.
+  std::array<std::array<float, 3>, kMaxShapedChannels> error{};
+};
+
+// Summary: Convert interleaved float32 samples into a device buffer of format in one pass.
+// Preconditions: src holds frames * channels samples; dst holds
+//   frames * channels * BytesPerSample(format) bytes and does not overlap src. dither may
+//   be null (plain rounding).
+// Postconditions: Float32 is copied. Integer formats are scaled by 2^(bits-1), dithered per
+//   dither->mode (Pcm16 and Pcm24; Pcm32's LSB is far below any audible floor), rounded to
+//   nearest and saturated to the format's range, little-endian (Pcm24 packed 3-byte).
+// Errors: none; Unsupported writes nothing. SSE2 (x86) or NEON (arm64) for the unshaped
+//   modes with scalar tails; real-time safe (no allocation, no locks).
+void ConvertFloatToDevice(const float* src,
+                          uint32_t frames,
+                          uint32_t channels,
+                          SampleFormat format,
+                          DitherState* dither,
+                          void* dst);
+
+// Summary: Convert interleaved little-endian samples of format to float32, the decode-side
+//   inverse of ConvertFloatToDevice (WAV data chunks, device captures).
+// Preconditions: src holds frames * channels * BytesPerSample(format) bytes, with no
+//   alignment requirement; dst holds frames * channels floats and does not overlap src.
+// Postconditions: Float32 is copied; integer formats are divided by 2^(bits-1), so full
+//   scale maps to [-1, 1) exactly.
+// Errors: none; Unsupported writes nothing. SSE2 (x86) or NEON (arm64) with scalar tails.
+void ConvertToFloat(const void* src,
+                    uint32_t frames,
+                    uint32_t channels,
+                    SampleFormat format,
+                    float* dst);
+
+}  // namespace audio
+}  // namespace tomplayer
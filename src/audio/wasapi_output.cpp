@@ -5,12 +5,27 @@
 #include <avrt.h>
 #include <ksmedia.h>
 
+#include <algorithm>
 #include <cassert>
-#include <cstring>
 
 namespace tomplayer {
 namespace wasapi {
 namespace detail {
+namespace {
+SampleFormat PcmSampleFormat(WORD bits_per_sample) {
+  switch (bits_per_sample) {
+    case 16:
+      return SampleFormat::Pcm16;
+    case 24:
+      return SampleFormat::Pcm24;
+    case 32:
+      return SampleFormat::Pcm32;
+    default:
+      return SampleFormat::Unsupported;
+  }
+}
+}  // namespace
+
 SampleFormat DetectSampleFormat(const WAVEFORMATEX* format) {
   if (!format) {
     return SampleFormat::Unsupported;
@@ -20,8 +35,8 @@ SampleFormat DetectSampleFormat(const WAVEFORMATEX* format) {
     return SampleFormat::Float32;
   }
 
-  if (format->wFormatTag == WAVE_FORMAT_PCM && format->wBitsPerSample == 16) {
-    return SampleFormat::Pcm16;
+  if (format->wFormatTag == WAVE_FORMAT_PCM) {
+    return PcmSampleFormat(format->wBitsPerSample);
   }
 
   if (format->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
@@ -30,50 +45,15 @@ SampleFormat DetectSampleFormat(const WAVEFORMATEX* format) {
         format->wBitsPerSample == 32) {
       return SampleFormat::Float32;
     }
-    if (IsEqualGUID(ext->SubFormat, KSDATAFORMAT_SUBTYPE_PCM) &&
-        format->wBitsPerSample == 16) {
-      return SampleFormat::Pcm16;
+    if (IsEqualGUID(ext->SubFormat, KSDATAFORMAT_SUBTYPE_PCM)) {
+      // The container decides the layout: 24-in-32 is MSB-aligned, so it renders as Pcm32.
+      return PcmSampleFormat(format->wBitsPerSample);
     }
   }
 
   return SampleFormat::Unsupported;
 }
 
-uint32_t ConsumeRingBufferFloat(AudioRingBuffer* ring_buffer,
-                                float* dst_interleaved,
-                                uint32_t frames_requested,
-                                uint32_t channels,
-                                std::atomic<uint64_t>* underrun_wakes,
-                                std::atomic<uint64_t>* underrun_frames) {
-  if (frames_requested == 0 || channels == 0) {
-    return 0;
-  }
-  assert(dst_interleaved != nullptr);
-
-  uint32_t frames_read = 0;
-  if (ring_buffer) {
-    frames_read = ring_buffer->read_frames(dst_interleaved, frames_requested);
-  }
-
-  if (frames_read < frames_requested) {
-    const size_t sample_offset =
-        static_cast<size_t>(frames_read) * channels;
-    const size_t samples_to_zero =
-        static_cast<size_t>(frames_requested - frames_read) * channels;
-    std::memset(dst_interleaved + sample_offset, 0, samples_to_zero * sizeof(float));
-
-    if (underrun_wakes) {
-      underrun_wakes->fetch_add(1, std::memory_order_relaxed);
-    }
-    if (underrun_frames) {
-      underrun_frames->fetch_add(frames_requested - frames_read,
-                                 std::memory_order_relaxed);
-    }
-  }
-
-  return frames_read;
-}
-
 bool SelectFloat32MixFormat(const FormatSupportApi& api,
                             const WAVEFORMATEX* device_mix_format,
                             WAVEFORMATEXTENSIBLE* float32_format) {
@@ -129,14 +109,25 @@ WasapiOutput::~WasapiOutput() {
 }
 
 
-// NOTE: ring_buffer_ is a non-owning pointer and is intentionally *not* synchronized.
-// Contract: set_ring_buffer() must be called exactly once before start(), and never
-// while the render thread is running. The AudioRingBuffer must outlive WasapiOutput.
-// This is safe because std::thread start publishes prior writes; violating this
-// contract would introduce a data race in Release builds.
+// NOTE: the ring pointer (held by core_) is non-owning. set_ring_buffer() is the pre-start
+// setter; exchange_ring_buffer() is the live path and leaves reclamation of the old buffer
+// to the caller, gated on render_grace_period_elapsed().
 void WasapiOutput::set_ring_buffer(AudioRingBuffer* ring_buffer) {
   assert(!running_.load(std::memory_order_relaxed));
-  ring_buffer_ = ring_buffer;
+  core_.set_ring_buffer(ring_buffer);
+}
+
+AudioRingBuffer* WasapiOutput::exchange_ring_buffer(AudioRingBuffer* ring_buffer) {
+  return core_.exchange_ring_buffer(ring_buffer);
+}
+
+uint32_t WasapiOutput::set_fill_frames(uint32_t frames) {
+  if (buffer_frames_ == 0) {
+    return 0;
+  }
+  const uint32_t fill = std::clamp(frames, period_frames_, buffer_frames_);
+  core_.set_fill_limit(fill);
+  return fill;
 }
 
 bool WasapiOutput::init_default_device() {
@@ -145,6 +136,14 @@ bool WasapiOutput::init_default_device() {
     return false; 
   }
 
+  // The engine is platform-neutral, so the backend joins the MTA itself. RPC_E_CHANGED_MODE
+  // means the caller already initialized COM (STA); the interfaces below still work there.
+  const HRESULT com_hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+  com_initialized_ = SUCCEEDED(com_hr);
+  if (FAILED(com_hr) && com_hr != RPC_E_CHANGED_MODE) {
+    return false;
+  }
+
   Microsoft::WRL::ComPtr<IMMDeviceEnumerator> enumerator;
   HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
                                 __uuidof(IMMDeviceEnumerator),
@@ -185,20 +184,27 @@ bool WasapiOutput::init_default_device() {
                                                                       closest);
       };
 
+  // Prefer float32 (the ring's format, copied as-is). Otherwise render into the mix format
+  // itself, which shared mode always accepts, through the integer conversion kernels.
   WAVEFORMATEXTENSIBLE float32_format{};
-  if (!detail::SelectFloat32MixFormat(format_support_api_, mix_format_, &float32_format)) {
+  const WAVEFORMATEX* stream_format = nullptr;
+  if (detail::SelectFloat32MixFormat(format_support_api_, mix_format_, &float32_format)) {
+    stream_format = &float32_format.Format;
+  } else if (detail::DetectSampleFormat(mix_format_) != SampleFormat::Unsupported) {
+    stream_format = mix_format_;
+  } else {
     shutdown();
     return false;
   }
-  sample_rate_ = float32_format.Format.nSamplesPerSec;
-  channels_ = float32_format.Format.nChannels;
-  bits_per_sample_ = float32_format.Format.wBitsPerSample;
-  block_align_ = float32_format.Format.nBlockAlign;
-  sample_format_ = SampleFormat::Float32;
+  sample_rate_ = stream_format->nSamplesPerSec;
+  channels_ = stream_format->nChannels;
+  bits_per_sample_ = stream_format->wBitsPerSample;
+  block_align_ = stream_format->nBlockAlign;
+  sample_format_ = detail::DetectSampleFormat(stream_format);
 
   hr = audio_client_->Initialize(AUDCLNT_SHAREMODE_SHARED,
                                  AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-                                 0, 0, &float32_format.Format, nullptr);
+                                 0, 0, stream_format, nullptr);
   if (FAILED(hr)) {
     shutdown();
     return false;
@@ -210,6 +216,17 @@ bool WasapiOutput::init_default_device() {
     return false;
   }
 
+  // Without a period the fill cannot be capped safely; keep the whole buffer.
+  REFERENCE_TIME default_period = 0;
+  period_frames_ = buffer_frames_;
+  if (SUCCEEDED(audio_client_->GetDevicePeriod(&default_period, nullptr)) &&
+      default_period > 0) {
+    period_frames_ = std::min<uint32_t>(
+        buffer_frames_,
+        static_cast<uint32_t>(static_cast<uint64_t>(default_period) * sample_rate_ /
+                              10'000'000ull));
+  }
+
   hr = audio_client_->GetService(__uuidof(IAudioRenderClient),
                                  reinterpret_cast<void**>(render_client_.GetAddressOf()));
   if (FAILED(hr)) {
@@ -230,20 +247,42 @@ bool WasapiOutput::init_default_device() {
     return false;
   }
 
+  // Pipeline latency past the endpoint buffer; GetCurrentPadding covers the buffer itself.
+  REFERENCE_TIME stream_latency = 0;
+  if (FAILED(audio_client_->GetStreamLatency(&stream_latency)) || stream_latency < 0) {
+    stream_latency = 0;
+  }
+  const auto latency_frames =
+      static_cast<uint32_t>(static_cast<uint64_t>(stream_latency) * sample_rate_ / 10'000'000ull);
+  core_.configure(sample_format_, channels_, buffer_frames_, sample_rate_, latency_frames);
+  core_.set_fill_limit(0);
   render_api_context_.audio_client = audio_client_.Get();
   render_api_context_.render_client = render_client_.Get();
-  render_api_.context = &render_api_context_;
-  render_api_.GetCurrentPadding = [](void* context, UINT32* padding) -> HRESULT {
+  device_api_.context = &render_api_context_;
+  device_api_.GetPadding = [](void* context, uint32_t* padding) {
     auto* ctx = static_cast<RenderApiContext*>(context);
-    return ctx->audio_client->GetCurrentPadding(padding);
+    UINT32 frames = 0;
+    if (FAILED(ctx->audio_client->GetCurrentPadding(&frames))) {
+      return false;
+    }
+    *padding = frames;
+    return true;
   };
-  render_api_.GetBuffer = [](void* context, UINT32 frames, BYTE** data) -> HRESULT {
+  device_api_.GetBuffer = [](void* context, uint32_t frames, uint8_t** data, uint32_t* granted) {
     auto* ctx = static_cast<RenderApiContext*>(context);
-    return ctx->render_client->GetBuffer(frames, data);
+    BYTE* buffer = nullptr;
+    if (FAILED(ctx->render_client->GetBuffer(frames, &buffer))) {
+      return false;
+    }
+    // WASAPI grants the whole request or fails.
+    *data = buffer;
+    *granted = frames;
+    return true;
   };
-  render_api_.ReleaseBuffer = [](void* context, UINT32 frames, DWORD flags) -> HRESULT {
+  device_api_.ReleaseBuffer = [](void* context, uint32_t frames, bool silent) {
     auto* ctx = static_cast<RenderApiContext*>(context);
-    return ctx->render_client->ReleaseBuffer(frames, flags);
+    const DWORD flags = silent ? AUDCLNT_BUFFERFLAGS_SILENT : 0;
+    return SUCCEEDED(ctx->render_client->ReleaseBuffer(frames, flags));
   };
 
   start_stop_api_.context = audio_client_.Get();
@@ -265,12 +304,13 @@ bool WasapiOutput::start() {
   if (!start_stop_api_.Start || !audio_event_ || !stop_event_) {
     return false;
   }
-  assert(ring_buffer_ != nullptr);
-  if (!ring_buffer_) {
+  AudioRingBuffer* ring_buffer = core_.ring_buffer();
+  assert(ring_buffer != nullptr);
+  if (!ring_buffer) {
     return false;
   }
-  assert(ring_buffer_->channels() == channels_);
-  if (ring_buffer_->channels() != channels_) {
+  assert(ring_buffer->channels() == channels_);
+  if (ring_buffer->channels() != channels_) {
     return false;
   }
 
@@ -279,6 +319,8 @@ bool WasapiOutput::start() {
   }
 
   ResetEvent(stop_event_);
+  core_.prepare(audio::DitherMode::Tpdf);
+  timing_.restart();
   render_thread_ = std::thread(&WasapiOutput::RenderLoop, this);
 
   const HRESULT hr = start_stop_api_.Start(start_stop_api_.context);
@@ -310,6 +352,8 @@ void WasapiOutput::stop() {
     start_stop_api_.Stop(start_stop_api_.context);
     start_stop_api_.Reset(start_stop_api_.context);
   }
+  // Reset dropped the queued frames; position holds where playback stopped.
+  core_.halt();
 }
 
 void WasapiOutput::shutdown() {
@@ -335,17 +379,25 @@ void WasapiOutput::shutdown() {
   audio_client_.Reset();
   device_.Reset();
 
-  render_api_ = {};
+  device_api_ = {};
   start_stop_api_ = {};
   format_support_api_ = {};
   render_api_context_ = {};
 
   buffer_frames_ = 0;
+  period_frames_ = 0;
   sample_rate_ = 0;
   channels_ = 0;
   bits_per_sample_ = 0;
   block_align_ = 0;
   sample_format_ = SampleFormat::Unsupported;
+  core_.configure(SampleFormat::Unsupported, 0, 0, 0);
+
+  // Last: every COM interface above has been released.
+  if (com_initialized_) {
+    com_initialized_ = false;
+    CoUninitialize();
+  }
 }
 
 void WasapiOutput::RenderLoop() {
@@ -356,6 +408,7 @@ void WasapiOutput::RenderLoop() {
   // S_OK/S_FALSE both require CoUninitialize to balance CoInitializeEx.
   const bool com_should_uninit = SUCCEEDED(com_hr);
 
+  thread_policy_.apply();
   DWORD task_index = 0;
   // MMCSS keeps the render loop prioritized without spinning.
   HANDLE mmcss_handle = AvSetMmThreadCharacteristicsW(L"Pro Audio", &task_index);
@@ -374,7 +427,12 @@ void WasapiOutput::RenderLoop() {
       break;
     }
 
+    const auto wake = audio::RenderTiming::Clock::now();
+    timing_.begin_callback(wake);
     RenderAudio();
+    // Quiescent point: this cycle no longer holds a ring pointer (see render_grace_token).
+    core_.complete_cycle();
+    timing_.end_callback(wake, audio::RenderTiming::Clock::now());
   }
 
   if (mmcss_handle) {
@@ -387,47 +445,11 @@ void WasapiOutput::RenderLoop() {
 }
 
 void WasapiOutput::RenderAudio() {
-  if (!render_api_.GetCurrentPadding || !render_api_.GetBuffer || !render_api_.ReleaseBuffer) {
-    return;
-  }
-
-  UINT32 padding = 0;
-  if (FAILED(render_api_.GetCurrentPadding(render_api_.context, &padding))) {
-    return;
-  }
-
-  if (padding >= buffer_frames_) {
+  if (!device_api_.GetPadding || !device_api_.GetBuffer || !device_api_.ReleaseBuffer) {
     return;
   }
-
-  const UINT32 frames_available = buffer_frames_ - padding;
-  if (frames_available == 0) {
-    return;
-  }
-
-  BYTE* data = nullptr;
-  if (FAILED(render_api_.GetBuffer(render_api_.context, frames_available, &data)) || !data) {
-    return;
-  }
-
-  // if not float32 then play silence (avoids garbage noise)
-  if (sample_format_ != SampleFormat::Float32) {
-    render_api_.ReleaseBuffer(render_api_.context, frames_available, AUDCLNT_BUFFERFLAGS_SILENT);
-    return;
-  }
-
-  float* out = reinterpret_cast<float*>(data);
-  const uint32_t frames_read = detail::ConsumeRingBufferFloat(ring_buffer_,
-                                                              out,
-                                                              frames_available,
-                                                              channels_,
-                                                              &underrun_wake_count_,
-                                                              &underrun_frame_count_);
-
-  const DWORD flags = frames_read == 0 ? AUDCLNT_BUFFERFLAGS_SILENT : 0;
-  render_api_.ReleaseBuffer(render_api_.context, frames_available, flags);
-  // Count all frames handed to WASAPI, including silence, to track playback clock.
-  rendered_frames_total_.fetch_add(frames_available, std::memory_order_relaxed);
+  // A failed COM call leaves the cycle short; the next event retries.
+  core_.render(device_api_);
 }
 
 #if defined(TOMPLAYER_TESTING)
@@ -17,26 +17,17 @@
 #include <windows.h>
 #include <wrl/client.h>
 
-class AudioRingBuffer;
+#include "audio/audio_output.h"
+#include "audio/render_core.h"
+#include "audio/ring_render.h"
+#include "buffer/audio_ring_buffer_fwd.h"
 
 namespace tomplayer {
 namespace wasapi {
 
-enum class SampleFormat {
-  Float32,
-  Pcm16,
-  Unsupported
-};
+using audio::SampleFormat;
 
 namespace detail {
-// Test seam for render-path unit tests; production wires COM calls into these slots.
-struct RenderApi {
-  void* context{nullptr};
-  HRESULT (*GetCurrentPadding)(void* context, UINT32* padding) = nullptr;
-  HRESULT (*GetBuffer)(void* context, UINT32 frames, BYTE** data) = nullptr;
-  HRESULT (*ReleaseBuffer)(void* context, UINT32 frames, DWORD flags) = nullptr;
-};
-
 // Test seam for start/stop without creating real COM interfaces.
 struct StartStopApi {
   void* context{nullptr};
@@ -54,25 +45,22 @@ struct FormatSupportApi {
                                WAVEFORMATEX** closest) = nullptr;
 };
 
+// Float32, or 16/24/32-bit PCM (plain or extensible; 24-in-32 maps to Pcm32).
 SampleFormat DetectSampleFormat(const WAVEFORMATEX* format);
-// Read frames into dst and zero-fill any underrun tail; updates counters if provided.
-uint32_t ConsumeRingBufferFloat(AudioRingBuffer* ring_buffer,
-                                float* dst_interleaved,
-                                uint32_t frames_requested,
-                                uint32_t channels,
-                                std::atomic<uint64_t>* underrun_wakes,
-                                std::atomic<uint64_t>* underrun_frames);
+// Shared with every backend; see audio/ring_render.h.
+using audio::ConsumeRingBufferFloat;
 // Build a float32 shared-mode format using device mix rate/channels and validate support.
 bool SelectFloat32MixFormat(const FormatSupportApi& api,
                             const WAVEFORMATEX* device_mix_format,
                             WAVEFORMATEXTENSIBLE* float32_format);
 }  // namespace detail
 
-// Summary: WASAPI shared-mode output wrapper with event-driven render thread.
-// Preconditions: COM initialized on calling thread before init_default_device.
+// Summary: WASAPI shared-mode AudioOutput backend with an event-driven render thread.
+// Preconditions: init_default_device and shutdown run on the same thread (it joins the MTA
+//   there and leaves it in shutdown).
 // Postconditions: start/stop control render thread lifecycle deterministically.
 // Errors: methods return false on initialization or start failures.
-class WasapiOutput {
+class WasapiOutput final : public audio::AudioOutput {
 public:
   WasapiOutput();
 
@@ -80,50 +68,78 @@ public:
   // Preconditions: none.
   // Postconditions: stop() has been called and resources released.
   // Errors: none.
-  ~WasapiOutput();
+  ~WasapiOutput() override;
 
   WasapiOutput(const WasapiOutput&) = delete;
   WasapiOutput& operator=(const WasapiOutput&) = delete;
 
-  // COM must stay initialized on the caller thread while COM interfaces are in use.
-  bool init_default_device();
+  // Initializes COM (multithreaded) on the calling thread, balanced by shutdown().
+  bool init_default_device() override;
 
   // Set the ring buffer used by the render thread.
   // Preconditions: must be called before start(); buffer outlives stop()/shutdown().
-  void set_ring_buffer(AudioRingBuffer* ring_buffer);
+  void set_ring_buffer(AudioRingBuffer* ring_buffer) override;
+
+  // Summary: Publish a replacement ring buffer to the render thread (RCU-style swap).
+  // Preconditions: ring_buffer is non-null and outlives its use; safe while running.
+  // Postconditions: the next render cycle reads from ring_buffer. The returned previous
+  //   buffer may still be read by the in-flight cycle; reclaim it only once
+  //   render_grace_period_elapsed(token) is true for a token taken after this call.
+  // Errors: a buffer whose channel count differs from the device renders silence.
+  AudioRingBuffer* exchange_ring_buffer(AudioRingBuffer* ring_buffer) override;
+
+  // Summary: Token for render_grace_period_elapsed, sampled after exchange_ring_buffer.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint64_t render_grace_token() const override { return core_.render_grace_token(); }
+
+  // Summary: True once no render cycle can still hold a ring pointer loaded before token.
+  // Preconditions: called on the thread that swaps and calls start()/stop().
+  // Postconditions: does not modify state.
+  // Errors: none.
+  bool render_grace_period_elapsed(uint64_t token) const override {
+    return !running_.load(std::memory_order_acquire) || core_.cycle_completed_since(token);
+  }
 
   // Start requires init_default_device, a non-null ring buffer, and matching channels.
-  bool start();
+  bool start() override;
 
   // Summary: Stop rendering and join the render thread.
   // Preconditions: none (safe if not running).
   // Postconditions: no render callbacks execute after return.
   // Errors: none.
-  void stop();
+  void stop() override;
 
   // Summary: Stop and release all COM resources and OS handles.
   // Preconditions: none.
   // Postconditions: object returns to uninitialized state.
   // Errors: none.
-  void shutdown();
+  void shutdown() override;
+
+  // Summary: Whether the render thread is running (between start() and stop()).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  bool is_running() const override { return running_.load(std::memory_order_acquire); }
 
   // Summary: Device mix sample rate in Hz.
   // Preconditions: init_default_device succeeded.
   // Postconditions: none.
   // Errors: returns 0 if uninitialized.
-  uint32_t sample_rate() const { return sample_rate_; }
+  uint32_t sample_rate() const override { return sample_rate_; }
 
   // Summary: Device channel count.
   // Preconditions: init_default_device succeeded.
   // Postconditions: none.
   // Errors: returns 0 if uninitialized.
-  uint16_t channels() const { return channels_; }
+  uint16_t channels() const override { return channels_; }
 
-  // Summary: Device sample format.
+  // Summary: Device sample format: Float32 when the device accepts it, else the mix format.
   // Preconditions: init_default_device succeeded.
   // Postconditions: none.
   // Errors: Unsupported if format is not handled.
-  SampleFormat sample_format() const { return sample_format_; }
+  SampleFormat sample_format() const override { return sample_format_; }
 
   // Summary: Bits per sample of the mix format.
   // Preconditions: init_default_device succeeded.
@@ -135,32 +151,52 @@ public:
   // Preconditions: init_default_device succeeded.
   // Postconditions: none.
   // Errors: returns 0 if uninitialized.
-  uint32_t buffer_frames() const { return buffer_frames_; }
+  uint32_t buffer_frames() const override { return buffer_frames_; }
   // Summary: Number of render wakes that saw a short read.
   // Preconditions: none.
   // Postconditions: does not modify state.
   // Errors: none.
-  uint64_t underrun_wake_count() const { return underrun_wake_count_.load(std::memory_order_relaxed); }
+  uint64_t underrun_wake_count() const override { return core_.underrun_wake_count(); }
 
   // Summary: Number of frames zero-filled due to underrun.
   // Preconditions: none.
   // Postconditions: does not modify state.
   // Errors: none.
-  uint64_t underrun_frame_count() const { return underrun_frame_count_.load(std::memory_order_relaxed); }
+  uint64_t underrun_frame_count() const override { return core_.underrun_frame_count(); }
 
   // Summary: Number of frames handed to WASAPI since last reset.
   // Preconditions: none.
   // Postconditions: does not modify state.
   // Errors: none.
-  uint64_t rendered_frames_total() const {
-    return rendered_frames_total_.load(std::memory_order_relaxed);
-  }
+  uint64_t rendered_frames_total() const override { return core_.rendered_frames_total(); }
 
   // Summary: Reset rendered frame counter (engine-thread only).
   // Preconditions: render thread stopped or quiescent.
   // Postconditions: rendered_frames_total returns 0.
   // Errors: none.
-  void reset_rendered_frames() { rendered_frames_total_.store(0, std::memory_order_relaxed); }
+  void reset_rendered_frames() override { core_.reset_rendered_frames(); }
+
+  // Summary: Event-wake intervals and RenderAudio execution time.
+  // Preconditions: none.
+  // Postconditions: none.
+  // Errors: none.
+  audio::RenderTiming& render_timing() override { return timing_; }
+  platform::ThreadPolicySlot& render_thread_policy() override { return thread_policy_; }
+
+  // Summary: Padding plus IAudioClient::GetStreamLatency, interpolated between wakes.
+  // Preconditions: none.
+  // Postconditions: none.
+  // Errors: none.
+  const audio::PresentationClock& presentation_clock() const override {
+    return core_.presentation_clock();
+  }
+
+  // Summary: Cap padding below the buffer size; the audio event still fires every device
+  //   period.
+  // Preconditions: none.
+  // Postconditions: clamped to [device period, buffer_frames].
+  // Errors: returns 0 if uninitialized.
+  uint32_t set_fill_frames(uint32_t frames) override;
 
 #if defined(TOMPLAYER_TESTING)
   void set_start_stop_api_for_test(const detail::StartStopApi& api,
@@ -177,8 +213,9 @@ private:
   // Errors: none.
   void RenderLoop();
 
-  // Summary: Single render cycle (padding -> get buffer -> fill -> release).
-  // Preconditions: render thread only; render_api_ is valid.
+  // Summary: Single render cycle through the shared render core (padding -> get buffer ->
+  //   fill -> release); COM calls reach it through device_api_.
+  // Preconditions: render thread only; device_api_ is valid.
   // Postconditions: buffer released or method returns early.
   // Errors: on failure, returns without rendering (silence handled by caller).
   void RenderAudio();
@@ -194,6 +231,9 @@ private:
 
   WAVEFORMATEX* mix_format_{nullptr};
 
+  // True when init_default_device's CoInitializeEx must be balanced in shutdown().
+  bool com_initialized_{false};
+
   HANDLE audio_event_{nullptr};
   HANDLE stop_event_{nullptr};
 
@@ -201,21 +241,23 @@ private:
   std::atomic<bool> running_{false};
 
   uint32_t buffer_frames_{0};
+  // Default device period: the audio event interval, and the smallest safe fill.
+  uint32_t period_frames_{0};
   uint32_t sample_rate_{0};
   uint16_t channels_{0};
   uint16_t bits_per_sample_{0};
   uint16_t block_align_{0};
   SampleFormat sample_format_{SampleFormat::Unsupported};
 
-  detail::RenderApi render_api_{};
+  audio::DeviceBufferApi device_api_{};
   detail::StartStopApi start_stop_api_{};
   detail::FormatSupportApi format_support_api_{};
   RenderApiContext render_api_context_{};
 
-  AudioRingBuffer* ring_buffer_{nullptr};
-  std::atomic<uint64_t> underrun_wake_count_{0};
-  std::atomic<uint64_t> underrun_frame_count_{0};
-  std::atomic<uint64_t> rendered_frames_total_{0};
+  // Ring pointer, conversion, silence flags, underrun accounting and the rendered clock.
+  audio::RenderCore core_;
+  audio::RenderTiming timing_;
+  platform::ThreadPolicySlot thread_policy_;
 };
 
 }  // namespace wasapi
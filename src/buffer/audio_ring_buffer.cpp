@@ -1,186 +1,417 @@
 #include "buffer/audio_ring_buffer.h"
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstring>
+#include <new>
+#include <numeric>
 
-AudioRingBuffer::AudioRingBuffer(uint32_t capacity_frames, uint32_t channels)
-    : capacity_frames_(capacity_frames),
-      channels_(channels),
-      storage_(static_cast<size_t>(capacity_frames) * channels) {}
+namespace {
+constexpr uint32_t kMaxPowerOfTwoCapacityFrames = 1u << 31;
 
-uint32_t AudioRingBuffer::available_to_write_frames() const {
-  const uint64_t read_pos =
-      read_pos_frames_.load(std::memory_order_acquire);
-  const uint64_t write_pos =
-      write_pos_frames_.load(std::memory_order_relaxed);
-  const uint32_t available_read =
-      available_to_read_frames_impl(write_pos, read_pos);
-  return capacity_frames_ - available_read;
+uint32_t RoundUpToPowerOfTwo(uint32_t capacity_frames) {
+  if (capacity_frames == 0 || capacity_frames > kMaxPowerOfTwoCapacityFrames) {
+    return capacity_frames;
+  }
+  return std::bit_ceil(capacity_frames);
 }
 
-uint32_t AudioRingBuffer::write_frames(const float* src_interleaved,
-                                       uint32_t frames_requested) {
-  if (frames_requested > 0) {
-    assert(src_interleaved != nullptr);
+// Smallest capacity >= capacity_frames whose byte size is a whole number of pages; 0 if none
+// fits in uint32_t. Page sizes are powers of two, so the frame granule is one as well.
+uint32_t RoundUpToPageFrames(uint32_t capacity_frames, size_t frame_bytes, size_t page_size) {
+  const size_t granule = page_size / std::gcd(page_size, frame_bytes);
+  const uint64_t rounded =
+      (static_cast<uint64_t>(capacity_frames) + granule - 1) / granule * granule;
+  return rounded <= UINT32_MAX ? static_cast<uint32_t>(rounded) : 0;
+}
+}  // namespace
+
+template <typename SampleT, uint32_t Channels>
+BasicAudioRingBuffer<SampleT, Channels>::BasicAudioRingBuffer(uint32_t capacity_frames,
+                                                              uint32_t channels,
+                                                              CapacityMode capacity_mode,
+                                                              StorageBackend storage_backend,
+                                                              MemoryPolicy memory_policy)
+    : channels_(Channels != kDynamicChannels ? Channels : channels) {
+  assert(Channels == kDynamicChannels || channels == Channels);
+  if (capacity_mode == CapacityMode::PowerOfTwo) {
+    capacity_frames = RoundUpToPowerOfTwo(capacity_frames);
   }
-  if (!storage_.size() || capacity_frames_ == 0 || channels_ == 0) {
-    return 0;
+  const size_t page_size = MirroredMapping::page_size();
+  if (storage_backend == StorageBackend::Mirrored && page_size > 0 && capacity_frames > 0 &&
+      channels_ > 0) {
+    // Rounding to pages keeps a power-of-two capacity a power of two (both granules are).
+    const uint32_t mirrored_frames =
+        RoundUpToPageFrames(capacity_frames, frame_bytes(), page_size);
+    if (mirrored_frames > 0 &&
+        mirror_.map(static_cast<size_t>(mirrored_frames) * frame_bytes())) {
+      capacity_frames = mirrored_frames;
+      data_ = static_cast<SampleT*>(mirror_.data());
+      // Both views need their page-table entries populated, not just the shared pages.
+      memory_residency_ = tomplayer::platform::MakeResident(mirror_.data(),
+                                                            mirror_.size_bytes() * 2,
+                                                            memory_policy);
+    }
   }
+  const size_t storage_bytes = static_cast<size_t>(capacity_frames) * frame_bytes();
+  if (!data_ && storage_bytes > 0) {
+    if (!storage_.allocate(storage_bytes, memory_policy)) {
+      throw std::bad_alloc();
+    }
+    data_ = static_cast<SampleT*>(storage_.data());
+    memory_residency_ = storage_.residency();
+  }
+  index_.set_capacity(capacity_frames);
+}
 
-  const uint64_t read_pos =
-      read_pos_frames_.load(std::memory_order_acquire);
-  const uint64_t write_pos =
-      write_pos_frames_.load(std::memory_order_relaxed);
-  const uint32_t available_read =
-      available_to_read_frames_impl(write_pos, read_pos);
-  const uint32_t available_write = capacity_frames_ - available_read;
+template <typename SampleT, uint32_t Channels>
+uint32_t BasicAudioRingBuffer<SampleT, Channels>::available_to_write_frames() const {
+  return index_.available_to_write_frames();
+}
 
-  const uint32_t frames_to_write = std::min(frames_requested, available_write);
-  if (frames_to_write == 0) {
-    if (frames_requested != 0) {
-      overrun_count_.fetch_add(1, std::memory_order_relaxed);
-    }
-    return 0;
+template <typename SampleT, uint32_t Channels>
+typename BasicAudioRingBuffer<SampleT, Channels>::WriteRegion
+BasicAudioRingBuffer<SampleT, Channels>::acquire_write(uint32_t frames_requested) {
+  if (!data_ || channel_count() == 0) {
+    return {};
   }
 
-  const uint32_t write_index =
-      static_cast<uint32_t>(write_pos % capacity_frames_);
-  const uint32_t frames_until_end = capacity_frames_ - write_index;
-  const uint32_t first_chunk = std::min(frames_to_write, frames_until_end);
-  const uint32_t second_chunk = frames_to_write - first_chunk;
+  const SpscFrameIndex::Reservation reservation = index_.acquire_write(frames_requested);
+  if (reservation.frames == 0) {
+    return {};
+  }
 
-  const size_t sample_offset =
-      static_cast<size_t>(write_index) * channels_;
-  const size_t first_samples = static_cast<size_t>(first_chunk) * channels_;
-  const size_t second_samples = static_cast<size_t>(second_chunk) * channels_;
+  // Publish the claim before the caller touches storage (seqlock writer side for taps).
+  write_claim_frames_.store(reservation.start_frame + reservation.frames,
+                            std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  return MakeRegion<SampleT>(reservation.start_frame, reservation.frames);
+}
 
-  std::memcpy(storage_.data() + sample_offset,
+template <typename SampleT, uint32_t Channels>
+void BasicAudioRingBuffer<SampleT, Channels>::commit_write(uint32_t frames_written) {
+  index_.commit_write(frames_written);
+}
+
+template <typename SampleT, uint32_t Channels>
+uint32_t BasicAudioRingBuffer<SampleT, Channels>::write_frames(const SampleT* src_interleaved,
+                                                               uint32_t frames_requested) {
+  if (frames_requested > 0) {
+    assert(src_interleaved != nullptr);
+  }
+
+  const WriteRegion region = acquire_write(frames_requested);
+  if (region.frames == 0) {
+    return 0;
+  }
+
+  std::memcpy(region.first.data(),
               src_interleaved,
-              first_samples * sizeof(float));
-  if (second_chunk > 0) {
-    std::memcpy(storage_.data(),
-                src_interleaved + first_samples,
-                second_samples * sizeof(float));
+              region.first.size_bytes());
+  if (!region.second.empty()) {
+    std::memcpy(region.second.data(),
+                src_interleaved + region.first.size(),
+                region.second.size_bytes());
   }
 
-  write_pos_frames_.store(write_pos + frames_to_write,
-                          std::memory_order_release);
+  commit_write(region.frames);
+  return region.frames;
+}
+
+template <typename SampleT, uint32_t Channels>
+uint32_t BasicAudioRingBuffer<SampleT, Channels>::available_to_read_frames() const {
+  return index_.available_to_read_frames();
+}
+
+template <typename SampleT, uint32_t Channels>
+typename BasicAudioRingBuffer<SampleT, Channels>::ReadRegion
+BasicAudioRingBuffer<SampleT, Channels>::acquire_read(uint32_t frames_requested) {
+  if (!data_ || channel_count() == 0) {
+    return {};
+  }
 
-  if (frames_to_write < frames_requested) {
-    overrun_count_.fetch_add(1, std::memory_order_relaxed);
+  if (flush_request_epoch_.load(std::memory_order_relaxed) > flush_applied_epoch_) {
+    apply_pending_flush();
   }
 
-  return frames_to_write;
+  const SpscFrameIndex::Reservation reservation = index_.acquire_read(frames_requested);
+  if (reservation.frames == 0) {
+    return {};
+  }
+  return MakeRegion<const SampleT>(reservation.start_frame, reservation.frames);
 }
 
-uint32_t AudioRingBuffer::available_to_read_frames() const {
-  const uint64_t write_pos =
-      write_pos_frames_.load(std::memory_order_acquire);
-  const uint64_t read_pos =
-      read_pos_frames_.load(std::memory_order_relaxed);
-  return available_to_read_frames_impl(write_pos, read_pos);
+template <typename SampleT, uint32_t Channels>
+void BasicAudioRingBuffer<SampleT, Channels>::commit_read(uint32_t frames_read) {
+  if (frames_read == 0) {
+    return;
+  }
+
+  // Publish any marker reached by this commit before the new read position, so readers
+  // never see a position past a marker they cannot yet observe.
+  const uint64_t read_end = index_.read_commit_end(frames_read);
+  markers_.publish_through(read_end);
+  index_.publish_read_pos(read_end);
 }
 
-uint32_t AudioRingBuffer::read_frames(float* dst_interleaved,
-                                      uint32_t frames_requested) {
+template <typename SampleT, uint32_t Channels>
+uint32_t BasicAudioRingBuffer<SampleT, Channels>::read_frames(SampleT* dst_interleaved,
+                                                              uint32_t frames_requested) {
   if (frames_requested > 0) {
     assert(dst_interleaved != nullptr);
   }
-  if (!storage_.size() || capacity_frames_ == 0 || channels_ == 0) {
+
+  const ReadRegion region = acquire_read(frames_requested);
+  if (region.frames == 0) {
     return 0;
   }
 
-  const uint64_t write_pos =
-      write_pos_frames_.load(std::memory_order_acquire);
-  const uint64_t read_pos =
-      read_pos_frames_.load(std::memory_order_relaxed);
-  const uint32_t available_read =
-      available_to_read_frames_impl(write_pos, read_pos);
+  std::memcpy(dst_interleaved,
+              region.first.data(),
+              region.first.size_bytes());
+  if (!region.second.empty()) {
+    std::memcpy(dst_interleaved + region.first.size(),
+                region.second.data(),
+                region.second.size_bytes());
+  }
 
-  const uint32_t frames_to_read = std::min(frames_requested, available_read);
-  if (frames_to_read == 0) {
-    if (frames_requested != 0) {
-      underrun_count_.fetch_add(1, std::memory_order_relaxed);
-    }
-    return 0;
+  commit_read(region.frames);
+  return region.frames;
+}
+
+template <typename SampleT, uint32_t Channels>
+void BasicAudioRingBuffer<SampleT, Channels>::publish_epoch_boundary(uint64_t epoch) {
+  const uint64_t write_pos = index_.write_pos_frames(std::memory_order_relaxed);
+  const uint32_t seq = boundary_seq_.load(std::memory_order_relaxed);
+  boundary_seq_.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  boundary_epoch_.store(epoch, std::memory_order_relaxed);
+  boundary_frame_.store(write_pos, std::memory_order_relaxed);
+  boundary_seq_.store(seq + 2, std::memory_order_release);
+}
+
+template <typename SampleT, uint32_t Channels>
+void BasicAudioRingBuffer<SampleT, Channels>::request_flush(uint64_t epoch) {
+  assert(epoch > 0);
+  flush_request_epoch_.store(epoch, std::memory_order_release);
+}
+
+template <typename SampleT, uint32_t Channels>
+bool BasicAudioRingBuffer<SampleT, Channels>::apply_pending_flush() {
+  const uint64_t requested = flush_request_epoch_.load(std::memory_order_acquire);
+  if (requested <= flush_applied_epoch_) {
+    return true;
+  }
+
+  // Load write_pos before the boundary: any frame of the requested epoch committed at or
+  // below it was preceded by the boundary publish, so the boundary read below sees it.
+  const uint64_t write_pos = index_.write_pos_frames();
+  // One seqlock read, no retry: the consumer may be a SCHED_FIFO thread that preempted the
+  // producer mid-publish, and spinning would keep the producer from ever finishing. A
+  // publish in progress counts as not yet published; no frame of the new epoch is written
+  // before the publish completes, so discarding up to write_pos is still safe.
+  const uint32_t before = boundary_seq_.load(std::memory_order_acquire);
+  const uint64_t boundary_epoch = boundary_epoch_.load(std::memory_order_relaxed);
+  const uint64_t boundary_frame = boundary_frame_.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const bool consistent =
+      (before & 1u) == 0 && boundary_seq_.load(std::memory_order_relaxed) == before;
+
+  const bool reached = consistent && boundary_epoch >= requested;
+  // Boundary frames never exceed the producer's committed write_pos, even if the write_pos
+  // loaded above is older than the boundary.
+  const uint64_t target = reached ? boundary_frame : write_pos;
+  const uint64_t read_pos = index_.read_pos_frames(std::memory_order_relaxed);
+  index_.observe_write_pos(std::max(write_pos, target));
+  if (target > read_pos) {
+    markers_.publish_through(target);
+    index_.publish_read_pos(target);
+  }
+  if (reached) {
+    flush_applied_epoch_ = requested;
   }
+  return reached;
+}
 
-  const uint32_t read_index =
-      static_cast<uint32_t>(read_pos % capacity_frames_);
-  const uint32_t frames_until_end = capacity_frames_ - read_index;
-  const uint32_t first_chunk = std::min(frames_to_read, frames_until_end);
-  const uint32_t second_chunk = frames_to_read - first_chunk;
+template <typename SampleT, uint32_t Channels>
+bool BasicAudioRingBuffer<SampleT, Channels>::push_marker(uint64_t epoch,
+                                                          uint64_t track_id,
+                                                          int64_t source_frame) {
+  FrameMarker marker;
+  marker.ring_frame = index_.write_pos_frames(std::memory_order_relaxed);
+  marker.epoch = epoch;
+  marker.track_id = track_id;
+  marker.source_frame = source_frame;
+  return markers_.push(marker);
+}
 
-  const size_t sample_offset =
-      static_cast<size_t>(read_index) * channels_;
-  const size_t first_samples = static_cast<size_t>(first_chunk) * channels_;
-  const size_t second_samples = static_cast<size_t>(second_chunk) * channels_;
+template <typename SampleT, uint32_t Channels>
+bool BasicAudioRingBuffer<SampleT, Channels>::current_marker(
+    FrameMarker* marker, uint64_t* frames_since_marker) const {
+  assert(marker != nullptr && frames_since_marker != nullptr);
+  // Load read_pos first: commit_read publishes every marker at or below a read position
+  // before storing it, so the marker seen next is never older than the one read_pos passed.
+  // It may be newer (published for a commit whose read_pos is not visible yet); clamp to it.
+  const uint64_t read_pos = index_.read_pos_frames();
+  if (!markers_.latest(marker)) {
+    return false;
+  }
+  *frames_since_marker = read_pos > marker->ring_frame ? read_pos - marker->ring_frame : 0;
+  return true;
+}
 
-  std::memcpy(dst_interleaved,
-              storage_.data() + sample_offset,
-              first_samples * sizeof(float));
-  if (second_chunk > 0) {
-    std::memcpy(dst_interleaved + first_samples,
-                storage_.data(),
-                second_samples * sizeof(float));
+template <typename SampleT, uint32_t Channels>
+AudioRingBufferTypes::TapCursor BasicAudioRingBuffer<SampleT, Channels>::open_tap() const {
+  TapCursor tap;
+  tap.generation = reset_generation_.load(std::memory_order_acquire);
+  tap.position_frames = index_.read_pos_frames();
+  return tap;
+}
+
+template <typename SampleT, uint32_t Channels>
+uint32_t BasicAudioRingBuffer<SampleT, Channels>::read_tap(TapCursor* tap,
+                                                           SampleT* dst_interleaved,
+                                                           uint32_t frames_requested) const {
+  assert(tap != nullptr);
+  if (!data_ || channel_count() == 0 || frames_requested == 0) {
+    return 0;
+  }
+  assert(dst_interleaved != nullptr);
+
+  // Frames below read_pos were consumed; frames below claim - capacity may already be reused.
+  const uint32_t capacity_frames = index_.capacity_frames();
+  const uint64_t read_pos = index_.read_pos_frames();
+  const uint64_t claim_before = write_claim_frames_.load(std::memory_order_acquire);
+  const uint32_t generation = reset_generation_.load(std::memory_order_acquire);
+  if (tap->generation != generation) {
+    // Ring was reset underneath the tap; positions restart from zero.
+    tap->generation = generation;
+    tap->position_frames = 0;
+  }
+  tap->position_frames = std::min(tap->position_frames, read_pos);
+  const uint64_t oldest_intact =
+      claim_before > capacity_frames ? claim_before - capacity_frames : 0;
+  if (tap->position_frames < oldest_intact) {
+    tap->dropped_frames += oldest_intact - tap->position_frames;
+    tap->position_frames = oldest_intact;
   }
 
-  read_pos_frames_.store(read_pos + frames_to_read,
-                         std::memory_order_release);
+  const uint64_t pending = read_pos > tap->position_frames ? read_pos - tap->position_frames : 0;
+  uint32_t frames = static_cast<uint32_t>(std::min<uint64_t>(frames_requested, pending));
+  if (frames == 0) {
+    return 0;
+  }
+
+  const Region<const SampleT> region = MakeRegion<const SampleT>(tap->position_frames, frames);
+  std::memcpy(dst_interleaved, region.first.data(), region.first.size_bytes());
+  if (!region.second.empty()) {
+    std::memcpy(dst_interleaved + region.first.size(),
+                region.second.data(),
+                region.second.size_bytes());
+  }
 
-  if (frames_to_read < frames_requested) {
-    underrun_count_.fetch_add(1, std::memory_order_relaxed);
+  // Seqlock reader side: any slot the producer claimed while we copied may be torn, so drop
+  // the leading frames that fell behind the new claim and keep the verified tail.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t claim_after = write_claim_frames_.load(std::memory_order_relaxed);
+  const uint64_t oldest_after =
+      claim_after > capacity_frames ? claim_after - capacity_frames : 0;
+  if (tap->position_frames < oldest_after) {
+    const uint32_t torn = static_cast<uint32_t>(
+        std::min<uint64_t>(frames, oldest_after - tap->position_frames));
+    const size_t channels = channel_count();
+    std::memmove(dst_interleaved,
+                 dst_interleaved + static_cast<size_t>(torn) * channels,
+                 static_cast<size_t>(frames - torn) * channels * sizeof(SampleT));
+    tap->dropped_frames += torn;
+    tap->position_frames += torn;
+    frames -= torn;
   }
 
-  return frames_to_read;
+  tap->position_frames += frames;
+  return frames;
 }
 
-void AudioRingBuffer::reset() {
-  // Safe only when no producer/consumer threads are active on the buffer.
-#ifndef NDEBUG
-  assert(available_to_read_frames() == 0);
-  assert(available_to_write_frames() == capacity_frames_);
-#endif
-  write_pos_frames_.store(0, std::memory_order_relaxed);
-  read_pos_frames_.store(0, std::memory_order_relaxed);
-  underrun_count_.store(0, std::memory_order_relaxed);
-  overrun_count_.store(0, std::memory_order_relaxed);
-  invariant_violation_count_.store(0, std::memory_order_relaxed);
+template <typename SampleT, uint32_t Channels>
+bool BasicAudioRingBuffer<SampleT, Channels>::wait_writable(uint32_t min_frames,
+                                                            std::chrono::nanoseconds timeout) {
+  return index_.wait_writable(min_frames, timeout);
 }
 
-uint64_t AudioRingBuffer::underrun_count() const {
-  return underrun_count_.load(std::memory_order_relaxed);
+template <typename SampleT, uint32_t Channels>
+bool BasicAudioRingBuffer<SampleT, Channels>::wait_readable(uint32_t min_frames,
+                                                            std::chrono::nanoseconds timeout) {
+  return index_.wait_readable(min_frames, timeout);
 }
 
-uint64_t AudioRingBuffer::overrun_count() const {
-  return overrun_count_.load(std::memory_order_relaxed);
+template <typename SampleT, uint32_t Channels>
+void BasicAudioRingBuffer<SampleT, Channels>::reset() {
+  // Safe only when no producer/consumer threads are active on the buffer; any buffered
+  // frames are discarded.
+  index_.reset();
+  write_claim_frames_.store(0, std::memory_order_relaxed);
+  markers_.reset();
+  flush_applied_epoch_ = 0;
+  flush_request_epoch_.store(0, std::memory_order_relaxed);
+  boundary_epoch_.store(0, std::memory_order_relaxed);
+  boundary_frame_.store(0, std::memory_order_relaxed);
+  reset_generation_.fetch_add(1, std::memory_order_release);
 }
 
-uint64_t AudioRingBuffer::invariant_violation_count() const {
-  return invariant_violation_count_.load(std::memory_order_relaxed);
+template <typename SampleT, uint32_t Channels>
+uint64_t BasicAudioRingBuffer<SampleT, Channels>::underrun_count() const {
+  return index_.underrun_count();
 }
 
-uint32_t AudioRingBuffer::available_to_read_frames_impl(uint64_t write_pos_frames,
-                                                        uint64_t read_pos_frames) const {
-#ifndef NDEBUG
-  assert(write_pos_frames >= read_pos_frames);
-  assert(write_pos_frames - read_pos_frames <= capacity_frames_);
-#else
-  if (write_pos_frames < read_pos_frames) {
-    invariant_violation_count_.fetch_add(1, std::memory_order_relaxed);
-    return 0;
+template <typename SampleT, uint32_t Channels>
+uint64_t BasicAudioRingBuffer<SampleT, Channels>::overrun_count() const {
+  return index_.overrun_count();
+}
+
+template <typename SampleT, uint32_t Channels>
+uint64_t BasicAudioRingBuffer<SampleT, Channels>::invariant_violation_count() const {
+  return index_.invariant_violation_count();
+}
+
+template <typename SampleT, uint32_t Channels>
+template <typename T>
+AudioRingBufferTypes::Region<T> BasicAudioRingBuffer<SampleT, Channels>::MakeRegion(
+    uint64_t start_pos_frames,
+    uint32_t frames) const {
+  const uint32_t start_index = index_.index_of(start_pos_frames);
+  const size_t channels = channel_count();
+  T* base = data_;
+
+  Region<T> region;
+  region.frames = frames;
+  if (mirror_.data()) {
+    // The second view aliases the first, so running past the end is just the wrapped tail.
+    region.first = std::span<T>(base + static_cast<size_t>(start_index) * channels,
+                                static_cast<size_t>(frames) * channels);
+    return region;
   }
-#endif
 
-  const uint64_t available = write_pos_frames - read_pos_frames;
-#ifndef NDEBUG
-  return static_cast<uint32_t>(available);
-#else
-  if (available > capacity_frames_) {
-    invariant_violation_count_.fetch_add(1, std::memory_order_relaxed);
-    return capacity_frames_;
+  // Split at the end of storage; the second span is the wrapped tail (if any).
+  const uint32_t frames_until_end = index_.capacity_frames() - start_index;
+  const uint32_t first_chunk = std::min(frames, frames_until_end);
+  const uint32_t second_chunk = frames - first_chunk;
+
+  region.first = std::span<T>(base + static_cast<size_t>(start_index) * channels,
+                              static_cast<size_t>(first_chunk) * channels);
+  if (second_chunk > 0) {
+    region.second = std::span<T>(base, static_cast<size_t>(second_chunk) * channels);
   }
-  return static_cast<uint32_t>(available);
-#endif
+  return region;
 }
+
+// Supported instantiations; add a line here to enable another fixed channel count.
+template class BasicAudioRingBuffer<float, kDynamicChannels>;
+template class BasicAudioRingBuffer<float, 1>;
+template class BasicAudioRingBuffer<float, 2>;
+template class BasicAudioRingBuffer<int32_t, kDynamicChannels>;
+template class BasicAudioRingBuffer<int32_t, 1>;
+template class BasicAudioRingBuffer<int32_t, 2>;
+template class BasicAudioRingBuffer<int16_t, kDynamicChannels>;
+template class BasicAudioRingBuffer<int16_t, 1>;
+template class BasicAudioRingBuffer<int16_t, 2>;
@@ -1,22 +1,122 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <type_traits>
 #include <vector>
 
-// AudioRingBuffer
+#include "buffer/audio_ring_buffer_fwd.h"
+#include "buffer/frame_marker_queue.h"
+#include "buffer/mirrored_mapping.h"
+#include "buffer/spsc_frame_index.h"
+#include "platform/resident_memory.h"
+
+// Summary: Types shared by every BasicAudioRingBuffer instantiation.
+// Preconditions: none.
+// Postconditions: none.
+// Errors: none.
+struct AudioRingBufferTypes {
+  // Summary: Frame range inside storage, split into at most two contiguous spans.
+  // Preconditions: none.
+  // Postconditions: first holds the leading samples; second is empty unless the range wraps
+  //   (never with StorageBackend::Mirrored).
+  // Errors: frames == 0 with both spans empty when nothing could be reserved.
+  template <typename T>
+  struct Region {
+    std::span<T> first;
+    std::span<T> second;
+    uint32_t frames = 0;
+  };
+
+  // Summary: How the requested capacity maps to storage and index arithmetic.
+  // Exact keeps the requested capacity (masking only if it already is a power of two);
+  // PowerOfTwo rounds capacity up so every index is a mask (no 64-bit division on the RT thread).
+  enum class CapacityMode { Exact, PowerOfTwo };
+
+  // Summary: Where samples live. Heap is one anonymous page-aligned allocation; Mirrored maps
+  // the storage twice back-to-back so reads/writes never split at the end of the buffer.
+  enum class StorageBackend { Heap, Mirrored };
+
+  // Summary: Page residency of storage (prefault / lock / huge pages, with fallbacks).
+  using MemoryPolicy = tomplayer::platform::MemoryPolicy;
+  using MemoryResidency = tomplayer::platform::MemoryResidency;
+
+  // Summary: Position of one lossy observer ("tap") over frames the consumer has released.
+  // Preconditions: owned by one observer thread; any number of taps per ring.
+  // Postconditions: read_tap advances position_frames and accumulates dropped_frames.
+  // Errors: none.
+  struct TapCursor {
+    uint64_t position_frames = 0;
+    uint64_t dropped_frames = 0;
+    uint32_t generation = 0;
+  };
+
+  // Summary: Capacity in frames that holds latency worth of audio at sample_rate_hz.
+  // Preconditions: none.
+  // Postconditions: rounds up to whole frames; saturates at UINT32_MAX.
+  // Errors: returns 0 if sample_rate_hz or latency is zero or negative.
+  static constexpr uint32_t frames_for_latency(uint32_t sample_rate_hz,
+                                               std::chrono::microseconds latency) {
+    if (sample_rate_hz == 0 || latency.count() <= 0) {
+      return 0;
+    }
+    constexpr uint64_t kMicrosPerSecond = 1'000'000;
+    const uint64_t micros = static_cast<uint64_t>(latency.count());
+    if (micros / kMicrosPerSecond > UINT32_MAX) {
+      return UINT32_MAX;
+    }
+    const uint64_t frames = micros / kMicrosPerSecond * sample_rate_hz +
+                            ((micros % kMicrosPerSecond) * sample_rate_hz + kMicrosPerSecond - 1) /
+                                kMicrosPerSecond;
+    return frames > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(frames);
+  }
+};
+
+// BasicAudioRingBuffer<SampleT, Channels> (AudioRingBuffer = <float, kDynamicChannels>)
 // - Single-producer/single-consumer only; multiple producers/consumers are misuse.
 // - Frame-based semantics (frame = one sample per channel at a single time step).
-// - Interleaved PCM float32 storage (e.g., stereo is LRLR...).
-// - Real-time constraints: no allocations, locks, or blocking in read/write.
-// - Invariant: write_pos_frames >= read_pos_frames and (write_pos_frames - read_pos_frames) <= capacity.
-class AudioRingBuffer {
+// - Interleaved PCM storage of SampleT (int16_t, int32_t or float; e.g., stereo is LRLR...).
+// - Channels is either fixed at compile time (constant strides) or kDynamicChannels (runtime).
+// - Storage is a heap vector, or (StorageBackend::Mirrored, Linux) a double-mapped region in
+//   which every reserved range is a single contiguous span.
+// - Real-time constraints: no allocations, locks, or blocking in read/write. Commits issue a
+//   wake syscall only when the peer is blocked in wait_* and its threshold was just crossed.
+// - Seeks flush in O(1): the consumer jumps read_pos to a producer-published epoch boundary
+//   (request_flush / publish_epoch_boundary) while the producer keeps running.
+// - Positions, waits and counters come from SpscFrameIndex (shared with PlanarAudioRingBuffer):
+//   split producer/consumer cache lines with cached peer indices, and the invariant
+//   write_pos_frames >= read_pos_frames, (write_pos_frames - read_pos_frames) <= capacity.
+// - Instantiations are explicit (see audio_ring_buffer.cpp): float/int32_t/int16_t with
+//   dynamic, mono or stereo channels.
+template <typename SampleT, uint32_t Channels>
+class BasicAudioRingBuffer : public AudioRingBufferTypes {
+  static_assert(std::is_same_v<SampleT, float> || std::is_same_v<SampleT, int32_t> ||
+                    std::is_same_v<SampleT, int16_t>,
+                "AudioRingBuffer stores float, int32_t or int16_t samples");
+
 public:
+  using sample_type = SampleT;
+  using WriteRegion = Region<SampleT>;
+  using ReadRegion = Region<const SampleT>;
+
   // Summary: Construct a fixed-capacity ring buffer sized in frames.
-  // Preconditions: capacity_frames > 0; channels > 0.
-  // Postconditions: storage is allocated for capacity_frames * channels.
+  // Preconditions: capacity_frames > 0; channels > 0 (and == Channels when fixed).
+  // Postconditions: storage is allocated for capacity_frames() * channels; in PowerOfTwo mode
+  //   capacity_frames() is the requested capacity rounded up (requests above 2^31 stay exact).
+  //   Mirrored additionally rounds capacity up to a whole number of pages and falls back to
+  //   Heap at the requested capacity when mapping is unavailable (see storage_backend()).
+  //   Storage is made resident per memory_policy before return (see memory_residency()), so
+  //   the first pass over it never faults on the real-time thread. HugePages applies to Heap
+  //   storage only; Mirrored storage degrades it to Lock.
   // Errors: none (construction failure throws on allocation).
-  AudioRingBuffer(uint32_t capacity_frames, uint32_t channels);
+  BasicAudioRingBuffer(uint32_t capacity_frames,
+                       uint32_t channels,
+                       CapacityMode capacity_mode = CapacityMode::Exact,
+                       StorageBackend storage_backend = StorageBackend::Heap,
+                       MemoryPolicy memory_policy = MemoryPolicy::Prefault);
 
   // Summary: Return how many frames can be written without overwriting.
   // Preconditions: none.
@@ -28,7 +128,19 @@ public:
   // Preconditions: src_interleaved points to frames_requested * channels samples.
   // Postconditions: advances write position by frames_written.
   // Errors: may drop data; returns frames actually written.
-  uint32_t write_frames(const float* src_interleaved, uint32_t frames_requested);
+  uint32_t write_frames(const SampleT* src_interleaved, uint32_t frames_requested);
+
+  // Summary: Reserve up to frames_requested writable frames directly in storage.
+  // Preconditions: producer thread only; at most one outstanding reservation.
+  // Postconditions: does not publish data; commit_write makes frames visible.
+  // Errors: may reserve fewer frames (counted as an overrun); frames == 0 when full.
+  WriteRegion acquire_write(uint32_t frames_requested);
+
+  // Summary: Publish frames_written frames filled through the last acquire_write.
+  // Preconditions: producer thread only; frames_written <= reserved frames.
+  // Postconditions: advances write position by frames_written.
+  // Errors: release builds clamp an oversized commit and count an invariant violation.
+  void commit_write(uint32_t frames_written);
 
   // Summary: Return how many frames can be read without underrun.
   // Preconditions: none.
@@ -40,7 +152,27 @@ public:
   // Preconditions: none.
   // Postconditions: does not modify state.
   // Errors: none.
-  uint32_t capacity_frames() const { return capacity_frames_; }
+  uint32_t capacity_frames() const { return index_.capacity_frames(); }
+
+  // Summary: True when indices are computed with a mask (power-of-two capacity).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  bool uses_index_mask() const { return index_.uses_index_mask(); }
+
+  // Summary: Backend actually in use (Heap when a Mirrored request fell back).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  StorageBackend storage_backend() const {
+    return mirror_.data() ? StorageBackend::Mirrored : StorageBackend::Heap;
+  }
+
+  // Summary: Residency policy actually applied to storage after fallbacks.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  const MemoryResidency& memory_residency() const { return memory_residency_; }
 
   // Summary: Frames available to read (alias of available_to_read_frames).
   // Preconditions: none.
@@ -58,17 +190,96 @@ public:
   // Preconditions: dst_interleaved points to frames_requested * channels samples.
   // Postconditions: advances read position by frames_read.
   // Errors: may output fewer frames; returns frames actually read.
-  uint32_t read_frames(float* dst_interleaved, uint32_t frames_requested);
+  uint32_t read_frames(SampleT* dst_interleaved, uint32_t frames_requested);
+
+  // Summary: Expose up to frames_requested readable frames directly from storage.
+  // Preconditions: consumer thread only; at most one outstanding reservation.
+  // Postconditions: does not release space; commit_read hands frames back to the producer.
+  // Errors: may expose fewer frames (counted as an underrun); frames == 0 when empty.
+  ReadRegion acquire_read(uint32_t frames_requested);
+
+  // Summary: Release frames_read frames exposed through the last acquire_read.
+  // Preconditions: consumer thread only; frames_read <= exposed frames.
+  // Postconditions: advances read position by frames_read.
+  // Errors: release builds clamp an oversized commit and count an invariant violation.
+  void commit_read(uint32_t frames_read);
+
+  // Summary: Declare that frames from the current write position on belong to epoch
+  //   (producer thread only).
+  // Preconditions: epoch is greater than any epoch published before (since reset()).
+  // Postconditions: a pending or later request_flush(epoch) can skip straight to this frame.
+  // Errors: none.
+  void publish_epoch_boundary(uint64_t epoch);
+
+  // Summary: Ask the consumer to discard every frame that precedes epoch's boundary.
+  // Preconditions: epoch > 0; requested epochs never decrease (any thread).
+  // Postconditions: the consumer's next acquire_read (or apply_pending_flush) moves
+  //   read_pos to the boundary in O(1), without copying. Until the producer publishes that
+  //   boundary, every frame that becomes readable is discarded the same way.
+  // Errors: none.
+  void request_flush(uint64_t epoch);
+
+  // Summary: Apply a requested flush now (consumer thread, or any single thread while the
+  //   consumer is stopped).
+  // Preconditions: no concurrent acquire_read/commit_read.
+  // Postconditions: read_pos is at the boundary, or at write_pos while it is unpublished
+  //   (including mid-publish). Blocked producers are woken if space was released.
+  // Errors: returns true if no flush remains pending. Never waits on the producer.
+  bool apply_pending_flush();
+
+  // Summary: Tag the next frame the producer will write (producer thread only).
+  // Preconditions: epoch/track_id/source_frame describe that frame; frames written after it
+  //   continue source_frame contiguously until the next marker.
+  // Postconditions: current_marker reports it once the consumer commits past that frame.
+  // Errors: returns false if FrameMarkerQueue::kCapacity markers are still pending.
+  bool push_marker(uint64_t epoch, uint64_t track_id, int64_t source_frame);
+
+  // Summary: Most recent marker the consumer has reached, plus frames consumed since it.
+  // Preconditions: marker and frames_since_marker are non-null (any thread).
+  // Postconditions: marker->source_frame + *frames_since_marker is the next source frame
+  //   the consumer will read.
+  // Errors: returns false if no marker has been consumed since construction or reset().
+  bool current_marker(FrameMarker* marker, uint64_t* frames_since_marker) const;
+
+  // Summary: Open a tap that observes frames from the current read position onward.
+  // Preconditions: none (any thread).
+  // Postconditions: the tap sees only frames the consumer releases after this call.
+  // Errors: none.
+  TapCursor open_tap() const;
+
+  // Summary: Copy up to frames_requested already-consumed frames at the tap into dst.
+  // Preconditions: dst_interleaved holds frames_requested * channels samples; one thread per tap.
+  // Postconditions: advances tap->position_frames past the frames returned. A tap that fell
+  //   behind the producer is skipped forward, and frames overwritten mid-copy are discarded;
+  //   both are added to tap->dropped_frames. After reset() the tap restarts at frame 0.
+  // Errors: returns frames copied (0 when caught up). Never blocks or slows the producer or
+  //   consumer: taps are invisible to both and validate their copy afterwards (seqlock style).
+  uint32_t read_tap(TapCursor* tap, SampleT* dst_interleaved, uint32_t frames_requested) const;
+
+  // Summary: Block the producer until at least min_frames can be written, or timeout.
+  // Preconditions: producer thread only.
+  // Postconditions: on true, available_to_write_frames() >= min_frames. The consumer wakes
+  //   the producer only when its commit crosses min_frames, not on every read.
+  // Errors: returns false on timeout or when min_frames > capacity_frames().
+  bool wait_writable(uint32_t min_frames, std::chrono::nanoseconds timeout);
+
+  // Summary: Block the consumer until at least min_frames can be read, or timeout.
+  // Preconditions: consumer thread only.
+  // Postconditions: on true, available_to_read_frames() >= min_frames. The producer wakes
+  //   the consumer only when its commit crosses min_frames, not on every write.
+  // Errors: returns false on timeout or when min_frames > capacity_frames().
+  bool wait_readable(uint32_t min_frames, std::chrono::nanoseconds timeout);
 
   // Summary: Number of channels stored per frame.
   // Preconditions: none.
   // Postconditions: does not modify state.
   // Errors: returns 0 if constructed with invalid channels.
-  uint32_t channels() const { return channels_; }
+  uint32_t channels() const { return channel_count(); }
 
   // Summary: Reset read/write positions and counters.
   // Preconditions: only call when no producer/consumer threads are in read/write.
-  // Postconditions: positions and counters are cleared.
+  // Postconditions: positions, counters, markers and flush state are cleared; buffered
+  //   frames are discarded. Prefer request_flush while either thread is live.
   // Errors: none.
   void reset();
 
@@ -91,17 +302,51 @@ public:
   uint64_t invariant_violation_count() const;
 
 private:
-  uint32_t available_to_read_frames_impl(uint64_t write_pos_frames,
-                                         uint64_t read_pos_frames) const;
+  // Compile-time constant when Channels is fixed, so strides and copies fold.
+  uint32_t channel_count() const {
+    if constexpr (Channels != kDynamicChannels) {
+      return Channels;
+    } else {
+      return channels_;
+    }
+  }
+  size_t frame_bytes() const { return static_cast<size_t>(channel_count()) * sizeof(SampleT); }
+  template <typename T>
+  Region<T> MakeRegion(uint64_t start_pos_frames, uint32_t frames) const;
+
+  // Fixed 64-byte line size: std::hardware_destructive_interference_size is not ABI-stable.
+  static constexpr size_t kCacheLineBytes = 64;
 
-  uint32_t capacity_frames_{0};
+  // Read-only after construction; shared freely by both threads.
   uint32_t channels_{0};
-  std::vector<float> storage_;
-
-  std::atomic<uint64_t> write_pos_frames_{0};
-  std::atomic<uint64_t> read_pos_frames_{0};
-  std::atomic<uint64_t> underrun_count_{0};
-  std::atomic<uint64_t> overrun_count_{0};
-  // Mutable so const diagnostic reads can record invariant violations in release.
-  mutable std::atomic<uint64_t> invariant_violation_count_{0};
+  // Exactly one of storage_/mirror_ backs data_; the other stays empty.
+  tomplayer::platform::ResidentMemory storage_;
+  MirroredMapping mirror_;
+  MemoryResidency memory_residency_{};
+  SampleT* data_{nullptr};
+
+  // Positions, cached peer views, waits and counters, each side on its own line.
+  SpscFrameIndex index_;
+  // Discontinuity markers; laid out on its own producer/consumer/published lines.
+  FrameMarkerQueue markers_;
+
+  // Tap line: written by the producer on every acquire_write, read only by taps. End of the
+  // range handed out by the latest acquire_write, so taps can detect slots the producer may
+  // be rewriting before the matching commit becomes visible.
+  alignas(kCacheLineBytes) std::atomic<uint64_t> write_claim_frames_{0};
+  // Bumped by reset() so taps opened before it restart at the new stream's origin.
+  std::atomic<uint32_t> reset_generation_{0};
+
+  // Flush line: written rarely (seeks and epoch starts), read by the consumer every
+  // acquire_read. The boundary pair is guarded by boundary_seq_ (odd while written).
+  alignas(kCacheLineBytes) std::atomic<uint64_t> flush_request_epoch_{0};
+  std::atomic<uint32_t> boundary_seq_{0};
+  std::atomic<uint64_t> boundary_epoch_{0};
+  std::atomic<uint64_t> boundary_frame_{0};
+  // Highest flush epoch fully applied (consumer only); a request above it is pending.
+  uint64_t flush_applied_epoch_{0};
 };
+
+using AudioRingBufferS16 = BasicAudioRingBuffer<int16_t, kDynamicChannels>;
+using AudioRingBufferS32 = BasicAudioRingBuffer<int32_t, kDynamicChannels>;
+using StereoAudioRingBuffer = BasicAudioRingBuffer<float, 2>;
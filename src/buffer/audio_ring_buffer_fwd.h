@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Channels value meaning "channel count is a constructor argument".
+inline constexpr uint32_t kDynamicChannels = 0;
+
+template <typename SampleT, uint32_t Channels = kDynamicChannels>
+class BasicAudioRingBuffer;
+
+// Interleaved float32 ring with a runtime channel count (engine and output default).
+using AudioRingBuffer = BasicAudioRingBuffer<float>;
@@ -0,0 +1,87 @@
+#include "buffer/frame_marker_queue.h"
+
+bool FrameMarkerQueue::push(const FrameMarker& marker) {
+  const uint32_t head = head_.load(std::memory_order_relaxed);
+  if (head - cached_tail_ >= kCapacity) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (head - cached_tail_ >= kCapacity) {
+      return false;
+    }
+  }
+  slots_[head % kCapacity] = marker;
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+bool FrameMarkerQueue::publish_through(uint64_t consumed_frame) {
+  uint32_t tail = tail_.load(std::memory_order_relaxed);
+  const FrameMarker* newest = nullptr;
+  while (true) {
+    if (tail == cached_head_) {
+      // Drained what the cache covered; markers pushed since may also be due.
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail == cached_head_) {
+        break;
+      }
+    }
+    if (slots_[tail % kCapacity].ring_frame > consumed_frame) {
+      break;
+    }
+    newest = &slots_[tail % kCapacity];
+    ++tail;
+  }
+  if (!newest) {
+    return false;
+  }
+
+  Publish(*newest, true);
+
+  // Release the slots only after copying out of them.
+  tail_.store(tail, std::memory_order_release);
+  return true;
+}
+
+bool FrameMarkerQueue::latest(FrameMarker* marker) const {
+  while (true) {
+    const uint32_t before = published_seq_.load(std::memory_order_acquire);
+    if (before & 1u) {
+      continue;
+    }
+    const bool valid = published_valid_.load(std::memory_order_relaxed);
+    FrameMarker snapshot;
+    snapshot.ring_frame = published_ring_frame_.load(std::memory_order_relaxed);
+    snapshot.epoch = published_epoch_.load(std::memory_order_relaxed);
+    snapshot.track_id = published_track_id_.load(std::memory_order_relaxed);
+    snapshot.source_frame = published_source_frame_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (published_seq_.load(std::memory_order_relaxed) != before) {
+      continue;
+    }
+    if (valid) {
+      *marker = snapshot;
+    }
+    return valid;
+  }
+}
+
+void FrameMarkerQueue::reset() {
+  head_.store(0, std::memory_order_relaxed);
+  tail_.store(0, std::memory_order_relaxed);
+  cached_tail_ = 0;
+  cached_head_ = 0;
+  // Readers may still be polling, so retire the published marker through the seqlock.
+  Publish(FrameMarker{}, false);
+}
+
+void FrameMarkerQueue::Publish(const FrameMarker& marker, bool valid) {
+  // Seqlock writer: odd sequence, fields, even sequence.
+  const uint32_t seq = published_seq_.load(std::memory_order_relaxed);
+  published_seq_.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  published_valid_.store(valid, std::memory_order_relaxed);
+  published_ring_frame_.store(marker.ring_frame, std::memory_order_relaxed);
+  published_epoch_.store(marker.epoch, std::memory_order_relaxed);
+  published_track_id_.store(marker.track_id, std::memory_order_relaxed);
+  published_source_frame_.store(marker.source_frame, std::memory_order_relaxed);
+  published_seq_.store(seq + 2, std::memory_order_release);
+}
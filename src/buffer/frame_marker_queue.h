@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Summary: Metadata attached to one ring position (the first frame of a contiguous run).
+// Preconditions: none.
+// Postconditions: frames after ring_frame continue source_frame one-for-one until the next
+//   marker.
+// Errors: none.
+struct FrameMarker {
+  uint64_t ring_frame = 0;
+  uint64_t epoch = 0;
+  uint64_t track_id = 0;
+  int64_t source_frame = 0;
+};
+
+// FrameMarkerQueue
+// - Single-producer/single-consumer queue of FrameMarkers kept alongside an AudioRingBuffer.
+// - The producer pushes a marker for the next ring frame it will write; the consumer publishes
+//   the newest marker whose ring_frame it has consumed; any thread reads the published marker.
+// - Markers mark discontinuities (epoch, seek, track change), so the queue stays tiny.
+// - Real-time constraints: push/publish_through never allocate, lock, or block. latest() is
+//   a seqlock read that retries only while the consumer is mid-publish.
+class FrameMarkerQueue {
+public:
+  static constexpr uint32_t kCapacity = 64;
+
+  // Summary: Queue a marker (producer thread only).
+  // Preconditions: marker.ring_frame >= ring_frame of every marker pushed before it.
+  // Postconditions: publish_through will publish it once ring_frame is consumed.
+  // Errors: returns false (marker dropped) if kCapacity markers are already pending.
+  bool push(const FrameMarker& marker);
+
+  // Summary: Publish the newest pending marker with ring_frame <= consumed_frame (consumer).
+  // Preconditions: consumed_frame is the consumer's read position after its latest commit.
+  // Postconditions: older pending markers passed over in the same call are discarded.
+  // Errors: returns false if nothing new was published. Costs one shared load when idle.
+  bool publish_through(uint64_t consumed_frame);
+
+  // Summary: Copy the most recently published marker (any thread).
+  // Preconditions: marker is non-null.
+  // Postconditions: *marker is a consistent snapshot (never a mix of two markers).
+  // Errors: returns false if nothing has been published since construction or reset().
+  bool latest(FrameMarker* marker) const;
+
+  // Summary: Drop pending and published markers.
+  // Preconditions: no concurrent push/publish_through (latest may run concurrently).
+  // Postconditions: latest() returns false until the next publish.
+  // Errors: none.
+  void reset();
+
+private:
+  static constexpr size_t kCacheLineBytes = 64;
+
+  // Seqlock write of the published marker; consumer thread (or reset) only.
+  void Publish(const FrameMarker& marker, bool valid);
+
+  std::array<FrameMarker, kCapacity> slots_{};
+
+  // Producer line.
+  alignas(kCacheLineBytes) std::atomic<uint32_t> head_{0};
+  uint32_t cached_tail_{0};
+
+  // Consumer line.
+  alignas(kCacheLineBytes) std::atomic<uint32_t> tail_{0};
+  uint32_t cached_head_{0};
+
+  // Published marker, guarded by an even/odd sequence (odd while the consumer writes).
+  alignas(kCacheLineBytes) std::atomic<uint32_t> published_seq_{0};
+  std::atomic<bool> published_valid_{false};
+  std::atomic<uint64_t> published_ring_frame_{0};
+  std::atomic<uint64_t> published_epoch_{0};
+  std::atomic<uint64_t> published_track_id_{0};
+  std::atomic<int64_t> published_source_frame_{0};
+};
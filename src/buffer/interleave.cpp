@@ -0,0 +1,198 @@
+#include "buffer/interleave.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TOMPLAYER_INTERLEAVE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define TOMPLAYER_INTERLEAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace tomplayer::buffer {
+namespace {
+
+void InterleaveScalar(const float* const* planes,
+                      uint32_t channels,
+                      uint32_t first_frame,
+                      uint32_t frames,
+                      float* dst_interleaved) {
+  for (uint32_t frame = first_frame; frame < frames; ++frame) {
+    float* out = dst_interleaved + static_cast<size_t>(frame) * channels;
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+      out[ch] = planes[ch][frame];
+    }
+  }
+}
+
+void DeinterleaveScalar(const float* src_interleaved,
+                        uint32_t channels,
+                        uint32_t first_frame,
+                        uint32_t frames,
+                        float* const* planes) {
+  for (uint32_t frame = first_frame; frame < frames; ++frame) {
+    const float* in = src_interleaved + static_cast<size_t>(frame) * channels;
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+      planes[ch][frame] = in[ch];
+    }
+  }
+}
+
+// Each SIMD helper handles whole 4-frame blocks and returns the first frame left for the
+// scalar tail.
+#if defined(TOMPLAYER_INTERLEAVE_SSE2)
+
+uint32_t Interleave2(const float* left, const float* right, uint32_t frames, float* dst) {
+  uint32_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    const __m128 l = _mm_loadu_ps(left + frame);
+    const __m128 r = _mm_loadu_ps(right + frame);
+    _mm_storeu_ps(dst + 2 * frame, _mm_unpacklo_ps(l, r));
+    _mm_storeu_ps(dst + 2 * frame + 4, _mm_unpackhi_ps(l, r));
+  }
+  return frame;
+}
+
+uint32_t Deinterleave2(const float* src, uint32_t frames, float* left, float* right) {
+  uint32_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    const __m128 a = _mm_loadu_ps(src + 2 * frame);      // L0 R0 L1 R1
+    const __m128 b = _mm_loadu_ps(src + 2 * frame + 4);  // L2 R2 L3 R3
+    _mm_storeu_ps(left + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(right + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  return frame;
+}
+
+uint32_t Interleave4(const float* const* planes, uint32_t frames, float* dst) {
+  uint32_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    __m128 c0 = _mm_loadu_ps(planes[0] + frame);
+    __m128 c1 = _mm_loadu_ps(planes[1] + frame);
+    __m128 c2 = _mm_loadu_ps(planes[2] + frame);
+    __m128 c3 = _mm_loadu_ps(planes[3] + frame);
+    // Rows become frames: a 4x4 transpose.
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    float* out = dst + 4 * static_cast<size_t>(frame);
+    _mm_storeu_ps(out, c0);
+    _mm_storeu_ps(out + 4, c1);
+    _mm_storeu_ps(out + 8, c2);
+    _mm_storeu_ps(out + 12, c3);
+  }
+  return frame;
+}
+
+uint32_t Deinterleave4(const float* src, uint32_t frames, float* const* planes) {
+  uint32_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    const float* in = src + 4 * static_cast<size_t>(frame);
+    __m128 f0 = _mm_loadu_ps(in);
+    __m128 f1 = _mm_loadu_ps(in + 4);
+    __m128 f2 = _mm_loadu_ps(in + 8);
+    __m128 f3 = _mm_loadu_ps(in + 12);
+    _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+    _mm_storeu_ps(planes[0] + frame, f0);
+    _mm_storeu_ps(planes[1] + frame, f1);
+    _mm_storeu_ps(planes[2] + frame, f2);
+    _mm_storeu_ps(planes[3] + frame, f3);
+  }
+  return frame;
+}
+
+#elif defined(TOMPLAYER_INTERLEAVE_NEON)
+
+uint32_t Interleave2(const float* left, const float* right, uint32_t frames, float* dst) {
+  uint32_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    float32x4x2_t pair;
+    pair.val[0] = vld1q_f32(left + frame);
+    pair.val[1] = vld1q_f32(right + frame);
+    vst2q_f32(dst + 2 * frame, pair);
+  }
+  return frame;
+}
+
+uint32_t Deinterleave2(const float* src, uint32_t frames, float* left, float* right) {
+  uint32_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    const float32x4x2_t pair = vld2q_f32(src + 2 * frame);
+    vst1q_f32(left + frame, pair.val[0]);
+    vst1q_f32(right + frame, pair.val[1]);
+  }
+  return frame;
+}
+
+uint32_t Interleave4(const float* const* planes, uint32_t frames, float* dst) {
+  uint32_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    float32x4x4_t quad;
+    quad.val[0] = vld1q_f32(planes[0] + frame);
+    quad.val[1] = vld1q_f32(planes[1] + frame);
+    quad.val[2] = vld1q_f32(planes[2] + frame);
+    quad.val[3] = vld1q_f32(planes[3] + frame);
+    vst4q_f32(dst + 4 * static_cast<size_t>(frame), quad);
+  }
+  return frame;
+}
+
+uint32_t Deinterleave4(const float* src, uint32_t frames, float* const* planes) {
+  uint32_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    const float32x4x4_t quad = vld4q_f32(src + 4 * static_cast<size_t>(frame));
+    vst1q_f32(planes[0] + frame, quad.val[0]);
+    vst1q_f32(planes[1] + frame, quad.val[1]);
+    vst1q_f32(planes[2] + frame, quad.val[2]);
+    vst1q_f32(planes[3] + frame, quad.val[3]);
+  }
+  return frame;
+}
+
+#else
+
+uint32_t Interleave2(const float*, const float*, uint32_t, float*) {
+  return 0;
+}
+
+uint32_t Deinterleave2(const float*, uint32_t, float*, float*) {
+  return 0;
+}
+
+uint32_t Interleave4(const float* const*, uint32_t, float*) {
+  return 0;
+}
+
+uint32_t Deinterleave4(const float*, uint32_t, float* const*) {
+  return 0;
+}
+
+#endif
+}  // namespace
+
+void Interleave(const float* const* planes,
+                uint32_t channels,
+                uint32_t frames,
+                float* dst_interleaved) {
+  uint32_t done = 0;
+  if (channels == 1) {
+    // Mono is a plain copy; let the scalar loop's auto-vectorization handle it.
+  } else if (channels == 2) {
+    done = Interleave2(planes[0], planes[1], frames, dst_interleaved);
+  } else if (channels == 4) {
+    done = Interleave4(planes, frames, dst_interleaved);
+  }
+  InterleaveScalar(planes, channels, done, frames, dst_interleaved);
+}
+
+void Deinterleave(const float* src_interleaved,
+                  uint32_t channels,
+                  uint32_t frames,
+                  float* const* planes) {
+  uint32_t done = 0;
+  if (channels == 2) {
+    done = Deinterleave2(src_interleaved, frames, planes[0], planes[1]);
+  } else if (channels == 4) {
+    done = Deinterleave4(src_interleaved, frames, planes);
+  }
+  DeinterleaveScalar(src_interleaved, channels, done, frames, planes);
+}
+
+}  // namespace tomplayer::buffer
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace tomplayer::buffer {
+
+// Summary: Interleave channel planes into one LRLR... buffer.
+// Preconditions: planes[0..channels) each hold frames samples; dst_interleaved holds
+//   frames * channels samples and does not overlap any plane. No alignment is required.
+// Postconditions: dst_interleaved[frame * channels + ch] == planes[ch][frame].
+// Errors: none. SSE2 (x86) or NEON (arm64) paths for 2 and 4 channels, scalar otherwise;
+//   real-time safe (no allocation, no locks).
+void Interleave(const float* const* planes,
+                uint32_t channels,
+                uint32_t frames,
+                float* dst_interleaved);
+
+// Summary: Split an interleaved buffer into channel planes.
+// Preconditions: src_interleaved holds frames * channels samples; planes[0..channels) each
+//   have room for frames samples and do not overlap the source.
+// Postconditions: planes[ch][frame] == src_interleaved[frame * channels + ch].
+// Errors: none. Same SIMD coverage and real-time guarantees as Interleave.
+void Deinterleave(const float* src_interleaved,
+                  uint32_t channels,
+                  uint32_t frames,
+                  float* const* planes);
+
+}  // namespace tomplayer::buffer
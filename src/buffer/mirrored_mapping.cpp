@@ -0,0 +1,87 @@
+#include "buffer/mirrored_mapping.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+MirroredMapping::~MirroredMapping() {
+  unmap();
+}
+
+#if defined(__linux__)
+
+size_t MirroredMapping::page_size() {
+  const long size = sysconf(_SC_PAGESIZE);
+  return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+bool MirroredMapping::map(size_t size_bytes) {
+  const size_t page = page_size();
+  if (data_ || size_bytes == 0 || page == 0 || size_bytes % page != 0) {
+    return false;
+  }
+
+  const int fd = memfd_create("tomplayer-ring", MFD_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  if (ftruncate(fd, static_cast<off_t>(size_bytes)) != 0) {
+    close(fd);
+    return false;
+  }
+
+  // Reserve 2x address space first so the two fixed mappings cannot clobber anything else.
+  void* reserved = mmap(nullptr, size_bytes * 2, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+
+  auto* base = static_cast<uint8_t*>(reserved);
+  void* first = mmap(base, size_bytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_FIXED, fd, 0);
+  void* second = first == MAP_FAILED
+                     ? MAP_FAILED
+                     : mmap(base + size_bytes, size_bytes, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_FIXED, fd, 0);
+  // The mappings keep the memfd alive; the descriptor itself is no longer needed.
+  close(fd);
+  if (first == MAP_FAILED || second == MAP_FAILED) {
+    munmap(reserved, size_bytes * 2);
+    return false;
+  }
+
+  data_ = reserved;
+  size_bytes_ = size_bytes;
+  return true;
+}
+
+void MirroredMapping::unmap() {
+  if (!data_) {
+    return;
+  }
+  munmap(data_, size_bytes_ * 2);
+  data_ = nullptr;
+  size_bytes_ = 0;
+}
+
+#else
+
+size_t MirroredMapping::page_size() {
+  return 0;
+}
+
+bool MirroredMapping::map(size_t) {
+  return false;
+}
+
+void MirroredMapping::unmap() {
+  data_ = nullptr;
+  size_bytes_ = 0;
+}
+
+#endif
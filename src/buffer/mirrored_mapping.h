@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+
+// MirroredMapping
+// - One shared-memory object mapped twice back-to-back: [data, data + size) and
+//   [data + size, data + 2 * size) alias the same physical pages.
+// - Lets a ring buffer hand out any range of up to size bytes as one contiguous span.
+// - Linux only (memfd_create + two MAP_FIXED mmaps); map() fails elsewhere so callers fall back.
+// - Not thread-safe; owned and mapped/unmapped by a single thread.
+class MirroredMapping {
+public:
+  MirroredMapping() = default;
+
+  // Summary: Unmap the region if mapped.
+  // Preconditions: no outstanding pointers into the mapping are used afterwards.
+  // Postconditions: address space and shared-memory object are released.
+  // Errors: none.
+  ~MirroredMapping();
+
+  MirroredMapping(const MirroredMapping&) = delete;
+  MirroredMapping& operator=(const MirroredMapping&) = delete;
+
+  // Summary: Map size_bytes of fresh zeroed memory twice back-to-back.
+  // Preconditions: size_bytes > 0 and a multiple of page_size(); not already mapped.
+  // Postconditions: data() points at 2 * size_bytes of addressable, mirrored memory.
+  // Errors: returns false (and leaves the object unmapped) if unsupported or any syscall fails.
+  bool map(size_t size_bytes);
+
+  // Summary: Release the mapping.
+  // Preconditions: none (safe if not mapped).
+  // Postconditions: data() == nullptr and size_bytes() == 0.
+  // Errors: none.
+  void unmap();
+
+  // Summary: Start of the first view, or nullptr if unmapped.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  void* data() const { return data_; }
+
+  // Summary: Size of one view in bytes (the mapping spans twice this).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: returns 0 if unmapped.
+  size_t size_bytes() const { return size_bytes_; }
+
+  // Summary: Granularity that size_bytes passed to map() must be a multiple of.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: returns 0 on platforms without mirrored mapping support.
+  static size_t page_size();
+
+private:
+  void* data_{nullptr};
+  size_t size_bytes_{0};
+};
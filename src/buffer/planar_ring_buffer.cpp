@@ -0,0 +1,211 @@
+#include "buffer/planar_ring_buffer.h"
+
+#include "buffer/interleave.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <new>
+
+namespace {
+constexpr uint32_t kMaxPowerOfTwoCapacityFrames = 1u << 31;
+constexpr size_t kPlaneAlignSamples = 64 / sizeof(float);
+
+uint32_t RoundUpToPowerOfTwo(uint32_t capacity_frames) {
+  if (capacity_frames == 0 || capacity_frames > kMaxPowerOfTwoCapacityFrames) {
+    return capacity_frames;
+  }
+  return std::bit_ceil(capacity_frames);
+}
+
+using PlanePointers = std::array<float*, PlanarAudioRingBuffer::kMaxChannels>;
+using ConstPlanePointers = std::array<const float*, PlanarAudioRingBuffer::kMaxChannels>;
+}  // namespace
+
+PlanarAudioRingBuffer::PlanarAudioRingBuffer(uint32_t capacity_frames,
+                                             uint32_t channels,
+                                             CapacityMode capacity_mode,
+                                             MemoryPolicy memory_policy)
+    : channels_(channels <= kMaxChannels ? channels : 0) {
+  assert(channels > 0 && channels <= kMaxChannels);
+  if (capacity_mode == CapacityMode::PowerOfTwo) {
+    capacity_frames = RoundUpToPowerOfTwo(capacity_frames);
+  }
+  plane_stride_ = (static_cast<size_t>(capacity_frames) + kPlaneAlignSamples - 1) /
+                  kPlaneAlignSamples * kPlaneAlignSamples;
+  const size_t storage_bytes = plane_stride_ * channels_ * sizeof(float);
+  if (storage_bytes > 0) {
+    if (!storage_.allocate(storage_bytes, memory_policy)) {
+      throw std::bad_alloc();
+    }
+    data_ = static_cast<float*>(storage_.data());
+  }
+  index_.set_capacity(capacity_frames);
+}
+
+uint32_t PlanarAudioRingBuffer::available_to_write_frames() const {
+  return index_.available_to_write_frames();
+}
+
+uint32_t PlanarAudioRingBuffer::available_to_read_frames() const {
+  return index_.available_to_read_frames();
+}
+
+PlanarAudioRingBuffer::WriteRegion PlanarAudioRingBuffer::acquire_write(
+    uint32_t frames_requested) {
+  if (!data_) {
+    return {};
+  }
+  const SpscFrameIndex::Reservation reservation = index_.acquire_write(frames_requested);
+  if (reservation.frames == 0) {
+    return {};
+  }
+  return MakeRegion<float>(reservation);
+}
+
+void PlanarAudioRingBuffer::commit_write(uint32_t frames_written) {
+  index_.commit_write(frames_written);
+}
+
+PlanarAudioRingBuffer::ReadRegion PlanarAudioRingBuffer::acquire_read(
+    uint32_t frames_requested) {
+  if (!data_) {
+    return {};
+  }
+  const SpscFrameIndex::Reservation reservation = index_.acquire_read(frames_requested);
+  if (reservation.frames == 0) {
+    return {};
+  }
+  return MakeRegion<const float>(reservation);
+}
+
+void PlanarAudioRingBuffer::commit_read(uint32_t frames_read) {
+  if (frames_read == 0) {
+    return;
+  }
+  index_.commit_read(frames_read);
+}
+
+uint32_t PlanarAudioRingBuffer::write_planar(const float* const* planes,
+                                             uint32_t frames_requested) {
+  const WriteRegion region = acquire_write(frames_requested);
+  if (region.frames == 0) {
+    return 0;
+  }
+  for (uint32_t ch = 0; ch < channels_; ++ch) {
+    const std::span<float> first = region.first(ch);
+    const std::span<float> second = region.second(ch);
+    std::memcpy(first.data(), planes[ch], first.size_bytes());
+    if (!second.empty()) {
+      std::memcpy(second.data(), planes[ch] + first.size(), second.size_bytes());
+    }
+  }
+  commit_write(region.frames);
+  return region.frames;
+}
+
+uint32_t PlanarAudioRingBuffer::write_interleaved(const float* src_interleaved,
+                                                  uint32_t frames_requested) {
+  const WriteRegion region = acquire_write(frames_requested);
+  if (region.frames == 0) {
+    return 0;
+  }
+  PlanePointers planes{};
+  for (uint32_t ch = 0; ch < channels_; ++ch) {
+    planes[ch] = region.first(ch).data();
+  }
+  tomplayer::buffer::Deinterleave(src_interleaved, channels_, region.first_frames,
+                                  planes.data());
+  if (region.frames > region.first_frames) {
+    for (uint32_t ch = 0; ch < channels_; ++ch) {
+      planes[ch] = region.second(ch).data();
+    }
+    tomplayer::buffer::Deinterleave(
+        src_interleaved + static_cast<size_t>(region.first_frames) * channels_, channels_,
+        region.frames - region.first_frames, planes.data());
+  }
+  commit_write(region.frames);
+  return region.frames;
+}
+
+uint32_t PlanarAudioRingBuffer::read_planar(float* const* planes, uint32_t frames_requested) {
+  const ReadRegion region = acquire_read(frames_requested);
+  if (region.frames == 0) {
+    return 0;
+  }
+  for (uint32_t ch = 0; ch < channels_; ++ch) {
+    const std::span<const float> first = region.first(ch);
+    const std::span<const float> second = region.second(ch);
+    std::memcpy(planes[ch], first.data(), first.size_bytes());
+    if (!second.empty()) {
+      std::memcpy(planes[ch] + first.size(), second.data(), second.size_bytes());
+    }
+  }
+  commit_read(region.frames);
+  return region.frames;
+}
+
+uint32_t PlanarAudioRingBuffer::read_interleaved(float* dst_interleaved,
+                                                 uint32_t frames_requested) {
+  const ReadRegion region = acquire_read(frames_requested);
+  if (region.frames == 0) {
+    return 0;
+  }
+  ConstPlanePointers planes{};
+  for (uint32_t ch = 0; ch < channels_; ++ch) {
+    planes[ch] = region.first(ch).data();
+  }
+  tomplayer::buffer::Interleave(planes.data(), channels_, region.first_frames, dst_interleaved);
+  if (region.frames > region.first_frames) {
+    for (uint32_t ch = 0; ch < channels_; ++ch) {
+      planes[ch] = region.second(ch).data();
+    }
+    tomplayer::buffer::Interleave(
+        planes.data(), channels_, region.frames - region.first_frames,
+        dst_interleaved + static_cast<size_t>(region.first_frames) * channels_);
+  }
+  commit_read(region.frames);
+  return region.frames;
+}
+
+bool PlanarAudioRingBuffer::wait_writable(uint32_t min_frames,
+                                          std::chrono::nanoseconds timeout) {
+  return index_.wait_writable(min_frames, timeout);
+}
+
+bool PlanarAudioRingBuffer::wait_readable(uint32_t min_frames,
+                                          std::chrono::nanoseconds timeout) {
+  return index_.wait_readable(min_frames, timeout);
+}
+
+void PlanarAudioRingBuffer::reset() {
+  index_.reset();
+}
+
+uint64_t PlanarAudioRingBuffer::underrun_count() const {
+  return index_.underrun_count();
+}
+
+uint64_t PlanarAudioRingBuffer::overrun_count() const {
+  return index_.overrun_count();
+}
+
+uint64_t PlanarAudioRingBuffer::invariant_violation_count() const {
+  return index_.invariant_violation_count();
+}
+
+template <typename T>
+PlanarAudioRingBuffer::Region<T> PlanarAudioRingBuffer::MakeRegion(
+    const SpscFrameIndex::Reservation& reservation) const {
+  const uint32_t start_index = index_.index_of(reservation.start_frame);
+  Region<T> region;
+  region.frames = reservation.frames;
+  region.first_frames =
+      std::min(reservation.frames, index_.capacity_frames() - start_index);
+  region.base_ = data_;
+  region.plane_stride_ = plane_stride_;
+  region.start_index_ = start_index;
+  return region;
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "buffer/audio_ring_buffer.h"
+#include "buffer/spsc_frame_index.h"
+#include "platform/resident_memory.h"
+
+// PlanarAudioRingBuffer
+// - Single-producer/single-consumer ring of float32 frames stored one plane per channel
+//   (LLLL... RRRR...), for DSP stages that work per channel.
+// - Same SPSC guarantees as AudioRingBuffer, from the same SpscFrameIndex: acquire/commit
+//   regions, split producer/consumer cache lines with cached peer indices, mask indexing at
+//   power-of-two capacity, no allocations, locks or blocking on the read/write paths, and
+//   wait_* wakes only on threshold crossings. This class adds only the plane layout.
+// - write_interleaved/read_interleaved convert with the SIMD kernels in buffer/interleave.h,
+//   so a planar pipeline interleaves exactly once, straight into the device buffer.
+// - Each plane starts on its own cache line (and a 16-byte SIMD boundary). Storage is always
+//   heap pages: a mirrored mapping would need one mapping per plane.
+// - Markers, taps and epoch flushes stay on the interleaved ring the engine hands to the
+//   output; this ring carries samples and counters only.
+class PlanarAudioRingBuffer {
+public:
+  using CapacityMode = AudioRingBufferTypes::CapacityMode;
+  using MemoryPolicy = AudioRingBufferTypes::MemoryPolicy;
+  using MemoryResidency = AudioRingBufferTypes::MemoryResidency;
+
+  // Upper bound on channels, so interleave paths can keep plane pointers on the stack.
+  static constexpr uint32_t kMaxChannels = 32;
+
+  // Summary: Frame range inside every plane, split into at most two contiguous spans.
+  // Preconditions: channel < the ring's channels() for first()/second().
+  // Postconditions: first(ch) holds the leading first_frames samples of channel ch; second(ch)
+  //   holds the remaining frames - first_frames samples (empty unless the range wraps).
+  // Errors: frames == 0 when nothing could be reserved.
+  template <typename T>
+  class Region {
+  public:
+    uint32_t frames = 0;
+    uint32_t first_frames = 0;
+
+    std::span<T> first(uint32_t channel) const {
+      return {base_ + channel * plane_stride_ + start_index_, first_frames};
+    }
+    std::span<T> second(uint32_t channel) const {
+      return {base_ + channel * plane_stride_, frames - first_frames};
+    }
+
+  private:
+    friend class PlanarAudioRingBuffer;
+    T* base_ = nullptr;
+    size_t plane_stride_ = 0;
+    uint32_t start_index_ = 0;
+  };
+
+  using WriteRegion = Region<float>;
+  using ReadRegion = Region<const float>;
+
+  // Summary: Construct a fixed-capacity planar ring sized in frames.
+  // Preconditions: capacity_frames > 0; 0 < channels <= kMaxChannels.
+  // Postconditions: channels() planes of capacity_frames() samples are allocated and made
+  //   resident per memory_policy; PowerOfTwo rounds capacity up as AudioRingBuffer does.
+  // Errors: throws std::bad_alloc when storage cannot be allocated. Invalid arguments leave
+  //   an empty ring whose operations all return 0.
+  PlanarAudioRingBuffer(uint32_t capacity_frames,
+                        uint32_t channels,
+                        CapacityMode capacity_mode = CapacityMode::Exact,
+                        MemoryPolicy memory_policy = MemoryPolicy::Prefault);
+
+  PlanarAudioRingBuffer(const PlanarAudioRingBuffer&) = delete;
+  PlanarAudioRingBuffer& operator=(const PlanarAudioRingBuffer&) = delete;
+
+  // Summary: Return how many frames can be written without overwriting.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint32_t available_to_write_frames() const;
+
+  // Summary: Return how many frames can be read without underrun.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint32_t available_to_read_frames() const;
+
+  // Summary: Reserve up to frames_requested writable frames in every plane.
+  // Preconditions: producer thread only; at most one outstanding reservation.
+  // Postconditions: does not publish data; commit_write makes frames visible.
+  // Errors: may reserve fewer frames (counted as an overrun); frames == 0 when full.
+  WriteRegion acquire_write(uint32_t frames_requested);
+
+  // Summary: Publish frames_written frames filled through the last acquire_write.
+  // Preconditions: producer thread only; frames_written <= reserved frames.
+  // Postconditions: advances write position by frames_written.
+  // Errors: release builds clamp an oversized commit and count an invariant violation.
+  void commit_write(uint32_t frames_written);
+
+  // Summary: Expose up to frames_requested readable frames in every plane.
+  // Preconditions: consumer thread only; at most one outstanding reservation.
+  // Postconditions: does not release space; commit_read hands frames back to the producer.
+  // Errors: may expose fewer frames (counted as an underrun); frames == 0 when empty.
+  ReadRegion acquire_read(uint32_t frames_requested);
+
+  // Summary: Release frames_read frames exposed through the last acquire_read.
+  // Preconditions: consumer thread only; frames_read <= exposed frames.
+  // Postconditions: advances read position by frames_read.
+  // Errors: release builds clamp an oversized commit and count an invariant violation.
+  void commit_read(uint32_t frames_read);
+
+  // Summary: Write up to frames_requested frames from channels() source planes.
+  // Preconditions: producer thread only; planes[ch] holds frames_requested samples.
+  // Postconditions: advances write position by the frames returned.
+  // Errors: may drop data; returns frames actually written.
+  uint32_t write_planar(const float* const* planes, uint32_t frames_requested);
+
+  // Summary: Write up to frames_requested frames from an interleaved source, deinterleaving
+  //   into the planes.
+  // Preconditions: producer thread only; src_interleaved holds frames_requested * channels().
+  // Postconditions: advances write position by the frames returned.
+  // Errors: may drop data; returns frames actually written.
+  uint32_t write_interleaved(const float* src_interleaved, uint32_t frames_requested);
+
+  // Summary: Read up to frames_requested frames into channels() destination planes.
+  // Preconditions: consumer thread only; planes[ch] has room for frames_requested samples.
+  // Postconditions: advances read position by the frames returned.
+  // Errors: may output fewer frames; returns frames actually read.
+  uint32_t read_planar(float* const* planes, uint32_t frames_requested);
+
+  // Summary: Read up to frames_requested frames, interleaving them into dst (the render
+  //   callback's device buffer).
+  // Preconditions: consumer thread only; dst_interleaved holds frames_requested * channels().
+  // Postconditions: advances read position by the frames returned.
+  // Errors: may output fewer frames; returns frames actually read.
+  uint32_t read_interleaved(float* dst_interleaved, uint32_t frames_requested);
+
+  // Summary: Block the producer until at least min_frames can be written, or timeout.
+  // Preconditions: producer thread only.
+  // Postconditions: on true, available_to_write_frames() >= min_frames.
+  // Errors: returns false on timeout or when min_frames > capacity_frames().
+  bool wait_writable(uint32_t min_frames, std::chrono::nanoseconds timeout);
+
+  // Summary: Block the consumer until at least min_frames can be read, or timeout.
+  // Preconditions: consumer thread only.
+  // Postconditions: on true, available_to_read_frames() >= min_frames.
+  // Errors: returns false on timeout or when min_frames > capacity_frames().
+  bool wait_readable(uint32_t min_frames, std::chrono::nanoseconds timeout);
+
+  // Summary: Reset read/write positions and counters.
+  // Preconditions: only call when no producer/consumer threads are in read/write.
+  // Postconditions: positions and counters are cleared; buffered frames are discarded.
+  // Errors: none.
+  void reset();
+
+  // Summary: Capacity in frames (per plane).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint32_t capacity_frames() const { return index_.capacity_frames(); }
+
+  // Summary: Number of planes.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: returns 0 if constructed with invalid channels.
+  uint32_t channels() const { return channels_; }
+
+  // Summary: True when indices are computed with a mask (power-of-two capacity).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  bool uses_index_mask() const { return index_.uses_index_mask(); }
+
+  // Summary: Residency policy actually applied to storage after fallbacks.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  const MemoryResidency& memory_residency() const { return storage_.residency(); }
+
+  // Summary: Number of read requests not fully satisfied (partials and zeros).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint64_t underrun_count() const;
+
+  // Summary: Number of write requests not fully satisfied (partials and zeros).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  uint64_t overrun_count() const;
+
+  // Summary: Count of invariant violations (debug asserts; release fail-soft clamp).
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: non-zero indicates misuse or concurrent reset.
+  uint64_t invariant_violation_count() const;
+
+private:
+  template <typename T>
+  Region<T> MakeRegion(const SpscFrameIndex::Reservation& reservation) const;
+
+  // Read-only after construction; shared freely by both threads.
+  uint32_t channels_{0};
+  // Samples between the starts of consecutive planes (capacity rounded to a cache line).
+  size_t plane_stride_{0};
+  tomplayer::platform::ResidentMemory storage_;
+  float* data_{nullptr};
+
+  SpscFrameIndex index_;
+};
@@ -0,0 +1,115 @@
+#include "buffer/spsc_frame_index.h"
+
+#include "platform/word_wait.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+void SpscFrameIndex::set_capacity(uint32_t capacity_frames) {
+  capacity_frames_ = capacity_frames;
+  index_mask_ = std::has_single_bit(capacity_frames) ? capacity_frames - 1 : 0;
+  // Registered here, before any commit, so commits take the light fence from the start.
+  tomplayer::platform::PrepareAsymmetricFence();
+}
+
+uint32_t SpscFrameIndex::available_to_write_frames() const {
+  const uint64_t read_pos = read_pos_frames_.load(std::memory_order_acquire);
+  const uint64_t write_pos = write_pos_frames_.load(std::memory_order_relaxed);
+  return capacity_frames_ - available_to_read_frames_impl(write_pos, read_pos);
+}
+
+uint32_t SpscFrameIndex::available_to_read_frames() const {
+  const uint64_t write_pos = write_pos_frames_.load(std::memory_order_acquire);
+  const uint64_t read_pos = read_pos_frames_.load(std::memory_order_relaxed);
+  return available_to_read_frames_impl(write_pos, read_pos);
+}
+
+void SpscFrameIndex::observe_write_pos(uint64_t write_pos_frames) {
+  cached_write_pos_frames_ = std::max(cached_write_pos_frames_, write_pos_frames);
+}
+
+bool SpscFrameIndex::wait_writable(uint32_t min_frames, std::chrono::nanoseconds timeout) {
+  if (min_frames > capacity_frames_) {
+    return false;
+  }
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    const uint32_t seq = space_wake_seq_.load(std::memory_order_acquire);
+    space_wait_frames_.store(min_frames, std::memory_order_relaxed);
+    // Pairs with the light fence in WakeSpaceWaiter: either this check sees the consumer's
+    // new read position, or the consumer sees the published threshold and wakes us. The
+    // heavy half is paid here, once per block, so commits stay fence-free.
+    tomplayer::platform::AsymmetricHeavyFence();
+    if (available_to_write_frames() >= min_frames) {
+      space_wait_frames_.store(0, std::memory_order_relaxed);
+      return true;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      space_wait_frames_.store(0, std::memory_order_relaxed);
+      return false;
+    }
+    tomplayer::platform::WaitForWordChange(&space_wake_seq_, seq, deadline - now);
+  }
+}
+
+bool SpscFrameIndex::wait_readable(uint32_t min_frames, std::chrono::nanoseconds timeout) {
+  if (min_frames > capacity_frames_) {
+    return false;
+  }
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    const uint32_t seq = data_wake_seq_.load(std::memory_order_acquire);
+    data_wait_frames_.store(min_frames, std::memory_order_relaxed);
+    // Pairs with the light fence in WakeDataWaiter (see wait_writable).
+    tomplayer::platform::AsymmetricHeavyFence();
+    if (available_to_read_frames() >= min_frames) {
+      data_wait_frames_.store(0, std::memory_order_relaxed);
+      return true;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      data_wait_frames_.store(0, std::memory_order_relaxed);
+      return false;
+    }
+    tomplayer::platform::WaitForWordChange(&data_wake_seq_, seq, deadline - now);
+  }
+}
+
+void SpscFrameIndex::reset() {
+  write_pos_frames_.store(0, std::memory_order_relaxed);
+  read_pos_frames_.store(0, std::memory_order_relaxed);
+  cached_read_pos_frames_ = 0;
+  cached_write_pos_frames_ = 0;
+  underrun_count_.store(0, std::memory_order_relaxed);
+  overrun_count_.store(0, std::memory_order_relaxed);
+  space_wait_frames_.store(0, std::memory_order_relaxed);
+  data_wait_frames_.store(0, std::memory_order_relaxed);
+  invariant_violation_count_.store(0, std::memory_order_relaxed);
+}
+
+void SpscFrameIndex::WakeSpaceWaiterSlow(uint64_t read_pos_frames) {
+  uint32_t wanted = space_wait_frames_.load(std::memory_order_relaxed);
+  const uint64_t write_pos = write_pos_frames_.load(std::memory_order_acquire);
+  const uint32_t writable =
+      capacity_frames_ - available_to_read_frames_impl(write_pos, read_pos_frames);
+  // Claiming the threshold makes sure one crossing produces exactly one wake syscall.
+  if (wanted != 0 && writable >= wanted &&
+      space_wait_frames_.compare_exchange_strong(wanted, 0, std::memory_order_relaxed)) {
+    space_wake_seq_.fetch_add(1, std::memory_order_release);
+    tomplayer::platform::WakeWordWaiters(&space_wake_seq_);
+  }
+}
+
+void SpscFrameIndex::WakeDataWaiterSlow(uint64_t write_pos_frames) {
+  uint32_t wanted = data_wait_frames_.load(std::memory_order_relaxed);
+  const uint64_t read_pos = read_pos_frames_.load(std::memory_order_acquire);
+  const uint32_t readable = available_to_read_frames_impl(write_pos_frames, read_pos);
+  if (wanted != 0 && readable >= wanted &&
+      data_wait_frames_.compare_exchange_strong(wanted, 0, std::memory_order_relaxed)) {
+    data_wake_seq_.fetch_add(1, std::memory_order_release);
+    tomplayer::platform::WakeWordWaiters(&data_wake_seq_);
+  }
+}
+
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform/word_wait.h"
+
+// SpscFrameIndex
+// - Position, wait and counter machinery shared by the single-producer/single-consumer rings
+//   (BasicAudioRingBuffer, PlanarAudioRingBuffer). A ring owns one and adds only its storage
+//   layout: mapping [start_frame, start_frame + frames) to sample addresses.
+// - Positions are monotonically increasing 64-bit frame counts; index_of maps one to a slot,
+//   with a mask at power-of-two capacity and modulo otherwise.
+// - Invariant: write_pos >= read_pos and write_pos - read_pos <= capacity. Debug builds assert
+//   it; release builds clamp and count an invariant violation.
+// - Layout: producer and consumer positions live on separate cache lines, and each side keeps
+//   a cached copy of the peer position so the shared line is touched only when the cache
+//   runs dry.
+// - Real-time constraints: acquire/commit never allocate, lock, or block. Commits issue a
+//   wake syscall only when the peer is blocked in wait_* and its threshold was just crossed.
+//   The commit-side waiter check uses the light half of an asymmetric fence (a compiler
+//   barrier where the OS supports it); wait_* pays the heavy half before it blocks.
+class SpscFrameIndex {
+public:
+  // Summary: Frames [start_frame, start_frame + frames) reserved by acquire_write/acquire_read.
+  // Preconditions: none.
+  // Postconditions: none.
+  // Errors: frames == 0 when nothing could be reserved.
+  struct Reservation {
+    uint64_t start_frame = 0;
+    uint32_t frames = 0;
+  };
+
+  // Summary: Fix the capacity before the owning ring is shared between threads.
+  // Preconditions: no producer/consumer activity yet (called from the ring's constructor).
+  // Postconditions: uses_index_mask() is true iff capacity_frames is a power of two.
+  // Errors: none; capacity 0 leaves an index whose reservations are always empty.
+  void set_capacity(uint32_t capacity_frames);
+
+  uint32_t capacity_frames() const { return capacity_frames_; }
+  bool uses_index_mask() const { return index_mask_ != 0; }
+  uint32_t index_of(uint64_t pos_frames) const {
+    return index_mask_ != 0 ? static_cast<uint32_t>(pos_frames & index_mask_)
+                            : static_cast<uint32_t>(pos_frames % capacity_frames_);
+  }
+
+  // Summary: Latest positions; acquire pairs with the owning side's commit (any thread).
+  uint64_t write_pos_frames(std::memory_order order = std::memory_order_acquire) const {
+    return write_pos_frames_.load(order);
+  }
+  uint64_t read_pos_frames(std::memory_order order = std::memory_order_acquire) const {
+    return read_pos_frames_.load(order);
+  }
+
+  uint32_t available_to_write_frames() const;
+  uint32_t available_to_read_frames() const;
+
+  // Summary: Reserve up to frames_requested frames at the write position (producer only).
+  // Preconditions: at most one outstanding write reservation.
+  // Postconditions: refreshes the cached read position only when the cached view falls short.
+  // Errors: reserves fewer frames when full and counts an overrun.
+  Reservation acquire_write(uint32_t frames_requested);
+
+  // Summary: Publish frames_written frames and wake a consumer waiting for them.
+  // Preconditions: producer only; frames_written <= the last reservation.
+  // Postconditions: write position advances by frames_written.
+  // Errors: release builds clamp an oversized commit and count an invariant violation.
+  void commit_write(uint32_t frames_written);
+
+  // Summary: Expose up to frames_requested frames at the read position (consumer only).
+  // Preconditions: at most one outstanding read reservation.
+  // Postconditions: refreshes the cached write position only when the cached view falls short.
+  // Errors: exposes fewer frames when empty and counts an underrun.
+  Reservation acquire_read(uint32_t frames_requested);
+
+  // Summary: Read position after releasing frames_read frames, checked against the last
+  //   acquire_read (consumer only). Does not publish: rings that attach state to positions
+  //   publish it first, then call publish_read_pos with the result.
+  // Preconditions: frames_read <= the last reservation.
+  // Postconditions: none.
+  // Errors: release builds clamp an oversized count and count an invariant violation.
+  uint64_t read_commit_end(uint32_t frames_read);
+
+  // Summary: Publish a new read position and wake a producer waiting for the space.
+  // Preconditions: consumer only; read_pos <= read_pos_frames <= a write position it has
+  //   observed (through acquire_read or observe_write_pos).
+  // Postconditions: the frames below read_pos_frames belong to the producer again.
+  // Errors: none.
+  void publish_read_pos(uint64_t read_pos_frames);
+
+  // Summary: commit_write's counterpart: publish_read_pos(read_commit_end(frames_read)).
+  void commit_read(uint32_t frames_read) { publish_read_pos(read_commit_end(frames_read)); }
+
+  // Summary: Fold a write position the consumer loaded itself into its cached view.
+  // Preconditions: consumer only; write_pos_frames was loaded with acquire.
+  // Postconditions: the cached view never moves backwards.
+  // Errors: none.
+  void observe_write_pos(uint64_t write_pos_frames);
+
+  // Summary: Block the producer until at least min_frames can be written, or timeout.
+  // Preconditions: producer only.
+  // Postconditions: on true, available_to_write_frames() >= min_frames. The consumer wakes
+  //   the producer only when its commit crosses min_frames, not on every read.
+  // Errors: returns false on timeout or when min_frames > capacity_frames().
+  bool wait_writable(uint32_t min_frames, std::chrono::nanoseconds timeout);
+
+  // Summary: Block the consumer until at least min_frames can be read, or timeout.
+  // Preconditions: consumer only.
+  // Postconditions: on true, available_to_read_frames() >= min_frames. The producer wakes
+  //   the consumer only when its commit crosses min_frames, not on every write.
+  // Errors: returns false on timeout or when min_frames > capacity_frames().
+  bool wait_readable(uint32_t min_frames, std::chrono::nanoseconds timeout);
+
+  // Summary: Clear positions, cached views, waits and counters.
+  // Preconditions: no producer/consumer activity.
+  // Postconditions: the index is empty.
+  // Errors: none.
+  void reset();
+
+  uint64_t underrun_count() const { return underrun_count_.load(std::memory_order_relaxed); }
+  uint64_t overrun_count() const { return overrun_count_.load(std::memory_order_relaxed); }
+  uint64_t invariant_violation_count() const {
+    return invariant_violation_count_.load(std::memory_order_relaxed);
+  }
+
+private:
+  uint32_t available_to_read_frames_impl(uint64_t write_pos_frames,
+                                         uint64_t read_pos_frames) const;
+  void WakeSpaceWaiter(uint64_t read_pos_frames);
+  void WakeDataWaiter(uint64_t write_pos_frames);
+  // Out of line: run only when a waiter has published a threshold.
+  void WakeSpaceWaiterSlow(uint64_t read_pos_frames);
+  void WakeDataWaiterSlow(uint64_t write_pos_frames);
+
+  // Fixed 64-byte line size: std::hardware_destructive_interference_size is not ABI-stable.
+  static constexpr size_t kCacheLineBytes = 64;
+
+  // Read-only once the ring is shared.
+  uint32_t capacity_frames_{0};
+  // capacity_frames_ - 1 at power-of-two capacity, 0 when indexing falls back to modulo.
+  uint64_t index_mask_{0};
+
+  // Producer line: written only by the producer. cached_read_pos_frames_ is the producer's
+  // private (possibly stale, always conservative) view of read_pos_frames_.
+  alignas(kCacheLineBytes) std::atomic<uint64_t> write_pos_frames_{0};
+  uint64_t cached_read_pos_frames_{0};
+  std::atomic<uint64_t> overrun_count_{0};
+
+  // Consumer line: mirror image of the producer line.
+  alignas(kCacheLineBytes) std::atomic<uint64_t> read_pos_frames_{0};
+  uint64_t cached_write_pos_frames_{0};
+  std::atomic<uint64_t> underrun_count_{0};
+
+  // Wait line: a blocked side publishes the frame count it needs (0 = not waiting) and
+  // sleeps on its wake sequence; the peer bumps the sequence only once that count is met.
+  alignas(kCacheLineBytes) std::atomic<uint32_t> space_wait_frames_{0};
+  std::atomic<uint32_t> space_wake_seq_{0};
+  std::atomic<uint32_t> data_wait_frames_{0};
+  std::atomic<uint32_t> data_wake_seq_{0};
+
+  // Mutable so const diagnostic reads can record invariant violations in release.
+  // Kept off both position lines since either thread may bump it.
+  alignas(kCacheLineBytes) mutable std::atomic<uint64_t> invariant_violation_count_{0};
+};
+
+// Hot path, inline so each ring's acquire/commit compiles to straight-line code.
+
+inline SpscFrameIndex::Reservation SpscFrameIndex::acquire_write(uint32_t frames_requested) {
+  const uint64_t write_pos = write_pos_frames_.load(std::memory_order_relaxed);
+  uint32_t available_write =
+      capacity_frames_ - available_to_read_frames_impl(write_pos, cached_read_pos_frames_);
+  if (available_write < frames_requested) {
+    // Only pull the consumer's line when the cached view cannot satisfy the request.
+    cached_read_pos_frames_ = read_pos_frames_.load(std::memory_order_acquire);
+    available_write =
+        capacity_frames_ - available_to_read_frames_impl(write_pos, cached_read_pos_frames_);
+  }
+
+  const uint32_t frames_to_write = std::min(frames_requested, available_write);
+  if (frames_to_write < frames_requested) {
+    overrun_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return {write_pos, frames_to_write};
+}
+
+inline void SpscFrameIndex::commit_write(uint32_t frames_written) {
+  if (frames_written == 0) {
+    return;
+  }
+
+  // Validate against the same cached view acquire_write reserved from.
+  const uint64_t write_pos = write_pos_frames_.load(std::memory_order_relaxed);
+  const uint32_t available_write =
+      capacity_frames_ - available_to_read_frames_impl(write_pos, cached_read_pos_frames_);
+#ifndef NDEBUG
+  assert(frames_written <= available_write);
+#else
+  if (frames_written > available_write) {
+    invariant_violation_count_.fetch_add(1, std::memory_order_relaxed);
+    frames_written = available_write;
+  }
+#endif
+
+  write_pos_frames_.store(write_pos + frames_written, std::memory_order_release);
+  WakeDataWaiter(write_pos + frames_written);
+}
+
+inline SpscFrameIndex::Reservation SpscFrameIndex::acquire_read(uint32_t frames_requested) {
+  const uint64_t read_pos = read_pos_frames_.load(std::memory_order_relaxed);
+  uint32_t available_read = available_to_read_frames_impl(cached_write_pos_frames_, read_pos);
+  if (available_read < frames_requested) {
+    // Only pull the producer's line when the cached view cannot satisfy the request.
+    cached_write_pos_frames_ = write_pos_frames_.load(std::memory_order_acquire);
+    available_read = available_to_read_frames_impl(cached_write_pos_frames_, read_pos);
+  }
+
+  const uint32_t frames_to_read = std::min(frames_requested, available_read);
+  if (frames_to_read < frames_requested) {
+    underrun_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return {read_pos, frames_to_read};
+}
+
+inline uint64_t SpscFrameIndex::read_commit_end(uint32_t frames_read) {
+  // Validate against the same cached view acquire_read exposed.
+  const uint64_t read_pos = read_pos_frames_.load(std::memory_order_relaxed);
+  const uint32_t available_read = available_to_read_frames_impl(cached_write_pos_frames_, read_pos);
+#ifndef NDEBUG
+  assert(frames_read <= available_read);
+#else
+  if (frames_read > available_read) {
+    invariant_violation_count_.fetch_add(1, std::memory_order_relaxed);
+    frames_read = available_read;
+  }
+#endif
+  return read_pos + frames_read;
+}
+
+inline void SpscFrameIndex::publish_read_pos(uint64_t read_pos_frames) {
+  if (read_pos_frames == read_pos_frames_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  read_pos_frames_.store(read_pos_frames, std::memory_order_release);
+  WakeSpaceWaiter(read_pos_frames);
+}
+
+inline uint32_t SpscFrameIndex::available_to_read_frames_impl(uint64_t write_pos_frames,
+                                                              uint64_t read_pos_frames) const {
+#ifndef NDEBUG
+  assert(write_pos_frames >= read_pos_frames);
+  assert(write_pos_frames - read_pos_frames <= capacity_frames_);
+#else
+  if (write_pos_frames < read_pos_frames) {
+    invariant_violation_count_.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+#endif
+
+  const uint64_t available = write_pos_frames - read_pos_frames;
+#ifndef NDEBUG
+  return static_cast<uint32_t>(available);
+#else
+  if (available > capacity_frames_) {
+    invariant_violation_count_.fetch_add(1, std::memory_order_relaxed);
+    return capacity_frames_;
+  }
+  return static_cast<uint32_t>(available);
+#endif
+}
+
+inline void SpscFrameIndex::WakeSpaceWaiter(uint64_t read_pos_frames) {
+  tomplayer::platform::AsymmetricLightFence();
+  if (space_wait_frames_.load(std::memory_order_relaxed) != 0) {
+    WakeSpaceWaiterSlow(read_pos_frames);
+  }
+}
+
+inline void SpscFrameIndex::WakeDataWaiter(uint64_t write_pos_frames) {
+  tomplayer::platform::AsymmetricLightFence();
+  if (data_wait_frames_.load(std::memory_order_relaxed) != 0) {
+    WakeDataWaiterSlow(write_pos_frames);
+  }
+}
@@ -0,0 +1,58 @@
+#include "decode/decoder.h"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+#include "decode/wav_decoder.h"
+#if defined(TOMPLAYER_HAS_FLAC)
+#include "decode/flac_decoder.h"
+#endif
+
+namespace tomplayer::decode {
+
+std::unique_ptr<Decoder> OpenDecoder(const std::string& path, std::string* error) {
+  // Sniff the magic rather than trusting the extension.
+  std::array<char, 4> magic{};
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (!file) {
+    if (error) {
+      *error = "Cannot open " + path;
+    }
+    return nullptr;
+  }
+  const size_t got = std::fread(magic.data(), 1, magic.size(), file);
+  std::fclose(file);
+
+  const auto is = [&](const char* tag) {
+    return got == magic.size() && std::memcmp(magic.data(), tag, magic.size()) == 0;
+  };
+  if (is("RIFF") || is("RF64") || is("BW64")) {
+    auto decoder = std::make_unique<WavDecoder>();
+    if (!decoder->open(path, error)) {
+      return nullptr;
+    }
+    return decoder;
+  }
+  // libFLAC skips an ID3v2 tag in front of the stream marker itself.
+  if (is("fLaC") || (got >= 3 && std::memcmp(magic.data(), "ID3", 3) == 0)) {
+#if defined(TOMPLAYER_HAS_FLAC)
+    auto decoder = std::make_unique<FlacDecoder>();
+    if (!decoder->open(path, error)) {
+      return nullptr;
+    }
+    return decoder;
+#else
+    if (error) {
+      *error = path + ": FLAC support is not built in (libFLAC was not found)";
+    }
+    return nullptr;
+#endif
+  }
+  if (error) {
+    *error = path + ": unrecognised audio format";
+  }
+  return nullptr;
+}
+
+}  // namespace tomplayer::decode
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace tomplayer::decode {
+
+// Summary: Layout of the float frames a Decoder produces.
+// Preconditions: none.
+// Postconditions: sample_rate and channels are non-zero for an open decoder.
+// Errors: none.
+struct StreamInfo {
+  uint32_t sample_rate = 0;
+  uint32_t channels = 0;
+  // Frames in the stream; -1 when the container does not say.
+  int64_t total_frames = -1;
+};
+
+// Summary: One open audio stream, decoded to interleaved float32 on demand.
+// Preconditions: used by one thread at a time (PlayerEngine hands it to the decode thread
+//   and only replaces it while that thread is idle).
+// Postconditions: frames come out in stream order from the last seek position.
+// Errors: a decode failure ends the stream early; error() says why.
+class Decoder {
+public:
+  virtual ~Decoder() = default;
+
+  virtual const StreamInfo& info() const = 0;
+
+  // Summary: Decode up to frames frames into dst (info().channels floats per frame).
+  // Preconditions: dst has room for frames * info().channels floats.
+  // Postconditions: the read position advances by the return value. Fewer than frames are
+  //   returned only at the end of the stream. Implementations write straight into dst and
+  //   do not allocate, so dst may be ring storage.
+  // Errors: returns 0 at the end of the stream or after a decode error.
+  virtual uint32_t read(float* dst, uint32_t frames) = 0;
+
+  // Summary: Move the read position to frame (sample-accurate).
+  // Preconditions: frame >= 0.
+  // Postconditions: the next read starts at frame; positions past the end leave the stream
+  //   at its end.
+  // Errors: returns false if the stream cannot seek there; the position is then undefined
+  //   until the next successful seek.
+  virtual bool seek(int64_t frame) = 0;
+
+  // Summary: Why the stream ended early; empty while healthy or at a clean end.
+  virtual const std::string& error() const = 0;
+};
+
+// Summary: Open path with the decoder its header identifies: RIFF/RF64/BW64 WAVE, or FLAC
+//   in builds with libFLAC (TOMPLAYER_HAS_FLAC).
+// Preconditions: none.
+// Postconditions: the returned decoder is positioned at frame 0.
+// Errors: returns null and sets *error (when non-null) if the file cannot be read, is not
+//   a recognised format, or uses an unsupported encoding.
+std::unique_ptr<Decoder> OpenDecoder(const std::string& path, std::string* error);
+
+}  // namespace tomplayer::decode
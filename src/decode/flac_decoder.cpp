@@ -0,0 +1,250 @@
+#include "decode/flac_decoder.h"
+
+#include <FLAC/stream_decoder.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace tomplayer::decode {
+namespace {
+FLAC__StreamDecoder* Handle(void* stream) {
+  return static_cast<FLAC__StreamDecoder*>(stream);
+}
+
+bool Fail(std::string* error, const std::string& message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+// Planar libFLAC samples [first, first + frames) to interleaved float.
+void Interleave(const FLAC__int32* const planes[],
+                uint32_t channels,
+                uint32_t first,
+                uint32_t frames,
+                float scale,
+                float* dst) {
+  for (uint32_t channel = 0; channel < channels; ++channel) {
+    const FLAC__int32* const in = planes[channel] + first;
+    float* const out = dst + channel;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      out[static_cast<size_t>(frame) * channels] = static_cast<float>(in[frame]) * scale;
+    }
+  }
+}
+}  // namespace
+
+struct FlacDecoder::Callbacks {
+  static FLAC__StreamDecoderReadStatus Read(const FLAC__StreamDecoder*,
+                                            FLAC__byte buffer[],
+                                            size_t* bytes,
+                                            void* client) {
+    FlacDecoder* const self = static_cast<FlacDecoder*>(client);
+    const uint64_t left = self->file_.size() - self->file_offset_;
+    if (left == 0) {
+      *bytes = 0;
+      return FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+    }
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(*bytes, left));
+    std::memcpy(buffer, self->file_.data() + self->file_offset_, count);
+    self->file_offset_ += count;
+    *bytes = count;
+    return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+  }
+
+  static FLAC__StreamDecoderSeekStatus Seek(const FLAC__StreamDecoder*,
+                                            FLAC__uint64 offset,
+                                            void* client) {
+    FlacDecoder* const self = static_cast<FlacDecoder*>(client);
+    if (offset > self->file_.size()) {
+      return FLAC__STREAM_DECODER_SEEK_STATUS_ERROR;
+    }
+    self->file_offset_ = offset;
+    return FLAC__STREAM_DECODER_SEEK_STATUS_OK;
+  }
+
+  static FLAC__StreamDecoderTellStatus Tell(const FLAC__StreamDecoder*,
+                                            FLAC__uint64* offset,
+                                            void* client) {
+    *offset = static_cast<FlacDecoder*>(client)->file_offset_;
+    return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+  }
+
+  static FLAC__StreamDecoderLengthStatus Length(const FLAC__StreamDecoder*,
+                                                FLAC__uint64* length,
+                                                void* client) {
+    *length = static_cast<FlacDecoder*>(client)->file_.size();
+    return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
+  }
+
+  static FLAC__bool Eof(const FLAC__StreamDecoder*, void* client) {
+    const FlacDecoder* const self = static_cast<FlacDecoder*>(client);
+    return self->file_offset_ >= self->file_.size();
+  }
+
+  static FLAC__StreamDecoderWriteStatus Write(const FLAC__StreamDecoder*,
+                                              const FLAC__Frame* frame,
+                                              const FLAC__int32* const buffer[],
+                                              void* client) {
+    FlacDecoder* const self = static_cast<FlacDecoder*>(client);
+    const uint32_t frames = frame->header.blocksize;
+    const uint32_t channels = self->info_.channels;
+    // The overflow buffer is sized from STREAMINFO; a stream that breaks its own limits
+    // is not worth an allocation on the decode thread.
+    if (frame->header.channels != channels ||
+        frame->header.bits_per_sample != self->bits_per_sample_ ||
+        frames > self->max_block_frames_) {
+      self->error_ = self->path_ + ": a frame does not match STREAMINFO";
+      return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+    }
+    // Straight into the reader's buffer as far as it reaches; the rest waits in parked_.
+    // The reader drains parked_ before decoding more, so it is empty here.
+    const uint32_t direct =
+        self->target_ ? std::min(frames, self->target_frames_ - self->target_filled_) : 0;
+    if (direct > 0) {
+      Interleave(buffer, channels, 0, direct, self->scale_,
+                 self->target_ + static_cast<size_t>(self->target_filled_) * channels);
+      self->target_filled_ += direct;
+    }
+    Interleave(buffer, channels, direct, frames - direct, self->scale_, self->parked_.data());
+    self->parked_frames_ = frames - direct;
+    self->parked_read_ = 0;
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+  }
+
+  static void Metadata(const FLAC__StreamDecoder*,
+                       const FLAC__StreamMetadata* metadata,
+                       void* client) {
+    if (metadata->type != FLAC__METADATA_TYPE_STREAMINFO) {
+      return;
+    }
+    FlacDecoder* const self = static_cast<FlacDecoder*>(client);
+    const FLAC__StreamMetadata_StreamInfo& info = metadata->data.stream_info;
+    self->info_.sample_rate = info.sample_rate;
+    self->info_.channels = info.channels;
+    // 0 means the encoder did not know the length (e.g. it was piped).
+    self->info_.total_frames =
+        info.total_samples > 0 ? static_cast<int64_t>(info.total_samples) : -1;
+    self->bits_per_sample_ = info.bits_per_sample;
+    self->max_block_frames_ = info.max_blocksize;
+  }
+
+  static void Error(const FLAC__StreamDecoder*,
+                    FLAC__StreamDecoderErrorStatus status,
+                    void* client) {
+    static_cast<FlacDecoder*>(client)->stream_error_ = FLAC__StreamDecoderErrorStatusString[status];
+  }
+};
+
+FlacDecoder::~FlacDecoder() {
+  Close();
+}
+
+bool FlacDecoder::open(const std::string& path, std::string* error) {
+  if (!file_.open(path, error)) {
+    return false;
+  }
+  path_ = path;
+  file_offset_ = 0;
+  stream_ = FLAC__stream_decoder_new();
+  if (!stream_) {
+    Close();
+    return Fail(error, path + ": cannot create a FLAC decoder");
+  }
+  const FLAC__StreamDecoderInitStatus status = FLAC__stream_decoder_init_stream(
+      Handle(stream_), &Callbacks::Read, &Callbacks::Seek, &Callbacks::Tell, &Callbacks::Length,
+      &Callbacks::Eof, &Callbacks::Write, &Callbacks::Metadata, &Callbacks::Error, this);
+  if (status != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+    Close();
+    return Fail(error, path + ": " + FLAC__StreamDecoderInitStatusString[status]);
+  }
+  if (!FLAC__stream_decoder_process_until_end_of_metadata(Handle(stream_)) ||
+      info_.channels == 0 || info_.sample_rate == 0 || max_block_frames_ == 0) {
+    Close();
+    return Fail(error, path + ": not a FLAC stream");
+  }
+  scale_ = std::ldexp(1.0f, 1 - static_cast<int>(bits_per_sample_));
+  parked_.assign(static_cast<size_t>(max_block_frames_) * info_.channels, 0.0f);
+  return true;
+}
+
+void FlacDecoder::Close() {
+  if (stream_) {
+    FLAC__stream_decoder_finish(Handle(stream_));
+    FLAC__stream_decoder_delete(Handle(stream_));
+    stream_ = nullptr;
+  }
+  file_.close();
+}
+
+uint32_t FlacDecoder::TakeParked(float* dst, uint32_t frames) {
+  const uint32_t count = std::min(frames, parked_frames_ - parked_read_);
+  const size_t channels = info_.channels;
+  std::copy_n(parked_.data() + parked_read_ * channels, count * channels, dst);
+  parked_read_ += count;
+  return count;
+}
+
+uint32_t FlacDecoder::read(float* dst, uint32_t frames) {
+  const uint32_t parked = TakeParked(dst, frames);
+  if (parked == frames || at_end_ || !stream_) {
+    return parked;
+  }
+  target_ = dst;
+  target_frames_ = frames;
+  target_filled_ = parked;
+  while (target_filled_ < target_frames_) {
+    if (!FLAC__stream_decoder_process_single(Handle(stream_))) {
+      if (error_.empty()) {
+        error_ = path_ + ": " +
+                 (stream_error_ ? stream_error_
+                                : FLAC__stream_decoder_get_resolved_state_string(Handle(stream_)));
+      }
+      at_end_ = true;
+      break;
+    }
+    if (FLAC__stream_decoder_get_state(Handle(stream_)) == FLAC__STREAM_DECODER_END_OF_STREAM) {
+      at_end_ = true;
+      break;
+    }
+  }
+  const uint32_t filled = target_filled_;
+  target_ = nullptr;
+  return filled;
+}
+
+bool FlacDecoder::seek(int64_t frame) {
+  parked_frames_ = 0;
+  parked_read_ = 0;
+  at_end_ = false;
+  if (!stream_) {
+    return false;
+  }
+  error_.clear();
+  stream_error_ = nullptr;
+  // After an aborted decode libFLAC refuses to seek until flushed.
+  if (FLAC__stream_decoder_get_state(Handle(stream_)) == FLAC__STREAM_DECODER_ABORTED) {
+    FLAC__stream_decoder_flush(Handle(stream_));
+  }
+  const uint64_t sample = static_cast<uint64_t>(std::max<int64_t>(frame, 0));
+  if (info_.total_frames >= 0 && sample >= static_cast<uint64_t>(info_.total_frames)) {
+    at_end_ = true;
+    return true;
+  }
+  // The block containing sample comes back through Write with target_ unset, trimmed to
+  // start at sample, and is parked for the next read.
+  if (FLAC__stream_decoder_seek_absolute(Handle(stream_), sample)) {
+    return true;
+  }
+  // A failed seek leaves the decoder unusable until flushed.
+  if (FLAC__stream_decoder_get_state(Handle(stream_)) == FLAC__STREAM_DECODER_SEEK_ERROR) {
+    FLAC__stream_decoder_flush(Handle(stream_));
+  }
+  error_ = path_ + ": cannot seek to frame " + std::to_string(sample);
+  at_end_ = true;
+  return false;
+}
+
+}  // namespace tomplayer::decode
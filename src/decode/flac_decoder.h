@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "decode/decoder.h"
+#include "platform/mapped_file.h"
+
+namespace tomplayer::decode {
+
+// Summary: FLAC decoder on libFLAC's stream decoder, fed from a memory-mapped file.
+// - read() decodes each block straight into the caller's buffer (ring storage, from
+//   PlayerEngine); only the part of a block past the end of that buffer is parked in a
+//   block-sized buffer allocated once on open, so decoding never allocates.
+// - seek() is libFLAC's sample-accurate seek (seek table or bisection over the file).
+// Preconditions: one thread at a time (see Decoder).
+// Postconditions: samples are scaled by 2^-(bits-1), as WavDecoder does for PCM.
+// Errors: open() fails for anything libFLAC cannot parse up to the first audio frame. A
+//   corrupt frame is skipped (libFLAC resynchronises); a fatal decode error ends the
+//   stream and error() reports it.
+// FLAC/stream_decoder.h stays out of this header: libFLAC's handle type is an anonymous
+// struct and cannot be forward-declared, so it is held as void*.
+class FlacDecoder final : public Decoder {
+public:
+  FlacDecoder() = default;
+  ~FlacDecoder() override;
+
+  FlacDecoder(const FlacDecoder&) = delete;
+  FlacDecoder& operator=(const FlacDecoder&) = delete;
+
+  // Summary: Map path and decode its metadata (STREAMINFO).
+  // Preconditions: nothing open yet.
+  // Postconditions: positioned at frame 0; info() describes the stream, with total_frames
+  //   -1 when STREAMINFO leaves it unset.
+  // Errors: returns false and sets *error (when non-null) if the file cannot be mapped or
+  //   is not a FLAC stream.
+  bool open(const std::string& path, std::string* error);
+
+  const StreamInfo& info() const override { return info_; }
+  uint32_t read(float* dst, uint32_t frames) override;
+  bool seek(int64_t frame) override;
+  const std::string& error() const override { return error_; }
+
+  uint32_t bits_per_sample() const { return bits_per_sample_; }
+  // Summary: Largest block STREAMINFO allows; the overflow buffer holds one.
+  uint32_t max_block_frames() const { return max_block_frames_; }
+
+private:
+  // libFLAC callbacks, defined next to the libFLAC include.
+  struct Callbacks;
+  friend struct Callbacks;
+
+  void Close();
+  uint32_t TakeParked(float* dst, uint32_t frames);
+
+  tomplayer::platform::MappedFile file_;
+  uint64_t file_offset_{0};
+  std::string path_;
+  // FLAC__StreamDecoder*.
+  void* stream_{nullptr};
+  StreamInfo info_{};
+  uint32_t bits_per_sample_{0};
+  uint32_t max_block_frames_{0};
+  float scale_{0.0f};
+
+  // Decoded frames a read had no room for: the tail of a block, or the block a seek
+  // landed in. Interleaved, capacity max_block_frames_.
+  std::vector<float> parked_;
+  uint32_t parked_frames_{0};
+  uint32_t parked_read_{0};
+  // Buffer of the read in progress; the write callback decodes straight into it.
+  float* target_{nullptr};
+  uint32_t target_frames_{0};
+  uint32_t target_filled_{0};
+  bool at_end_{false};
+  // Last recoverable stream error, reported if decoding later fails outright.
+  const char* stream_error_{nullptr};
+  std::string error_;
+};
+
+}  // namespace tomplayer::decode
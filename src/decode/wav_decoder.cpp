@@ -0,0 +1,222 @@
+#include "decode/wav_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "audio/sample_convert.h"
+
+namespace tomplayer::decode {
+namespace {
+using tomplayer::audio::SampleFormat;
+
+constexpr uint16_t kWaveFormatPcm = 1;
+constexpr uint16_t kWaveFormatIeeeFloat = 3;
+constexpr uint16_t kWaveFormatExtensible = 0xFFFE;
+// KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT differ only in their first two bytes, which hold
+// the plain format tag.
+constexpr std::array<uint8_t, 14> kSubtypeGuidTail = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80,
+                                                      0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+// RF64/BW64 write this into a 32-bit size field and keep the real size in ds64.
+constexpr uint32_t kSizeInDs64 = 0xFFFFFFFF;
+constexpr uint64_t kDs64MinBytes = 28;
+constexpr uint64_t kDs64TableEntryBytes = 12;
+// Asked for ahead of a seek target; sequential readahead takes over from there.
+constexpr uint64_t kSeekPrefetchBytes = 256 * 1024;
+
+uint16_t U16(const uint8_t* in) {
+  return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t U32(const uint8_t* in) {
+  return uint32_t{in[0]} | (uint32_t{in[1]} << 8) | (uint32_t{in[2]} << 16) |
+         (uint32_t{in[3]} << 24);
+}
+
+uint64_t U64(const uint8_t* in) {
+  return uint64_t{U32(in)} | (uint64_t{U32(in + 4)} << 32);
+}
+
+bool IsTag(const uint8_t* in, const char* tag) {
+  return std::memcmp(in, tag, 4) == 0;
+}
+
+bool Fail(std::string* error, const std::string& message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+SampleFormat FormatFor(uint16_t format_tag, uint32_t bits) {
+  if (format_tag == kWaveFormatPcm) {
+    switch (bits) {
+      case 16:
+        return SampleFormat::Pcm16;
+      case 24:
+        return SampleFormat::Pcm24;
+      case 32:
+        return SampleFormat::Pcm32;
+      default:
+        return SampleFormat::Unsupported;
+    }
+  }
+  if (format_tag == kWaveFormatIeeeFloat && (bits == 32 || bits == 64)) {
+    return SampleFormat::Float32;
+  }
+  return SampleFormat::Unsupported;
+}
+}  // namespace
+
+bool WavDecoder::open(const std::string& path, std::string* error) {
+  if (!file_.open(path, error)) {
+    return false;
+  }
+  if (!Parse(path, error)) {
+    file_.close();
+    return false;
+  }
+  return true;
+}
+
+bool WavDecoder::Parse(const std::string& path, std::string* error) {
+  const uint8_t* const file = file_.data();
+  const uint64_t size = file_.size();
+  if (size < 12 || !IsTag(file + 8, "WAVE")) {
+    return Fail(error, path + " is not a WAVE file");
+  }
+  const bool rf64 = IsTag(file, "RF64") || IsTag(file, "BW64");
+  if (!rf64 && !IsTag(file, "RIFF")) {
+    return Fail(error, path + " is not a WAVE file");
+  }
+
+  // ds64: 64-bit sizes for the RIFF, the data chunk and (rarely) any other chunk over 4 GB.
+  uint64_t ds64_data_bytes = 0;
+  const uint8_t* ds64_table = nullptr;
+  uint64_t ds64_table_entries = 0;
+  const uint8_t* fmt = nullptr;
+  uint64_t fmt_bytes = 0;
+  bool have_data = false;
+  uint64_t data_bytes = 0;
+
+  uint64_t offset = 12;
+  while (offset + 8 <= size) {
+    const uint8_t* const header = file + offset;
+    const uint64_t body = offset + 8;
+    uint64_t chunk_bytes = U32(header + 4);
+    if (rf64 && chunk_bytes == kSizeInDs64) {
+      if (IsTag(header, "data")) {
+        chunk_bytes = ds64_data_bytes;
+      }
+      for (uint64_t entry = 0; entry < ds64_table_entries; ++entry) {
+        const uint8_t* const row = ds64_table + entry * kDs64TableEntryBytes;
+        if (std::memcmp(row, header, 4) == 0) {
+          chunk_bytes = U64(row + 4);
+        }
+      }
+    }
+
+    if (IsTag(header, "ds64")) {
+      if (!rf64 || chunk_bytes < kDs64MinBytes || chunk_bytes > size - body) {
+        return Fail(error, path + ": malformed ds64 chunk");
+      }
+      ds64_data_bytes = U64(file + body + 8);
+      ds64_table = file + body + kDs64MinBytes;
+      ds64_table_entries = std::min<uint64_t>(U32(file + body + 24),
+                                              (chunk_bytes - kDs64MinBytes) /
+                                                  kDs64TableEntryBytes);
+    } else if (IsTag(header, "fmt ")) {
+      if (chunk_bytes < 16 || chunk_bytes > size - body) {
+        return Fail(error, path + ": malformed fmt chunk");
+      }
+      fmt = file + body;
+      fmt_bytes = chunk_bytes;
+    } else if (IsTag(header, "data")) {
+      // A header written before the recording finished may claim more than the file holds.
+      data_offset_ = body;
+      data_bytes = std::min(chunk_bytes, size - body);
+      have_data = true;
+      if (fmt) {
+        // Anything after the samples is metadata.
+        break;
+      }
+    }
+    if (chunk_bytes >= size - body) {
+      break;
+    }
+    // Chunks are word-aligned: an odd size is followed by a pad byte.
+    offset = body + chunk_bytes + (chunk_bytes & 1);
+  }
+
+  if (!fmt || !have_data) {
+    return Fail(error, path + (fmt ? ": no data chunk" : ": no fmt chunk"));
+  }
+  uint16_t format_tag = U16(fmt);
+  const uint32_t channels = U16(fmt + 2);
+  const uint32_t sample_rate = U32(fmt + 4);
+  const uint32_t block_align = U16(fmt + 12);
+  const uint32_t bits = U16(fmt + 14);
+  if (format_tag == kWaveFormatExtensible) {
+    // cbSize, valid bits and channel mask precede the subformat GUID. Valid bits below the
+    // container size (24-in-32) need no special handling: samples are MSB-aligned.
+    if (fmt_bytes < 40) {
+      return Fail(error, path + ": malformed WAVE_FORMAT_EXTENSIBLE header");
+    }
+    const uint8_t* const subformat = fmt + 24;
+    if (std::memcmp(subformat + 2, kSubtypeGuidTail.data(), kSubtypeGuidTail.size()) != 0) {
+      return Fail(error, path + ": unsupported WAVE_FORMAT_EXTENSIBLE subformat");
+    }
+    format_tag = U16(subformat);
+  }
+  const SampleFormat format = FormatFor(format_tag, bits);
+  if (format == SampleFormat::Unsupported) {
+    return Fail(error, path + ": unsupported encoding (format tag " +
+                           std::to_string(format_tag) + ", " + std::to_string(bits) +
+                           "-bit)");
+  }
+  if (channels == 0 || sample_rate == 0 || block_align != channels * (bits / 8)) {
+    return Fail(error, path + ": inconsistent fmt chunk");
+  }
+
+  info_.sample_rate = sample_rate;
+  info_.channels = channels;
+  format_ = format;
+  bits_per_sample_ = bits;
+  block_align_ = block_align;
+  total_frames_ = data_bytes / block_align;
+  info_.total_frames = static_cast<int64_t>(total_frames_);
+  cursor_frame_ = 0;
+  return true;
+}
+
+uint32_t WavDecoder::read(float* dst, uint32_t frames) {
+  const uint32_t count =
+      static_cast<uint32_t>(std::min<uint64_t>(frames, total_frames_ - cursor_frame_));
+  if (count == 0) {
+    return 0;
+  }
+  const uint8_t* const src = file_.data() + data_offset_ + cursor_frame_ * block_align_;
+  if (bits_per_sample_ == 64) {
+    // Double-precision masters are rare enough that a scalar narrowing loop will do.
+    const size_t samples = static_cast<size_t>(count) * info_.channels;
+    for (size_t i = 0; i < samples; ++i) {
+      double sample;
+      std::memcpy(&sample, src + i * sizeof(sample), sizeof(sample));
+      dst[i] = static_cast<float>(sample);
+    }
+  } else {
+    tomplayer::audio::ConvertToFloat(src, count, info_.channels, format_, dst);
+  }
+  cursor_frame_ += count;
+  return count;
+}
+
+bool WavDecoder::seek(int64_t frame) {
+  cursor_frame_ = std::min(static_cast<uint64_t>(std::max<int64_t>(frame, 0)), total_frames_);
+  // Sequential readahead only follows faults; after a jump, start the read before the
+  // decoder touches the new pages.
+  file_.prefetch(data_offset_ + cursor_frame_ * block_align_, kSeekPrefetchBytes);
+  return true;
+}
+
+}  // namespace tomplayer::decode
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "audio/audio_output.h"
+#include "decode/decoder.h"
+#include "platform/mapped_file.h"
+
+namespace tomplayer::decode {
+
+// Summary: Streaming WAVE decoder over a memory-mapped file.
+// - Containers: RIFF, and RF64/BW64 (ds64 chunk) for data chunks of 4 GB and more.
+// - Encodings: PCM 16/24/32-bit, IEEE float 32/64-bit, plain or WAVE_FORMAT_EXTENSIBLE.
+// - read() converts straight from the mapping into the caller's buffer with the SIMD
+//   kernels in audio/sample_convert; there is no read() copy or staging buffer.
+// - seek() is O(1): frames are fixed-size, so a position is one multiply.
+// Preconditions: one thread at a time (see Decoder).
+// Postconditions: a data chunk cut short by the end of the file plays up to the last whole
+//   frame present.
+// Errors: open() rejects anything else (8-bit PCM, compressed tags, malformed chunks).
+class WavDecoder final : public Decoder {
+public:
+  WavDecoder() = default;
+
+  WavDecoder(const WavDecoder&) = delete;
+  WavDecoder& operator=(const WavDecoder&) = delete;
+
+  // Summary: Map path and parse its header.
+  // Preconditions: nothing open yet.
+  // Postconditions: positioned at frame 0; info() describes the stream.
+  // Errors: returns false and sets *error (when non-null) for unreadable, malformed or
+  //   unsupported files.
+  bool open(const std::string& path, std::string* error);
+
+  const StreamInfo& info() const override { return info_; }
+  uint32_t read(float* dst, uint32_t frames) override;
+  bool seek(int64_t frame) override;
+  const std::string& error() const override { return error_; }
+
+  // Summary: Storage of one sample: Float32 also stands for 64-bit float when
+  //   bits_per_sample() is 64.
+  tomplayer::audio::SampleFormat sample_format() const { return format_; }
+  uint32_t bits_per_sample() const { return bits_per_sample_; }
+  // Summary: File offset of the first sample (tests use it to check chunk parsing).
+  uint64_t data_offset() const { return data_offset_; }
+
+private:
+  bool Parse(const std::string& path, std::string* error);
+
+  tomplayer::platform::MappedFile file_;
+  StreamInfo info_{};
+  tomplayer::audio::SampleFormat format_{tomplayer::audio::SampleFormat::Unsupported};
+  uint32_t bits_per_sample_{0};
+  uint32_t block_align_{0};
+  uint64_t data_offset_{0};
+  uint64_t total_frames_{0};
+  uint64_t cursor_frame_{0};
+  std::string error_;
+};
+
+}  // namespace tomplayer::decode
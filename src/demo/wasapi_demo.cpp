@@ -92,12 +92,16 @@ bool ParseArgs(int argc, char* argv[], DemoOptions* options) {
   return true;
 }
 
-const char* SampleFormatToString(tomplayer::wasapi::SampleFormat format) {
+const char* SampleFormatToString(tomplayer::audio::SampleFormat format) {
   switch (format) {
-    case tomplayer::wasapi::SampleFormat::Float32:
+    case tomplayer::audio::SampleFormat::Float32:
       return "float32";
-    case tomplayer::wasapi::SampleFormat::Pcm16:
+    case tomplayer::audio::SampleFormat::Pcm16:
       return "pcm16";
+    case tomplayer::audio::SampleFormat::Pcm24:
+      return "pcm24";
+    case tomplayer::audio::SampleFormat::Pcm32:
+      return "pcm32";
     default:
       return "unsupported";
   }
@@ -287,7 +291,7 @@ int RunWasapiDemo(int argc, char* argv[]) {
   std::cout << "Mix format: " << output.sample_rate() << " Hz, " << output.channels()
             << " ch, " << SampleFormatToString(output.sample_format()) << "\n";
 
-  if (output.sample_format() == tomplayer::wasapi::SampleFormat::Unsupported) {
+  if (output.sample_format() == tomplayer::audio::SampleFormat::Unsupported) {
     std::cout << "Mix format unsupported; rendering silence.\n";
   }
 
@@ -0,0 +1,63 @@
+#include "engine/latency_controller.h"
+
+#include <algorithm>
+
+namespace tomplayer::engine {
+namespace {
+uint32_t FramesFor(std::chrono::milliseconds duration, uint32_t sample_rate_hz) {
+  return static_cast<uint32_t>(std::max<int64_t>(duration.count(), 0) * sample_rate_hz / 1000);
+}
+}  // namespace
+
+void LatencyController::reset(uint32_t sample_rate_hz, const Sample& baseline) {
+  sample_rate_hz_ = sample_rate_hz;
+  min_frames_ = std::max<uint32_t>(FramesFor(config_.min_latency, sample_rate_hz), 1);
+  max_frames_ = std::max(FramesFor(config_.max_latency, sample_rate_hz), min_frames_);
+  // Start safe; quiet time earns lower latency.
+  target_frames_ = max_frames_;
+  rebase(baseline);
+}
+
+void LatencyController::rebase(const Sample& sample) {
+  last_ = sample;
+  quiet_since_ = sample.at;
+}
+
+bool LatencyController::update(const Sample& sample) {
+  if (sample_rate_hz_ == 0 || sample.at - last_.at < config_.evaluation_interval) {
+    return false;
+  }
+  const double window_seconds = std::chrono::duration<double>(sample.at - last_.at).count();
+  const double window_frames = window_seconds * static_cast<double>(sample_rate_hz_);
+  // The decoder only counts as behind once the ring is running low; a full ring blocks it
+  // at exactly real time.
+  const bool decode_behind =
+      sample.capacity_frames > 0 && sample.buffered_frames < sample.capacity_frames / 4 &&
+      static_cast<double>(sample.decoded_frames - last_.decoded_frames) < window_frames;
+  const bool stressed = sample.underrun_wakes > last_.underrun_wakes ||
+                        sample.deadline_overruns > last_.deadline_overruns ||
+                        sample.late_wakes > last_.late_wakes || decode_behind;
+  last_ = sample;
+
+  if (stressed) {
+    quiet_since_ = sample.at;
+    const uint32_t grown =
+        static_cast<uint32_t>(std::min<uint64_t>(uint64_t{target_frames_} * 2, max_frames_));
+    if (grown == target_frames_) {
+      return false;
+    }
+    target_frames_ = grown;
+    ++grow_count_;
+    return true;
+  }
+  if (sample.at - quiet_since_ < config_.quiet_period || target_frames_ == min_frames_) {
+    return false;
+  }
+  quiet_since_ = sample.at;
+  target_frames_ = std::max(target_frames_ - std::max<uint32_t>(target_frames_ / 4, 1),
+                            min_frames_);
+  ++shrink_count_;
+  return true;
+}
+
+}  // namespace tomplayer::engine
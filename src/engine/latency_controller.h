@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace tomplayer::engine {
+
+// Summary: Picks how much audio to keep queued in the device from what the render and
+//   decode threads report: grow fast under stress (underruns, late wakes, overrunning
+//   callbacks, a decoder falling behind), shrink slowly while the system stays quiet.
+// Preconditions: engine thread only; samples carry cumulative counters, oldest first.
+// Postconditions: target_frames stays within [min_latency, max_latency] at the rate given
+//   to reset.
+// Errors: none.
+class LatencyController {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Summary: Bounds and pacing; see PlayerEngine::Config::adaptive_latency.
+  struct Config {
+    // Off: the device buffer is always filled completely (fixed latency).
+    bool enabled = false;
+    std::chrono::milliseconds min_latency{5};
+    std::chrono::milliseconds max_latency{100};
+    // Stress-free time before each shrink step.
+    std::chrono::milliseconds quiet_period{2000};
+    // Samples closer together than this are skipped: decode throughput over shorter
+    // windows is noise.
+    std::chrono::milliseconds evaluation_interval{100};
+  };
+
+  // Summary: Cumulative counters at one point in time (PlayerEngine fills it from the
+  //   output's counters, its RenderTiming report and the ring).
+  struct Sample {
+    Clock::time_point at{};
+    uint64_t underrun_wakes = 0;
+    uint64_t deadline_overruns = 0;
+    uint64_t late_wakes = 0;
+    uint64_t decoded_frames = 0;
+    uint32_t buffered_frames = 0;
+    uint32_t capacity_frames = 0;
+  };
+
+  explicit LatencyController(const Config& config) : config_(config) {}
+
+  // Summary: Start over at max_latency for a device running at sample_rate_hz.
+  // Preconditions: sample_rate_hz > 0.
+  // Postconditions: target_frames() is max_latency in frames; counters are measured from
+  //   baseline.
+  // Errors: none.
+  void reset(uint32_t sample_rate_hz, const Sample& baseline);
+
+  // Summary: Measure from sample on, keeping the target (playback resumed: the stop gap is
+  //   neither stress nor quiet time).
+  // Preconditions: none.
+  // Postconditions: the quiet period restarts at sample.at.
+  // Errors: none.
+  void rebase(const Sample& sample);
+
+  // Summary: Evaluate the window since the previous sample.
+  // Preconditions: reset() ran.
+  // Postconditions: under stress the target doubles (up to max); after quiet_period without
+  //   stress it shrinks by a quarter (down to min).
+  // Errors: none; returns true when target_frames() changed.
+  bool update(const Sample& sample);
+
+  // Summary: Device queue to aim for, in frames; 0 before reset().
+  uint32_t target_frames() const { return target_frames_; }
+  uint64_t grow_count() const { return grow_count_; }
+  uint64_t shrink_count() const { return shrink_count_; }
+
+private:
+  const Config config_;
+  uint32_t sample_rate_hz_{0};
+  uint32_t min_frames_{0};
+  uint32_t max_frames_{0};
+  uint32_t target_frames_{0};
+  Sample last_{};
+  Clock::time_point quiet_since_{};
+  uint64_t grow_count_{0};
+  uint64_t shrink_count_{0};
+};
+
+}  // namespace tomplayer::engine
@@ -3,16 +3,45 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
-#include <objbase.h>
+#include <span>
 #include <utility>
-#include <vector>
 
 namespace tomplayer::engine {
+namespace {
+// Fit src_channels-wide frames into dst's dst_channels: mono is copied to every channel,
+// extra source channels are dropped and missing ones are silent. No downmix matrix yet.
+void MapChannels(const float* src, uint32_t src_channels, std::span<float> dst,
+                 uint32_t dst_channels) {
+  const size_t frames = dst.size() / dst_channels;
+  for (size_t frame = 0; frame < frames; ++frame) {
+    const float* const in = src + frame * src_channels;
+    float* const out = dst.data() + frame * dst_channels;
+    for (uint32_t channel = 0; channel < dst_channels; ++channel) {
+      out[channel] = src_channels == 1          ? in[0]
+                     : channel < src_channels ? in[channel]
+                                              : 0.0f;
+    }
+  }
+}
+}  // namespace
+
+PlayerEngine::PlayerEngine() : PlayerEngine(Config{}) {}
+
+PlayerEngine::PlayerEngine(const Config& config)
+    : PlayerEngine(config, tomplayer::audio::CreateDefaultAudioOutput()) {}
 
-PlayerEngine::PlayerEngine() {
-  ring_buffer_ = std::make_unique<AudioRingBuffer>(kDefaultSampleRateHz * 2,
-                                                   kDefaultChannels);
-  output_ = std::make_unique<tomplayer::wasapi::WasapiOutput>();
+PlayerEngine::PlayerEngine(const Config& config,
+                           std::unique_ptr<tomplayer::audio::AudioOutput> output)
+    : config_(config),
+      output_(std::move(output)),
+      latency_controller_(config.adaptive_latency) {
+  // Sized for the default format; EnsureOutputInitialized resizes to the device format.
+  ResizeRingBuffer(kDefaultSampleRateHz, kDefaultChannels);
+  if (config_.lock_process_memory) {
+    process_memory_locked_ = tomplayer::platform::LockProcessMemory();
+  }
+  engine_thread_policy_.set(config_.engine_thread);
+  decode_thread_policy_.set(config_.decode_thread);
   // Start background threads immediately; they exit cleanly on Quit.
   engine_thread_ = std::thread(&PlayerEngine::EngineLoop, this);
   decode_thread_ = std::thread(&PlayerEngine::DecodeLoop, this);
@@ -28,6 +57,10 @@ PlayerEngine::~PlayerEngine() {
   }
 }
 
+void PlayerEngine::open(const std::string& path) {
+  Enqueue(OpenCommand{path});
+}
+
 void PlayerEngine::play() {
   Enqueue(PlayCommand{});
 }
@@ -74,7 +107,13 @@ PlayerEngine::Status PlayerEngine::get_status() const {
   if (output_) {
     snapshot.underrun_wake_count = output_->underrun_wake_count();
     snapshot.underrun_frames_total = output_->underrun_frame_count();
+    snapshot.render_timing = output_->render_timing().report();
+    snapshot.render_thread = output_->render_thread_policy().report();
   }
+  snapshot.engine_thread = engine_thread_policy_.report();
+  snapshot.decode_thread = decode_thread_policy_.report();
+  snapshot.process_memory_locked = process_memory_locked_;
+  snapshot.output_latency_seconds = output_latency_seconds_.load(std::memory_order_acquire);
   snapshot.dropped_frames = dropped_frames_.load(std::memory_order_acquire);
   snapshot.decode_epoch = decode_control_.epoch.load(std::memory_order_acquire);
   snapshot.decode_mode = decode_control_.mode.load(std::memory_order_acquire);
@@ -85,19 +124,50 @@ PlayerEngine::Status PlayerEngine::get_status() const {
   snapshot.produced_frames_total =
       produced_frames_total_.load(std::memory_order_acquire);
   const uint32_t sample_rate = sample_rate_hz_.load(std::memory_order_acquire);
-  const int64_t offset_frames =
-      render_frame_offset_.load(std::memory_order_acquire);
-  uint64_t rendered_frames = 0;
-  if (output_) {
-    rendered_frames = output_->rendered_frames_total();
-  }
-  if (sample_rate > 0) {
-    snapshot.position_seconds =
-        static_cast<double>(rendered_frames + offset_frames) /
-        static_cast<double>(sample_rate);
-  } else {
-    snapshot.position_seconds = 0.0;
+  snapshot.sample_rate_hz = sample_rate;
+  snapshot.channels = channels_.load(std::memory_order_acquire);
+  // Exact position: the marker the render thread last consumed plus frames read past it,
+  // less what the device has queued but not yet played. The clock's seqlock pairs the ring
+  // read position with the queue depth published by the same render cycle.
+  // Before the first marker of the current epoch is reached, report the epoch's start.
+  const tomplayer::audio::PresentationClock* presentation =
+      output_ ? &output_->presentation_clock() : nullptr;
+  int64_t position_frames = 0;
+  uint64_t pending_frames = 0;
+  AudioRingBuffer* ring = AcquirePublishedRing();
+  for (;;) {
+    const uint32_t sequence = presentation ? presentation->read_begin() : 0;
+    position_frames = render_frame_offset_.load(std::memory_order_acquire);
+    pending_frames = 0;
+    FrameMarker marker;
+    uint64_t frames_since_marker = 0;
+    if (ring && ring->current_marker(&marker, &frames_since_marker) &&
+        marker.epoch == snapshot.decode_epoch) {
+      position_frames = marker.source_frame + static_cast<int64_t>(frames_since_marker);
+      if (presentation) {
+        pending_frames = presentation->pending_frames(
+            tomplayer::audio::PresentationClock::Clock::now());
+      }
+      // Audio queued ahead of a seek belongs to the previous epoch; never report a frame
+      // before the one this epoch started at.
+      position_frames =
+          std::max(marker.source_frame, position_frames - static_cast<int64_t>(pending_frames));
+    }
+    if (!presentation || !presentation->read_retry(sequence)) {
+      break;
+    }
   }
+  if (ring) {
+    snapshot.ring_memory = ring->memory_residency();
+  }
+  ReleasePublishedRing();
+  snapshot.position_seconds =
+      sample_rate > 0
+          ? static_cast<double>(position_frames) / static_cast<double>(sample_rate)
+          : 0.0;
+  snapshot.presentation_delay_seconds =
+      sample_rate > 0 ? static_cast<double>(pending_frames) / static_cast<double>(sample_rate)
+                      : 0.0;
   {
     std::lock_guard<std::mutex> lock(last_error_mutex_);
     snapshot.last_error = last_error_;
@@ -105,6 +175,38 @@ PlayerEngine::Status PlayerEngine::get_status() const {
   return snapshot;
 }
 
+PlayerEngine::TapCursor PlayerEngine::open_tap() const {
+  AudioRingBuffer* ring = AcquirePublishedRing();
+  const TapCursor tap = ring ? ring->open_tap() : TapCursor{};
+  ReleasePublishedRing();
+  return tap;
+}
+
+uint32_t PlayerEngine::read_tap(TapCursor* tap,
+                                float* dst_interleaved,
+                                uint32_t frames_requested) const {
+  if (!tap) {
+    return 0;
+  }
+  // A tap opened on a ring that has since been replaced resumes at the new ring's read
+  // position (read_tap clamps positions ahead of it).
+  AudioRingBuffer* ring = AcquirePublishedRing();
+  const uint32_t frames = ring ? ring->read_tap(tap, dst_interleaved, frames_requested) : 0;
+  ReleasePublishedRing();
+  return frames;
+}
+
+AudioRingBuffer* PlayerEngine::AcquirePublishedRing() const {
+  // Announce the reader before loading the pointer; ReclaimRetiredRings frees a replaced
+  // ring only when no reader is announced after the swap (both sides seq_cst).
+  ring_readers_.fetch_add(1, std::memory_order_seq_cst);
+  return published_ring_.load(std::memory_order_seq_cst);
+}
+
+void PlayerEngine::ReleasePublishedRing() const {
+  ring_readers_.fetch_sub(1, std::memory_order_release);
+}
+
 void PlayerEngine::Enqueue(Command command) {
   {
     std::lock_guard<std::mutex> lock(queue_mutex_);
@@ -115,9 +217,9 @@ void PlayerEngine::Enqueue(Command command) {
 }
 
 void PlayerEngine::EngineLoop() {
-  // The engine thread is the sole owner of state transitions.
-  const HRESULT com_hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-  const bool com_should_uninit = SUCCEEDED(com_hr);
+  engine_thread_policy_.apply();
+  // The engine thread is the sole owner of state transitions, and of output_ (which may
+  // bind per-thread OS state such as COM in init_default_device/shutdown).
   while (true) {
     Command command;
     bool has_command = false;
@@ -160,20 +262,27 @@ void PlayerEngine::EngineLoop() {
     buffered_seconds_.store(buffered_seconds, std::memory_order_release);
 
     AdvancePriming();
+    FinishIfDrained();
+    UpdateAdaptiveLatency();
+    ReclaimRetiredRings();
 
   }
-
-  if (com_should_uninit) {
-    CoUninitialize();
-  }
 }
 
 void PlayerEngine::HandleCommand(const Command& command) {
   // Placeholder transitions for v1 skeleton. Actual logic is engine-owned only.
+  if (const auto* open = std::get_if<OpenCommand>(&command)) {
+    OpenSource(open->path);
+    return;
+  }
   if (std::holds_alternative<PlayCommand>(command)) {
+    if (state_.load(std::memory_order_acquire) == PlayerState::Finished) {
+      // The source is spent; play it again from the start.
+      HandleCommand(ReplayCommand{});
+      return;
+    }
     state_.store(PlayerState::Starting, std::memory_order_release);
-    const uint32_t threshold_frames =
-        static_cast<uint32_t>(sample_rate_hz_.load(std::memory_order_acquire) / 5);
+    const uint32_t threshold_frames = PrimingFrames();
     if (!BeginPriming(threshold_frames, false)) {
       return;
     }
@@ -199,8 +308,8 @@ void PlayerEngine::HandleCommand(const Command& command) {
     state_.store(PlayerState::Stopped, std::memory_order_release);
     render_frame_offset_.store(0, std::memory_order_release);
     StopDecodeAndWaitIdle();
-    ResetBufferingState();
     BeginNewDecodeEpochAndSetTarget(std::nullopt);
+    FlushBufferedAudio();
     return;
   }
   if (std::holds_alternative<SeekCommand>(command)) {
@@ -212,20 +321,21 @@ void PlayerEngine::HandleCommand(const Command& command) {
         static_cast<int64_t>(std::llround(clamped *
                                           static_cast<double>(
                                               sample_rate_hz_.load(std::memory_order_acquire))));
-    const DecodeMode desired_mode =
-        prior_state == PlayerState::Paused ? DecodeMode::Paused : DecodeMode::Running;
-    StopOutputAndResetRenderedFrames();
+    // The device keeps running and the decoder is never parked: the new epoch's boundary
+    // lets the render thread drop stale audio in O(1) on its next cycle.
     render_frame_offset_.store(frames, std::memory_order_release);
-    PauseDecodeAndWaitIdle();
-    ResetBufferingState();
     BeginNewDecodeEpochAndSetTarget(frames);
-    priming_active_ = false;
-    if (desired_mode == DecodeMode::Paused) {
+    FlushBufferedAudio();
+    if (prior_state == PlayerState::Paused) {
       CommitPaused();
+    } else if (output_ && output_->is_running()) {
+      priming_active_ = false;
+      set_decode_mode(DecodeMode::Running);
+      state_.store(PlayerState::Playing, std::memory_order_release);
     } else {
+      priming_active_ = false;
       state_.store(PlayerState::Starting, std::memory_order_release);
-      const uint32_t threshold_frames =
-          static_cast<uint32_t>(sample_rate_hz_.load(std::memory_order_acquire) / 5);
+      const uint32_t threshold_frames = PrimingFrames();
       if (!BeginPriming(threshold_frames, false)) {
         return;
       }
@@ -236,11 +346,10 @@ void PlayerEngine::HandleCommand(const Command& command) {
     StopOutputAndResetRenderedFrames();
     state_.store(PlayerState::Starting, std::memory_order_release);
     render_frame_offset_.store(0, std::memory_order_release);
-    ResetBufferingState();
     BeginNewDecodeEpochAndSetTarget(0);
+    FlushBufferedAudio();
     priming_active_ = false;
-    const uint32_t threshold_frames =
-        static_cast<uint32_t>(sample_rate_hz_.load(std::memory_order_acquire) / 5);
+    const uint32_t threshold_frames = PrimingFrames();
     if (!BeginPriming(threshold_frames, false)) {
       return;
     }
@@ -248,12 +357,67 @@ void PlayerEngine::HandleCommand(const Command& command) {
   }
 }
 
+void PlayerEngine::OpenSource(const std::string& path) {
+  priming_active_ = false;
+  StopOutputAndResetRenderedFrames();
+  StopDecodeAndWaitIdle();
+  // Nothing plays the previous source past this point, even if the new one fails.
+  decoder_.reset();
+  duration_seconds_.store(0.0, std::memory_order_release);
+  render_frame_offset_.store(0, std::memory_order_release);
+  BeginNewDecodeEpochAndSetTarget(0);
+  FlushBufferedAudio();
+
+  std::string error;
+  std::unique_ptr<tomplayer::decode::Decoder> decoder =
+      tomplayer::decode::OpenDecoder(path, &error);
+  if (!decoder) {
+    SetLastError(error.c_str());
+    state_.store(PlayerState::Error, std::memory_order_release);
+    return;
+  }
+  // The ring runs at the device format, so the output has to be up to check the rate.
+  if (!EnsureOutputInitialized()) {
+    state_.store(PlayerState::Error, std::memory_order_release);
+    return;
+  }
+  const tomplayer::decode::StreamInfo& info = decoder->info();
+  const uint32_t device_rate = sample_rate_hz_.load(std::memory_order_acquire);
+  if (info.sample_rate != device_rate) {
+    error = path + ": " + std::to_string(info.sample_rate) + " Hz source on a " +
+            std::to_string(device_rate) + " Hz output (no resampler yet)";
+    SetLastError(error.c_str());
+    state_.store(PlayerState::Error, std::memory_order_release);
+    return;
+  }
+  // Same residency as the ring, so the decode thread never faults on either buffer; one
+  // chunk is far below a huge page, so HugePages stops at Lock here.
+  decode_scratch_.release();
+  if (!decode_scratch_.allocate(
+          static_cast<size_t>(kDecodeChunkFrames) * info.channels * sizeof(float),
+          std::min(config_.memory_policy, tomplayer::platform::MemoryPolicy::Lock))) {
+    SetLastError("out of memory for the decode buffer");
+    state_.store(PlayerState::Error, std::memory_order_release);
+    return;
+  }
+  decoder_ = std::move(decoder);
+  if (info.total_frames >= 0) {
+    duration_seconds_.store(
+        static_cast<double>(info.total_frames) / static_cast<double>(info.sample_rate),
+        std::memory_order_release);
+  }
+  SetLastError("");
+  state_.store(PlayerState::Stopped, std::memory_order_release);
+}
+
 void PlayerEngine::bump_epoch() {
   decode_control_.epoch.fetch_add(1, std::memory_order_acq_rel);
 }
 
 void PlayerEngine::set_decode_mode(DecodeMode mode) {
-  decode_control_.mode.store(mode, std::memory_order_release);
+  // seq_cst pairs with the decode thread's busy flag (see DecodeLoop): after switching to
+  // Stopped/Paused, WaitForDecodeIdle cannot miss a decoder that is about to start work.
+  decode_control_.mode.store(mode, std::memory_order_seq_cst);
 }
 
 void PlayerEngine::set_target_frame(int64_t frame) {
@@ -269,27 +433,30 @@ void PlayerEngine::StopOutputAndResetRenderedFrames() {
   output_->reset_rendered_frames();
 }
 
-void PlayerEngine::PauseDecodeAndWaitIdle() {
-  set_decode_mode(DecodeMode::Paused);
-  WaitForDecodeIdle();
-}
-
 void PlayerEngine::StopDecodeAndWaitIdle() {
   set_decode_mode(DecodeMode::Stopped);
   WaitForDecodeIdle();
 }
 
-void PlayerEngine::ResetBufferingState() {
-  DrainRingBuffer();
+void PlayerEngine::FlushBufferedAudio() {
+  // O(1) and safe with the decoder and render thread live: the consumer jumps read_pos to
+  // the boundary the decoder publishes when it starts the current epoch.
+  // Preconditions: the epoch has already been bumped for the new stream position.
   if (ring_buffer_) {
-    ring_buffer_->reset();
+    ring_buffer_->request_flush(decode_control_.epoch.load(std::memory_order_acquire));
+    if (!output_ || !output_->is_running()) {
+      // No render thread: the engine thread is the consumer until the output starts.
+      ring_buffer_->apply_pending_flush();
+    }
   }
   buffered_seconds_.store(0.0, std::memory_order_release);
 }
 
 void PlayerEngine::BeginNewDecodeEpochAndSetTarget(std::optional<int64_t> target_frame) {
-  bump_epoch();
+  // Target first: the decoder keeps running through seeks and reads the target after it
+  // sees the epoch change (acquire), so the epoch's release must already cover it.
   set_target_frame(target_frame.value_or(-1));
+  bump_epoch();
 }
 
 void PlayerEngine::CommitPaused() {
@@ -302,12 +469,16 @@ void PlayerEngine::CommitPaused() {
 }
 
 void PlayerEngine::DecodeLoop() {
-  constexpr int64_t chunk_frames = 1024;
+  decode_thread_policy_.apply();
   uint64_t local_epoch = decode_control_.epoch.load(std::memory_order_acquire);
   int64_t local_cursor_frame = 0;
+  // Publish a flush boundary and tag the first frame written in each epoch, so seeks can
+  // discard stale audio in O(1) and position tracking follows them exactly.
+  bool epoch_start_pending = true;
+  bool marker_pending = false;
+  // The decoder is only touched while Running, so an epoch's seek waits until then.
+  bool seek_pending = true;
   decoded_frame_cursor_.store(local_cursor_frame, std::memory_order_release);
-  uint32_t local_channels = channels_.load(std::memory_order_acquire);
-  std::vector<float> silence(static_cast<size_t>(chunk_frames) * local_channels, 0.0f);
 
   while (true) {
     const DecodeMode mode = decode_control_.mode.load(std::memory_order_acquire);
@@ -323,6 +494,8 @@ void PlayerEngine::DecodeLoop() {
       const int64_t target =
           decode_control_.target_frame.load(std::memory_order_acquire);
       local_cursor_frame = target >= 0 ? target : 0;
+      epoch_start_pending = true;
+      seek_pending = true;
       decoded_frame_cursor_.store(local_cursor_frame, std::memory_order_release);
     }
 
@@ -334,6 +507,11 @@ void PlayerEngine::DecodeLoop() {
 
     if (mode == DecodeMode::Running) {
       SetDecodeIdle(false);
+      // The engine swaps ring_buffer_ and decoder_ after parking us; re-check now that we
+      // are marked busy, so a park that raced the load above is seen before touching them.
+      if (decode_control_.mode.load(std::memory_order_seq_cst) != DecodeMode::Running) {
+        continue;
+      }
       if (!ring_buffer_) {
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
         continue;
@@ -343,43 +521,116 @@ void PlayerEngine::DecodeLoop() {
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
         continue;
       }
-      const uint32_t current_channels = channels_.load(std::memory_order_acquire);
-      if (current_channels != local_channels) {
-        local_channels = current_channels;
-        silence.assign(static_cast<size_t>(chunk_frames) * local_channels, 0.0f);
+      if (end_of_stream_epoch_.load(std::memory_order_acquire) == local_epoch) {
+        // Nothing left until a seek or replay starts a new epoch.
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        continue;
+      }
+      if (seek_pending && decoder_) {
+        if (!decoder_->seek(local_cursor_frame)) {
+          SetLastError(decoder_->error().empty() ? "Seek failed."
+                                                 : decoder_->error().c_str());
+        }
       }
-      const uint32_t written = ring_buffer_->write_frames(
-          silence.data(),
-          static_cast<uint32_t>(chunk_frames));
-      if (written < static_cast<uint32_t>(chunk_frames)) {
-        dropped_frames_.fetch_add(static_cast<uint64_t>(chunk_frames - written),
+      seek_pending = false;
+      // Block until a whole chunk fits instead of pacing against wall-clock sleeps; the
+      // bounded timeout keeps mode and epoch changes responsive.
+      const uint32_t chunk = std::min(kDecodeChunkFrames, ring_buffer_->capacity_frames());
+      if (!ring_buffer_->wait_writable(chunk, kDecodeWaitTimeout)) {
+        continue;
+      }
+      if (epoch_start_pending) {
+        // Exactly once per epoch: a later boundary would discard this epoch's own frames.
+        ring_buffer_->publish_epoch_boundary(local_epoch);
+        epoch_start_pending = false;
+        marker_pending = true;
+      }
+      if (marker_pending) {
+        // A full marker queue only delays the tag; retry before the next chunk.
+        marker_pending =
+            !ring_buffer_->push_marker(local_epoch, kDefaultTrackId, local_cursor_frame);
+      }
+      // Produce straight into ring storage; no staging buffer between decode and ring.
+      const AudioRingBuffer::WriteRegion region = ring_buffer_->acquire_write(chunk);
+      if (region.frames < chunk) {
+        dropped_frames_.fetch_add(static_cast<uint64_t>(chunk - region.frames),
                                   std::memory_order_acq_rel);
       }
+      uint32_t written = region.frames;
+      if (decoder_) {
+        written = DecodeIntoRegion(region);
+        if (written < region.frames) {
+          if (!decoder_->error().empty()) {
+            SetLastError(decoder_->error().c_str());
+          }
+          end_of_stream_epoch_.store(local_epoch, std::memory_order_release);
+        }
+      } else {
+        std::fill(region.first.begin(), region.first.end(), 0.0f);
+        std::fill(region.second.begin(), region.second.end(), 0.0f);
+      }
+      ring_buffer_->commit_write(written);
       if (written == 0) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
         continue;
       }
 
-      {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
-      }
-      buffer_cv_.notify_all();
-
       local_cursor_frame += written;
       decoded_frame_cursor_.store(local_cursor_frame, std::memory_order_release);
       produced_frames_total_.fetch_add(static_cast<uint64_t>(written),
                                        std::memory_order_acq_rel);
+    }
+  }
+}
 
-      const auto written_duration =
-          std::chrono::duration<double>(static_cast<double>(written) /
-                                        static_cast<double>(current_rate));
-      std::this_thread::sleep_for(written_duration);
+uint32_t PlayerEngine::DecodeIntoRegion(const AudioRingBuffer::WriteRegion& region) {
+  // Decode thread only. Matching layouts decode straight into ring storage; otherwise one
+  // chunk goes through decode_scratch_ and is remapped into the ring.
+  const uint32_t ring_channels = ring_buffer_->channels();
+  const uint32_t source_channels = decoder_->info().channels;
+  uint32_t total = 0;
+  for (const std::span<float> span : {region.first, region.second}) {
+    const uint32_t frames = static_cast<uint32_t>(span.size() / ring_channels);
+    if (frames == 0) {
+      continue;
     }
+    uint32_t decoded = 0;
+    if (source_channels == ring_channels) {
+      decoded = decoder_->read(span.data(), frames);
+    } else {
+      float* scratch = static_cast<float*>(decode_scratch_.data());
+      decoded = decoder_->read(scratch, std::min(frames, kDecodeChunkFrames));
+      MapChannels(scratch, source_channels,
+                  span.first(static_cast<size_t>(decoded) * ring_channels), ring_channels);
+    }
+    total += decoded;
+    if (decoded < frames) {
+      break;
+    }
+  }
+  return total;
+}
+
+bool PlayerEngine::SourceExhausted() const {
+  return decoder_ && end_of_stream_epoch_.load(std::memory_order_acquire) ==
+                         decode_control_.epoch.load(std::memory_order_acquire);
+}
+
+void PlayerEngine::FinishIfDrained() {
+  // Finished once the last decoded frame has been heard: the ring is empty and the device
+  // holds no more of it (queued silence does not count).
+  if (state_.load(std::memory_order_acquire) != PlayerState::Playing || !SourceExhausted() ||
+      !ring_buffer_ || ring_buffer_->available_to_read_frames() > 0 || !output_ ||
+      output_->presentation_clock().pending_frames(
+          tomplayer::audio::PresentationClock::Clock::now()) > 0) {
+    return;
   }
+  output_->stop();
+  set_decode_mode(DecodeMode::Paused);
+  state_.store(PlayerState::Finished, std::memory_order_release);
 }
 
 void PlayerEngine::WaitForDecodeIdle() {
-  if (decode_idle_.load(std::memory_order_acquire)) {
+  if (decode_idle_.load(std::memory_order_seq_cst)) {
     return;
   }
   std::unique_lock<std::mutex> lock(decode_idle_mutex_);
@@ -388,26 +639,8 @@ void PlayerEngine::WaitForDecodeIdle() {
   });
 }
 
-void PlayerEngine::DrainRingBuffer() {
-  constexpr uint32_t kDrainChunkFrames = 1024;
-  if (!ring_buffer_) {
-    return;
-  }
-  const uint32_t channels = channels_.load(std::memory_order_acquire);
-  std::vector<float> scratch(static_cast<size_t>(kDrainChunkFrames) * channels, 0.0f);
-  while (true) {
-    const uint32_t available = ring_buffer_->available_to_read_frames();
-    if (available == 0) {
-      break;
-    }
-    const uint32_t to_read =
-        available < kDrainChunkFrames ? available : kDrainChunkFrames;
-    ring_buffer_->read_frames(scratch.data(), to_read);
-  }
-}
-
 void PlayerEngine::SetDecodeIdle(bool idle) {
-  const bool was_idle = decode_idle_.exchange(idle, std::memory_order_release);
+  const bool was_idle = decode_idle_.exchange(idle, std::memory_order_seq_cst);
   if (idle && !was_idle) {
     decode_idle_cv_.notify_all();
   }
@@ -423,39 +656,50 @@ bool PlayerEngine::EnsureOutputInitialized() {
     return true;
   }
   if (!output_) {
-    output_ = std::make_unique<tomplayer::wasapi::WasapiOutput>();
+    SetLastError("No audio output backend is available on this platform.");
+    return false;
   }
   if (!output_->init_default_device()) {
-    SetLastError("Failed to initialize WASAPI output.");
+    SetLastError("Failed to initialize audio output.");
     return false;
   }
 
   const uint32_t device_rate = output_->sample_rate();
   const uint32_t device_channels = output_->channels();
 
-  // Stereo only for right now.
-  if (device_channels != 2) {
-    SetLastError("Only stereo WASAPI output is supported.");
-    return false;
-  }
-
   if (device_rate == 0 || device_channels == 0) {
-    SetLastError("Invalid WASAPI mix format.");
+    SetLastError("Invalid audio output format.");
     return false;
   }
 
   sample_rate_hz_.store(device_rate, std::memory_order_release);
   channels_.store(device_channels, std::memory_order_release);
 
+  std::chrono::microseconds render_deadline = config_.render_deadline;
+  if (render_deadline.count() == 0) {
+    render_deadline = std::chrono::microseconds(
+        static_cast<int64_t>(output_->buffer_frames()) * 1'000'000 / device_rate / 2);
+  }
+  output_->render_timing().set_deadline(render_deadline);
+  output_->render_thread_policy().set(config_.render_thread);
+  output_latency_seconds_.store(
+      static_cast<double>(output_->buffer_frames()) / static_cast<double>(device_rate),
+      std::memory_order_release);
+
   set_decode_mode(DecodeMode::Paused);
   WaitForDecodeIdle();
-  DrainRingBuffer();
-  ring_buffer_->reset();
-  //ring_buffer_ = std::make_unique<AudioRingBuffer>(device_rate * 2, device_channels);
-  output_->set_ring_buffer(ring_buffer_.get());
+  ResizeRingBuffer(device_rate, device_channels);
   buffered_seconds_.store(0.0, std::memory_order_release);
-  render_frame_offset_.store(0, std::memory_order_release);
+  // Buffered audio (and its marker) was discarded; restart decode at the pending target so
+  // the new ring's first frame is tagged again.
+  const int64_t target = decode_control_.target_frame.load(std::memory_order_acquire);
+  render_frame_offset_.store(std::max<int64_t>(target, 0), std::memory_order_release);
+  bump_epoch();
   output_->reset_rendered_frames();
+  if (config_.adaptive_latency.enabled) {
+    latency_controller_.reset(device_rate, SampleLatencyInputs());
+    ApplyOutputLatency(latency_controller_.target_frames());
+  }
 
   output_initialized_ = true;
   return true;
@@ -481,17 +725,24 @@ void PlayerEngine::AdvancePriming(){
   if (!priming_active_ || !ring_buffer_ || !output_) {
     return ;
   }
+  // The output is not running yet, so stale frames from a pending flush are dropped here.
+  ring_buffer_->apply_pending_flush();
   const uint32_t available = ring_buffer_->available_to_read_frames();
-  if (!priming_allow_empty_ && available < priming_target_frames_) {
+  // A source shorter than the threshold starts with whatever it produced.
+  if (!priming_allow_empty_ && available < priming_target_frames_ && !SourceExhausted()) {
     return;
   }
 
   if (!output_->start()) {
     set_decode_mode(DecodeMode::Paused);
-    SetLastError("Failed to start WASAPI output.");
+    SetLastError("Failed to start audio output.");
     state_.store(PlayerState::Error);
   } else {
     state_.store(PlayerState::Playing);
+    if (config_.adaptive_latency.enabled) {
+      // The stopped gap is neither stress nor quiet time.
+      latency_controller_.rebase(SampleLatencyInputs());
+    }
   }
   priming_active_ = false;
 
@@ -499,5 +750,114 @@ void PlayerEngine::AdvancePriming(){
 }
 
 
+uint32_t PlayerEngine::PrimingFrames() const {
+  // 200 ms of decode-ahead before the device starts; with adaptive latency, a few device
+  // queues' worth is enough while the system is quiet.
+  const uint32_t fixed = sample_rate_hz_.load(std::memory_order_acquire) / 5;
+  const uint32_t target = latency_controller_.target_frames();
+  if (!config_.adaptive_latency.enabled || target == 0) {
+    return fixed;
+  }
+  return static_cast<uint32_t>(std::min<uint64_t>(fixed, uint64_t{target} * 4));
+}
+
+LatencyController::Sample PlayerEngine::SampleLatencyInputs() const {
+  LatencyController::Sample sample;
+  sample.at = LatencyController::Clock::now();
+  sample.decoded_frames = produced_frames_total_.load(std::memory_order_acquire);
+  if (output_) {
+    const tomplayer::audio::RenderTimingReport timing = output_->render_timing().report();
+    sample.underrun_wakes = output_->underrun_wake_count();
+    sample.deadline_overruns = timing.deadline_overruns;
+    sample.late_wakes = timing.late_wakes;
+  }
+  if (ring_buffer_) {
+    sample.buffered_frames = ring_buffer_->available_to_read_frames();
+    sample.capacity_frames = ring_buffer_->capacity_frames();
+  }
+  return sample;
+}
+
+void PlayerEngine::UpdateAdaptiveLatency() {
+  if (!config_.adaptive_latency.enabled || !output_ || !output_->is_running() ||
+      state_.load(std::memory_order_acquire) != PlayerState::Playing) {
+    return;
+  }
+  if (latency_controller_.update(SampleLatencyInputs())) {
+    ApplyOutputLatency(latency_controller_.target_frames());
+  }
+}
+
+void PlayerEngine::ApplyOutputLatency(uint32_t fill_frames) {
+  const uint32_t device_rate = output_->sample_rate();
+  const uint32_t fill = output_->set_fill_frames(fill_frames);
+  if (device_rate == 0 || fill == 0) {
+    return;
+  }
+  // A wake later than the queue lasts may have let the device run dry; a callback longer
+  // than half of it leaves no margin for the next wake.
+  const auto queue_time =
+      std::chrono::microseconds(static_cast<int64_t>(fill) * 1'000'000 / device_rate);
+  output_->render_timing().set_wake_limit(queue_time);
+  if (config_.render_deadline.count() == 0) {
+    output_->render_timing().set_deadline(queue_time / 2);
+  }
+  output_latency_seconds_.store(static_cast<double>(fill) / static_cast<double>(device_rate),
+                                std::memory_order_release);
+}
+
+void PlayerEngine::ResizeRingBuffer(uint32_t sample_rate_hz, uint32_t channels) {
+  // Engine thread only, with the decoder idle: the producer side is never shared.
+  const uint32_t capacity = std::max<uint32_t>(
+      AudioRingBuffer::frames_for_latency(sample_rate_hz, config_.ring_latency), 1);
+  // Capacity is rounded up (power of two, then whole pages), so reuse anything close enough.
+  if (ring_buffer_ && ring_buffer_->channels() == channels &&
+      ring_buffer_->capacity_frames() >= capacity &&
+      ring_buffer_->capacity_frames() / 2 < capacity) {
+    ring_buffer_->reset();
+    if (output_) {
+      output_->set_ring_buffer(ring_buffer_.get());
+    }
+    return;
+  }
+
+  // Allocate and map off the render thread, then publish with a single pointer swap.
+  // Mirrored storage (where available) keeps every render-side read a single span, and a
+  // power-of-two capacity turns the render thread's per-acquire/commit index into a mask
+  // instead of a 64-bit modulo, for up to 2x the requested frames (about 1.36x at the
+  // default 2 s, 48 kHz: 131072 frames instead of 96000).
+  auto fresh = std::make_unique<AudioRingBuffer>(capacity,
+                                                 channels,
+                                                 AudioRingBuffer::CapacityMode::PowerOfTwo,
+                                                 AudioRingBuffer::StorageBackend::Mirrored,
+                                                 config_.memory_policy);
+  published_ring_.store(fresh.get(), std::memory_order_seq_cst);
+  uint64_t render_grace_token = 0;
+  if (output_) {
+    output_->exchange_ring_buffer(fresh.get());
+    render_grace_token = output_->render_grace_token();
+  }
+  if (ring_buffer_) {
+    retired_rings_.push_back(RetiredRing{std::move(ring_buffer_), render_grace_token});
+  }
+  ring_buffer_ = std::move(fresh);
+  ReclaimRetiredRings();
+}
+
+void PlayerEngine::ReclaimRetiredRings() {
+  if (retired_rings_.empty()) {
+    return;
+  }
+  // Taps that announced themselves before the swap may still hold a retired pointer; newer
+  // readers only see published_ring_. Wait for a moment with no reads in flight.
+  if (ring_readers_.load(std::memory_order_seq_cst) != 0) {
+    return;
+  }
+  const auto elapsed = [this](const RetiredRing& retired) {
+    return !output_ || output_->render_grace_period_elapsed(retired.render_grace_token);
+  };
+  retired_rings_.erase(std::remove_if(retired_rings_.begin(), retired_rings_.end(), elapsed),
+                       retired_rings_.end());
+}
 
 }  // namespace tomplayer::engine
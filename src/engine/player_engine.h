@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <cstdint>
@@ -11,9 +12,14 @@
 #include <string>
 #include <thread>
 #include <variant>
+#include <vector>
 
-#include "audio/wasapi_output.h"
+#include "audio/audio_output.h"
 #include "buffer/audio_ring_buffer.h"
+#include "decode/decoder.h"
+#include "engine/latency_controller.h"
+#include "platform/resident_memory.h"
+#include "platform/thread_priority.h"
 
 namespace tomplayer::engine {
 
@@ -51,7 +57,11 @@ public:
   // Errors: None.
   struct Status {
     PlayerState state = PlayerState::Idle;
+    // Frame audible now: device queue and pipeline latency are subtracted, interpolated
+    // between render cycles.
     double position_seconds = 0.0;
+    // Audio handed to the device that has not been heard yet.
+    double presentation_delay_seconds = 0.0;
     double duration_seconds = 0.0;
     double buffered_seconds = 0.0;
     uint64_t underrun_wake_count = 0;
@@ -62,15 +72,84 @@ public:
     int64_t seek_target_frame = -1;
     int64_t decoded_frame_cursor = 0;
     uint64_t produced_frames_total = 0;
+    // Interleaved layout of frames returned by read_tap.
+    uint32_t sample_rate_hz = 0;
+    uint32_t channels = 0;
+    tomplayer::platform::MemoryResidency ring_memory;
+    // Render thread wake jitter, callback time and Config::render_deadline overruns, to
+    // line underruns up with scheduling hiccups.
+    tomplayer::audio::RenderTimingReport render_timing;
+    // Scheduling each thread actually got (see Config::*_thread); render_thread reflects
+    // the latest output start.
+    tomplayer::platform::ThreadPolicyReport engine_thread;
+    tomplayer::platform::ThreadPolicyReport decode_thread;
+    tomplayer::platform::ThreadPolicyReport render_thread;
+    bool process_memory_locked = false;
+    // Audio the output keeps queued in the device: the whole buffer, or the adaptive
+    // target (Config::adaptive_latency) clamped to what the backend allows.
+    double output_latency_seconds = 0.0;
     std::string last_error;
   };
 
+  // Summary: Observer position for read_tap (meters, spectrum, recorders).
+  // Preconditions: None.
+  // Postconditions: Owned by a single observer thread.
+  // Errors: None.
+  using TapCursor = AudioRingBuffer::TapCursor;
+
+  // Summary: Construction-time tuning.
+  // Preconditions: None.
+  // Postconditions: Copied by the engine; later changes have no effect.
+  // Errors: None.
+  struct Config {
+    // Decode-ahead held in the ring; the ring is resized to at least this at the device
+    // rate, rounded up to a power of two frames so render-side indexing is a mask.
+    std::chrono::milliseconds ring_latency{2000};
+    // Page residency of ring storage and the decode buffer; falls back (huge pages -> lock
+    // -> prefault) when the OS refuses. What the ring got is reported in Status::ring_memory.
+    tomplayer::platform::MemoryPolicy memory_policy = tomplayer::platform::MemoryPolicy::Lock;
+    // Render callbacks longer than this count as deadline overruns in Status::render_timing.
+    // 0 uses half the device buffer: past that, the next wake risks finding it empty.
+    std::chrono::microseconds render_deadline{0};
+    // Per-thread scheduling. The render thread must never miss a device period; the decoder
+    // only has to keep the ring ahead; the engine thread just handles commands.
+    tomplayer::platform::ThreadPolicy engine_thread{};
+    tomplayer::platform::ThreadPolicy decode_thread{tomplayer::platform::ThreadClass::Elevated};
+    tomplayer::platform::ThreadPolicy render_thread{tomplayer::platform::ThreadClass::RealTime};
+    // mlockall at construction, so neither code, stacks nor heap can fault on the render
+    // path. Off by default: later allocations fail once RLIMIT_MEMLOCK is exhausted.
+    bool lock_process_memory = false;
+    // Adaptive device latency: while playing, the device queue shrinks toward min_latency
+    // when no underruns, late wakes, deadline overruns or decode stalls are seen, and
+    // doubles (up to max_latency) when they are. Play/seek priming follows the target.
+    // The ring's decode-ahead (ring_latency) is not output latency and stays fixed.
+    LatencyController::Config adaptive_latency{};
+  };
+
   PlayerEngine();
+  explicit PlayerEngine(const Config& config);
+
+  // Summary: Construct an engine that plays through the given backend.
+  // Preconditions: output is uninitialized; it is owned (and shut down) by the engine.
+  // Postconditions: same as PlayerEngine(config), with output in place of the platform default.
+  // Errors: with a null output, playback fails and Status::last_error says no backend is
+  //   available.
+  PlayerEngine(const Config& config, std::unique_ptr<tomplayer::audio::AudioOutput> output);
   ~PlayerEngine();
 
   PlayerEngine(const PlayerEngine&) = delete;
   PlayerEngine& operator=(const PlayerEngine&) = delete;
 
+  // Summary: Enqueue an Open command: stop playback and load path as the source.
+  // Preconditions: None.
+  // Postconditions: Command is queued for the engine thread. Once handled, the state is
+  //   Stopped at frame 0 with Status::duration_seconds set, or Error with
+  //   Status::last_error saying why (unreadable or unsupported file, or a sample rate the
+  //   output does not run at: there is no resampler yet). Without an opened source the
+  //   engine plays silence.
+  // Errors: None.
+  void open(const std::string& path);
+
   // Summary: Enqueue a Play command.
   // Preconditions: None.
   // Postconditions: Command is queued for the engine thread.
@@ -125,10 +204,33 @@ public:
   // Errors: None.
   Status get_status() const;
 
+  // Summary: Open a tap over the PCM the render thread consumes from now on.
+  // Preconditions: None (any thread).
+  // Postconditions: Does not affect playback.
+  // Errors: None.
+  TapCursor open_tap() const;
+
+  // Summary: Copy up to frames_requested rendered frames (Status::channels interleaved floats
+  //   per frame) into dst_interleaved.
+  // Preconditions: dst_interleaved has room for frames_requested * Status::channels floats.
+  // Postconditions: Advances tap; frames the tap was too slow to see are added to
+  //   tap->dropped_frames. Never blocks the render or decode threads.
+  // Errors: Returns frames copied; 0 when caught up.
+  uint32_t read_tap(TapCursor* tap, float* dst_interleaved, uint32_t frames_requested) const;
+
 private:
   static constexpr uint32_t kDefaultSampleRateHz = 48000;
   static constexpr uint32_t kDefaultChannels = 2;
+  // Single-source engine for now; markers carry it so multi-track playback can distinguish.
+  static constexpr uint64_t kDefaultTrackId = 0;
+  // Frames the decode thread produces per ring write.
+  static constexpr uint32_t kDecodeChunkFrames = 1024;
+  // Upper bound on one decode-thread block in wait_writable before re-checking mode/epoch.
+  static constexpr std::chrono::milliseconds kDecodeWaitTimeout{20};
 
+  struct OpenCommand {
+    std::string path;
+  };
   struct PlayCommand {};
   struct PauseCommand {};
   struct ResumeCommand {};
@@ -139,7 +241,8 @@ private:
   struct ReplayCommand {};
   struct QuitCommand {};
 
-  using Command = std::variant<PlayCommand,
+  using Command = std::variant<OpenCommand,
+                               PlayCommand,
                                PauseCommand,
                                ResumeCommand,
                                StopCommand,
@@ -150,23 +253,33 @@ private:
   void Enqueue(Command command);
   void EngineLoop();
   void HandleCommand(const Command& command);
+  void OpenSource(const std::string& path);
   void bump_epoch();
   void set_decode_mode(DecodeMode mode);
   void set_target_frame(int64_t frame);
   void DecodeLoop();
+  uint32_t DecodeIntoRegion(const AudioRingBuffer::WriteRegion& region);
+  bool SourceExhausted() const;
+  void FinishIfDrained();
   void WaitForDecodeIdle();
-  void DrainRingBuffer();
   void SetDecodeIdle(bool idle);
   void SetLastError(const char* message);
   bool EnsureOutputInitialized();
   void StopOutputAndResetRenderedFrames();
-  void PauseDecodeAndWaitIdle();
   void StopDecodeAndWaitIdle();
-  void ResetBufferingState();
+  void FlushBufferedAudio();
   void BeginNewDecodeEpochAndSetTarget(std::optional<int64_t> target_frame);
   void CommitPaused();
   bool BeginPriming(uint32_t target, bool allow_empty);
   void AdvancePriming();
+  uint32_t PrimingFrames() const;
+  LatencyController::Sample SampleLatencyInputs() const;
+  void UpdateAdaptiveLatency();
+  void ApplyOutputLatency(uint32_t fill_frames);
+  void ResizeRingBuffer(uint32_t sample_rate_hz, uint32_t channels);
+  void ReclaimRetiredRings();
+  AudioRingBuffer* AcquirePublishedRing() const;
+  void ReleasePublishedRing() const;
 
   // Decode control is owned by the engine thread; atomics provide snapshots to readers.
   // Epoch is a generation counter: any change that invalidates in-flight decode work
@@ -186,6 +299,7 @@ private:
   std::atomic<bool> running_{true};
   std::atomic<uint32_t> sample_rate_hz_{kDefaultSampleRateHz};
   std::atomic<uint32_t> channels_{kDefaultChannels};
+  // Position reported until the render thread consumes the first marker of the current epoch.
   std::atomic<int64_t> render_frame_offset_{0};
 
   // Protected by last_error_mutex_ because std::string is not atomic.
@@ -195,9 +309,36 @@ private:
   DecodeControl decode_control_{};
   std::atomic<int64_t> decoded_frame_cursor_{0};
   std::atomic<uint64_t> produced_frames_total_{0};
+  // Epoch whose decode reached the end of the source; kNoEndOfStream while decoding.
+  static constexpr uint64_t kNoEndOfStream = UINT64_MAX;
+  std::atomic<uint64_t> end_of_stream_epoch_{kNoEndOfStream};
+  // Replaced only on the engine thread while the decoder is idle, like ring_buffer_.
+  // decode_scratch_ holds one chunk when the source's channel count differs from the
+  // ring's; it is sized on open, under Config::memory_policy, so the decode thread never
+  // allocates or faults.
+  std::unique_ptr<tomplayer::decode::Decoder> decoder_;
+  tomplayer::platform::ResidentMemory decode_scratch_;
+  const Config config_;
+  tomplayer::platform::ThreadPolicySlot engine_thread_policy_;
+  tomplayer::platform::ThreadPolicySlot decode_thread_policy_;
+  bool process_memory_locked_{false};
   // Frame = one time-step across all channels (interleaved float32 layout).
+  // Replaced only on the engine thread while the decoder is idle; the render thread and taps
+  // see the new ring through published_ring_ / exchange_ring_buffer.
   std::unique_ptr<AudioRingBuffer> ring_buffer_;
-  std::unique_ptr<tomplayer::wasapi::WasapiOutput> output_;
+  // Ring pointer for tap/status readers on arbitrary threads; ring_readers_ counts in-flight
+  // reads.
+  std::atomic<AudioRingBuffer*> published_ring_{nullptr};
+  mutable std::atomic<uint32_t> ring_readers_{0};
+
+  // Replaced rings wait here until the render thread and all taps have moved on.
+  struct RetiredRing {
+    std::unique_ptr<AudioRingBuffer> ring;
+    uint64_t render_grace_token = 0;
+  };
+  std::vector<RetiredRing> retired_rings_;
+  // Set once at construction and never reassigned; other threads dereference it.
+  std::unique_ptr<tomplayer::audio::AudioOutput> output_;
   bool output_initialized_{false};
 
   std::mutex queue_mutex_;
@@ -205,9 +346,6 @@ private:
   std::deque<Command> queue_;
   std::atomic<bool> queue_has_pending_{false};
 
-  std::mutex buffer_mutex_;
-  std::condition_variable buffer_cv_;
-
   std::atomic<bool> decode_idle_{true};
   std::mutex decode_idle_mutex_;
   std::condition_variable decode_idle_cv_;
@@ -218,6 +356,10 @@ private:
   bool priming_active_ = false;
   uint32_t priming_target_frames_ = 0;
   bool priming_allow_empty_ = false;
+
+  // Engine thread only; inert unless config_.adaptive_latency.enabled.
+  LatencyController latency_controller_;
+  std::atomic<double> output_latency_seconds_{0.0};
 };
 
 }  // namespace tomplayer::engine
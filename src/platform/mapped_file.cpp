@@ -0,0 +1,144 @@
+#include "platform/mapped_file.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include <algorithm>
+#include <limits>
+
+namespace tomplayer::platform {
+namespace {
+
+bool Fail(std::string* error, const std::string& message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+}  // namespace
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& path, std::string* error) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return Fail(error, "Cannot open " + path);
+  }
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+      static_cast<uint64_t>(size.QuadPart) > std::numeric_limits<size_t>::max()) {
+    CloseHandle(file);
+    return Fail(error, "Cannot map " + path + " (empty or too large)");
+  }
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  const void* view =
+      mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    if (mapping) {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    return Fail(error, "Cannot map " + path);
+  }
+  file_ = file;
+  mapping_ = mapping;
+  data_ = static_cast<const uint8_t*>(view);
+  size_ = static_cast<uint64_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_) {
+    CloseHandle(static_cast<HANDLE>(mapping_));
+  }
+  if (file_) {
+    CloseHandle(static_cast<HANDLE>(file_));
+  }
+  data_ = nullptr;
+  size_ = 0;
+  mapping_ = nullptr;
+  file_ = nullptr;
+}
+
+void MappedFile::prefetch(uint64_t offset, uint64_t bytes) const {
+  if (!data_ || offset >= size_) {
+    return;
+  }
+  WIN32_MEMORY_RANGE_ENTRY range{};
+  range.VirtualAddress = const_cast<uint8_t*>(data_ + offset);
+  range.NumberOfBytes = static_cast<SIZE_T>(std::min(bytes, size_ - offset));
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, std::string* error) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return Fail(error, "Cannot open " + path + ": " + std::strerror(errno));
+  }
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || info.st_size <= 0 ||
+      static_cast<uint64_t>(info.st_size) > std::numeric_limits<size_t>::max()) {
+    ::close(fd);
+    return Fail(error, "Cannot map " + path + " (empty or too large)");
+  }
+  const size_t size = static_cast<size_t>(info.st_size);
+  void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    return Fail(error, "Cannot map " + path + ": " + std::strerror(errno));
+  }
+  madvise(view, size, MADV_SEQUENTIAL);
+  data_ = static_cast<const uint8_t*>(view);
+  size_ = size;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_) {
+    munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void MappedFile::prefetch(uint64_t offset, uint64_t bytes) const {
+  if (!data_ || offset >= size_) {
+    return;
+  }
+  // madvise wants a page-aligned start.
+  const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  const uint64_t start = offset / page * page;
+  const uint64_t end = std::min(size_, offset + bytes);
+  madvise(const_cast<uint8_t*>(data_ + start), static_cast<size_t>(end - start), MADV_WILLNEED);
+}
+
+#endif
+
+}  // namespace tomplayer::platform
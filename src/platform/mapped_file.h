@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tomplayer::platform {
+
+// MappedFile
+// - Maps a whole file read-only (mmap / CreateFileMapping) so decoders parse and convert
+//   straight out of the page cache, with no read() copies or staging buffers.
+// - Files larger than the address space (4 GB+ on 32-bit builds) fail to open.
+// - Not thread-safe; the owner opens and closes, any thread may read data().
+class MappedFile {
+public:
+  MappedFile() = default;
+
+  // Summary: Unmap the file if open.
+  // Preconditions: no outstanding pointers into it are used afterwards.
+  // Postconditions: the mapping and file handle are released.
+  // Errors: none.
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Summary: Map path for sequential reading.
+  // Preconditions: nothing open yet.
+  // Postconditions: data() points at size() bytes of the file; the kernel is told the
+  //   access is sequential so readahead runs ahead of the decoder.
+  // Errors: returns false and sets *error (when non-null) if the file cannot be opened or
+  //   mapped, or is empty.
+  bool open(const std::string& path, std::string* error);
+
+  // Summary: Unmap.
+  // Preconditions: none (safe if nothing is open).
+  // Postconditions: data() == nullptr, size() == 0.
+  // Errors: none.
+  void close();
+
+  // Summary: Ask the OS to start reading [offset, offset + bytes) in ahead of use (after a
+  //   seek, where sequential readahead has not caught up yet).
+  // Preconditions: none; the range is clamped to the file.
+  // Postconditions: advisory only; returns immediately.
+  // Errors: none.
+  void prefetch(uint64_t offset, uint64_t bytes) const;
+
+  const uint8_t* data() const { return data_; }
+  uint64_t size() const { return size_; }
+
+private:
+  const uint8_t* data_{nullptr};
+  uint64_t size_{0};
+#if defined(_WIN32)
+  void* file_{nullptr};
+  void* mapping_{nullptr};
+#endif
+};
+
+}  // namespace tomplayer::platform
@@ -0,0 +1,261 @@
+#include "platform/resident_memory.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <cstdlib>
+#endif
+
+#include <cstdint>
+
+namespace tomplayer::platform {
+namespace {
+
+size_t RoundUp(size_t value, size_t granule) {
+  return (value + granule - 1) / granule * granule;
+}
+
+size_t SmallPageSize() {
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#elif defined(__linux__)
+  const long size = sysconf(_SC_PAGESIZE);
+  return size > 0 ? static_cast<size_t>(size) : 4096;
+#else
+  return 4096;
+#endif
+}
+
+// Write every page once (keeping its contents) so first use on the RT thread cannot fault.
+void TouchPages(void* data, size_t size_bytes) {
+  volatile uint8_t* bytes = static_cast<volatile uint8_t*>(data);
+  const size_t page = SmallPageSize();
+  for (size_t offset = 0; offset < size_bytes; offset += page) {
+    bytes[offset] = bytes[offset];
+  }
+  if (size_bytes > 0) {
+    bytes[size_bytes - 1] = bytes[size_bytes - 1];
+  }
+}
+
+bool LockPages(void* data, size_t size_bytes) {
+#if defined(_WIN32)
+  if (VirtualLock(data, size_bytes)) {
+    return true;
+  }
+  // The default minimum working set only admits a few hundred KiB of locked pages; grow it
+  // by this buffer and retry once.
+  HANDLE process = GetCurrentProcess();
+  SIZE_T min_working_set = 0;
+  SIZE_T max_working_set = 0;
+  if (!GetProcessWorkingSetSize(process, &min_working_set, &max_working_set) ||
+      !SetProcessWorkingSetSize(process, min_working_set + size_bytes,
+                                max_working_set + size_bytes)) {
+    return false;
+  }
+  return VirtualLock(data, size_bytes) != 0;
+#elif defined(__linux__)
+  return mlock(data, size_bytes) == 0;
+#else
+  (void)data;
+  (void)size_bytes;
+  return false;
+#endif
+}
+
+// Lock, then prefault as the fallback; shared by allocate() and MakeResident().
+void ApplyLockAndPrefault(void* data, size_t size_bytes, MemoryResidency* residency) {
+  if (residency->requested >= MemoryPolicy::Lock && !residency->locked) {
+    // A successful lock also faults every page in.
+    residency->locked = LockPages(data, size_bytes);
+    residency->prefaulted = residency->prefaulted || residency->locked;
+  }
+  if (residency->requested >= MemoryPolicy::Prefault && !residency->prefaulted) {
+    TouchPages(data, size_bytes);
+    residency->prefaulted = true;
+  }
+}
+
+#if defined(__linux__)
+// Huge page size used for explicit/transparent requests (x86-64 and arm64 default).
+constexpr size_t kHugePageBytes = size_t{2} << 20;
+
+// Anonymous mapping aligned to kHugePageBytes so the kernel can back it with huge pages.
+void* MapHugeAligned(size_t size_bytes) {
+  const size_t reserve = size_bytes + kHugePageBytes;
+  void* raw = mmap(nullptr, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  const uintptr_t aligned = RoundUp(start, kHugePageBytes);
+  if (aligned > start) {
+    munmap(raw, aligned - start);
+  }
+  const uintptr_t end = start + reserve;
+  if (end > aligned + size_bytes) {
+    munmap(reinterpret_cast<void*>(aligned + size_bytes), end - (aligned + size_bytes));
+  }
+  return reinterpret_cast<void*>(aligned);
+}
+#endif
+}  // namespace
+
+ResidentMemory::~ResidentMemory() {
+  release();
+}
+
+#if defined(_WIN32)
+
+bool ResidentMemory::allocate(size_t size_bytes, MemoryPolicy policy) {
+  if (data_ || size_bytes == 0) {
+    return false;
+  }
+  MemoryResidency residency;
+  residency.requested = policy;
+
+  if (policy >= MemoryPolicy::HugePages) {
+    // Large pages are always resident and non-pageable, but need SeLockMemoryPrivilege
+    // enabled on the process token; without it VirtualAlloc fails and we fall back.
+    const size_t large_page = GetLargePageMinimum();
+    if (large_page > 0) {
+      const size_t rounded = RoundUp(size_bytes, large_page);
+      data_ = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                           PAGE_READWRITE);
+      if (data_) {
+        mapped_bytes_ = rounded;
+        residency.huge_pages = HugePageBacking::Explicit;
+        residency.locked = true;
+        residency.prefaulted = true;
+      }
+    }
+  }
+  if (!data_) {
+    mapped_bytes_ = RoundUp(size_bytes, SmallPageSize());
+    data_ = VirtualAlloc(nullptr, mapped_bytes_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!data_) {
+      mapped_bytes_ = 0;
+      return false;
+    }
+  }
+
+  size_bytes_ = size_bytes;
+  ApplyLockAndPrefault(data_, mapped_bytes_, &residency);
+  residency_ = residency;
+  return true;
+}
+
+void ResidentMemory::release() {
+  if (data_) {
+    // Freeing also drops any VirtualLock.
+    VirtualFree(data_, 0, MEM_RELEASE);
+  }
+  data_ = nullptr;
+  size_bytes_ = 0;
+  mapped_bytes_ = 0;
+  residency_ = {};
+}
+
+#elif defined(__linux__)
+
+bool ResidentMemory::allocate(size_t size_bytes, MemoryPolicy policy) {
+  if (data_ || size_bytes == 0) {
+    return false;
+  }
+  MemoryResidency residency;
+  residency.requested = policy;
+
+  if (policy >= MemoryPolicy::HugePages) {
+    // Explicit pages come from the hugetlbfs pool (vm.nr_hugepages), usually empty.
+    const size_t rounded = RoundUp(size_bytes, kHugePageBytes);
+    void* mapped = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mapped != MAP_FAILED) {
+      data_ = mapped;
+      mapped_bytes_ = rounded;
+      residency.huge_pages = HugePageBacking::Explicit;
+    } else if ((data_ = MapHugeAligned(rounded)) != nullptr) {
+      mapped_bytes_ = rounded;
+      if (madvise(data_, rounded, MADV_HUGEPAGE) == 0) {
+        residency.huge_pages = HugePageBacking::Transparent;
+      }
+    }
+  }
+  if (!data_) {
+    const size_t rounded = RoundUp(size_bytes, SmallPageSize());
+    void* mapped =
+        mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+      return false;
+    }
+    data_ = mapped;
+    mapped_bytes_ = rounded;
+  }
+
+  size_bytes_ = size_bytes;
+  ApplyLockAndPrefault(data_, mapped_bytes_, &residency);
+  residency_ = residency;
+  return true;
+}
+
+void ResidentMemory::release() {
+  if (data_) {
+    // Unmapping also drops any mlock.
+    munmap(data_, mapped_bytes_);
+  }
+  data_ = nullptr;
+  size_bytes_ = 0;
+  mapped_bytes_ = 0;
+  residency_ = {};
+}
+
+#else
+
+bool ResidentMemory::allocate(size_t size_bytes, MemoryPolicy policy) {
+  if (data_ || size_bytes == 0) {
+    return false;
+  }
+  data_ = std::calloc(1, size_bytes);
+  if (!data_) {
+    return false;
+  }
+  size_bytes_ = size_bytes;
+  mapped_bytes_ = size_bytes;
+  MemoryResidency residency;
+  residency.requested = policy;
+  ApplyLockAndPrefault(data_, mapped_bytes_, &residency);
+  residency_ = residency;
+  return true;
+}
+
+void ResidentMemory::release() {
+  std::free(data_);
+  data_ = nullptr;
+  size_bytes_ = 0;
+  mapped_bytes_ = 0;
+  residency_ = {};
+}
+
+#endif
+
+MemoryResidency MakeResident(void* data, size_t size_bytes, MemoryPolicy policy) {
+  MemoryResidency residency;
+  residency.requested = policy;
+  if (data && size_bytes > 0) {
+    ApplyLockAndPrefault(data, size_bytes, &residency);
+  }
+  return residency;
+}
+
+}  // namespace tomplayer::platform
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+
+namespace tomplayer::platform {
+
+// Summary: How hard to keep a buffer resident so the real-time thread never page-faults.
+// Each level includes the ones before it and falls back to them when the OS refuses
+// (missing privilege, RLIMIT_MEMLOCK / working-set quota, no huge pages configured).
+// - None: pages are faulted in lazily on first touch.
+// - Prefault: every page is touched at allocation time.
+// - Lock: pages are locked in RAM (mlock / VirtualLock) so they cannot be paged out.
+// - HugePages: backed by explicit huge pages if available, else transparent huge pages
+//   (Linux), then locked.
+enum class MemoryPolicy { None, Prefault, Lock, HugePages };
+
+// Summary: Huge-page backing actually obtained.
+// Transparent means the kernel was advised to use huge pages; it may still use small ones.
+enum class HugePageBacking { None, Transparent, Explicit };
+
+// Summary: What an allocation actually got after fallbacks.
+// Preconditions: none.
+// Postconditions: plain value; safe to copy across threads.
+// Errors: none.
+struct MemoryResidency {
+  MemoryPolicy requested = MemoryPolicy::None;
+  bool prefaulted = false;
+  bool locked = false;
+  HugePageBacking huge_pages = HugePageBacking::None;
+};
+
+// ResidentMemory
+// - Owns one zero-filled, page-aligned allocation made according to a MemoryPolicy.
+// - Allocation and release may block and allocate; do them off the real-time thread.
+// - Not thread-safe; the owner allocates and releases, any thread may use data().
+class ResidentMemory {
+public:
+  ResidentMemory() = default;
+
+  // Summary: Release the allocation if any.
+  // Preconditions: no outstanding pointers into it are used afterwards.
+  // Postconditions: memory (and any lock on it) is returned to the OS.
+  // Errors: none.
+  ~ResidentMemory();
+
+  ResidentMemory(const ResidentMemory&) = delete;
+  ResidentMemory& operator=(const ResidentMemory&) = delete;
+
+  // Summary: Allocate size_bytes of zeroed memory, applying policy with fallbacks.
+  // Preconditions: size_bytes > 0; nothing allocated yet.
+  // Postconditions: data() points at size_bytes usable bytes; residency() reports what
+  //   policy was actually achieved.
+  // Errors: returns false (nothing allocated) only if no memory could be obtained at all.
+  bool allocate(size_t size_bytes, MemoryPolicy policy);
+
+  // Summary: Free the allocation.
+  // Preconditions: none (safe if nothing is allocated).
+  // Postconditions: data() == nullptr, size_bytes() == 0, residency() is reset.
+  // Errors: none.
+  void release();
+
+  // Summary: Start of the allocation, or nullptr.
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  void* data() const { return data_; }
+
+  // Summary: Usable size requested from allocate().
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: returns 0 when nothing is allocated.
+  size_t size_bytes() const { return size_bytes_; }
+
+  // Summary: Residency achieved by allocate().
+  // Preconditions: none.
+  // Postconditions: does not modify state.
+  // Errors: none.
+  const MemoryResidency& residency() const { return residency_; }
+
+private:
+  void* data_{nullptr};
+  size_t size_bytes_{0};
+  // Bytes actually reserved from the OS (rounded to the page or huge-page size).
+  size_t mapped_bytes_{0};
+  MemoryResidency residency_{};
+};
+
+// Summary: Prefault and/or lock memory allocated elsewhere (e.g. a MirroredMapping).
+// Preconditions: [data, data + size_bytes) is writable; existing contents are preserved.
+// Postconditions: applied according to policy with fallbacks. HugePages degrades to Lock
+//   because the backing of existing memory cannot be changed. Locks end when the memory is
+//   unmapped.
+// Errors: none; the returned residency reports what was achieved.
+MemoryResidency MakeResident(void* data, size_t size_bytes, MemoryPolicy policy);
+
+}  // namespace tomplayer::platform
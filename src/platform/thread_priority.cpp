@@ -0,0 +1,153 @@
+#include "platform/thread_priority.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include <algorithm>
+
+namespace tomplayer::platform {
+namespace {
+
+void NoteRefusal(ThreadPolicyReport* report, int error) {
+  if (report->error == 0) {
+    report->error = error;
+  }
+}
+
+#if defined(__linux__)
+
+// Soft limit of an RLIMIT_* resource, or 0 if it cannot be read.
+rlim_t SoftLimit(int resource) {
+  rlimit limit{};
+  return getrlimit(resource, &limit) == 0 ? limit.rlim_cur : 0;
+}
+
+bool SetAffinity(uint64_t cpu_mask, ThreadPolicyReport* report) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu = 0; cpu < 64; ++cpu) {
+    if (cpu_mask & (uint64_t{1} << cpu)) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (result != 0) {
+    NoteRefusal(report, result);
+  }
+  return result == 0;
+}
+
+bool SetRealtime(const ThreadPolicy& policy, ThreadPolicyReport* report) {
+  const int scheduler = policy.round_robin ? SCHED_RR : SCHED_FIFO;
+  const int min_priority = sched_get_priority_min(scheduler);
+  const int max_priority = sched_get_priority_max(scheduler);
+  sched_param param{};
+  param.sched_priority = std::clamp(policy.realtime_priority, min_priority, max_priority);
+  int result = pthread_setschedparam(pthread_self(), scheduler, &param);
+  if (result == EPERM) {
+    NoteRefusal(report, result);
+    // Unprivileged users may still go up to RLIMIT_RTPRIO (e.g. the "audio" group limits).
+    const rlim_t allowed = SoftLimit(RLIMIT_RTPRIO);
+    if (allowed >= static_cast<rlim_t>(min_priority) &&
+        allowed < static_cast<rlim_t>(param.sched_priority)) {
+      param.sched_priority = static_cast<int>(allowed);
+      result = pthread_setschedparam(pthread_self(), scheduler, &param);
+    }
+  }
+  if (result != 0) {
+    NoteRefusal(report, result);
+    return false;
+  }
+  report->scheduling = policy.round_robin ? ThreadScheduling::RoundRobin : ThreadScheduling::Fifo;
+  report->priority = param.sched_priority;
+  return true;
+}
+
+bool SetNice(int nice, ThreadPolicyReport* report) {
+  // On Linux setpriority on a thread id changes only that thread.
+  const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+  nice = std::clamp(nice, -20, 19);
+  if (setpriority(PRIO_PROCESS, tid, nice) != 0) {
+    NoteRefusal(report, errno);
+    // RLIMIT_NICE lets unprivileged users reach 20 - limit.
+    const rlim_t limit = std::min<rlim_t>(SoftLimit(RLIMIT_NICE), 40);
+    const int floor = 20 - static_cast<int>(limit);
+    if (floor <= nice || floor >= 0 || setpriority(PRIO_PROCESS, tid, floor) != 0) {
+      return false;
+    }
+    nice = floor;
+  }
+  report->scheduling = ThreadScheduling::Nice;
+  report->priority = nice;
+  return true;
+}
+
+#endif
+
+}  // namespace
+
+ThreadPolicyReport ApplyThreadPolicy(const ThreadPolicy& policy) {
+  ThreadPolicyReport report;
+  report.requested = policy.thread_class;
+#if defined(_WIN32)
+  if (policy.cpu_mask != 0) {
+    if (SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(policy.cpu_mask))) {
+      report.affinity_applied = true;
+    } else {
+      NoteRefusal(&report, static_cast<int>(GetLastError()));
+    }
+  }
+  if (policy.thread_class == ThreadClass::Inherit) {
+    return report;
+  }
+  // MMCSS (see WasapiOutput::RenderLoop) boosts further; this is the portable baseline.
+  const int priority = policy.thread_class == ThreadClass::RealTime
+                           ? THREAD_PRIORITY_TIME_CRITICAL
+                           : THREAD_PRIORITY_ABOVE_NORMAL;
+  if (SetThreadPriority(GetCurrentThread(), priority)) {
+    report.scheduling = ThreadScheduling::ThreadPriority;
+    report.priority = priority;
+  } else {
+    NoteRefusal(&report, static_cast<int>(GetLastError()));
+  }
+#elif defined(__linux__)
+  if (policy.cpu_mask != 0) {
+    report.affinity_applied = SetAffinity(policy.cpu_mask, &report);
+  }
+  if (policy.thread_class == ThreadClass::RealTime && SetRealtime(policy, &report)) {
+    return report;
+  }
+  if (policy.thread_class != ThreadClass::Inherit) {
+    SetNice(policy.nice, &report);
+  }
+#else
+  (void)NoteRefusal;
+#endif
+  return report;
+}
+
+bool LockProcessMemory() {
+#if defined(__linux__)
+  return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace tomplayer::platform
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+namespace tomplayer::platform {
+
+// Summary: Scheduling class requested for a player thread.
+// - Inherit: leave the thread as created.
+// - Elevated: a better nice level (Linux) / above-normal priority (Windows); for work that
+//   must keep up but has slack, such as decoding ahead into the ring.
+// - RealTime: SCHED_FIFO/SCHED_RR (Linux) / time-critical priority (Windows), falling back
+//   to Elevated when the OS refuses (no CAP_SYS_NICE and RLIMIT_RTPRIO == 0).
+enum class ThreadClass { Inherit, Elevated, RealTime };
+
+// Summary: Scheduling actually in effect after ApplyThreadPolicy.
+enum class ThreadScheduling { Unchanged, Nice, RoundRobin, Fifo, ThreadPriority };
+
+// Summary: Requested scheduling, priority and placement for one thread.
+// Preconditions: none.
+// Postconditions: plain value.
+// Errors: none; out-of-range priorities are clamped when applied.
+struct ThreadPolicy {
+  ThreadClass thread_class = ThreadClass::Inherit;
+  // RealTime only: SCHED_RR instead of SCHED_FIFO.
+  bool round_robin = false;
+  // RealTime only: 1..99 on Linux; lowered to RLIMIT_RTPRIO when that is what is allowed.
+  int realtime_priority = 70;
+  // Elevated, and RealTime when it falls back: -20..19; raised to the RLIMIT_NICE floor
+  // when that is what is allowed.
+  int nice = -10;
+  // Bit i pins the thread to CPU i; 0 leaves affinity alone.
+  uint64_t cpu_mask = 0;
+};
+
+// Summary: What ApplyThreadPolicy achieved, for Status reporting.
+// Preconditions: none.
+// Postconditions: plain value; safe to copy across threads.
+// Errors: none.
+struct ThreadPolicyReport {
+  ThreadClass requested = ThreadClass::Inherit;
+  ThreadScheduling scheduling = ThreadScheduling::Unchanged;
+  // Realtime priority for RoundRobin/Fifo, nice value for Nice, Windows thread priority
+  // for ThreadPriority; 0 when Unchanged.
+  int priority = 0;
+  bool affinity_applied = false;
+  // errno (GetLastError on Windows) of the first step the OS refused; 0 if none was.
+  int error = 0;
+};
+
+// Summary: Apply policy to the calling thread, falling back RealTime -> nice -> unchanged.
+// Preconditions: called on the thread to configure, outside its real-time loop (may make
+//   syscalls and take locks).
+// Postconditions: the thread runs with the returned scheduling; affinity is set first so
+//   a pinned thread is never briefly real-time on the wrong CPU.
+// Errors: none; refusals are reported, never fatal.
+ThreadPolicyReport ApplyThreadPolicy(const ThreadPolicy& policy);
+
+// Summary: Lock every current and future page of the process in RAM (mlockall).
+// Preconditions: RLIMIT_MEMLOCK covers the process (or CAP_IPC_LOCK). Later allocations
+//   beyond the limit fail, so size the limit for the whole session.
+// Postconditions: no page fault can hit a real-time thread on process memory.
+// Errors: returns false if the OS refused or the platform has no equivalent (Windows).
+bool LockProcessMemory();
+
+// ThreadPolicySlot
+// - Holds the policy a thread should apply at start and the report of the last apply.
+// - Any thread may set() or read report(); the owning thread calls apply() before its loop.
+class ThreadPolicySlot {
+public:
+  void set(const ThreadPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+  }
+
+  // Summary: Apply the stored policy to the calling thread and keep the report.
+  // Preconditions: same as ApplyThreadPolicy.
+  // Postconditions: report() returns the result.
+  // Errors: none.
+  ThreadPolicyReport apply() {
+    ThreadPolicy policy;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      policy = policy_;
+    }
+    const ThreadPolicyReport report = ApplyThreadPolicy(policy);
+    std::lock_guard<std::mutex> lock(mutex_);
+    report_ = report;
+    return report;
+  }
+
+  ThreadPolicyReport report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return report_;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  ThreadPolicy policy_{};
+  ThreadPolicyReport report_{};
+};
+
+}  // namespace tomplayer::platform
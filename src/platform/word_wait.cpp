@@ -0,0 +1,144 @@
+#include "platform/word_wait.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <thread>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+namespace tomplayer::platform {
+
+// std::atomic<uint32_t> is a plain 32-bit word on every supported ABI; the OS primitives
+// below operate on that word directly.
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+
+#if defined(_WIN32)
+
+bool WaitForWordChange(std::atomic<uint32_t>* word,
+                   uint32_t expected,
+                   std::chrono::nanoseconds timeout) {
+  if (timeout <= std::chrono::nanoseconds::zero()) {
+    return false;
+  }
+  // Round up so sub-millisecond timeouts still block instead of spinning.
+  const auto millis = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+  const DWORD wait_ms = millis >= static_cast<long long>(INFINITE)
+                            ? INFINITE - 1
+                            : static_cast<DWORD>(millis);
+  if (::WaitOnAddress(word, &expected, sizeof(expected), wait_ms)) {
+    return true;
+  }
+  return GetLastError() != ERROR_TIMEOUT;
+}
+
+void WakeWordWaiters(std::atomic<uint32_t>* word) {
+  ::WakeByAddressAll(word);
+}
+
+bool PrepareAsymmetricFence() {
+  // FlushProcessWriteBuffers interrupts every processor running a thread of this process.
+  detail::asymmetric_fence_ready.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void AsymmetricHeavyFence() {
+  PrepareAsymmetricFence();
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  ::FlushProcessWriteBuffers();
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+#elif defined(__linux__)
+
+bool WaitForWordChange(std::atomic<uint32_t>* word,
+                   uint32_t expected,
+                   std::chrono::nanoseconds timeout) {
+  if (timeout <= std::chrono::nanoseconds::zero()) {
+    return false;
+  }
+  const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  timespec relative{};
+  relative.tv_sec = static_cast<time_t>(seconds.count());
+  relative.tv_nsec = static_cast<long>((timeout - seconds).count());
+  // FUTEX_WAIT takes a relative timeout; EAGAIN (value changed) and EINTR count as wakes.
+  const long result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(word),
+                              FUTEX_WAIT_PRIVATE, expected, &relative, nullptr, 0);
+  return result == 0 || errno != ETIMEDOUT;
+}
+
+void WakeWordWaiters(std::atomic<uint32_t>* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, INT_MAX,
+          nullptr, nullptr, 0);
+}
+
+bool PrepareAsymmetricFence() {
+  // Expedited private membarrier (Linux 4.14+) must be registered before use; light fences
+  // stay full fences until it is, and for good when the kernel refuses.
+  static const bool ready = [] {
+    const long commands = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0);
+    if (commands < 0 || (commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED) == 0 ||
+        syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) != 0) {
+      return false;
+    }
+    detail::asymmetric_fence_ready.store(true, std::memory_order_relaxed);
+    return true;
+  }();
+  return ready;
+}
+
+void AsymmetricHeavyFence() {
+  const bool ready = PrepareAsymmetricFence();
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ready) {
+    syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+#else
+
+bool WaitForWordChange(std::atomic<uint32_t>* word,
+                   uint32_t expected,
+                   std::chrono::nanoseconds timeout) {
+  // Portable fallback: bounded sleeps until the word changes or the timeout expires.
+  constexpr auto kPollInterval = std::chrono::milliseconds(1);
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (word->load(std::memory_order_acquire) == expected) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(kPollInterval, deadline - now));
+  }
+  return true;
+}
+
+void WakeWordWaiters(std::atomic<uint32_t>*) {}
+
+bool PrepareAsymmetricFence() {
+  return false;
+}
+
+void AsymmetricHeavyFence() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+#endif
+
+}  // namespace tomplayer::platform
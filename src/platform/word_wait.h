@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace tomplayer::platform {
+
+// Summary: Block the calling thread while *word == expected, for at most timeout.
+// Preconditions: word outlives the wait; paired with WakeWordWaiters on the same word.
+// Postconditions: returns after a wake, a value change, a timeout, or spuriously.
+// Errors: returns false only when the timeout elapsed; callers must re-check their condition.
+// Notes: futex on Linux, WaitOnAddress on Windows, short sleeps elsewhere. std::atomic::wait
+//   is not used because it has no timed form.
+bool WaitForWordChange(std::atomic<uint32_t>* word,
+                   uint32_t expected,
+                   std::chrono::nanoseconds timeout);
+
+// Summary: Wake every thread blocked in WaitForWordChange on word.
+// Preconditions: the caller changed *word first (waiters compare against it).
+// Postconditions: blocked waiters return and re-check.
+// Errors: none; a syscall, so keep it off paths that run when nobody waits.
+void WakeWordWaiters(std::atomic<uint32_t>* word);
+
+namespace detail {
+// Set once AsymmetricHeavyFence can serialize every running thread of the process.
+inline std::atomic<bool> asymmetric_fence_ready{false};
+}  // namespace detail
+
+// Summary: Register the process for AsymmetricHeavyFence (idempotent, thread-safe).
+// Preconditions: none; call off the real-time path, e.g. when building the structure whose
+//   hot path uses AsymmetricLightFence.
+// Postconditions: returns true when light fences are now compiler barriers (Linux expedited
+//   membarrier, Windows FlushProcessWriteBuffers).
+// Errors: returns false when the OS has no such primitive; light fences stay full fences.
+bool PrepareAsymmetricFence();
+
+// Summary: Fast half of a store-load fence whose other half is AsymmetricHeavyFence; for the
+//   side that runs on every call (a ring commit checking for a blocked peer).
+// Preconditions: the peer orders its side of the same store/load pair with
+//   AsymmetricHeavyFence, never with this function.
+// Postconditions: a compiler barrier once PrepareAsymmetricFence succeeded; a full seq_cst
+//   fence before that and on other platforms.
+// Errors: none.
+inline void AsymmetricLightFence() {
+  if (detail::asymmetric_fence_ready.load(std::memory_order_relaxed)) {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+  } else {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+// Summary: Slow half of the pair: orders the caller's earlier stores before its later loads
+//   against every AsymmetricLightFence running concurrently. For the side about to block.
+// Preconditions: none; registers through PrepareAsymmetricFence if nothing did yet.
+// Postconditions: as a seq_cst fence on both sides of the pair.
+// Errors: none; a syscall (microseconds), so keep it off paths that run on every call.
+void AsymmetricHeavyFence();
+
+}  // namespace tomplayer::platform
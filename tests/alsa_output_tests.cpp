@@ -0,0 +1,115 @@
+// AlsaOutput tests against ALSA's null and file PCM plugins (no sound hardware needed):
+// negotiation, mmap rendering, counters and bit-exact frames on the file plugin.
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/alsa_output.h"
+#include "buffer/audio_ring_buffer.h"
+#include "test_support.h"
+
+namespace {
+using tomplayer::alsa::AlsaOutput;
+using namespace std::chrono_literals;
+using tomplayer::test::WaitFor;
+
+AlsaOutput::Config NullDevice() {
+  AlsaOutput::Config config;
+  config.device = "null";
+  config.sample_rate = 48000;
+  config.channels = 2;
+  config.latency = 20ms;
+  config.periods = 2;
+  return config;
+}
+}  // namespace
+
+// Period comes from the latency target; format prefers float32 when the device offers it.
+TEST_CASE("AlsaOutput negotiates format and period from the latency target") {
+  AlsaOutput output(NullDevice());
+  REQUIRE_FALSE(output.start());
+  REQUIRE(output.init_default_device());
+  REQUIRE_FALSE(output.init_default_device());
+  REQUIRE(output.sample_rate() == 48000);
+  REQUIRE(output.channels() == 2);
+  REQUIRE(output.sample_format() == tomplayer::audio::SampleFormat::Float32);
+  // 20 ms over two periods is 480 frames each; the device may round.
+  REQUIRE(output.period_frames() >= 240);
+  REQUIRE(output.period_frames() <= 960);
+  REQUIRE(output.buffer_frames() >= output.period_frames());
+
+  AudioRingBuffer mono(1024, 1);
+  output.set_ring_buffer(&mono);
+  REQUIRE_FALSE(output.start());
+  output.shutdown();
+  REQUIRE(output.sample_rate() == 0);
+  REQUIRE(output.sample_format() == tomplayer::audio::SampleFormat::Unsupported);
+
+  AlsaOutput::Config missing = NullDevice();
+  missing.device = "tomplayer_no_such_pcm";
+  AlsaOutput unopenable(missing);
+  REQUIRE_FALSE(unopenable.init_default_device());
+}
+
+// The null plugin drains whatever is committed; an empty ring shows up as underruns.
+TEST_CASE("AlsaOutput renders through mmap and counts underruns") {
+  AlsaOutput output(NullDevice());
+  REQUIRE(output.init_default_device());
+  AudioRingBuffer ring(8192, 2);
+  const std::vector<float> input(static_cast<size_t>(4800) * 2, 0.25f);
+  REQUIRE(ring.write_frames(input.data(), 4800) == 4800);
+  output.set_ring_buffer(&ring);
+
+  REQUIRE(output.start());
+  REQUIRE(WaitFor([&] { return output.rendered_frames_total() >= 9600; }, 2000ms));
+  output.stop();
+
+  REQUIRE(ring.available_to_read_frames() == 0);
+  REQUIRE(output.underrun_wake_count() > 0);
+  REQUIRE(output.underrun_frame_count() == output.rendered_frames_total() - 4800);
+
+  // Restartable, and a swapped ring takes over after a grace period.
+  AudioRingBuffer second(4096, 2);
+  REQUIRE(output.start());
+  REQUIRE(output.exchange_ring_buffer(&second) == &ring);
+  const uint64_t token = output.render_grace_token();
+  REQUIRE(WaitFor([&] { return output.render_grace_period_elapsed(token); }, 2000ms));
+  output.shutdown();
+}
+
+// The file plugin records exactly what the render loop committed into the mmap area.
+TEST_CASE("AlsaOutput frames reach the file plugin bit-exact") {
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "tomplayer_alsa_output.raw").string();
+  std::filesystem::remove(path);
+  AlsaOutput::Config config = NullDevice();
+  config.device = "file:FILE=" + path + ",FORMAT=raw";
+  AlsaOutput output(config);
+  REQUIRE(output.init_default_device());
+  REQUIRE(output.sample_format() == tomplayer::audio::SampleFormat::Float32);
+
+  AudioRingBuffer ring(4096, 2);
+  std::vector<float> input(static_cast<size_t>(3000) * 2);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<float>(i) * 0.0001f - 0.3f;
+  }
+  REQUIRE(ring.write_frames(input.data(), 3000) == 3000);
+  output.set_ring_buffer(&ring);
+  REQUIRE(output.start());
+  REQUIRE(WaitFor([&] { return output.rendered_frames_total() >= 3000; }, 2000ms));
+  output.shutdown();
+
+  std::ifstream in(path, std::ios::binary);
+  const std::vector<char> bytes(std::istreambuf_iterator<char>(in), {});
+  REQUIRE(bytes.size() >= input.size() * sizeof(float));
+  REQUIRE(std::memcmp(bytes.data(), input.data(), input.size() * sizeof(float)) == 0);
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,269 @@
+// FileOutput tests: WAV/raw layout, bit-exact sample transfer, integer PCM output, frame
+// limits, and an engine-driven offline render.
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/file_output.h"
+#include "buffer/audio_ring_buffer.h"
+#include "engine/player_engine.h"
+#include "test_support.h"
+
+namespace {
+using tomplayer::audio::FileOutput;
+using namespace std::chrono_literals;
+using tomplayer::test::TempPath;
+using tomplayer::test::WaitFor;
+
+std::vector<uint8_t> ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+}
+
+uint32_t U32At(const std::vector<uint8_t>& bytes, size_t offset) {
+  return static_cast<uint32_t>(bytes[offset]) | (static_cast<uint32_t>(bytes[offset + 1]) << 8) |
+         (static_cast<uint32_t>(bytes[offset + 2]) << 16) |
+         (static_cast<uint32_t>(bytes[offset + 3]) << 24);
+}
+
+uint16_t U16At(const std::vector<uint8_t>& bytes, size_t offset) {
+  return static_cast<uint16_t>(bytes[offset] | (bytes[offset + 1] << 8));
+}
+
+std::vector<float> Ramp(uint32_t frames, uint32_t channels) {
+  std::vector<float> samples(static_cast<size_t>(frames) * channels);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i] = static_cast<float>(i) * 0.001f - 0.5f;
+  }
+  return samples;
+}
+}  // namespace
+
+// Frames pass through bit-exact, across ring wrap-around and several sink cycles.
+TEST_CASE("FileOutput writes a float WAV with ring frames bit-exact") {
+  FileOutput::Config config;
+  config.path = TempPath("tomplayer_file_output.wav");
+  config.sample_rate = 44100;
+  config.channels = 2;
+  config.block_frames = 100;
+  FileOutput output(config);
+  REQUIRE(output.init_default_device());
+
+  AudioRingBuffer ring(256, 2);
+  output.set_ring_buffer(&ring);
+  REQUIRE(output.start());
+  const std::vector<float> input = Ramp(1000, 2);
+  uint32_t sent = 0;
+  while (sent < 1000) {
+    sent += ring.write_frames(input.data() + static_cast<size_t>(sent) * 2,
+                              std::min<uint32_t>(300, 1000 - sent));
+    std::this_thread::yield();
+  }
+  REQUIRE(WaitFor([&] { return output.frames_written() == 1000; }, 2000ms));
+  output.stop();
+  REQUIRE(output.rendered_frames_total() == 1000);
+  REQUIRE(output.underrun_wake_count() == 0);
+  REQUIRE(output.speed_factor() > 0.0);
+  output.shutdown();
+  REQUIRE_FALSE(output.has_write_error());
+
+  const std::vector<uint8_t> bytes = ReadFile(config.path);
+  REQUIRE(bytes.size() == 44 + input.size() * sizeof(float));
+  REQUIRE(std::memcmp(bytes.data(), "RIFF", 4) == 0);
+  REQUIRE(U32At(bytes, 4) == bytes.size() - 8);
+  REQUIRE(std::memcmp(bytes.data() + 8, "WAVE", 4) == 0);
+  REQUIRE(U16At(bytes, 20) == 3);
+  REQUIRE(U16At(bytes, 22) == 2);
+  REQUIRE(U32At(bytes, 24) == 44100);
+  REQUIRE(U16At(bytes, 34) == 32);
+  REQUIRE(U32At(bytes, 40) == input.size() * sizeof(float));
+  REQUIRE(std::memcmp(bytes.data() + 44, input.data(), input.size() * sizeof(float)) == 0);
+  std::filesystem::remove(config.path);
+}
+
+// Raw output has no header; frames past the limit are drained but not written.
+TEST_CASE("FileOutput raw container honours frame_limit") {
+  FileOutput::Config config;
+  config.path = TempPath("tomplayer_file_output.raw");
+  config.container = FileOutput::Container::Raw;
+  config.channels = 1;
+  config.frame_limit = 150;
+  FileOutput output(config);
+  REQUIRE(output.init_default_device());
+
+  AudioRingBuffer ring(512, 1);
+  const std::vector<float> input = Ramp(400, 1);
+  REQUIRE(ring.write_frames(input.data(), 400) == 400);
+  output.set_ring_buffer(&ring);
+  REQUIRE(output.start());
+  REQUIRE(WaitFor([&] { return ring.available_to_read_frames() == 0; }, 2000ms));
+  output.shutdown();
+
+  REQUIRE(output.finished());
+  REQUIRE(output.frames_written() == 150);
+  const std::vector<uint8_t> bytes = ReadFile(config.path);
+  REQUIRE(bytes.size() == 150 * sizeof(float));
+  REQUIRE(std::memcmp(bytes.data(), input.data(), bytes.size()) == 0);
+  std::filesystem::remove(config.path);
+}
+
+// Integer formats go through the shared conversion kernels; >16-bit PCM is extensible.
+TEST_CASE("FileOutput writes integer PCM through the conversion kernels") {
+  FileOutput::Config config;
+  config.path = TempPath("tomplayer_file_output_pcm.wav");
+  config.channels = 1;
+  config.sample_format = tomplayer::audio::SampleFormat::Pcm16;
+  config.dither = tomplayer::audio::DitherMode::None;
+  config.block_frames = 3;
+  FileOutput output(config);
+  REQUIRE(output.init_default_device());
+  REQUIRE(output.sample_format() == tomplayer::audio::SampleFormat::Pcm16);
+
+  AudioRingBuffer ring(4, 1);
+  const float input[5] = {0.5f, -0.5f, 1.0f, -1.0f, 0.25f};
+  output.set_ring_buffer(&ring);
+  REQUIRE(output.start());
+  uint32_t sent = 0;
+  while (sent < 5) {
+    sent += ring.write_frames(input + sent, 5 - sent);
+    std::this_thread::yield();
+  }
+  REQUIRE(WaitFor([&] { return output.frames_written() == 5; }, 2000ms));
+  output.shutdown();
+
+  const std::vector<uint8_t> bytes = ReadFile(config.path);
+  REQUIRE(bytes.size() == 44 + 5 * sizeof(int16_t));
+  REQUIRE(U16At(bytes, 20) == 1);
+  REQUIRE(U32At(bytes, 28) == 48000 * 2);
+  REQUIRE(U16At(bytes, 32) == 2);
+  REQUIRE(U16At(bytes, 34) == 16);
+  REQUIRE(U32At(bytes, 40) == 10);
+  REQUIRE(U16At(bytes, 44) == 16384);
+  REQUIRE(U16At(bytes, 46) == static_cast<uint16_t>(-16384));
+  REQUIRE(U16At(bytes, 48) == 32767);
+  REQUIRE(U16At(bytes, 50) == 0x8000);
+  REQUIRE(U16At(bytes, 52) == 8192);
+  std::filesystem::remove(config.path);
+
+  FileOutput::Config packed = config;
+  packed.path = TempPath("tomplayer_file_output_pcm24.wav");
+  packed.channels = 2;
+  packed.sample_format = tomplayer::audio::SampleFormat::Pcm24;
+  FileOutput packed_output(packed);
+  REQUIRE(packed_output.init_default_device());
+  packed_output.shutdown();
+  const std::vector<uint8_t> header = ReadFile(packed.path);
+  REQUIRE(header.size() == 68);
+  REQUIRE(U16At(header, 20) == 0xFFFE);
+  REQUIRE(U16At(header, 32) == 6);
+  REQUIRE(U16At(header, 34) == 24);
+  REQUIRE(U32At(header, 44) == 1);
+  std::filesystem::remove(packed.path);
+}
+
+// An odd-sized data chunk gets a RIFF pad byte that RIFF counts and data does not; frames
+// written after a restart replace the pad instead of landing behind it.
+TEST_CASE("FileOutput pads an odd-sized Pcm24 data chunk") {
+  FileOutput::Config config;
+  config.path = TempPath("tomplayer_file_output_pad.wav");
+  config.channels = 1;
+  config.sample_format = tomplayer::audio::SampleFormat::Pcm24;
+  config.dither = tomplayer::audio::DitherMode::None;
+  FileOutput output(config);
+  REQUIRE(output.init_default_device());
+
+  AudioRingBuffer ring(8, 1);
+  output.set_ring_buffer(&ring);
+  const float first[5] = {0.5f, 0.5f, 0.5f, 0.5f, 0.5f};
+  REQUIRE(ring.write_frames(first, 5) == 5);
+  REQUIRE(output.start());
+  REQUIRE(WaitFor([&] { return output.frames_written() == 5; }, 2000ms));
+  output.stop();
+
+  const float second[2] = {0.25f, 0.25f};
+  REQUIRE(ring.write_frames(second, 2) == 2);
+  REQUIRE(output.start());
+  REQUIRE(WaitFor([&] { return output.frames_written() == 7; }, 2000ms));
+  output.stop();
+  output.shutdown();
+  REQUIRE_FALSE(output.has_write_error());
+
+  const std::vector<uint8_t> bytes = ReadFile(config.path);
+  REQUIRE(bytes.size() == 68 + 21 + 1);
+  REQUIRE(U32At(bytes, 4) == bytes.size() - 8);
+  REQUIRE(U32At(bytes, 64) == 21);
+  REQUIRE(bytes[68 + 14] == 0x40);  // last byte of the first run
+  REQUIRE(bytes[68 + 15] == 0x00);  // second run starts where the first run's pad was
+  REQUIRE(bytes[68 + 17] == 0x20);
+  REQUIRE(bytes[68 + 20] == 0x20);
+  REQUIRE(bytes[68 + 21] == 0);  // pad
+  std::filesystem::remove(config.path);
+}
+
+// More than two channels switch to WAVE_FORMAT_EXTENSIBLE.
+TEST_CASE("FileOutput writes an extensible header for multichannel renders") {
+  FileOutput::Config config;
+  config.path = TempPath("tomplayer_file_output_6ch.wav");
+  config.channels = 6;
+  FileOutput output(config);
+  REQUIRE(output.init_default_device());
+  output.shutdown();
+
+  const std::vector<uint8_t> bytes = ReadFile(config.path);
+  REQUIRE(bytes.size() == 68);
+  REQUIRE(U32At(bytes, 16) == 40);
+  REQUIRE(U16At(bytes, 20) == 0xFFFE);
+  REQUIRE(U16At(bytes, 22) == 6);
+  REQUIRE(U16At(bytes, 32) == 24);
+  REQUIRE(U32At(bytes, 64) == 0);
+  std::filesystem::remove(config.path);
+
+  FileOutput::Config missing_dir;
+  missing_dir.path = TempPath("tomplayer_no_such_dir/out.wav");
+  FileOutput unopenable(missing_dir);
+  REQUIRE_FALSE(unopenable.init_default_device());
+}
+
+// The engine drives the sink through priming, seek and stop exactly as with a device.
+TEST_CASE("PlayerEngine renders offline faster than realtime") {
+  using PlayerEngine = tomplayer::engine::PlayerEngine;
+  FileOutput::Config config;
+  config.path = TempPath("tomplayer_engine_render.wav");
+  config.frame_limit = 48000 * 4;
+  auto sink = std::make_unique<FileOutput>(config);
+  FileOutput* file_output = sink.get();
+
+  PlayerEngine::Config engine_config;
+  engine_config.memory_policy = tomplayer::platform::MemoryPolicy::Prefault;
+  PlayerEngine engine(engine_config, std::move(sink));
+
+  const auto start = std::chrono::steady_clock::now();
+  engine.play();
+  REQUIRE(WaitFor([&] { return engine.get_status().state == PlayerEngine::PlayerState::Playing; },
+                  2000ms));
+  engine.seek_seconds(30.0);
+  REQUIRE(WaitFor([&] { return engine.get_status().position_seconds >= 30.0; }, 3000ms));
+  REQUIRE(WaitFor([&] { return file_output->finished(); }, 3000ms));
+  const double wall_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  // Four seconds of audio (plus the seek) without a device clock pacing it.
+  REQUIRE(wall_seconds < 4.0);
+  REQUIRE(file_output->speed_factor() > 1.0);
+
+  engine.stop();
+  REQUIRE(WaitFor([&] { return engine.get_status().state == PlayerEngine::PlayerState::Stopped; },
+                  2000ms));
+  engine.quit();
+  REQUIRE_FALSE(file_output->has_write_error());
+  std::filesystem::remove(config.path);
+}
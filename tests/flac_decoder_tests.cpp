@@ -0,0 +1,188 @@
+// FlacDecoder tests: fixtures are encoded with libFLAC's stream encoder, then decoded back
+// bit-exact through reads smaller and larger than a block, seeks, and PlayerEngine.
+#include <catch2/catch_test_macros.hpp>
+
+#include <FLAC/stream_encoder.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/file_output.h"
+#include "decode/decoder.h"
+#include "decode/flac_decoder.h"
+#include "decode/wav_decoder.h"
+#include "engine/player_engine.h"
+#include "test_support.h"
+
+namespace {
+using tomplayer::decode::FlacDecoder;
+using namespace std::chrono_literals;
+using tomplayer::test::TempPath;
+using tomplayer::test::WaitFor;
+
+// Deterministic full-range samples: incompressible enough to exercise every subframe type.
+std::vector<int32_t> Samples(uint32_t count, uint32_t bits) {
+  std::vector<int32_t> samples(count);
+  const int64_t min = -(int64_t{1} << (bits - 1));
+  const int64_t span = int64_t{1} << bits;
+  for (uint32_t i = 0; i < count; ++i) {
+    // A slow ramp with noise on top, so blocks are neither constant nor pure noise.
+    const int64_t noise = (int64_t{i} * 7919 * 65537) % 4096;
+    samples[i] = static_cast<int32_t>(min + (int64_t{i} * 977 + noise) % span);
+  }
+  return samples;
+}
+
+bool Encode(const std::string& path,
+            const std::vector<int32_t>& interleaved,
+            uint32_t channels,
+            uint32_t bits,
+            uint32_t sample_rate,
+            uint32_t block_frames) {
+  FLAC__StreamEncoder* encoder = FLAC__stream_encoder_new();
+  if (!encoder) {
+    return false;
+  }
+  const uint32_t frames = static_cast<uint32_t>(interleaved.size() / channels);
+  bool ok = FLAC__stream_encoder_set_channels(encoder, channels) &&
+            FLAC__stream_encoder_set_bits_per_sample(encoder, bits) &&
+            FLAC__stream_encoder_set_sample_rate(encoder, sample_rate) &&
+            FLAC__stream_encoder_set_blocksize(encoder, block_frames) &&
+            FLAC__stream_encoder_set_total_samples_estimate(encoder, frames) &&
+            FLAC__stream_encoder_init_file(encoder, path.c_str(), nullptr, nullptr) ==
+                FLAC__STREAM_ENCODER_INIT_STATUS_OK;
+  ok = ok && FLAC__stream_encoder_process_interleaved(encoder, interleaved.data(), frames);
+  ok = FLAC__stream_encoder_finish(encoder) && ok;
+  FLAC__stream_encoder_delete(encoder);
+  return ok;
+}
+
+float Scaled(int32_t sample, uint32_t bits) {
+  return static_cast<float>(sample) / static_cast<float>(int64_t{1} << (bits - 1));
+}
+}  // namespace
+
+TEST_CASE("FlacDecoder decodes bit-exact through small and large reads") {
+  struct Case {
+    uint32_t channels;
+    uint32_t bits;
+    uint32_t read_frames;
+  };
+  // Reads smaller than a block park the remainder; larger ones span several blocks.
+  for (const Case c : {Case{2, 16, 1000}, Case{1, 24, 10000}, Case{6, 16, 4096}}) {
+    const uint32_t frames = 10007;
+    const std::vector<int32_t> samples = Samples(frames * c.channels, c.bits);
+    const std::string path = TempPath("tomplayer_flac_decode.flac");
+    REQUIRE(Encode(path, samples, c.channels, c.bits, 44100, 4096));
+
+    FlacDecoder decoder;
+    std::string error;
+    REQUIRE(decoder.open(path, &error));
+    REQUIRE(decoder.info().sample_rate == 44100);
+    REQUIRE(decoder.info().channels == c.channels);
+    REQUIRE(decoder.info().total_frames == frames);
+    REQUIRE(decoder.bits_per_sample() == c.bits);
+    REQUIRE(decoder.max_block_frames() == 4096);
+
+    std::vector<float> out(static_cast<size_t>(frames) * c.channels);
+    uint32_t done = 0;
+    while (done < frames) {
+      const uint32_t got = decoder.read(out.data() + static_cast<size_t>(done) * c.channels,
+                                        std::min(c.read_frames, frames - done));
+      REQUIRE(got > 0);
+      done += got;
+    }
+    float spare[8];
+    REQUIRE(decoder.read(spare, 1) == 0);
+    REQUIRE(decoder.error().empty());
+    for (size_t i = 0; i < samples.size(); ++i) {
+      REQUIRE(out[i] == Scaled(samples[i], c.bits));
+    }
+    std::filesystem::remove(path);
+  }
+}
+
+TEST_CASE("FlacDecoder seeks sample-accurately") {
+  const uint32_t frames = 20000;
+  const std::vector<int32_t> samples = Samples(frames * 2, 16);
+  const std::string path = TempPath("tomplayer_flac_seek.flac");
+  REQUIRE(Encode(path, samples, 2, 16, 48000, 1152));
+
+  std::string error;
+  std::unique_ptr<tomplayer::decode::Decoder> decoder =
+      tomplayer::decode::OpenDecoder(path, &error);
+  REQUIRE(decoder);
+  std::vector<float> out(3000 * 2);
+  // Mid-block, block-aligned, backwards, and a read running off the end.
+  for (const int64_t target : {int64_t{12345}, int64_t{1152}, int64_t{7}, int64_t{19000}}) {
+    REQUIRE(decoder->seek(target));
+    const uint32_t expected = static_cast<uint32_t>(std::min<int64_t>(3000, frames - target));
+    REQUIRE(decoder->read(out.data(), 3000) == expected);
+    for (uint32_t i = 0; i < expected * 2; ++i) {
+      REQUIRE(out[i] == Scaled(samples[static_cast<size_t>(target) * 2 + i], 16));
+    }
+  }
+  REQUIRE(decoder->seek(frames));
+  REQUIRE(decoder->read(out.data(), 10) == 0);
+  REQUIRE(decoder->seek(0));
+  REQUIRE(decoder->read(out.data(), 10) == 10);
+  REQUIRE(out[0] == Scaled(samples[0], 16));
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("FlacDecoder rejects a stream that is not FLAC") {
+  const std::string path = TempPath("tomplayer_flac_bad.flac");
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "fLaC" << std::string(64, '\x7f');
+  }
+  std::string error;
+  REQUIRE_FALSE(tomplayer::decode::OpenDecoder(path, &error));
+  REQUIRE_FALSE(error.empty());
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("PlayerEngine seeks into a FLAC file and plays it to the end") {
+  using PlayerEngine = tomplayer::engine::PlayerEngine;
+  using tomplayer::audio::FileOutput;
+  const uint32_t frames = 48000;
+  const std::vector<int32_t> samples = Samples(frames * 2, 16);
+  const std::string source = TempPath("tomplayer_engine_source.flac");
+  REQUIRE(Encode(source, samples, 2, 16, 48000, 4096));
+
+  FileOutput::Config sink_config;
+  sink_config.path = TempPath("tomplayer_engine_flac_rendered.wav");
+  PlayerEngine::Config engine_config;
+  engine_config.memory_policy = tomplayer::platform::MemoryPolicy::Prefault;
+  {
+    PlayerEngine engine(engine_config, std::make_unique<FileOutput>(sink_config));
+    const auto state_is = [&](PlayerEngine::PlayerState state) {
+      return [&engine, state] { return engine.get_status().state == state; };
+    };
+    engine.open(source);
+    REQUIRE(WaitFor(state_is(PlayerEngine::PlayerState::Stopped), 2000ms));
+    // STREAMINFO's total sample count.
+    REQUIRE(engine.get_status().duration_seconds == 1.0);
+    // Seeking while stopped starts playback at the target frame.
+    engine.seek_seconds(0.5);
+    REQUIRE(WaitFor(state_is(PlayerEngine::PlayerState::Finished), 3000ms));
+  }
+
+  tomplayer::decode::WavDecoder rendered;
+  REQUIRE(rendered.open(sink_config.path, nullptr));
+  REQUIRE(rendered.info().total_frames == frames / 2);
+  std::vector<float> out(static_cast<size_t>(frames / 2) * 2);
+  REQUIRE(rendered.read(out.data(), frames / 2) == frames / 2);
+  for (size_t i = 0; i < out.size(); ++i) {
+    REQUIRE(out[i] == Scaled(samples[static_cast<size_t>(frames / 2) * 2 + i], 16));
+  }
+  std::filesystem::remove(source);
+  std::filesystem::remove(sink_config.path);
+}
@@ -0,0 +1,124 @@
+// LatencyController tests: synthetic counter samples drive the grow/shrink policy with
+// explicit time points, so every decision is deterministic.
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+#include "engine/latency_controller.h"
+
+namespace {
+using tomplayer::engine::LatencyController;
+using namespace std::chrono_literals;
+
+LatencyController::Config TestConfig() {
+  LatencyController::Config config;
+  config.enabled = true;
+  config.min_latency = 5ms;
+  config.max_latency = 40ms;
+  config.quiet_period = 1000ms;
+  config.evaluation_interval = 100ms;
+  return config;
+}
+
+// A decoder comfortably ahead: full ring, one second decoded per second.
+LatencyController::Sample Healthy(LatencyController::Clock::time_point at,
+                                  std::chrono::milliseconds elapsed) {
+  LatencyController::Sample sample;
+  sample.at = at + elapsed;
+  sample.decoded_frames = static_cast<uint64_t>(elapsed.count()) * 48;
+  sample.buffered_frames = 96000;
+  sample.capacity_frames = 96000;
+  return sample;
+}
+}  // namespace
+
+TEST_CASE("LatencyController shrinks while quiet and stops at the minimum") {
+  LatencyController controller(TestConfig());
+  REQUIRE(controller.target_frames() == 0);
+  const auto t0 = LatencyController::Clock::now();
+  controller.reset(48000, Healthy(t0, 0ms));
+  REQUIRE(controller.target_frames() == 1920);
+
+  // Quiet, but not for a whole quiet period yet.
+  REQUIRE_FALSE(controller.update(Healthy(t0, 500ms)));
+  REQUIRE(controller.update(Healthy(t0, 1000ms)));
+  REQUIRE(controller.target_frames() == 1440);
+
+  // Samples inside the evaluation interval are ignored entirely.
+  REQUIRE_FALSE(controller.update(Healthy(t0, 1050ms)));
+
+  std::chrono::milliseconds now = 1000ms;
+  for (int step = 0; step < 20; ++step) {
+    now += 1000ms;
+    controller.update(Healthy(t0, now));
+  }
+  REQUIRE(controller.target_frames() == 240);
+  REQUIRE_FALSE(controller.update(Healthy(t0, now + 1000ms)));
+  REQUIRE(controller.grow_count() == 0);
+}
+
+TEST_CASE("LatencyController doubles on stress up to the maximum") {
+  LatencyController controller(TestConfig());
+  const auto t0 = LatencyController::Clock::now();
+  controller.reset(48000, Healthy(t0, 0ms));
+  for (std::chrono::milliseconds now = 1000ms; now <= 8000ms; now += 1000ms) {
+    controller.update(Healthy(t0, now));
+  }
+  const uint32_t quiet_target = controller.target_frames();
+  REQUIRE(quiet_target < 1920);
+
+  LatencyController::Sample sample = Healthy(t0, 8200ms);
+  sample.underrun_wakes = 1;
+  REQUIRE(controller.update(sample));
+  REQUIRE(controller.target_frames() == quiet_target * 2);
+
+  // Each stress signal counts; the quiet period restarts after every one.
+  sample = Healthy(t0, 8400ms);
+  sample.underrun_wakes = 1;
+  sample.late_wakes = 3;
+  controller.update(sample);
+  sample = Healthy(t0, 8600ms);
+  sample.underrun_wakes = 1;
+  sample.late_wakes = 3;
+  sample.deadline_overruns = 1;
+  controller.update(sample);
+  REQUIRE(controller.target_frames() == 1920);
+
+  // Unchanged counters: quiet again, and a shrink one period after the last stress.
+  LatencyController::Sample calm = sample;
+  calm.at = t0 + 9500ms;
+  REQUIRE_FALSE(controller.update(calm));
+  calm.at = t0 + 9700ms;
+  REQUIRE(controller.update(calm));
+  REQUIRE(controller.target_frames() == 1440);
+}
+
+TEST_CASE("LatencyController treats a draining ring with slow decode as stress") {
+  LatencyController controller(TestConfig());
+  const auto t0 = LatencyController::Clock::now();
+  controller.reset(48000, Healthy(t0, 0ms));
+  controller.update(Healthy(t0, 1000ms));
+  REQUIRE(controller.target_frames() == 1440);
+
+  // Half real time, with the ring below a quarter full.
+  LatencyController::Sample slow = Healthy(t0, 1000ms);
+  slow.at = t0 + 1200ms;
+  slow.decoded_frames += 4800;
+  slow.buffered_frames = 20000;
+  REQUIRE(controller.update(slow));
+  REQUIRE(controller.target_frames() == 1920);
+
+  // The same throughput with a full ring is just the decoder blocking on space.
+  LatencyController::Sample blocked = slow;
+  blocked.at = t0 + 1400ms;
+  blocked.decoded_frames += 4800;
+  blocked.buffered_frames = 96000;
+  REQUIRE_FALSE(controller.update(blocked));
+  REQUIRE(controller.target_frames() == 1920);
+
+  // Resuming after a pause keeps the target and restarts the quiet period.
+  controller.rebase(Healthy(t0, 60000ms));
+  REQUIRE_FALSE(controller.update(Healthy(t0, 60500ms)));
+  REQUIRE(controller.target_frames() == 1920);
+}
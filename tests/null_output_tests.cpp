@@ -0,0 +1,244 @@
+// NullOutput tests: simulated device clock, counters, ring swaps, and the engine running
+// headless on top of it.
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "audio/null_output.h"
+#include "buffer/audio_ring_buffer.h"
+#include "engine/player_engine.h"
+#include "test_support.h"
+
+namespace {
+using tomplayer::audio::NullOutput;
+using namespace std::chrono_literals;
+using tomplayer::test::WaitFor;
+}  // namespace
+
+// Format accessors and start preconditions mirror WasapiOutput.
+TEST_CASE("NullOutput derives device format from its config") {
+  NullOutput::Config config;
+  config.sample_rate = 192000;
+  config.channels = 2;
+  config.period = 3ms;
+  NullOutput output(config);
+
+  REQUIRE(output.sample_format() == tomplayer::audio::SampleFormat::Unsupported);
+  REQUIRE_FALSE(output.start());
+  REQUIRE(output.init_default_device());
+  REQUIRE_FALSE(output.init_default_device());
+  REQUIRE(output.sample_rate() == 192000);
+  REQUIRE(output.channels() == 2);
+  REQUIRE(output.period_frames() == 576);
+  REQUIRE(output.buffer_frames() == 1152);
+  REQUIRE(output.sample_format() == tomplayer::audio::SampleFormat::Float32);
+
+  AudioRingBuffer mono(1024, 1);
+  output.set_ring_buffer(&mono);
+  REQUIRE_FALSE(output.start());
+
+  output.shutdown();
+  REQUIRE(output.sample_rate() == 0);
+  REQUIRE(output.buffer_frames() == 0);
+
+  NullOutput::Config invalid;
+  invalid.period = 0us;
+  NullOutput rejected(invalid);
+  REQUIRE_FALSE(rejected.init_default_device());
+}
+
+// Free-running: first cycle fills the device buffer, each later cycle refills one period.
+TEST_CASE("NullOutput free-running drains the ring and counts underruns") {
+  NullOutput::Config config;
+  config.sample_rate = 48000;
+  config.channels = 2;
+  config.period = 10ms;
+  config.free_running = true;
+  NullOutput output(config);
+  REQUIRE(output.init_default_device());
+
+  AudioRingBuffer ring(8192, 2);
+  std::vector<float> input(static_cast<size_t>(4800) * 2, 0.5f);
+  REQUIRE(ring.write_frames(input.data(), 4800) == 4800);
+  output.set_ring_buffer(&ring);
+
+  REQUIRE(output.start());
+  REQUIRE(WaitFor([&] { return output.rendered_frames_total() >= 9600; }, 2000ms));
+  output.stop();
+
+  const uint64_t rendered = output.rendered_frames_total();
+  REQUIRE(rendered == 960 + 480 * (output.render_cycle_count() - 1));
+  REQUIRE(ring.available_to_read_frames() == 0);
+  REQUIRE(output.underrun_frame_count() == rendered - 4800);
+  REQUIRE(output.underrun_wake_count() > 0);
+
+  output.reset_rendered_frames();
+  REQUIRE(output.rendered_frames_total() == 0);
+}
+
+// Real-time: the simulated clock paces consumption at roughly the sample rate.
+TEST_CASE("NullOutput real-time clock renders at the configured rate") {
+  NullOutput::Config config;
+  config.sample_rate = 48000;
+  config.channels = 2;
+  config.period = 5ms;
+  NullOutput output(config);
+  REQUIRE(output.init_default_device());
+  AudioRingBuffer ring(4096, 2);
+  output.set_ring_buffer(&ring);
+
+  const auto start = std::chrono::steady_clock::now();
+  REQUIRE(output.start());
+  std::this_thread::sleep_for(200ms);
+  output.stop();
+  const double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Never ahead of the clock by more than the device buffer; loose lower bound for slow CI.
+  const double rendered = static_cast<double>(output.rendered_frames_total());
+  REQUIRE(rendered <= elapsed * 48000.0 + output.buffer_frames());
+  REQUIRE(rendered >= 0.25 * 0.2 * 48000.0);
+
+  // Stopped: the device queue is dropped and the presentation delay no longer drains.
+  const auto& presentation = output.presentation_clock();
+  const uint64_t held = presentation.pending_frames(std::chrono::steady_clock::now());
+  REQUIRE(held <= output.buffer_frames());
+  REQUIRE(presentation.pending_frames(std::chrono::steady_clock::now() + 1s) == held);
+}
+
+// Adaptive latency: the fill cap never goes below the wake period or past the buffer.
+TEST_CASE("NullOutput clamps the fill cap to its period and buffer") {
+  NullOutput::Config config;
+  config.period = 5ms;
+  config.buffer_frames = 960;
+  NullOutput output(config);
+  REQUIRE(output.set_fill_frames(480) == 0);
+  REQUIRE(output.init_default_device());
+  REQUIRE(output.set_fill_frames(1) == output.period_frames());
+  REQUIRE(output.set_fill_frames(480) == 480);
+  REQUIRE(output.set_fill_frames(100000) == 960);
+}
+
+// Same RCU contract as WasapiOutput: swapping hands back the old ring, and a grace token
+// taken afterwards elapses once a cycle completes.
+TEST_CASE("NullOutput ring exchange honours render grace periods") {
+  NullOutput::Config config;
+  config.period = 1ms;
+  NullOutput output(config);
+  REQUIRE(output.init_default_device());
+  AudioRingBuffer first(4096, 2);
+  AudioRingBuffer second(4096, 2);
+  output.set_ring_buffer(&first);
+  REQUIRE(output.start());
+
+  REQUIRE(output.exchange_ring_buffer(&second) == &first);
+  const uint64_t token = output.render_grace_token();
+  REQUIRE(WaitFor([&] { return output.render_grace_period_elapsed(token); }, 2000ms));
+  output.stop();
+  REQUIRE(output.render_grace_period_elapsed(output.render_grace_token()));
+}
+
+// The whole engine state machine runs headless against the simulated device.
+TEST_CASE("PlayerEngine plays, seeks and stops on NullOutput") {
+  using PlayerEngine = tomplayer::engine::PlayerEngine;
+  PlayerEngine::Config engine_config;
+  engine_config.memory_policy = tomplayer::platform::MemoryPolicy::Prefault;
+  NullOutput::Config output_config;
+  output_config.period = 5ms;
+  PlayerEngine engine(engine_config, std::make_unique<NullOutput>(output_config));
+
+  const auto state_is = [&](PlayerEngine::PlayerState state) {
+    return [&engine, state] { return engine.get_status().state == state; };
+  };
+
+  engine.play();
+  REQUIRE(WaitFor(state_is(PlayerEngine::PlayerState::Playing), 2000ms));
+  REQUIRE(engine.get_status().sample_rate_hz == 48000);
+  // Default deadline is half the 10 ms device buffer.
+  REQUIRE(engine.get_status().render_timing.deadline == 5ms);
+  REQUIRE(WaitFor([&] { return engine.get_status().position_seconds > 0.02; }, 2000ms));
+  // The audible position trails the ring by what sits in the 10 ms device buffer.
+  REQUIRE(WaitFor([&] { return engine.get_status().presentation_delay_seconds > 0.0; }, 2000ms));
+  REQUIRE(engine.get_status().presentation_delay_seconds <= 0.010);
+
+  engine.seek_seconds(5.0);
+  REQUIRE(WaitFor([&] { return engine.get_status().position_seconds >= 5.0; }, 2000ms));
+  REQUIRE(WaitFor(state_is(PlayerEngine::PlayerState::Playing), 2000ms));
+
+  REQUIRE(engine.get_status().render_timing.callback.count > 0);
+  // Whether the OS granted them depends on privileges; the requests are always recorded.
+  REQUIRE(engine.get_status().render_thread.requested == tomplayer::platform::ThreadClass::RealTime);
+  REQUIRE(engine.get_status().decode_thread.requested == tomplayer::platform::ThreadClass::Elevated);
+
+  engine.stop();
+  REQUIRE(WaitFor(state_is(PlayerEngine::PlayerState::Stopped), 2000ms));
+  engine.quit();
+}
+
+// The decoder keeps running through seeks, so each epoch must start at its own target:
+// a stale target would tag the epoch's first frames with the wrong source position.
+TEST_CASE("PlayerEngine seeks repeatedly while playing") {
+  using PlayerEngine = tomplayer::engine::PlayerEngine;
+  PlayerEngine::Config engine_config;
+  engine_config.memory_policy = tomplayer::platform::MemoryPolicy::Prefault;
+  NullOutput::Config output_config;
+  output_config.period = 5ms;
+  PlayerEngine engine(engine_config, std::make_unique<NullOutput>(output_config));
+
+  engine.play();
+  REQUIRE(WaitFor([&] { return engine.get_status().state == PlayerEngine::PlayerState::Playing; },
+                  2000ms));
+  // Targets far apart: a position near the wrong one can never pass for the right one.
+  const double targets[] = {30.0, 2.0, 60.0, 7.0, 45.0, 0.0, 90.0, 15.0};
+  for (int round = 0; round < 3; ++round) {
+    for (const double target : targets) {
+      engine.seek_seconds(target);
+      // Past the seek target means the render thread reached this epoch's first marker.
+      REQUIRE(WaitFor(
+          [&] {
+            const double position = engine.get_status().position_seconds;
+            return position > target + 0.01 && position < target + 1.0;
+          },
+          2000ms));
+      const PlayerEngine::Status status = engine.get_status();
+      const auto target_frame = static_cast<int64_t>(target * 48000.0);
+      // Decode-ahead is bounded by the 2 s ring.
+      REQUIRE(status.decoded_frame_cursor >= target_frame);
+      REQUIRE(status.decoded_frame_cursor <= target_frame + 3 * 48000);
+    }
+  }
+  engine.quit();
+}
+
+TEST_CASE("PlayerEngine adapts the device queue within its bounds") {
+  using PlayerEngine = tomplayer::engine::PlayerEngine;
+  PlayerEngine::Config engine_config;
+  engine_config.memory_policy = tomplayer::platform::MemoryPolicy::Prefault;
+  engine_config.adaptive_latency.enabled = true;
+  engine_config.adaptive_latency.min_latency = 5ms;
+  engine_config.adaptive_latency.max_latency = 40ms;
+  engine_config.adaptive_latency.quiet_period = 100ms;
+  NullOutput::Config output_config;
+  output_config.period = 5ms;
+  output_config.buffer_frames = 1920;
+  PlayerEngine engine(engine_config, std::make_unique<NullOutput>(output_config));
+
+  engine.play();
+  REQUIRE(WaitFor([&] { return engine.get_status().state == PlayerEngine::PlayerState::Playing; },
+                  2000ms));
+  // Starts at the 40 ms buffer and shrinks while quiet; stress may grow it again, but
+  // never outside [one 5 ms period, the buffer].
+  REQUIRE(WaitFor([&] { return engine.get_status().output_latency_seconds < 0.040; }, 5000ms));
+  for (int i = 0; i < 20; ++i) {
+    const PlayerEngine::Status status = engine.get_status();
+    REQUIRE(status.output_latency_seconds >= 0.005);
+    REQUIRE(status.output_latency_seconds <= 0.040);
+    REQUIRE(status.render_timing.wake_limit.count() > 0);
+    std::this_thread::sleep_for(10ms);
+  }
+  engine.quit();
+}
@@ -0,0 +1,159 @@
+// Planar ring buffer and interleave kernel tests: layout conversions, wrap-around, SPSC safety.
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "buffer/interleave.h"
+#include "buffer/planar_ring_buffer.h"
+
+namespace {
+constexpr uint32_t kChannelStride = 1000;
+
+std::vector<float> MakeInterleaved(uint32_t frames, uint32_t channels, uint32_t base) {
+  std::vector<float> data(static_cast<size_t>(frames) * channels);
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+      data[static_cast<size_t>(frame) * channels + ch] =
+          static_cast<float>(base + frame + ch * kChannelStride);
+    }
+  }
+  return data;
+}
+}  // namespace
+
+// Covers the SIMD paths (2 and 4 channels), scalar channel counts, tails and unaligned planes.
+TEST_CASE("Interleave kernels round-trip every channel count and tail length") {
+  const uint32_t channels = GENERATE(1u, 2u, 3u, 4u, 6u, 8u);
+  const uint32_t frames = GENERATE(0u, 1u, 3u, 4u, 7u, 64u, 67u);
+  const uint32_t offset = GENERATE(0u, 1u);
+
+  const std::vector<float> interleaved = MakeInterleaved(frames, channels, 1);
+  std::vector<std::vector<float>> storage(channels, std::vector<float>(frames + offset, -1.0f));
+  std::vector<float*> planes(channels);
+  for (uint32_t ch = 0; ch < channels; ++ch) {
+    planes[ch] = storage[ch].data() + offset;
+  }
+
+  tomplayer::buffer::Deinterleave(interleaved.data(), channels, frames, planes.data());
+  for (uint32_t ch = 0; ch < channels; ++ch) {
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      REQUIRE(planes[ch][frame] == static_cast<float>(1 + frame + ch * kChannelStride));
+    }
+  }
+
+  std::vector<const float*> const_planes(planes.begin(), planes.end());
+  std::vector<float> output(interleaved.size() + 1, -1.0f);
+  tomplayer::buffer::Interleave(const_planes.data(), channels, frames, output.data() + offset);
+  REQUIRE(std::vector<float>(output.begin() + offset,
+                             output.begin() + offset + interleaved.size()) == interleaved);
+}
+
+// Interleaved in, planar out, and back, across the end of storage.
+TEST_CASE("PlanarAudioRingBuffer converts layouts across wrap-around") {
+  const uint32_t channels = GENERATE(1u, 2u, 4u, 5u);
+  PlanarAudioRingBuffer buffer(16, channels);
+  REQUIRE(buffer.channels() == channels);
+
+  std::vector<float> scratch(static_cast<size_t>(12) * channels);
+  REQUIRE(buffer.write_interleaved(MakeInterleaved(12, channels, 0).data(), 12) == 12);
+  REQUIRE(buffer.read_interleaved(scratch.data(), 12) == 12);
+
+  // The next 10 frames start at index 12, so both the write and the reads below wrap.
+  const std::vector<float> input = MakeInterleaved(10, channels, 500);
+  REQUIRE(buffer.write_interleaved(input.data(), 10) == 10);
+
+  const PlanarAudioRingBuffer::ReadRegion region = buffer.acquire_read(10);
+  REQUIRE(region.frames == 10);
+  REQUIRE(region.first_frames == 4);
+  for (uint32_t ch = 0; ch < channels; ++ch) {
+    REQUIRE(region.first(ch)[0] == static_cast<float>(500 + ch * kChannelStride));
+    REQUIRE(region.second(ch).size() == 6);
+    REQUIRE(region.second(ch)[5] == static_cast<float>(509 + ch * kChannelStride));
+  }
+  // Nothing committed yet: a planar read sees the same frames.
+  std::vector<std::vector<float>> planes(channels, std::vector<float>(10));
+  std::vector<float*> plane_ptrs(channels);
+  for (uint32_t ch = 0; ch < channels; ++ch) {
+    plane_ptrs[ch] = planes[ch].data();
+  }
+  REQUIRE(buffer.read_planar(plane_ptrs.data(), 3) == 3);
+  REQUIRE(planes[channels - 1][2] == static_cast<float>(502 + (channels - 1) * kChannelStride));
+
+  std::vector<float> output(static_cast<size_t>(7) * channels);
+  REQUIRE(buffer.read_interleaved(output.data(), 7) == 7);
+  REQUIRE(output == std::vector<float>(input.begin() + 3 * channels, input.end()));
+  REQUIRE(buffer.available_to_read_frames() == 0);
+  REQUIRE(buffer.invariant_violation_count() == 0);
+}
+
+// Partial writes and empty reads are counted like the interleaved ring.
+TEST_CASE("PlanarAudioRingBuffer counts overruns and underruns") {
+  PlanarAudioRingBuffer buffer(8, 2, PlanarAudioRingBuffer::CapacityMode::PowerOfTwo);
+  REQUIRE(buffer.capacity_frames() == 8);
+  REQUIRE(buffer.uses_index_mask());
+
+  const std::vector<float> input = MakeInterleaved(10, 2, 0);
+  REQUIRE(buffer.write_interleaved(input.data(), 10) == 8);
+  REQUIRE(buffer.overrun_count() == 1);
+  REQUIRE(buffer.available_to_write_frames() == 0);
+
+  std::vector<float> output(input.size());
+  REQUIRE(buffer.read_interleaved(output.data(), 10) == 8);
+  REQUIRE(buffer.underrun_count() == 1);
+  REQUIRE(buffer.read_interleaved(output.data(), 1) == 0);
+  REQUIRE(buffer.underrun_count() == 2);
+
+  buffer.reset();
+  REQUIRE(buffer.underrun_count() == 0);
+  REQUIRE(buffer.available_to_write_frames() == 8);
+}
+
+// Planar producer, interleaving consumer (the render path), with odd chunk sizes.
+TEST_CASE("PlanarAudioRingBuffer SPSC stream stays ordered") {
+  constexpr uint32_t channels = 2;
+  constexpr uint32_t total_frames = 200000;
+  PlanarAudioRingBuffer buffer(1024, channels);
+
+  std::thread producer([&]() {
+    std::vector<float> left(97);
+    std::vector<float> right(97);
+    uint32_t sent = 0;
+    while (sent < total_frames) {
+      const uint32_t frames = std::min<uint32_t>(97, total_frames - sent);
+      for (uint32_t i = 0; i < frames; ++i) {
+        left[i] = static_cast<float>(sent + i);
+        right[i] = -static_cast<float>(sent + i);
+      }
+      const float* planes[channels] = {left.data(), right.data()};
+      if (!buffer.wait_writable(frames, std::chrono::seconds(5))) {
+        break;
+      }
+      sent += buffer.write_planar(planes, frames);
+    }
+  });
+
+  std::vector<float> chunk(static_cast<size_t>(61) * channels);
+  uint32_t received = 0;
+  bool ordered = true;
+  while (received < total_frames && ordered) {
+    if (!buffer.wait_readable(1, std::chrono::seconds(5))) {
+      break;
+    }
+    const uint32_t frames = buffer.read_interleaved(chunk.data(), 61);
+    for (uint32_t i = 0; i < frames; ++i) {
+      ordered = ordered && chunk[2 * i] == static_cast<float>(received + i) &&
+                chunk[2 * i + 1] == -static_cast<float>(received + i);
+    }
+    received += frames;
+  }
+  producer.join();
+
+  REQUIRE(ordered);
+  REQUIRE(received == total_frames);
+  REQUIRE(buffer.invariant_violation_count() == 0);
+}
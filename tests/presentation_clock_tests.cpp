@@ -0,0 +1,58 @@
+// PresentationClock tests: the device queue depth published per render cycle and its
+// steady_clock interpolation, with explicit time points so results are exact.
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+
+#include "audio/presentation_clock.h"
+
+namespace {
+using tomplayer::audio::PresentationClock;
+using namespace std::chrono_literals;
+}  // namespace
+
+TEST_CASE("PresentationClock drains the queue at the sample rate between cycles") {
+  PresentationClock clock;
+  REQUIRE(clock.pending_frames(PresentationClock::Clock::now()) == 0);
+
+  clock.configure(48000, 96);
+  const auto t0 = PresentationClock::Clock::now();
+  clock.restart(t0);
+  REQUIRE(clock.pending_frames(t0 + 1s) == 0);
+
+  clock.begin_update();
+  REQUIRE(clock.read_retry(clock.read_begin()));
+  clock.end_update(t0, 480);
+  const uint32_t sequence = clock.read_begin();
+  REQUIRE_FALSE(clock.read_retry(sequence));
+
+  // 480 queued plus 96 frames of pipeline latency, one frame per 1/48000 s.
+  REQUIRE(clock.pending_frames(t0) == 576);
+  REQUIRE(clock.pending_frames(t0 - 1ms) == 576);
+  REQUIRE(clock.pending_frames(t0 + 1ms) == 528);
+  REQUIRE(clock.pending_frames(t0 + 11ms) == 48);
+  REQUIRE(clock.pending_frames(t0 + 12ms) == 0);
+  REQUIRE(clock.pending_frames(t0 + 1h) == 0);
+
+  // A new cycle re-anchors and invalidates readers of the previous snapshot.
+  clock.begin_update();
+  clock.end_update(t0 + 5ms, 240);
+  REQUIRE(clock.read_retry(sequence));
+  REQUIRE(clock.pending_frames(t0 + 5ms) == 336);
+}
+
+TEST_CASE("PresentationClock holds the delay while stopped") {
+  PresentationClock clock;
+  clock.configure(48000, 0);
+  const auto t0 = PresentationClock::Clock::now();
+  clock.restart(t0);
+  clock.begin_update();
+  clock.end_update(t0, 960);
+
+  clock.freeze(t0 + 10ms);
+  REQUIRE(clock.pending_frames(t0 + 10ms) == 480);
+  REQUIRE(clock.pending_frames(t0 + 1h) == 480);
+
+  clock.restart(t0 + 2h);
+  REQUIRE(clock.pending_frames(t0 + 2h) == 0);
+}
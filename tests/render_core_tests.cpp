@@ -0,0 +1,293 @@
+// RenderCore tests: the padding -> GetBuffer -> fill -> ReleaseBuffer cycle every device
+// backend ships, driven through a fake DeviceBufferApi so it runs on any platform.
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "audio/render_core.h"
+#include "audio/ring_render.h"
+#include "buffer/audio_ring_buffer.h"
+
+namespace {
+using tomplayer::audio::ConsumeRingBufferFloat;
+using tomplayer::audio::DeviceBufferApi;
+using tomplayer::audio::DitherMode;
+using tomplayer::audio::RenderCore;
+using tomplayer::audio::RenderCycle;
+using tomplayer::audio::SampleFormat;
+
+// Device buffer of buffer_frames frames that grants at most max_grant contiguous frames per
+// GetBuffer (a wrapping mmap area) and records every release.
+struct FakeDevice {
+  struct Release {
+    uint32_t frames = 0;
+    bool silent = false;
+  };
+
+  FakeDevice(uint32_t buffer_frames, size_t frame_bytes)
+      : memory(buffer_frames * frame_bytes, 0xAB), frame_bytes(frame_bytes) {}
+
+  std::vector<uint8_t> memory;
+  size_t frame_bytes = 0;
+  size_t write_frame = 0;
+  uint32_t padding = 0;
+  uint32_t max_grant = UINT32_MAX;
+  bool fail_padding = false;
+  bool fail_release = false;
+  std::vector<Release> releases;
+
+  static bool GetPaddingThunk(void* context, uint32_t* padding) {
+    auto* self = static_cast<FakeDevice*>(context);
+    *padding = self->padding;
+    return !self->fail_padding;
+  }
+
+  static bool GetBufferThunk(void* context, uint32_t frames, uint8_t** data, uint32_t* granted) {
+    auto* self = static_cast<FakeDevice*>(context);
+    *data = self->memory.data() + self->write_frame * self->frame_bytes;
+    *granted = frames < self->max_grant ? frames : self->max_grant;
+    return true;
+  }
+
+  static bool ReleaseBufferThunk(void* context, uint32_t frames, bool silent) {
+    auto* self = static_cast<FakeDevice*>(context);
+    if (self->fail_release) {
+      return false;
+    }
+    self->releases.push_back({frames, silent});
+    self->write_frame += frames;
+    return true;
+  }
+
+  DeviceBufferApi api() { return {this, &GetPaddingThunk, &GetBufferThunk, &ReleaseBufferThunk}; }
+};
+}  // namespace
+
+TEST_CASE("RenderCore fills the writable space and zero-fills an underrun") {
+  RenderCore core;
+  core.configure(SampleFormat::Float32, 2, 8, 48000);
+  core.prepare(DitherMode::Tpdf);
+  AudioRingBuffer ring(16, 2);
+  const std::array<float, 6> input = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f};
+  REQUIRE(ring.write_frames(input.data(), 3) == 3);
+  core.set_ring_buffer(&ring);
+
+  FakeDevice device(8, 2 * sizeof(float));
+  device.padding = 2;
+  const RenderCycle cycle = core.render(device.api());
+
+  REQUIRE_FALSE(cycle.device_error);
+  REQUIRE(cycle.frames_written == 6);
+  REQUIRE(cycle.frames_read == 3);
+  REQUIRE(device.releases.size() == 1);
+  REQUIRE(device.releases[0].frames == 6);
+  REQUIRE_FALSE(device.releases[0].silent);
+  std::array<float, 12> written{};
+  std::memcpy(written.data(), device.memory.data(), sizeof(written));
+  for (size_t i = 0; i < input.size(); ++i) {
+    REQUIRE(written[i] == input[i]);
+  }
+  for (size_t i = input.size(); i < written.size(); ++i) {
+    REQUIRE(written[i] == 0.0f);
+  }
+  REQUIRE(core.rendered_frames_total() == 6);
+  REQUIRE(core.underrun_wake_count() == 1);
+  REQUIRE(core.underrun_frame_count() == 3);
+
+  // A full device buffer is left alone.
+  device.padding = 8;
+  REQUIRE(core.render(device.api()).frames_written == 0);
+  REQUIRE(device.releases.size() == 1);
+  core.reset_rendered_frames();
+  REQUIRE(core.rendered_frames_total() == 0);
+}
+
+// ALSA mmap areas wrap: one cycle spans several GetBuffer/ReleaseBuffer pairs.
+TEST_CASE("RenderCore converts across wrapped blocks and counts one underrun per cycle") {
+  RenderCore core;
+  core.configure(SampleFormat::Pcm16, 1, 8, 48000);
+  core.prepare(DitherMode::None);
+  AudioRingBuffer ring(16, 1);
+  const std::array<float, 8> input = {0.5f, -0.5f, 0.25f, -0.25f, 1.0f, -1.0f, 0.0f, 0.125f};
+  REQUIRE(ring.write_frames(input.data(), 8) == 8);
+  core.set_ring_buffer(&ring);
+
+  FakeDevice device(16, sizeof(int16_t));
+  device.max_grant = 3;
+  RenderCycle cycle = core.render(device.api());
+  REQUIRE(cycle.frames_written == 8);
+  REQUIRE(cycle.frames_read == 8);
+  REQUIRE(device.releases.size() == 3);
+  REQUIRE(device.releases[0].frames == 3);
+  REQUIRE(device.releases[2].frames == 2);
+  std::array<int16_t, 8> samples{};
+  std::memcpy(samples.data(), device.memory.data(), sizeof(samples));
+  const std::array<int16_t, 8> expected = {16384, -16384, 8192, -8192, 32767, -32768, 0, 4096};
+  REQUIRE(samples == expected);
+  REQUIRE(core.underrun_wake_count() == 0);
+
+  // Empty ring: every block is silent, and the short read is one underrun wake.
+  device.padding = 0;
+  device.write_frame = 8;
+  cycle = core.render(device.api());
+  REQUIRE(cycle.frames_written == 8);
+  REQUIRE(cycle.frames_read == 0);
+  REQUIRE(device.releases.size() == 6);
+  REQUIRE(device.releases[3].silent);
+  REQUIRE(device.releases[5].silent);
+  REQUIRE(core.underrun_wake_count() == 1);
+  REQUIRE(core.underrun_frame_count() == 8);
+  REQUIRE(core.rendered_frames_total() == 16);
+}
+
+TEST_CASE("RenderCore renders silence for a missing or mismatched ring") {
+  RenderCore core;
+  core.configure(SampleFormat::Float32, 2, 4, 48000);
+  FakeDevice device(4, 2 * sizeof(float));
+
+  // No ring: silence, counted as rendered clock but not as underrun.
+  RenderCycle cycle = core.render(device.api());
+  REQUIRE(cycle.frames_written == 4);
+  REQUIRE(device.releases.back().silent);
+  REQUIRE(std::all_of(device.memory.begin(), device.memory.end(), [](uint8_t b) { return b == 0; }));
+
+  AudioRingBuffer mono(8, 1);
+  const std::array<float, 4> input = {1.0f, 1.0f, 1.0f, 1.0f};
+  REQUIRE(mono.write_frames(input.data(), 4) == 4);
+  core.set_ring_buffer(&mono);
+  device.write_frame = 0;
+  cycle = core.render(device.api());
+  REQUIRE(cycle.frames_read == 0);
+  REQUIRE(device.releases.back().silent);
+  REQUIRE(mono.available_to_read_frames() == 4);
+  REQUIRE(core.underrun_wake_count() == 0);
+  REQUIRE(core.rendered_frames_total() == 8);
+
+  // RCU swap: the previous ring comes back; a completed cycle ends the grace period.
+  AudioRingBuffer stereo(8, 2);
+  REQUIRE(core.exchange_ring_buffer(&stereo) == &mono);
+  REQUIRE(core.ring_buffer() == &stereo);
+  const uint64_t token = core.render_grace_token();
+  REQUIRE_FALSE(core.cycle_completed_since(token));
+  core.complete_cycle();
+  REQUIRE(core.cycle_completed_since(token));
+  REQUIRE(core.cycles_completed() == 1);
+}
+
+TEST_CASE("RenderCore reports device failures without advancing the clock") {
+  RenderCore core;
+  core.configure(SampleFormat::Float32, 2, 4, 48000);
+  AudioRingBuffer ring(8, 2);
+  core.set_ring_buffer(&ring);
+  FakeDevice device(4, 2 * sizeof(float));
+
+  device.fail_padding = true;
+  RenderCycle cycle = core.render(device.api());
+  REQUIRE(cycle.device_error);
+  REQUIRE(cycle.frames_written == 0);
+
+  device.fail_padding = false;
+  device.fail_release = true;
+  cycle = core.render(device.api());
+  REQUIRE(cycle.device_error);
+  REQUIRE(core.rendered_frames_total() == 0);
+
+  // An unknown device format is released as silence and never counted.
+  RenderCore unsupported;
+  unsupported.configure(SampleFormat::Unsupported, 2, 4, 48000);
+  unsupported.set_ring_buffer(&ring);
+  device.fail_release = false;
+  cycle = unsupported.render(device.api());
+  REQUIRE_FALSE(cycle.device_error);
+  REQUIRE(cycle.frames_written == 0);
+  REQUIRE(device.releases.size() == 1);
+  REQUIRE(device.releases[0].silent);
+  REQUIRE(unsupported.rendered_frames_total() == 0);
+}
+
+TEST_CASE("RenderCore publishes the ring audio queued in the device") {
+  RenderCore core;
+  core.configure(SampleFormat::Float32, 2, 8, 48000);
+  core.prepare(DitherMode::None);
+  AudioRingBuffer ring(16, 2);
+  const std::array<float, 6> input = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f};
+  REQUIRE(ring.write_frames(input.data(), 3) == 3);
+  core.set_ring_buffer(&ring);
+  FakeDevice device(8, 2 * sizeof(float));
+  // A time before any anchor reads the published depth without interpolation.
+  const tomplayer::audio::PresentationClock::Clock::time_point before{};
+
+  // 2 frames already queued, 3 frames of audio then 3 of silence written behind them.
+  device.padding = 2;
+  core.render(device.api());
+  REQUIRE(core.presentation_clock().pending_frames(before) == 5);
+
+  // Underrun: 3 more silent frames; the earlier silent tail has partly played.
+  device.padding = 5;
+  device.write_frame = 0;
+  core.render(device.api());
+  REQUIRE(core.presentation_clock().pending_frames(before) == 2);
+
+  // Only silence left in the device.
+  device.padding = 4;
+  device.write_frame = 0;
+  core.render(device.api());
+  REQUIRE(core.presentation_clock().pending_frames(before) == 0);
+
+  core.prepare(DitherMode::None);
+  REQUIRE(core.presentation_clock().pending_frames(before) == 0);
+}
+
+TEST_CASE("RenderCore tops the device up to the fill limit only") {
+  RenderCore core;
+  core.configure(SampleFormat::Float32, 2, 8, 48000);
+  core.prepare(DitherMode::None);
+  FakeDevice device(8, 2 * sizeof(float));
+
+  core.set_fill_limit(5);
+  device.padding = 2;
+  REQUIRE(core.render(device.api()).frames_written == 3);
+  device.padding = 6;
+  device.write_frame = 0;
+  REQUIRE(core.render(device.api()).frames_written == 0);
+
+  // A limit past the buffer is the buffer; 0 restores it.
+  core.set_fill_limit(100);
+  device.padding = 2;
+  REQUIRE(core.render(device.api()).frames_written == 6);
+  core.set_fill_limit(0);
+  device.write_frame = 0;
+  REQUIRE(core.render(device.api()).frames_written == 6);
+}
+
+// Validates ring-buffer consumption zero-fills missing frames on underrun.
+TEST_CASE("ConsumeRingBufferFloat zero-fills tail on underrun") {
+  const uint32_t channels = 2;
+  AudioRingBuffer buffer(4, channels);
+  std::array<float, 4> input = {1.0f, 2.0f, 3.0f, 4.0f};
+  std::array<float, 8> output{};
+  std::atomic<uint64_t> underrun_wakes{0};
+  std::atomic<uint64_t> underrun_frames{0};
+
+  REQUIRE(buffer.write_frames(input.data(), 2) == 2);
+
+  const uint32_t frames_read = ConsumeRingBufferFloat(
+      &buffer, output.data(), 4, channels, &underrun_wakes, &underrun_frames);
+
+  REQUIRE(frames_read == 2);
+  REQUIRE(output[0] == 1.0f);
+  REQUIRE(output[1] == 2.0f);
+  REQUIRE(output[2] == 3.0f);
+  REQUIRE(output[3] == 4.0f);
+  REQUIRE(output[4] == 0.0f);
+  REQUIRE(output[5] == 0.0f);
+  REQUIRE(output[6] == 0.0f);
+  REQUIRE(output[7] == 0.0f);
+  REQUIRE(underrun_wakes.load() == 1);
+  REQUIRE(underrun_frames.load() == 2);
+}
@@ -0,0 +1,111 @@
+// RenderTiming tests: histogram bucketing and percentiles, deadline overruns, and the
+// wake-interval jitter a NullOutput render thread reports.
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "audio/null_output.h"
+#include "audio/render_timing.h"
+#include "buffer/audio_ring_buffer.h"
+
+namespace {
+using tomplayer::audio::RenderTiming;
+using tomplayer::audio::TimingHistogram;
+using namespace std::chrono_literals;
+}  // namespace
+
+TEST_CASE("TimingHistogram reports percentiles within one sub-bucket") {
+  TimingHistogram histogram;
+  REQUIRE(histogram.summarize().count == 0);
+  REQUIRE(histogram.summarize().p99 == 0ns);
+
+  // 1..1000 us: p50 = 500 us, p99 = 990 us, p99.9 = 999 us.
+  for (int64_t us = 1; us <= 1000; ++us) {
+    histogram.record(std::chrono::microseconds(us));
+  }
+  const tomplayer::audio::TimingSummary summary = histogram.summarize();
+  REQUIRE(summary.count == 1000);
+  REQUIRE(summary.max == 1000us);
+  REQUIRE(summary.p50 >= 500us);
+  REQUIRE(summary.p50 <= 500us * 1.125);
+  REQUIRE(summary.p99 >= 990us);
+  REQUIRE(summary.p99 <= 1000us);
+  REQUIRE(summary.p999 >= 999us);
+  REQUIRE(summary.p999 <= summary.max);
+
+  // Small values are exact; negative durations clamp to 0; huge ones saturate.
+  histogram.reset();
+  histogram.record(7ns);
+  histogram.record(-5ns);
+  REQUIRE(histogram.summarize().count == 2);
+  REQUIRE(histogram.summarize().max == 7ns);
+  REQUIRE(histogram.summarize().p50 == 0ns);
+  histogram.record(std::chrono::hours(2));
+  REQUIRE(histogram.summarize().max == std::chrono::hours(2));
+  REQUIRE(histogram.summarize().p999 == std::chrono::hours(2));
+}
+
+TEST_CASE("RenderTiming records intervals, callback time and deadline overruns") {
+  RenderTiming timing;
+  timing.set_deadline(2ms);
+  REQUIRE(timing.deadline() == 2ms);
+  timing.set_wake_limit(8ms);
+
+  const auto t0 = RenderTiming::Clock::now();
+  timing.restart();
+  timing.begin_callback(t0);
+  timing.end_callback(t0, t0 + 500us);
+  timing.begin_callback(t0 + 10ms);
+  timing.end_callback(t0 + 10ms, t0 + 13ms);
+  // A stop/start gap is not jitter.
+  timing.restart();
+  timing.begin_callback(t0 + 1000ms);
+  timing.end_callback(t0 + 1000ms, t0 + 1001ms);
+
+  tomplayer::audio::RenderTimingReport report = timing.report();
+  REQUIRE(report.wake_interval.count == 1);
+  REQUIRE(report.wake_interval.max == 10ms);
+  REQUIRE(report.callback.count == 3);
+  REQUIRE(report.callback.max == 3ms);
+  REQUIRE(report.deadline_overruns == 1);
+  REQUIRE(report.deadline == 2ms);
+  REQUIRE(report.late_wakes == 1);
+  REQUIRE(report.wake_limit == 8ms);
+
+  timing.set_deadline(0us);
+  timing.begin_callback(t0 + 1010ms);
+  timing.end_callback(t0 + 1010ms, t0 + 1100ms);
+  REQUIRE(timing.report().deadline_overruns == 1);
+  timing.reset();
+  report = timing.report();
+  REQUIRE(report.callback.count == 0);
+  REQUIRE(report.wake_interval.count == 0);
+  REQUIRE(report.deadline_overruns == 0);
+  REQUIRE(report.late_wakes == 0);
+}
+
+// The simulated device wakes once per period, so the median interval sits near it.
+TEST_CASE("NullOutput reports wake jitter and callback time") {
+  tomplayer::audio::NullOutput::Config config;
+  config.period = 5ms;
+  tomplayer::audio::NullOutput output(config);
+  REQUIRE(output.init_default_device());
+  AudioRingBuffer ring(4096, 2);
+  output.set_ring_buffer(&ring);
+
+  REQUIRE(output.start());
+  std::this_thread::sleep_for(200ms);
+  output.stop();
+
+  const tomplayer::audio::RenderTimingReport report = output.render_timing().report();
+  REQUIRE(report.callback.count >= 10);
+  REQUIRE(report.wake_interval.count == report.callback.count - 1);
+  REQUIRE(report.wake_interval.p50 >= 4ms);
+  REQUIRE(report.wake_interval.p50 <= 20ms);
+  REQUIRE(report.callback.p50 < 5ms);
+  REQUIRE(report.wake_interval.p50 <= report.wake_interval.p99);
+  REQUIRE(report.wake_interval.p99 <= report.wake_interval.p999);
+  REQUIRE(report.wake_interval.p999 <= report.wake_interval.max);
+}
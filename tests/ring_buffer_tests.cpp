@@ -1,16 +1,22 @@
 // Ring buffer unit tests validate correctness, interleaving, and SPSC safety.
+#include <catch2/catch_template_test_macros.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <cmath>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "buffer/audio_ring_buffer.h"
 
 namespace {
 constexpr uint32_t kChannelStride = 1000;
+using CapacityMode = AudioRingBuffer::CapacityMode;
 
 std::vector<float> MakePattern(uint32_t frames, uint32_t base) {
   constexpr uint32_t channels = 2;
@@ -23,6 +29,18 @@ std::vector<float> MakePattern(uint32_t frames, uint32_t base) {
   }
   return data;
 }
+
+template <typename SampleT>
+std::vector<SampleT> MakeTypedPattern(uint32_t frames, uint32_t channels, uint32_t base) {
+  std::vector<SampleT> data(static_cast<size_t>(frames) * channels);
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+      data[static_cast<size_t>(frame) * channels + ch] =
+          static_cast<SampleT>(base + frame + ch * kChannelStride);
+    }
+  }
+  return data;
+}
 }  // namespace
 
 // Verifies round-trip write/read preserves interleaved data exactly.
@@ -42,22 +60,27 @@ TEST_CASE("AudioRingBuffer round-trip preserves samples") {
 // Forces wrap-around by interleaving reads/writes across the end boundary.
 TEST_CASE("AudioRingBuffer wrap-around preserves order") {
   constexpr uint32_t channels = 2;
-  AudioRingBuffer buffer(8, channels);
+  const CapacityMode mode = GENERATE(CapacityMode::Exact, CapacityMode::PowerOfTwo);
+  // Exact keeps 6 (modulo indexing); PowerOfTwo rounds it up to 8 (mask indexing).
+  AudioRingBuffer buffer(6, channels, mode);
+  const uint32_t capacity = buffer.capacity_frames();
+  REQUIRE(capacity == (mode == CapacityMode::Exact ? 6u : 8u));
+  REQUIRE(buffer.uses_index_mask() == (mode == CapacityMode::PowerOfTwo));
 
-  auto first = MakePattern(6, 0);   // frames 0..5
-  auto second = MakePattern(6, 6);  // frames 6..11
+  auto first = MakePattern(capacity - 2, 0);  // frames 0..capacity-3
+  auto second = MakePattern(6, capacity - 2);
 
-  REQUIRE(buffer.write_frames(first.data(), 6) == 6);
+  REQUIRE(buffer.write_frames(first.data(), capacity - 2) == capacity - 2);
 
   std::vector<float> temp(static_cast<size_t>(4) * channels);
   REQUIRE(buffer.read_frames(temp.data(), 4) == 4);  // consume frames 0..3
 
   REQUIRE(buffer.write_frames(second.data(), 6) == 6);
 
-  std::vector<float> output(static_cast<size_t>(8) * channels);
-  REQUIRE(buffer.read_frames(output.data(), 8) == 8);
+  std::vector<float> output(static_cast<size_t>(capacity) * channels);
+  REQUIRE(buffer.read_frames(output.data(), capacity) == capacity);
 
-  auto expected = MakePattern(8, 4);  // frames 4..11
+  auto expected = MakePattern(capacity, 4);  // frames 4..capacity+3
   REQUIRE(output == expected);
 }
 
@@ -148,10 +171,14 @@ TEST_CASE("AudioRingBuffer interleaving preserved across wrap-around") {
 // Validates boundary behavior when hitting exact capacity, including after wrap-around.
 TEST_CASE("AudioRingBuffer exact-capacity boundaries") {
   const uint32_t channels = 2;
-  const uint32_t capacity = 4;
+  const CapacityMode mode = GENERATE(CapacityMode::Exact, CapacityMode::PowerOfTwo);
+  // Requests 6 in both modes: Exact keeps it (modulo), PowerOfTwo rounds it to 8 (mask).
+  const uint32_t capacity = mode == CapacityMode::Exact ? 6 : 8;
 
   SECTION("exact fill and drain") {
-    AudioRingBuffer buffer(capacity, channels);
+    AudioRingBuffer buffer(6, channels, mode);
+    REQUIRE(buffer.capacity_frames() == capacity);
+    REQUIRE(buffer.uses_index_mask() == (mode == CapacityMode::PowerOfTwo));
     auto input = MakePattern(capacity, 0);
     std::vector<float> output(input.size(), 0.0f);
 
@@ -167,7 +194,9 @@ TEST_CASE("AudioRingBuffer exact-capacity boundaries") {
   }
 
   SECTION("exact capacity after wrap-around") {
-    AudioRingBuffer buffer(capacity, channels);
+    AudioRingBuffer buffer(6, channels, mode);
+    REQUIRE(buffer.capacity_frames() == capacity);
+    REQUIRE(buffer.uses_index_mask() == (mode == CapacityMode::PowerOfTwo));
     auto input = MakePattern(capacity, 0);
     auto refill = MakePattern(2, capacity);
 
@@ -182,7 +211,7 @@ TEST_CASE("AudioRingBuffer exact-capacity boundaries") {
     REQUIRE(buffer.overrun_count() == 1);
 
     REQUIRE(buffer.read_frames(output.data(), capacity) == capacity);
-    auto expected = MakePattern(capacity, 2);  // frames 2..5
+    auto expected = MakePattern(capacity, 2);  // frames 2..capacity+1
     REQUIRE(output == expected);
 
     REQUIRE(buffer.read_frames(output.data(), 1) == 0);
@@ -190,10 +219,615 @@ TEST_CASE("AudioRingBuffer exact-capacity boundaries") {
   }
 }
 
+// Verifies acquire/commit hands out two spans across the wrap and preserves order.
+TEST_CASE("AudioRingBuffer acquire/commit spans split at wrap-around") {
+  constexpr uint32_t channels = 2;
+  const CapacityMode mode = GENERATE(CapacityMode::Exact, CapacityMode::PowerOfTwo);
+  // Exact keeps 6 (modulo indexing); PowerOfTwo rounds it up to 8 (mask indexing).
+  AudioRingBuffer buffer(6, channels, mode);
+  const uint32_t capacity = buffer.capacity_frames();
+  REQUIRE(capacity == (mode == CapacityMode::Exact ? 6u : 8u));
+  REQUIRE(buffer.uses_index_mask() == (mode == CapacityMode::PowerOfTwo));
+
+  auto first = MakePattern(capacity - 2, 0);  // frames 0..capacity-3
+  auto second = MakePattern(6, capacity - 2);
+
+  REQUIRE(buffer.write_frames(first.data(), capacity - 2) == capacity - 2);
+  std::vector<float> temp(static_cast<size_t>(4) * channels);
+  REQUIRE(buffer.read_frames(temp.data(), 4) == 4);  // consume frames 0..3
+
+  auto write_region = buffer.acquire_write(6);
+  REQUIRE(write_region.frames == 6);
+  REQUIRE(write_region.first.size() == static_cast<size_t>(2) * channels);
+  REQUIRE(write_region.second.size() == static_cast<size_t>(4) * channels);
+  std::copy(second.begin(), second.begin() + write_region.first.size(),
+            write_region.first.begin());
+  std::copy(second.begin() + write_region.first.size(), second.end(),
+            write_region.second.begin());
+  buffer.commit_write(write_region.frames);
+
+  auto read_region = buffer.acquire_read(capacity);
+  REQUIRE(read_region.frames == capacity);
+  REQUIRE(read_region.first.size() == static_cast<size_t>(capacity - 4) * channels);
+  REQUIRE(read_region.second.size() == static_cast<size_t>(4) * channels);
+  std::vector<float> output(read_region.first.begin(), read_region.first.end());
+  output.insert(output.end(), read_region.second.begin(), read_region.second.end());
+  buffer.commit_read(read_region.frames);
+
+  REQUIRE(output == MakePattern(capacity, 4));  // frames 4..capacity+3
+  REQUIRE(buffer.available_to_read_frames() == 0);
+  REQUIRE(buffer.overrun_count() == 0);
+  REQUIRE(buffer.underrun_count() == 0);
+}
+
+// Confirms reservations are invisible until committed and partial commits are honored.
+TEST_CASE("AudioRingBuffer acquire without commit publishes nothing") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(4, channels);
+  auto input = MakePattern(3, 0);
+
+  auto write_region = buffer.acquire_write(3);
+  REQUIRE(write_region.frames == 3);
+  std::copy(input.begin(), input.end(), write_region.first.begin());
+  REQUIRE(buffer.available_to_read_frames() == 0);
+
+  buffer.commit_write(2);
+  REQUIRE(buffer.available_to_read_frames() == 2);
+  REQUIRE(buffer.available_to_write_frames() == 2);
+
+  auto read_region = buffer.acquire_read(2);
+  REQUIRE(read_region.frames == 2);
+  REQUIRE(buffer.available_to_write_frames() == 2);
+
+  buffer.commit_read(1);
+  REQUIRE(buffer.available_to_read_frames() == 1);
+  REQUIRE(buffer.available_to_write_frames() == 3);
+}
+
+// Short reservations count as overrun/underrun exactly like write_frames/read_frames.
+TEST_CASE("AudioRingBuffer short acquire updates counters") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(4, channels);
+
+  auto read_region = buffer.acquire_read(1);
+  REQUIRE(read_region.frames == 0);
+  REQUIRE(read_region.first.empty());
+  REQUIRE(read_region.second.empty());
+  REQUIRE(buffer.underrun_count() == 1);
+
+  auto write_region = buffer.acquire_write(6);
+  REQUIRE(write_region.frames == 4);
+  REQUIRE(buffer.overrun_count() == 1);
+  buffer.commit_write(write_region.frames);
+
+  REQUIRE(buffer.acquire_write(1).frames == 0);
+  REQUIRE(buffer.overrun_count() == 2);
+}
+
+// Power-of-two mode rounds capacity up and switches indexing to a mask.
+TEST_CASE("AudioRingBuffer power-of-two mode rounds capacity up") {
+  constexpr uint32_t channels = 2;
+
+  AudioRingBuffer exact(5, channels, CapacityMode::Exact);
+  REQUIRE(exact.capacity_frames() == 5);
+  REQUIRE_FALSE(exact.uses_index_mask());
+
+  AudioRingBuffer rounded(5, channels, CapacityMode::PowerOfTwo);
+  REQUIRE(rounded.capacity_frames() == 8);
+  REQUIRE(rounded.uses_index_mask());
+  REQUIRE(rounded.available_to_write_frames() == 8);
+
+  AudioRingBuffer already(16, channels, CapacityMode::PowerOfTwo);
+  REQUIRE(already.capacity_frames() == 16);
+  REQUIRE(already.uses_index_mask());
+}
+
+// Reuses the interleaving wrap case at the rounded capacity (5 -> 8) so the mask path wraps.
+TEST_CASE("AudioRingBuffer power-of-two interleaving preserved across wrap-around") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(5, channels, CapacityMode::PowerOfTwo);
+  REQUIRE(buffer.capacity_frames() == 8);
+
+  auto first = MakePattern(7, 0);   // frames 0..6
+  auto second = MakePattern(7, 7);  // frames 7..13
+
+  REQUIRE(buffer.write_frames(first.data(), 7) == 7);
+
+  std::vector<float> temp(static_cast<size_t>(6) * channels);
+  REQUIRE(buffer.read_frames(temp.data(), 6) == 6);  // consume frames 0..5
+
+  REQUIRE(buffer.write_frames(second.data(), 7) == 7);
+  REQUIRE(buffer.write_frames(second.data(), 1) == 0);
+  REQUIRE(buffer.overrun_count() == 1);
+
+  std::vector<float> output(static_cast<size_t>(8) * channels);
+  REQUIRE(buffer.read_frames(output.data(), 8) == 8);
+  REQUIRE(output == MakePattern(8, 6));  // frames 6..13
+
+  REQUIRE(buffer.read_frames(output.data(), 1) == 0);
+  REQUIRE(buffer.underrun_count() == 1);
+}
+
+// Mirrored storage serves every reservation as one span, even across the wrap point.
+TEST_CASE("AudioRingBuffer mirrored backend hands out single spans") {
+  constexpr uint32_t channels = 2;
+  using StorageBackend = AudioRingBuffer::StorageBackend;
+  AudioRingBuffer buffer(8, channels, CapacityMode::Exact, StorageBackend::Mirrored);
+
+  if (buffer.storage_backend() == StorageBackend::Heap) {
+    // Fallback keeps the requested capacity and the regular two-span behavior.
+    REQUIRE(buffer.capacity_frames() == 8);
+    return;
+  }
+  const uint32_t capacity = buffer.capacity_frames();
+  REQUIRE(capacity >= 8);
+  REQUIRE(capacity % 8 == 0);
+
+  const uint32_t head = capacity - 3;
+  auto lead = MakePattern(head, 0);
+  REQUIRE(buffer.write_frames(lead.data(), head) == head);
+  std::vector<float> temp(lead.size());
+  REQUIRE(buffer.read_frames(temp.data(), head) == head);
+  REQUIRE(temp == lead);
+
+  auto tail = MakePattern(6, head);
+  auto write_region = buffer.acquire_write(6);
+  REQUIRE(write_region.frames == 6);
+  REQUIRE(write_region.second.empty());
+  REQUIRE(write_region.first.size() == tail.size());
+  std::copy(tail.begin(), tail.end(), write_region.first.begin());
+  buffer.commit_write(write_region.frames);
+
+  auto read_region = buffer.acquire_read(6);
+  REQUIRE(read_region.frames == 6);
+  REQUIRE(read_region.second.empty());
+  std::vector<float> output(read_region.first.begin(), read_region.first.end());
+  buffer.commit_read(read_region.frames);
+  REQUIRE(output == tail);
+
+  // Frames written past the end landed at the start of the first view.
+  auto wrapped = MakePattern(capacity, 100);
+  REQUIRE(buffer.write_frames(wrapped.data(), capacity) == capacity);
+  std::vector<float> drained(wrapped.size());
+  REQUIRE(buffer.read_frames(drained.data(), capacity) == capacity);
+  REQUIRE(drained == wrapped);
+}
+
+// Mirrored plus PowerOfTwo stays a power of two after page rounding.
+TEST_CASE("AudioRingBuffer mirrored backend keeps power-of-two capacity") {
+  using StorageBackend = AudioRingBuffer::StorageBackend;
+  AudioRingBuffer buffer(1000, 2, CapacityMode::PowerOfTwo, StorageBackend::Mirrored);
+  REQUIRE(buffer.capacity_frames() >= 1024);
+  REQUIRE(buffer.uses_index_mask());
+}
+
+// Runs the wrap-around case across every explicitly instantiated sample/channel combination.
+TEMPLATE_TEST_CASE("BasicAudioRingBuffer wrap-around preserves order per instantiation",
+                   "",
+                   (BasicAudioRingBuffer<float, kDynamicChannels>),
+                   (BasicAudioRingBuffer<float, 1>),
+                   (BasicAudioRingBuffer<float, 2>),
+                   (BasicAudioRingBuffer<int32_t, kDynamicChannels>),
+                   (BasicAudioRingBuffer<int32_t, 1>),
+                   (BasicAudioRingBuffer<int32_t, 2>),
+                   (BasicAudioRingBuffer<int16_t, kDynamicChannels>),
+                   (BasicAudioRingBuffer<int16_t, 1>),
+                   (BasicAudioRingBuffer<int16_t, 2>)) {
+  using Sample = typename TestType::sample_type;
+  // Dynamic instantiations run a 3-channel layout to cover odd strides.
+  const uint32_t channels = std::is_same_v<TestType, BasicAudioRingBuffer<Sample, 1>>   ? 1
+                            : std::is_same_v<TestType, BasicAudioRingBuffer<Sample, 2>> ? 2
+                                                                                        : 3;
+  TestType buffer(8, channels);
+  REQUIRE(buffer.channels() == channels);
+
+  auto first = MakeTypedPattern<Sample>(6, channels, 0);
+  auto second = MakeTypedPattern<Sample>(6, channels, 6);
+  std::vector<Sample> temp(static_cast<size_t>(4) * channels);
+
+  REQUIRE(buffer.write_frames(first.data(), 6) == 6);
+  REQUIRE(buffer.read_frames(temp.data(), 4) == 4);
+  REQUIRE(buffer.write_frames(second.data(), 6) == 6);
+  REQUIRE(buffer.write_frames(second.data(), 1) == 0);
+  REQUIRE(buffer.overrun_count() == 1);
+
+  std::vector<Sample> output(static_cast<size_t>(8) * channels);
+  REQUIRE(buffer.read_frames(output.data(), 8) == 8);
+  REQUIRE(output == MakeTypedPattern<Sample>(8, channels, 4));
+}
+
+// 16-bit storage halves the footprint relative to float for the same frame capacity.
+TEST_CASE("BasicAudioRingBuffer int16 stereo spans cover half the bytes of float") {
+  BasicAudioRingBuffer<int16_t, 2> narrow(16, 2);
+  AudioRingBuffer wide(16, 2);
+
+  auto narrow_region = narrow.acquire_write(16);
+  auto wide_region = wide.acquire_write(16);
+  REQUIRE(narrow_region.frames == 16);
+  REQUIRE(wide_region.frames == 16);
+  REQUIRE(narrow_region.first.size_bytes() * 2 == wide_region.first.size_bytes());
+}
+
+// Waits return immediately when satisfied and time out when the peer never commits.
+TEST_CASE("AudioRingBuffer wait primitives honor thresholds and timeouts") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(8, channels);
+  auto input = MakePattern(8, 0);
+
+  REQUIRE(buffer.wait_writable(8, std::chrono::milliseconds(0)));
+  REQUIRE_FALSE(buffer.wait_readable(1, std::chrono::milliseconds(5)));
+  REQUIRE_FALSE(buffer.wait_readable(9, std::chrono::seconds(10)));  // above capacity
+
+  REQUIRE(buffer.write_frames(input.data(), 3) == 3);
+  REQUIRE(buffer.wait_readable(3, std::chrono::milliseconds(0)));
+  REQUIRE_FALSE(buffer.wait_readable(4, std::chrono::milliseconds(5)));
+  REQUIRE_FALSE(buffer.wait_writable(6, std::chrono::milliseconds(5)));
+}
+
+// A blocked producer wakes once the consumer frees enough space, and vice versa.
+TEST_CASE("AudioRingBuffer wait primitives wake on threshold crossing") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(8, channels);
+  auto input = MakePattern(8, 0);
+  REQUIRE(buffer.write_frames(input.data(), 8) == 8);
+
+  std::atomic<bool> producer_woke{false};
+  std::thread producer([&]() {
+    producer_woke.store(buffer.wait_writable(4, std::chrono::seconds(10)));
+  });
+  std::vector<float> output(static_cast<size_t>(2) * channels);
+  REQUIRE(buffer.read_frames(output.data(), 2) == 2);  // below threshold: stays asleep
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE_FALSE(producer_woke.load());
+  REQUIRE(buffer.read_frames(output.data(), 2) == 2);  // crosses 4 writable frames
+  producer.join();
+  REQUIRE(producer_woke.load());
+
+  std::vector<float> drain(static_cast<size_t>(4) * channels);
+  REQUIRE(buffer.read_frames(drain.data(), 4) == 4);
+
+  std::atomic<bool> consumer_woke{false};
+  std::thread consumer([&]() {
+    consumer_woke.store(buffer.wait_readable(5, std::chrono::seconds(10)));
+  });
+  REQUIRE(buffer.write_frames(input.data(), 4) == 4);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE_FALSE(consumer_woke.load());
+  REQUIRE(buffer.write_frames(input.data(), 1) == 1);
+  consumer.join();
+  REQUIRE(consumer_woke.load());
+}
+
+// Commits check for a blocked peer behind the light half of an asymmetric fence; a missed
+// wake would show up here as a wait that runs into its timeout.
+TEST_CASE("AudioRingBuffer blocking producer and consumer never miss a wake") {
+  constexpr uint32_t channels = 2;
+  constexpr uint32_t kFrames = 20000;
+  constexpr auto kTimeout = std::chrono::seconds(5);
+  AudioRingBuffer buffer(4, channels);
+
+  std::atomic<uint32_t> producer_timeouts{0};
+  std::thread producer([&]() {
+    for (uint32_t frame = 0; frame < kFrames; ++frame) {
+      if (!buffer.wait_writable(1, kTimeout)) {
+        producer_timeouts.fetch_add(1);
+      }
+      const auto input = MakePattern(1, frame);
+      buffer.write_frames(input.data(), 1);
+    }
+  });
+
+  uint32_t consumer_timeouts = 0;
+  uint32_t received = 0;
+  bool in_order = true;
+  std::vector<float> output(channels);
+  while (received < kFrames && consumer_timeouts == 0) {
+    if (!buffer.wait_readable(1, kTimeout)) {
+      ++consumer_timeouts;
+      break;
+    }
+    while (buffer.read_frames(output.data(), 1) == 1) {
+      in_order = in_order && output[0] == static_cast<float>(received);
+      ++received;
+    }
+  }
+  producer.join();
+  REQUIRE(consumer_timeouts == 0);
+  REQUIRE(producer_timeouts.load() == 0);
+  REQUIRE(received == kFrames);
+  REQUIRE(in_order);
+}
+
+// Ensures reset also clears the producer/consumer cached peer indices.
+TEST_CASE("AudioRingBuffer reset clears cached peer positions") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(4, channels);
+  auto input = MakePattern(4, 0);
+  std::vector<float> output(input.size(), 0.0f);
+
+  REQUIRE(buffer.write_frames(input.data(), 4) == 4);
+  REQUIRE(buffer.read_frames(output.data(), 4) == 4);
+  buffer.reset();
+
+  REQUIRE(buffer.write_frames(input.data(), 4) == 4);
+  REQUIRE(buffer.write_frames(input.data(), 1) == 0);
+  REQUIRE(buffer.read_frames(output.data(), 4) == 4);
+  REQUIRE(output == input);
+  REQUIRE(buffer.read_frames(output.data(), 1) == 0);
+}
+
+// Markers become visible only once the consumer reaches their ring frame.
+TEST_CASE("AudioRingBuffer markers publish when their frame is consumed") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(8, channels);
+  auto input = MakePattern(4, 0);
+  std::vector<float> output(input.size(), 0.0f);
+  FrameMarker marker;
+  uint64_t since = 0;
+
+  REQUIRE(buffer.push_marker(1, 7, 1000));
+  REQUIRE(buffer.write_frames(input.data(), 4) == 4);
+  REQUIRE(buffer.push_marker(2, 7, 5000));
+  REQUIRE(buffer.write_frames(input.data(), 4) == 4);
+  REQUIRE_FALSE(buffer.current_marker(&marker, &since));
+
+  REQUIRE(buffer.read_frames(output.data(), 3) == 3);
+  REQUIRE(buffer.current_marker(&marker, &since));
+  REQUIRE(marker.epoch == 1);
+  REQUIRE(marker.track_id == 7);
+  REQUIRE(marker.source_frame + static_cast<int64_t>(since) == 1003);
+
+  // One commit crossing the second marker skips straight to it.
+  REQUIRE(buffer.read_frames(output.data(), 3) == 3);
+  REQUIRE(buffer.current_marker(&marker, &since));
+  REQUIRE(marker.epoch == 2);
+  REQUIRE(marker.ring_frame == 4);
+  REQUIRE(marker.source_frame + static_cast<int64_t>(since) == 5002);
+
+  buffer.read_frames(output.data(), 2);
+  buffer.reset();
+  REQUIRE_FALSE(buffer.current_marker(&marker, &since));
+}
+
+// A flush requested after the boundary is published jumps read_pos straight to it.
+TEST_CASE("AudioRingBuffer flush skips to a published epoch boundary") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(16, channels);
+  auto stale = MakePattern(6, 0);
+  auto fresh = MakePattern(4, 500);
+  std::vector<float> output(fresh.size(), 0.0f);
+
+  REQUIRE(buffer.write_frames(stale.data(), 6) == 6);
+  buffer.publish_epoch_boundary(1);
+  REQUIRE(buffer.push_marker(1, 0, 500));
+  REQUIRE(buffer.write_frames(fresh.data(), 4) == 4);
+
+  buffer.request_flush(1);
+  REQUIRE(buffer.available_to_read_frames() == 10);
+  REQUIRE(buffer.read_frames(output.data(), 4) == 4);
+  REQUIRE(output == fresh);
+  REQUIRE(buffer.available_to_read_frames() == 0);
+
+  FrameMarker marker;
+  uint64_t since = 0;
+  REQUIRE(buffer.current_marker(&marker, &since));
+  REQUIRE(marker.source_frame + static_cast<int64_t>(since) == 504);
+  REQUIRE(buffer.underrun_count() == 0);
+}
+
+// Before the boundary exists, every readable frame is stale and is discarded as it arrives.
+TEST_CASE("AudioRingBuffer flush discards until the boundary is published") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(8, channels);
+  auto stale = MakePattern(8, 0);
+  auto fresh = MakePattern(3, 900);
+  std::vector<float> output(fresh.size(), 0.0f);
+
+  REQUIRE(buffer.write_frames(stale.data(), 8) == 8);
+  buffer.request_flush(4);
+  REQUIRE_FALSE(buffer.apply_pending_flush());
+  REQUIRE(buffer.available_to_read_frames() == 0);
+  // Space came back without the consumer copying anything.
+  REQUIRE(buffer.available_to_write_frames() == 8);
+
+  // The producer finishes an in-flight stale chunk before noticing the new epoch.
+  REQUIRE(buffer.write_frames(stale.data(), 5) == 5);
+  buffer.publish_epoch_boundary(4);
+  REQUIRE(buffer.write_frames(fresh.data(), 3) == 3);
+
+  REQUIRE(buffer.read_frames(output.data(), 3) == 3);
+  REQUIRE(output == fresh);
+  REQUIRE(buffer.apply_pending_flush());
+
+  // Frames of the flushed-to epoch are kept once the flush has been applied.
+  REQUIRE(buffer.write_frames(fresh.data(), 3) == 3);
+  REQUIRE(buffer.read_frames(output.data(), 3) == 3);
+  REQUIRE(output == fresh);
+}
+
+// A producer blocked on a full ring is woken by the flush releasing space.
+TEST_CASE("AudioRingBuffer flush wakes a blocked producer") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(8, channels);
+  auto stale = MakePattern(8, 0);
+  REQUIRE(buffer.write_frames(stale.data(), 8) == 8);
+
+  std::atomic<bool> woke{false};
+  std::thread producer([&]() {
+    woke.store(buffer.wait_writable(4, std::chrono::seconds(5)));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  buffer.request_flush(1);
+  REQUIRE_FALSE(buffer.apply_pending_flush());
+  producer.join();
+  REQUIRE(woke.load());
+}
+
+// The marker queue is bounded; pushes fail instead of allocating when it is full.
+TEST_CASE("FrameMarkerQueue rejects pushes when full") {
+  FrameMarkerQueue queue;
+  FrameMarker marker;
+  for (uint32_t i = 0; i < FrameMarkerQueue::kCapacity; ++i) {
+    marker.ring_frame = i;
+    REQUIRE(queue.push(marker));
+  }
+  REQUIRE_FALSE(queue.push(marker));
+
+  REQUIRE(queue.publish_through(0));
+  REQUIRE(queue.push(marker));
+  REQUIRE_FALSE(queue.publish_through(0));
+  REQUIRE(queue.publish_through(FrameMarkerQueue::kCapacity));
+
+  FrameMarker latest;
+  REQUIRE(queue.latest(&latest));
+  REQUIRE(latest.ring_frame == FrameMarkerQueue::kCapacity - 1);
+}
+
+// Markers pushed after the consumer cached the head are still published once due.
+TEST_CASE("FrameMarkerQueue publishes markers pushed past its cached head") {
+  FrameMarkerQueue queue;
+  FrameMarker marker;
+  marker.ring_frame = 10;
+  REQUIRE(queue.push(marker));
+  marker.ring_frame = 20;
+  REQUIRE(queue.push(marker));
+  // Caches the head with both markers queued; neither is due yet.
+  REQUIRE_FALSE(queue.publish_through(5));
+
+  marker.ring_frame = 22;
+  REQUIRE(queue.push(marker));
+  REQUIRE(queue.publish_through(25));
+  FrameMarker latest;
+  REQUIRE(queue.latest(&latest));
+  REQUIRE(latest.ring_frame == 22);
+  REQUIRE_FALSE(queue.publish_through(25));
+}
+
+// Every memory policy yields usable storage and reports what it achieved after fallbacks.
+TEST_CASE("AudioRingBuffer memory policies fall back and report residency") {
+  using MemoryPolicy = AudioRingBuffer::MemoryPolicy;
+  const auto policy = GENERATE(MemoryPolicy::None,
+                               MemoryPolicy::Prefault,
+                               MemoryPolicy::Lock,
+                               MemoryPolicy::HugePages);
+  const auto backend = GENERATE(AudioRingBuffer::StorageBackend::Heap,
+                                AudioRingBuffer::StorageBackend::Mirrored);
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(1024, channels, CapacityMode::Exact, backend, policy);
+
+  const auto& residency = buffer.memory_residency();
+  REQUIRE(residency.requested == policy);
+  // Prefault is the floor every stronger policy falls back to.
+  REQUIRE(residency.prefaulted == (policy != MemoryPolicy::None));
+  if (policy < MemoryPolicy::Lock) {
+    REQUIRE_FALSE(residency.locked);
+  }
+  if (policy != MemoryPolicy::HugePages ||
+      buffer.storage_backend() == AudioRingBuffer::StorageBackend::Mirrored) {
+    REQUIRE(residency.huge_pages == tomplayer::platform::HugePageBacking::None);
+  }
+
+  auto input = MakePattern(1000, 0);
+  std::vector<float> output(input.size(), 0.0f);
+  REQUIRE(buffer.write_frames(input.data(), 1000) == 1000);
+  REQUIRE(buffer.read_frames(output.data(), 1000) == 1000);
+  REQUIRE(output == input);
+}
+
+// Latency sizing rounds up to whole frames and rejects empty inputs.
+TEST_CASE("AudioRingBuffer sizes capacity from target latency") {
+  using std::chrono::milliseconds;
+  STATIC_REQUIRE(AudioRingBuffer::frames_for_latency(48000, milliseconds(2000)) == 96000);
+  REQUIRE(AudioRingBuffer::frames_for_latency(192000, milliseconds(250)) == 48000);
+  REQUIRE(AudioRingBuffer::frames_for_latency(44100, milliseconds(1)) == 45);
+  REQUIRE(AudioRingBuffer::frames_for_latency(44100, std::chrono::microseconds(1)) == 1);
+  REQUIRE(AudioRingBuffer::frames_for_latency(0, milliseconds(10)) == 0);
+  REQUIRE(AudioRingBuffer::frames_for_latency(48000, milliseconds(0)) == 0);
+  REQUIRE(AudioRingBuffer::frames_for_latency(48000, milliseconds(-5)) == 0);
+}
+
+// Taps observe consumed frames in order without moving the consumer's read position.
+TEST_CASE("AudioRingBuffer tap sees consumed frames only") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(8, channels);
+  auto tap = buffer.open_tap();
+  auto input = MakePattern(6, 0);
+  std::vector<float> output(input.size(), 0.0f);
+  std::vector<float> tapped(input.size(), 0.0f);
+
+  REQUIRE(buffer.write_frames(input.data(), 6) == 6);
+  REQUIRE(buffer.read_tap(&tap, tapped.data(), 6) == 0);
+
+  REQUIRE(buffer.read_frames(output.data(), 4) == 4);
+  REQUIRE(buffer.read_tap(&tap, tapped.data(), 6) == 4);
+  REQUIRE(buffer.available_to_read_frames() == 2);
+  REQUIRE(buffer.read_frames(output.data() + 4 * channels, 2) == 2);
+  REQUIRE(buffer.read_tap(&tap, tapped.data() + 4 * channels, 6) == 2);
+
+  REQUIRE(tapped == input);
+  REQUIRE(tap.position_frames == 6);
+  REQUIRE(tap.dropped_frames == 0);
+}
+
+// A lagging tap is skipped past overwritten slots and the skipped frames are counted.
+TEST_CASE("AudioRingBuffer lagging tap skips forward and counts drops") {
+  const auto mode = GENERATE(CapacityMode::Exact, CapacityMode::PowerOfTwo);
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(6, channels, mode);
+  const uint32_t capacity = buffer.capacity_frames();
+  REQUIRE(buffer.uses_index_mask() == (mode == CapacityMode::PowerOfTwo));
+  auto tap = buffer.open_tap();
+  std::vector<float> output(static_cast<size_t>(capacity) * channels, 0.0f);
+
+  // Three full laps; only the last lap's frames are still intact in storage.
+  for (uint32_t lap = 0; lap < 3; ++lap) {
+    auto input = MakePattern(capacity, lap * capacity);
+    REQUIRE(buffer.write_frames(input.data(), capacity) == capacity);
+    REQUIRE(buffer.read_frames(output.data(), capacity) == capacity);
+  }
+
+  std::vector<float> tapped(output.size(), 0.0f);
+  REQUIRE(buffer.read_tap(&tap, tapped.data(), capacity) == capacity);
+  REQUIRE(tap.dropped_frames == 2 * capacity);
+  REQUIRE(tapped == MakePattern(capacity, 2 * capacity));
+  REQUIRE(buffer.read_tap(&tap, tapped.data(), capacity) == 0);
+
+  // Claimed-but-uncommitted slots are treated as overwritten even before commit.
+  auto input = MakePattern(1, 3 * capacity);
+  REQUIRE(buffer.write_frames(input.data(), 1) == 1);
+  REQUIRE(buffer.read_frames(output.data(), 1) == 1);
+  auto stale = buffer.open_tap();
+  stale.position_frames = tap.position_frames - capacity + 1;
+  REQUIRE(buffer.acquire_write(2).frames == 2);
+  REQUIRE(buffer.read_tap(&stale, tapped.data(), capacity) == capacity - 2);
+  REQUIRE(stale.dropped_frames == 2);
+}
+
+// Reset moves taps that are ahead of the new read position back to it.
+TEST_CASE("AudioRingBuffer tap resynchronizes after reset") {
+  constexpr uint32_t channels = 2;
+  AudioRingBuffer buffer(4, channels);
+  auto input = MakePattern(3, 0);
+  std::vector<float> output(input.size(), 0.0f);
+  auto tap = buffer.open_tap();
+
+  REQUIRE(buffer.write_frames(input.data(), 3) == 3);
+  REQUIRE(buffer.read_frames(output.data(), 3) == 3);
+  REQUIRE(buffer.read_tap(&tap, output.data(), 3) == 3);
+  buffer.reset();
+
+  REQUIRE(buffer.write_frames(input.data(), 2) == 2);
+  REQUIRE(buffer.read_frames(output.data(), 2) == 2);
+  REQUIRE(buffer.read_tap(&tap, output.data(), 3) == 2);
+  REQUIRE(tap.position_frames == 2);
+  REQUIRE(tap.dropped_frames == 0);
+}
+
 // Exercises SPSC atomics under contention with a bounded counter pattern.
 TEST_CASE("AudioRingBuffer SPSC stress preserves order without overruns") {
   constexpr uint32_t channels = 2;
-  constexpr uint32_t capacity_frames = 2048;
+  // Not a power of two, so Exact runs modulo indexing and PowerOfTwo rounds to 2048.
+  constexpr uint32_t capacity_frames = 2000;
   constexpr uint32_t max_counter = 1u << 20;  // < 2^24, exact in float32
   const std::vector<uint32_t> chunk_sizes = {1, 7, 64, 127};
 
@@ -211,9 +845,12 @@ TEST_CASE("AudioRingBuffer SPSC stress preserves order without overruns") {
     kMismatch = 4
   };
 
+  const CapacityMode mode = GENERATE(CapacityMode::Exact, CapacityMode::PowerOfTwo);
+
   for (uint32_t chunk_frames : chunk_sizes) {
     for (int repeat = 0; repeat < 3; ++repeat) {
-      AudioRingBuffer buffer(capacity_frames, channels);
+      AudioRingBuffer buffer(capacity_frames, channels, mode);
+      REQUIRE(buffer.uses_index_mask() == (mode == CapacityMode::PowerOfTwo));
       Failure failure;
       std::atomic<bool> producer_done{false};
 
@@ -0,0 +1,235 @@
+// Float-to-device conversion tests: rounding and saturation per format, TPDF dither, noise
+// shaping, and one-pass ring consumption into an integer device buffer; plus the
+// decode-side integer-to-float conversion.
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "audio/ring_render.h"
+#include "audio/sample_convert.h"
+#include "buffer/audio_ring_buffer.h"
+
+namespace {
+using tomplayer::audio::ConvertFloatToDevice;
+using tomplayer::audio::ConvertToFloat;
+using tomplayer::audio::DitherMode;
+using tomplayer::audio::DitherState;
+using tomplayer::audio::SampleFormat;
+
+int32_t Pcm24At(const std::vector<uint8_t>& bytes, size_t index) {
+  const uint32_t bits = static_cast<uint32_t>(bytes[3 * index]) |
+                        (static_cast<uint32_t>(bytes[3 * index + 1]) << 8) |
+                        (static_cast<uint32_t>(bytes[3 * index + 2]) << 16);
+  // Sign-extend from bit 23.
+  return static_cast<int32_t>(bits << 8) >> 8;
+}
+
+// Mean square of the requantization error after an 8-sample moving average: a crude
+// low-pass that shows how much noise sits in the low (audible) band.
+double LowBandErrorPower(const std::vector<float>& input,
+                         const std::vector<int16_t>& output) {
+  double power = 0.0;
+  size_t count = 0;
+  for (size_t i = 8; i < input.size(); i += 8) {
+    double sum = 0.0;
+    for (size_t k = i - 8; k < i; ++k) {
+      sum += output[k] - static_cast<double>(input[k]) * 32768.0;
+    }
+    power += (sum / 8.0) * (sum / 8.0);
+    ++count;
+  }
+  return power / static_cast<double>(count);
+}
+}  // namespace
+
+TEST_CASE("BytesPerSample covers every device format") {
+  REQUIRE(tomplayer::audio::BytesPerSample(SampleFormat::Float32) == 4);
+  REQUIRE(tomplayer::audio::BytesPerSample(SampleFormat::Pcm16) == 2);
+  REQUIRE(tomplayer::audio::BytesPerSample(SampleFormat::Pcm24) == 3);
+  REQUIRE(tomplayer::audio::BytesPerSample(SampleFormat::Pcm32) == 4);
+  REQUIRE(tomplayer::audio::BytesPerSample(SampleFormat::Unsupported) == 0);
+}
+
+// Every length from 1 to 13 mixes SIMD blocks with scalar tails.
+TEST_CASE("Undithered conversion rounds to nearest and saturates") {
+  const std::array<float, 13> input = {0.0f,           0.5f,  -0.5f, 1.0f,  -1.0f,
+                                       2.0f,           -3.0f, 1.0f / 65536.0f,
+                                       3.0f / 65536.0f, -0.25f, 0.999f, 1e-9f, -1e9f};
+  const std::array<int16_t, 13> expected16 = {0,     16384,  -16384, 32767, -32768, 32767, -32768,
+                                              0,     2,      -8192,  32735, 0,      -32768};
+  for (uint32_t count = 1; count <= input.size(); ++count) {
+    std::array<int16_t, 13> out{};
+    ConvertFloatToDevice(input.data(), count, 1, SampleFormat::Pcm16, nullptr, out.data());
+    for (uint32_t i = 0; i < count; ++i) {
+      REQUIRE(out[i] == expected16[i]);
+    }
+  }
+
+  std::vector<uint8_t> packed(input.size() * 3);
+  ConvertFloatToDevice(input.data(), 13, 1, SampleFormat::Pcm24, nullptr, packed.data());
+  REQUIRE(Pcm24At(packed, 0) == 0);
+  REQUIRE(Pcm24At(packed, 1) == 4194304);
+  REQUIRE(Pcm24At(packed, 3) == 8388607);
+  REQUIRE(Pcm24At(packed, 4) == -8388608);
+  REQUIRE(Pcm24At(packed, 6) == -8388608);
+  REQUIRE(Pcm24At(packed, 7) == 128);
+  REQUIRE(Pcm24At(packed, 9) == -2097152);
+
+  std::array<int32_t, 13> out32{};
+  ConvertFloatToDevice(input.data(), 13, 1, SampleFormat::Pcm32, nullptr, out32.data());
+  REQUIRE(out32[1] == 1073741824);
+  // +1.0 saturates at the largest float below 2^31.
+  REQUIRE(out32[3] == 2147483520);
+  REQUIRE(out32[4] == INT32_MIN);
+  REQUIRE(out32[5] == 2147483520);
+  REQUIRE(out32[12] == INT32_MIN);
+
+  std::array<float, 13> copy{};
+  ConvertFloatToDevice(input.data(), 13, 1, SampleFormat::Float32, nullptr, copy.data());
+  REQUIRE(std::memcmp(copy.data(), input.data(), sizeof(copy)) == 0);
+}
+
+// Every length from 1 to 13 mixes SIMD blocks with scalar tails; extremes and sign
+// extension must come out exact.
+TEST_CASE("Integer samples convert to float exactly") {
+  const std::array<int16_t, 13> in16 = {0,     1,     -1,    16384, -16384, 32767, -32768,
+                                        12345, -1234, 256,   -256,  8191,   -8192};
+  const std::array<int32_t, 13> in24 = {0,       1,       -1,      4194304, -4194304,
+                                        8388607, -8388608, 123456, -654321, 65536,
+                                        -65536,  255,      -255};
+  std::vector<uint8_t> packed24(in24.size() * 3);
+  for (size_t i = 0; i < in24.size(); ++i) {
+    const uint32_t bits = static_cast<uint32_t>(in24[i]);
+    packed24[3 * i] = static_cast<uint8_t>(bits);
+    packed24[3 * i + 1] = static_cast<uint8_t>(bits >> 8);
+    packed24[3 * i + 2] = static_cast<uint8_t>(bits >> 16);
+  }
+  const std::array<int32_t, 13> in32 = {0,         1,          -1,         1 << 30, -(1 << 30),
+                                        INT32_MAX, INT32_MIN,  123456789,  -987654321,
+                                        1 << 16,   -(1 << 16), 1 << 8,     -(1 << 8)};
+
+  for (uint32_t count = 1; count <= 13; ++count) {
+    std::array<float, 13> out{};
+    ConvertToFloat(in16.data(), count, 1, SampleFormat::Pcm16, out.data());
+    for (uint32_t i = 0; i < count; ++i) {
+      REQUIRE(out[i] == static_cast<float>(in16[i]) / 32768.0f);
+    }
+    ConvertToFloat(packed24.data(), count, 1, SampleFormat::Pcm24, out.data());
+    for (uint32_t i = 0; i < count; ++i) {
+      REQUIRE(out[i] == static_cast<float>(in24[i]) / 8388608.0f);
+    }
+    ConvertToFloat(in32.data(), count, 1, SampleFormat::Pcm32, out.data());
+    for (uint32_t i = 0; i < count; ++i) {
+      REQUIRE(out[i] == static_cast<float>(in32[i]) / 2147483648.0f);
+    }
+  }
+
+  // Round trip through the device conversion is lossless for 16-bit.
+  std::array<float, 13> as_float{};
+  ConvertToFloat(in16.data(), 13, 1, SampleFormat::Pcm16, as_float.data());
+  std::array<int16_t, 13> back{};
+  ConvertFloatToDevice(as_float.data(), 13, 1, SampleFormat::Pcm16, nullptr, back.data());
+  REQUIRE(back == in16);
+}
+
+// TPDF turns digital silence into +-1 LSB noise with zero mean, reproducibly per seed.
+TEST_CASE("TPDF dither stays within one LSB and is deterministic") {
+  const std::vector<float> silence(4099, 0.0f);
+  std::vector<int16_t> first(silence.size());
+  std::vector<int16_t> second(silence.size());
+  DitherState dither(DitherMode::Tpdf);
+  ConvertFloatToDevice(silence.data(), 4099, 1, SampleFormat::Pcm16, &dither, first.data());
+  dither.reset(DitherMode::Tpdf);
+  ConvertFloatToDevice(silence.data(), 4099, 1, SampleFormat::Pcm16, &dither, second.data());
+  REQUIRE(first == second);
+
+  int64_t sum = 0;
+  size_t nonzero = 0;
+  for (const int16_t value : first) {
+    REQUIRE(value >= -1);
+    REQUIRE(value <= 1);
+    sum += value;
+    nonzero += value != 0 ? 1 : 0;
+  }
+  REQUIRE(nonzero > silence.size() / 8);
+  REQUIRE(std::abs(static_cast<double>(sum) / silence.size()) < 0.05);
+
+  // Different seeds draw different noise; Pcm32 is never dithered.
+  dither.reset(DitherMode::Tpdf, 12345);
+  ConvertFloatToDevice(silence.data(), 4099, 1, SampleFormat::Pcm16, &dither, second.data());
+  REQUIRE(first != second);
+  std::vector<int32_t> wide(silence.size(), -7);
+  ConvertFloatToDevice(silence.data(), 4099, 1, SampleFormat::Pcm32, &dither, wide.data());
+  REQUIRE(std::all_of(wide.begin(), wide.end(), [](int32_t v) { return v == 0; }));
+}
+
+// Error feedback moves noise out of the low band: less low-passed error power than plain
+// TPDF on the same quiet tone, with every sample still within a few LSB.
+TEST_CASE("Noise-shaped dither lowers the low-band noise floor") {
+  const uint32_t frames = 48000;
+  std::vector<float> tone(static_cast<size_t>(frames) * 2);
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    const float sample = 0.001f * std::sin(static_cast<float>(frame) * 0.0523f);
+    tone[2 * frame] = sample;
+    tone[2 * frame + 1] = -sample;
+  }
+
+  std::vector<int16_t> flat(tone.size());
+  std::vector<int16_t> shaped(tone.size());
+  DitherState tpdf(DitherMode::Tpdf);
+  DitherState shaping(DitherMode::TpdfShaped);
+  ConvertFloatToDevice(tone.data(), frames, 2, SampleFormat::Pcm16, &tpdf, flat.data());
+  ConvertFloatToDevice(tone.data(), frames, 2, SampleFormat::Pcm16, &shaping, shaped.data());
+
+  for (size_t i = 0; i < tone.size(); ++i) {
+    REQUIRE(std::abs(shaped[i] - tone[i] * 32768.0f) < 8.0f);
+  }
+  std::vector<float> left(frames);
+  std::vector<int16_t> flat_left(frames);
+  std::vector<int16_t> shaped_left(frames);
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    left[frame] = tone[2 * frame];
+    flat_left[frame] = flat[2 * frame];
+    shaped_left[frame] = shaped[2 * frame];
+  }
+  REQUIRE(LowBandErrorPower(left, shaped_left) < 0.5 * LowBandErrorPower(left, flat_left));
+}
+
+// Both ring spans convert straight into the device buffer; the underrun tail is silence.
+TEST_CASE("ConsumeRingBuffer converts across wrap-around into a Pcm16 buffer") {
+  AudioRingBuffer ring(8, 2);
+  std::array<float, 12> warmup{};
+  REQUIRE(ring.write_frames(warmup.data(), 6) == 6);
+  std::array<float, 12> sink{};
+  REQUIRE(ring.read_frames(sink.data(), 6) == 6);
+
+  const std::array<float, 10> input = {0.5f, -0.5f, 0.25f, -0.25f, 1.0f,
+                                       -1.0f, 0.0f, 0.125f, 2.0f, -2.0f};
+  REQUIRE(ring.write_frames(input.data(), 5) == 5);
+
+  std::array<int16_t, 16> device{};
+  device.fill(0x5555);
+  std::atomic<uint64_t> underrun_wakes{0};
+  std::atomic<uint64_t> underrun_frames{0};
+  const uint32_t frames_read =
+      tomplayer::audio::ConsumeRingBuffer(&ring, SampleFormat::Pcm16, nullptr, device.data(), 8,
+                                          2, &underrun_wakes, &underrun_frames);
+
+  REQUIRE(frames_read == 5);
+  const std::array<int16_t, 16> expected = {16384, -16384, 8192, -8192, 32767, -32768,
+                                            0,     4096,   32767, -32768, 0,    0,
+                                            0,     0,      0,     0};
+  REQUIRE(device == expected);
+  REQUIRE(ring.available_to_read_frames() == 0);
+  REQUIRE(underrun_wakes.load() == 1);
+  REQUIRE(underrun_frames.load() == 3);
+
+  REQUIRE(tomplayer::audio::ConsumeRingBuffer(&ring, SampleFormat::Unsupported, nullptr,
+                                              device.data(), 8, 2, nullptr, nullptr) == 0);
+}
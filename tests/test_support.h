@@ -0,0 +1,31 @@
+#pragma once
+
+// Helpers shared by the test executables that drive real threads and files.
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace tomplayer::test {
+
+// Summary: Path of name inside the system temp directory.
+inline std::string TempPath(const char* name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Summary: Poll predicate every millisecond until it holds or timeout passes.
+// Postconditions: returns the predicate's last result, checked once more at the deadline.
+template <typename Predicate>
+bool WaitFor(Predicate predicate, std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (predicate()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return predicate();
+}
+
+}  // namespace tomplayer::test
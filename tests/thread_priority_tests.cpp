@@ -0,0 +1,158 @@
+// Thread policy tests: each policy runs on a scratch thread so the test process keeps its
+// own scheduling. Whether RealTime is granted depends on privileges, so every test accepts
+// either the requested scheduling (verified against the OS) or a reported refusal.
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "audio/null_output.h"
+#include "buffer/audio_ring_buffer.h"
+#include "platform/thread_priority.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+using tomplayer::platform::ApplyThreadPolicy;
+using tomplayer::platform::ThreadClass;
+using tomplayer::platform::ThreadPolicy;
+using tomplayer::platform::ThreadPolicyReport;
+using tomplayer::platform::ThreadScheduling;
+using namespace std::chrono_literals;
+
+// Runs body on a fresh thread that exits afterwards, taking its scheduling with it.
+template <typename Body>
+void OnScratchThread(Body body) {
+  std::thread thread(body);
+  thread.join();
+}
+
+#if defined(__linux__)
+int CurrentScheduler(int* priority) {
+  int policy = 0;
+  sched_param param{};
+  pthread_getschedparam(pthread_self(), &policy, &param);
+  *priority = param.sched_priority;
+  return policy;
+}
+
+int CurrentNice() {
+  return getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+}
+#endif
+}  // namespace
+
+TEST_CASE("Inherit leaves the thread untouched") {
+  OnScratchThread([] {
+    const ThreadPolicyReport report = ApplyThreadPolicy(ThreadPolicy{});
+    CHECK(report.requested == ThreadClass::Inherit);
+    CHECK(report.scheduling == ThreadScheduling::Unchanged);
+    CHECK(report.priority == 0);
+    CHECK_FALSE(report.affinity_applied);
+    CHECK(report.error == 0);
+  });
+}
+
+#if defined(__linux__)
+TEST_CASE("RealTime applies SCHED_FIFO or SCHED_RR, else falls back to nice") {
+  for (const bool round_robin : {false, true}) {
+    OnScratchThread([round_robin] {
+      ThreadPolicy policy;
+      policy.thread_class = ThreadClass::RealTime;
+      policy.round_robin = round_robin;
+      policy.realtime_priority = 200;  // Clamped to the scheduler maximum.
+      policy.nice = -5;
+      const ThreadPolicyReport report = ApplyThreadPolicy(policy);
+      CHECK(report.requested == ThreadClass::RealTime);
+
+      int priority = 0;
+      const int scheduler = CurrentScheduler(&priority);
+      if (report.scheduling == ThreadScheduling::Fifo ||
+          report.scheduling == ThreadScheduling::RoundRobin) {
+        CHECK(report.scheduling ==
+              (round_robin ? ThreadScheduling::RoundRobin : ThreadScheduling::Fifo));
+        CHECK(scheduler == (round_robin ? SCHED_RR : SCHED_FIFO));
+        CHECK(priority == report.priority);
+        CHECK(priority <= sched_get_priority_max(scheduler));
+      } else {
+        // Refused: the fallback is reported along with why.
+        CHECK(report.error != 0);
+        CHECK(scheduler == SCHED_OTHER);
+        if (report.scheduling == ThreadScheduling::Nice) {
+          CHECK(CurrentNice() == report.priority);
+        }
+      }
+    });
+  }
+}
+
+TEST_CASE("Elevated sets the thread's nice level") {
+  const int process_nice = CurrentNice();
+  OnScratchThread([] {
+    ThreadPolicy policy;
+    policy.thread_class = ThreadClass::Elevated;
+    policy.nice = -3;
+    const ThreadPolicyReport report = ApplyThreadPolicy(policy);
+    int priority = 0;
+    CHECK(CurrentScheduler(&priority) == SCHED_OTHER);
+    if (report.scheduling == ThreadScheduling::Nice) {
+      CHECK(report.priority <= 0);
+      CHECK(CurrentNice() == report.priority);
+    } else {
+      CHECK(report.scheduling == ThreadScheduling::Unchanged);
+      CHECK(report.error != 0);
+    }
+  });
+  // Only the scratch thread changed.
+  CHECK(CurrentNice() == process_nice);
+}
+
+TEST_CASE("cpu_mask pins the thread") {
+  OnScratchThread([] {
+    const int cpu = sched_getcpu();
+    REQUIRE(cpu >= 0);
+    REQUIRE(cpu < 64);
+    ThreadPolicy policy;
+    policy.cpu_mask = uint64_t{1} << cpu;
+    const ThreadPolicyReport report = ApplyThreadPolicy(policy);
+    REQUIRE(report.affinity_applied);
+    cpu_set_t set;
+    REQUIRE(pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0);
+    CHECK(CPU_COUNT(&set) == 1);
+    CHECK(CPU_ISSET(cpu, &set));
+    CHECK(sched_getcpu() == cpu);
+  });
+}
+#endif
+
+// The render thread applies the slot's policy on every start and reports it.
+TEST_CASE("NullOutput applies the render thread policy on start") {
+  tomplayer::audio::NullOutput::Config config;
+  config.period = 5ms;
+  tomplayer::audio::NullOutput output(config);
+  REQUIRE(output.init_default_device());
+  AudioRingBuffer ring(4096, 2);
+  output.set_ring_buffer(&ring);
+
+  REQUIRE(output.render_thread_policy().report().requested == ThreadClass::Inherit);
+  ThreadPolicy policy;
+  policy.thread_class = ThreadClass::RealTime;
+  output.render_thread_policy().set(policy);
+  REQUIRE(output.start());
+  const uint64_t token = output.render_grace_token();
+  while (!output.render_grace_period_elapsed(token)) {
+    std::this_thread::sleep_for(1ms);
+  }
+  output.stop();
+
+  const ThreadPolicyReport report = output.render_thread_policy().report();
+  CHECK(report.requested == ThreadClass::RealTime);
+  CHECK((report.scheduling != ThreadScheduling::Unchanged || report.error != 0));
+}
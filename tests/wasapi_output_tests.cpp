@@ -4,8 +4,6 @@
 
 #include <catch2/catch_test_macros.hpp>
 
-#include <array>
-#include <atomic>
 #include <windows.h>
 #include <ks.h>
 #include <ksmedia.h>
@@ -130,12 +128,35 @@ TEST_CASE("DetectSampleFormat handles all mix format branches") {
     REQUIRE(tomplayer::wasapi::detail::DetectSampleFormat(&fmt.Format) == SampleFormat::Pcm16);
   }
 
-  SECTION("Extensible unsupported") {
+  SECTION("PCM 24-bit packed and 32-bit") {
+    WAVEFORMATEX fmt{};
+    fmt.wFormatTag = WAVE_FORMAT_PCM;
+    fmt.wBitsPerSample = 24;
+    REQUIRE(tomplayer::wasapi::detail::DetectSampleFormat(&fmt) == SampleFormat::Pcm24);
+    fmt.wBitsPerSample = 32;
+    REQUIRE(tomplayer::wasapi::detail::DetectSampleFormat(&fmt) == SampleFormat::Pcm32);
+  }
+
+  SECTION("Extensible PCM 24-bit packed and 24-in-32") {
     WAVEFORMATEXTENSIBLE fmt{};
     fmt.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
     fmt.Format.wBitsPerSample = 24;
+    fmt.Samples.wValidBitsPerSample = 24;
+    fmt.SubFormat = KSDATAFORMAT_SUBTYPE_PCM;
+    REQUIRE(tomplayer::wasapi::detail::DetectSampleFormat(&fmt.Format) == SampleFormat::Pcm24);
+    fmt.Format.wBitsPerSample = 32;
+    REQUIRE(tomplayer::wasapi::detail::DetectSampleFormat(&fmt.Format) == SampleFormat::Pcm32);
+  }
+
+  SECTION("Extensible unsupported") {
+    WAVEFORMATEXTENSIBLE fmt{};
+    fmt.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    fmt.Format.wBitsPerSample = 8;
     fmt.SubFormat = KSDATAFORMAT_SUBTYPE_PCM;
     REQUIRE(tomplayer::wasapi::detail::DetectSampleFormat(&fmt.Format) == SampleFormat::Unsupported);
+    fmt.Format.wBitsPerSample = 64;
+    fmt.SubFormat = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+    REQUIRE(tomplayer::wasapi::detail::DetectSampleFormat(&fmt.Format) == SampleFormat::Unsupported);
   }
 }
 
@@ -161,38 +182,6 @@ TEST_CASE("SelectFloat32MixFormat requests float32 with device rate/channels") {
   REQUIRE(IsEqualGUID(fake.captured.SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT));
 }
 
-// Validates ring-buffer consumption zero-fills missing frames on underrun.
-TEST_CASE("ConsumeRingBufferFloat zero-fills tail on underrun") {
-  const uint32_t channels = 2;
-  AudioRingBuffer buffer(4, channels);
-  std::array<float, 4> input = {1.0f, 2.0f, 3.0f, 4.0f};
-  std::array<float, 8> output{};
-  std::atomic<uint64_t> underrun_wakes{0};
-  std::atomic<uint64_t> underrun_frames{0};
-
-  REQUIRE(buffer.write_frames(input.data(), 2) == 2);
-
-  const uint32_t frames_read = tomplayer::wasapi::detail::ConsumeRingBufferFloat(
-      &buffer,
-      output.data(),
-      4,
-      channels,
-      &underrun_wakes,
-      &underrun_frames);
-
-  REQUIRE(frames_read == 2);
-  REQUIRE(output[0] == 1.0f);
-  REQUIRE(output[1] == 2.0f);
-  REQUIRE(output[2] == 3.0f);
-  REQUIRE(output[3] == 4.0f);
-  REQUIRE(output[4] == 0.0f);
-  REQUIRE(output[5] == 0.0f);
-  REQUIRE(output[6] == 0.0f);
-  REQUIRE(output[7] == 0.0f);
-  REQUIRE(underrun_wakes.load() == 1);
-  REQUIRE(underrun_frames.load() == 2);
-}
-
 // Covers lifecycle paths that can be validated without COM or real devices.
 TEST_CASE("WasapiOutput lifecycle without COM objects is safe") {
   tomplayer::wasapi::WasapiOutput output;
@@ -250,6 +239,31 @@ TEST_CASE("WasapiOutput lifecycle without COM objects is safe") {
     output.shutdown();
   }
 
+  SECTION("ring exchange hands back the previous buffer") {
+    FakeStartStopApi fake;
+    WinHandle audio_event(CreateEvent(nullptr, FALSE, FALSE, nullptr));
+    WinHandle stop_event(CreateEvent(nullptr, TRUE, FALSE, nullptr));
+    REQUIRE(audio_event.handle != nullptr);
+    REQUIRE(stop_event.handle != nullptr);
+
+    AudioRingBuffer first(1, 2);
+    AudioRingBuffer second(4, 2);
+    output.set_ring_buffer(&first);
+    output.set_channels_for_test(2);
+    output.set_start_stop_api_for_test(fake.api(), audio_event.release(), stop_event.release());
+
+    REQUIRE(output.start());
+    REQUIRE(output.exchange_ring_buffer(&second) == &first);
+    const uint64_t token = output.render_grace_token();
+    // No audio event was signaled, so no render cycle has passed the quiescent point yet.
+    REQUIRE_FALSE(output.render_grace_period_elapsed(token));
+    output.stop();
+    REQUIRE(output.render_grace_period_elapsed(token));
+    REQUIRE(output.exchange_ring_buffer(&first) == &second);
+
+    output.shutdown();
+  }
+
   SECTION("shutdown is safe to call twice") {
     output.shutdown();
     output.shutdown();
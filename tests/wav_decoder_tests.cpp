@@ -0,0 +1,341 @@
+// WavDecoder tests: header variants (plain, extensible, RF64 over 4 GB), exact integer and
+// float conversion, O(1) seeking, rejected encodings, and PlayerEngine playing a WAV file
+// to the end through FileOutput.
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/file_output.h"
+#include "decode/decoder.h"
+#include "decode/wav_decoder.h"
+#include "engine/player_engine.h"
+#include "test_support.h"
+
+namespace {
+using tomplayer::audio::SampleFormat;
+using tomplayer::decode::WavDecoder;
+using namespace std::chrono_literals;
+using tomplayer::test::TempPath;
+using tomplayer::test::WaitFor;
+
+void Put16(std::vector<uint8_t>* out, uint32_t value) {
+  out->push_back(static_cast<uint8_t>(value));
+  out->push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void Put32(std::vector<uint8_t>* out, uint32_t value) {
+  Put16(out, value & 0xFFFF);
+  Put16(out, value >> 16);
+}
+
+void Put64(std::vector<uint8_t>* out, uint64_t value) {
+  Put32(out, static_cast<uint32_t>(value));
+  Put32(out, static_cast<uint32_t>(value >> 32));
+}
+
+void PutTag(std::vector<uint8_t>* out, const char* tag) {
+  out->insert(out->end(), tag, tag + 4);
+}
+
+struct WavSpec {
+  uint16_t format_tag = 1;
+  uint16_t bits = 16;
+  uint16_t channels = 2;
+  uint32_t sample_rate = 48000;
+  bool extensible = false;
+};
+
+// Header up to and including the data chunk's id and size. An odd-sized LIST chunk sits
+// between fmt and data to exercise pad bytes.
+std::vector<uint8_t> Header(const WavSpec& spec, uint64_t data_bytes, bool rf64 = false) {
+  const uint16_t block_align = static_cast<uint16_t>(spec.channels * spec.bits / 8);
+  std::vector<uint8_t> out;
+  PutTag(&out, rf64 ? "RF64" : "RIFF");
+  Put32(&out, rf64 ? 0xFFFFFFFFu : 0);  // RIFF size: unchecked by the decoder
+  PutTag(&out, "WAVE");
+  if (rf64) {
+    PutTag(&out, "ds64");
+    Put32(&out, 28);
+    Put64(&out, 0);
+    Put64(&out, data_bytes);
+    Put64(&out, data_bytes / block_align);
+    Put32(&out, 0);
+  }
+  PutTag(&out, "fmt ");
+  Put32(&out, spec.extensible ? 40 : 16);
+  Put16(&out, spec.extensible ? 0xFFFE : spec.format_tag);
+  Put16(&out, spec.channels);
+  Put32(&out, spec.sample_rate);
+  Put32(&out, spec.sample_rate * block_align);
+  Put16(&out, block_align);
+  Put16(&out, spec.bits);
+  if (spec.extensible) {
+    Put16(&out, 22);
+    Put16(&out, spec.bits);
+    Put32(&out, 0);
+    Put16(&out, spec.format_tag);
+    const uint8_t tail[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80,
+                              0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+    out.insert(out.end(), tail, tail + sizeof(tail));
+  }
+  PutTag(&out, "LIST");
+  Put32(&out, 5);
+  out.insert(out.end(), {'I', 'N', 'F', 'O', 'x', 0});
+  PutTag(&out, "data");
+  Put32(&out, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(data_bytes));
+  return out;
+}
+
+void WriteFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Integer samples spanning the full range, little-endian in bits-wide containers.
+std::vector<uint8_t> IntegerSamples(uint32_t count, uint16_t bits, std::vector<int32_t>* values) {
+  std::vector<uint8_t> out;
+  const int64_t min = -(int64_t{1} << (bits - 1));
+  const int64_t span = int64_t{1} << bits;
+  for (uint32_t i = 0; i < count; ++i) {
+    const int32_t value = static_cast<int32_t>(min + (int64_t{i} * 7919 * 65537) % span);
+    values->push_back(value);
+    for (uint32_t byte = 0; byte < bits / 8u; ++byte) {
+      out.push_back(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * byte)));
+    }
+  }
+  return out;
+}
+}  // namespace
+
+TEST_CASE("WavDecoder converts PCM 16/24/32 exactly, plain and extensible") {
+  for (const WavSpec spec : {WavSpec{1, 16, 2, 48000, false}, WavSpec{1, 24, 2, 44100, true},
+                             WavSpec{1, 32, 3, 96000, true}, WavSpec{1, 16, 1, 8000, true}}) {
+    // Odd frame counts leave a scalar tail after the SIMD blocks.
+    const uint32_t frames = 1027;
+    std::vector<int32_t> values;
+    const std::vector<uint8_t> samples = IntegerSamples(frames * spec.channels, spec.bits, &values);
+    std::vector<uint8_t> bytes = Header(spec, samples.size());
+    bytes.insert(bytes.end(), samples.begin(), samples.end());
+    const std::string path = TempPath("tomplayer_wav_pcm.wav");
+    WriteFile(path, bytes);
+
+    WavDecoder decoder;
+    std::string error;
+    REQUIRE(decoder.open(path, &error));
+    REQUIRE(decoder.info().sample_rate == spec.sample_rate);
+    REQUIRE(decoder.info().channels == spec.channels);
+    REQUIRE(decoder.info().total_frames == frames);
+    REQUIRE(decoder.bits_per_sample() == spec.bits);
+    // 12 RIFF + fmt (8 + 16/40) + LIST (8 + 5 + pad) + data header.
+    REQUIRE(decoder.data_offset() == 12 + 8 + (spec.extensible ? 40u : 16u) + 14 + 8);
+
+    std::vector<float> out(static_cast<size_t>(frames) * spec.channels + 8, 9.0f);
+    REQUIRE(decoder.read(out.data(), 1000) == 1000);
+    REQUIRE(decoder.read(out.data() + 1000 * spec.channels, 1000) == frames - 1000);
+    REQUIRE(decoder.read(out.data(), 1000) == 0);
+    const float scale = 1.0f / static_cast<float>(int64_t{1} << (spec.bits - 1));
+    for (size_t i = 0; i < values.size(); ++i) {
+      REQUIRE(out[i] == static_cast<float>(values[i]) * scale);
+    }
+    REQUIRE(decoder.error().empty());
+  }
+}
+
+TEST_CASE("WavDecoder reads IEEE float 32 and 64-bit") {
+  for (const WavSpec spec : {WavSpec{3, 32, 2, 48000, false}, WavSpec{3, 64, 2, 48000, true}}) {
+    const uint32_t frames = 301;
+    std::vector<float> expected;
+    std::vector<uint8_t> samples;
+    for (uint32_t i = 0; i < frames * 2; ++i) {
+      const float value = static_cast<float>(i) / 300.0f - 1.0f;
+      expected.push_back(value);
+      if (spec.bits == 32) {
+        uint32_t raw;
+        std::memcpy(&raw, &value, sizeof(raw));
+        Put32(&samples, raw);
+      } else {
+        const double wide = value;
+        uint64_t raw;
+        std::memcpy(&raw, &wide, sizeof(raw));
+        Put64(&samples, raw);
+      }
+    }
+    std::vector<uint8_t> bytes = Header(spec, samples.size());
+    bytes.insert(bytes.end(), samples.begin(), samples.end());
+    const std::string path = TempPath("tomplayer_wav_float.wav");
+    WriteFile(path, bytes);
+
+    WavDecoder decoder;
+    REQUIRE(decoder.open(path, nullptr));
+    REQUIRE(decoder.sample_format() == SampleFormat::Float32);
+    std::vector<float> out(expected.size());
+    REQUIRE(decoder.read(out.data(), frames) == frames);
+    REQUIRE(out == expected);
+  }
+}
+
+TEST_CASE("WavDecoder seeks sample-accurately and clamps truncated data") {
+  const WavSpec spec{};
+  const uint32_t frames = 4000;
+  std::vector<int32_t> values;
+  const std::vector<uint8_t> samples = IntegerSamples(frames * 2, 16, &values);
+  // The header claims more than was written, as a recorder killed mid-take leaves it.
+  std::vector<uint8_t> bytes = Header(spec, samples.size() * 2);
+  bytes.insert(bytes.end(), samples.begin(), samples.end());
+  bytes.push_back(0);  // half a frame
+  const std::string path = TempPath("tomplayer_wav_seek.wav");
+  WriteFile(path, bytes);
+
+  std::string error;
+  std::unique_ptr<tomplayer::decode::Decoder> decoder =
+      tomplayer::decode::OpenDecoder(path, &error);
+  REQUIRE(decoder);
+  REQUIRE(decoder->info().total_frames == frames);
+
+  std::vector<float> out(64 * 2);
+  for (const int64_t target : {int64_t{3001}, int64_t{17}, int64_t{0}, int64_t{3990}}) {
+    REQUIRE(decoder->seek(target));
+    const uint32_t got = decoder->read(out.data(), 64);
+    REQUIRE(got == std::min<int64_t>(64, frames - target));
+    for (uint32_t i = 0; i < got * 2; ++i) {
+      REQUIRE(out[i] == static_cast<float>(values[static_cast<size_t>(target) * 2 + i]) / 32768.0f);
+    }
+  }
+  REQUIRE(decoder->seek(frames + 100));
+  REQUIRE(decoder->read(out.data(), 64) == 0);
+}
+
+TEST_CASE("WavDecoder rejects unsupported and malformed files") {
+  const std::string path = TempPath("tomplayer_wav_reject.wav");
+  std::string error;
+
+  WavSpec eight_bit{};
+  eight_bit.bits = 8;
+  std::vector<uint8_t> bytes = Header(eight_bit, 4);
+  bytes.insert(bytes.end(), 4, 0x80);
+  WriteFile(path, bytes);
+  REQUIRE_FALSE(tomplayer::decode::OpenDecoder(path, &error));
+  REQUIRE(error.find("unsupported encoding") != std::string::npos);
+
+  WavSpec adpcm{};
+  adpcm.format_tag = 2;
+  bytes = Header(adpcm, 4);
+  bytes.insert(bytes.end(), 4, 0);
+  WriteFile(path, bytes);
+  REQUIRE_FALSE(tomplayer::decode::OpenDecoder(path, &error));
+
+  bytes = Header(WavSpec{}, 4);
+  bytes.resize(20);
+  WriteFile(path, bytes);
+  REQUIRE_FALSE(tomplayer::decode::OpenDecoder(path, &error));
+
+  WriteFile(path, {'O', 'g', 'g', 'S', 0, 0, 0, 0});
+  REQUIRE_FALSE(tomplayer::decode::OpenDecoder(path, &error));
+  REQUIRE(error.find("unrecognised") != std::string::npos);
+
+  REQUIRE_FALSE(tomplayer::decode::OpenDecoder(TempPath("tomplayer_missing.wav"), &error));
+  std::filesystem::remove(path);
+}
+
+// A sparse file keeps this cheap: only the header and the last frames hold real blocks.
+TEST_CASE("WavDecoder reads RF64 data past 4 GB") {
+  if (sizeof(size_t) < 8) {
+    // A 4 GB mapping needs a 64-bit address space.
+    return;
+  }
+  const WavSpec spec{};
+  const uint64_t data_bytes = (uint64_t{1} << 32) + 4096;
+  const uint64_t frames = data_bytes / 4;
+  const std::vector<uint8_t> header = Header(spec, data_bytes, true);
+  const std::string path = TempPath("tomplayer_wav_rf64.wav");
+  WriteFile(path, header);
+  std::error_code ec;
+  std::filesystem::resize_file(path, header.size() + data_bytes, ec);
+  if (ec) {
+    // No room for (or no sparse support for) a 4 GB file here.
+    std::filesystem::remove(path);
+    return;
+  }
+  std::vector<int32_t> values;
+  const std::vector<uint8_t> tail = IntegerSamples(16 * 2, 16, &values);
+  {
+    std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(static_cast<std::streamoff>(header.size() + data_bytes - tail.size()));
+    out.write(reinterpret_cast<const char*>(tail.data()), static_cast<std::streamsize>(tail.size()));
+  }
+
+  WavDecoder decoder;
+  std::string error;
+  REQUIRE(decoder.open(path, &error));
+  REQUIRE(decoder.info().total_frames == static_cast<int64_t>(frames));
+  REQUIRE(decoder.seek(static_cast<int64_t>(frames) - 16));
+  std::vector<float> out(32 * 2);
+  REQUIRE(decoder.read(out.data(), 32) == 16);
+  for (size_t i = 0; i < values.size(); ++i) {
+    REQUIRE(out[i] == static_cast<float>(values[i]) / 32768.0f);
+  }
+  decoder.seek(0);
+  REQUIRE(decoder.read(out.data(), 4) == 4);
+  REQUIRE(out[0] == 0.0f);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("PlayerEngine plays a WAV file to the end through FileOutput") {
+  using PlayerEngine = tomplayer::engine::PlayerEngine;
+  using tomplayer::audio::FileOutput;
+  // Mono source on a stereo sink: each sample lands in both channels.
+  WavSpec spec{};
+  spec.channels = 1;
+  const uint32_t frames = 3000;
+  std::vector<int32_t> values;
+  const std::vector<uint8_t> samples = IntegerSamples(frames, 16, &values);
+  std::vector<uint8_t> bytes = Header(spec, samples.size());
+  bytes.insert(bytes.end(), samples.begin(), samples.end());
+  const std::string source = TempPath("tomplayer_engine_source.wav");
+  WriteFile(source, bytes);
+
+  FileOutput::Config sink_config;
+  sink_config.path = TempPath("tomplayer_engine_rendered.wav");
+  PlayerEngine::Config engine_config;
+  engine_config.memory_policy = tomplayer::platform::MemoryPolicy::Prefault;
+  {
+    PlayerEngine engine(engine_config, std::make_unique<FileOutput>(sink_config));
+    const auto state_is = [&](PlayerEngine::PlayerState state) {
+      return [&engine, state] { return engine.get_status().state == state; };
+    };
+
+    engine.open(TempPath("tomplayer_missing.wav"));
+    REQUIRE(WaitFor(state_is(PlayerEngine::PlayerState::Error), 2000ms));
+    REQUIRE_FALSE(engine.get_status().last_error.empty());
+
+    engine.open(source);
+    REQUIRE(WaitFor(state_is(PlayerEngine::PlayerState::Stopped), 2000ms));
+    REQUIRE(engine.get_status().duration_seconds == 3000.0 / 48000.0);
+    REQUIRE(engine.get_status().last_error.empty());
+    // Shorter than the priming threshold: playback starts once the source is exhausted.
+    engine.play();
+    REQUIRE(WaitFor(state_is(PlayerEngine::PlayerState::Finished), 3000ms));
+    REQUIRE(engine.get_status().decoded_frame_cursor == frames);
+  }
+
+  WavDecoder rendered;
+  REQUIRE(rendered.open(sink_config.path, nullptr));
+  REQUIRE(rendered.info().channels == 2);
+  REQUIRE(rendered.info().total_frames == frames);
+  std::vector<float> out(static_cast<size_t>(frames) * 2);
+  REQUIRE(rendered.read(out.data(), frames) == frames);
+  for (uint32_t i = 0; i < frames; ++i) {
+    REQUIRE(out[i * 2] == static_cast<float>(values[i]) / 32768.0f);
+    REQUIRE(out[i * 2 + 1] == out[i * 2]);
+  }
+  std::filesystem::remove(source);
+  std::filesystem::remove(sink_config.path);
+}